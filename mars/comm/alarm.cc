@@ -20,20 +20,134 @@
 
 #include "comm/alarm.h"
 
+#include <map>
+#include <vector>
+
 #include "comm/assert/__assert.h"
+#include "comm/thread/condition.h"
 #include "comm/thread/lock.h"
+#include "comm/thread/thread.h"
 #include "comm/time_utils.h"
+#include "comm/timing_wheel.h"
 #include "comm/xlogger/xlogger.h"
 
 #include "comm/platform_comm.h"
 
 static Mutex sg_lock;
 static int64_t sg_seq = 1;
-static const MessageQueue::MessageTitle_t KALARM_MESSAGETITLE(0x1F1FF);
 
 #define MAX_LOCK_TIME (5000)
 #define INVAILD_SEQ (0)
 
+namespace {
+
+/*
+ * the started alarms of the whole process on one timing wheel and one thread,
+ * a due one is posted to the async handler of its alarm, instead of a delayed broadcast to all the alarms.
+ */
+class AlarmTimer {
+  public:
+    typedef boost::function<void (bool)> OnAlarmFunction;
+
+    static AlarmTimer& Instance() {
+        static AlarmTimer* timer = new AlarmTimer;  // never deleted, alarms are cancelled by static destructors too.
+        return *timer;
+    }
+
+    bool Add(int64_t _seq, int _after, const MessageQueue::MessageHandler_t& _handler, MessageQueue::MessageTitle_t _title, const OnAlarmFunction& _onalarm) {
+        ScopedLock lock(mutex_);
+
+        Timer* timer = new Timer;
+        timer->seq = _seq;
+        timer->handler = _handler;
+        timer->title = _title;
+        timer->onalarm = _onalarm;
+
+        if (0 != thread_.start()) {
+            delete timer;
+            return false;
+        }
+
+        wheel_.Add(timer, ::gettickcount() + (0 < _after ? _after : 0));
+        timers_[_seq] = timer;
+
+        if (timer->expire < wakeup_) cond_.notifyAll(lock);
+        return true;
+    }
+
+    void Remove(int64_t _seq) {
+        ScopedLock lock(mutex_);
+
+        std::map<int64_t, Timer*>::iterator it = timers_.find(_seq);
+        if (timers_.end() == it) return;
+
+        wheel_.Remove(it->second);
+        delete it->second;
+        timers_.erase(it);
+    }
+
+    // the timer stays till it's due, the android alarm may go off early.
+    void OnSystemAlarm(int64_t _seq) {
+        ScopedLock lock(mutex_);
+
+        std::map<int64_t, Timer*>::iterator it = timers_.find(_seq);
+        if (timers_.end() == it) return;
+
+        __Post(*it->second, true);
+    }
+
+  private:
+    struct Timer : TimingWheel::Timer {
+        int64_t                             seq;
+        MessageQueue::MessageHandler_t      handler;
+        MessageQueue::MessageTitle_t        title;
+        OnAlarmFunction                     onalarm;
+    };
+
+    AlarmTimer()
+    : wheel_(::gettickcount()), wakeup_(~(uint64_t)0)
+    , thread_(boost::bind(&AlarmTimer::__Run, this), "alarm_timer") {}
+
+    // posted with mutex_ locked, once Remove returns nothing is posted for the alarm anymore.
+    void __Post(const Timer& _timer, bool _android) {
+        MessageQueue::AsyncInvoke(boost::bind(_timer.onalarm, _android), _timer.title, _timer.handler);
+    }
+
+    void __Run() {
+        ScopedLock lock(mutex_);
+        std::vector<TimingWheel::Timer*> expired;
+
+        while (true) {
+            wheel_.Advance(::gettickcount(), expired);
+
+            for (std::vector<TimingWheel::Timer*>::iterator it = expired.begin(); it != expired.end(); ++it) {
+                Timer* timer = static_cast<Timer*>(*it);
+                timers_.erase(timer->seq);
+                __Post(*timer, false);
+                delete timer;
+            }
+
+            expired.clear();
+
+            wakeup_ = wheel_.NextTick();
+            uint64_t now = ::gettickcount();
+
+            if (~(uint64_t)0 == wakeup_) cond_.wait(lock);
+            else if (wakeup_ > now) cond_.wait(lock, (long)(wakeup_ - now));
+        }
+    }
+
+  private:
+    Mutex                                   mutex_;
+    Condition                               cond_;
+    TimingWheel                             wheel_;
+    std::map<int64_t, Timer*>               timers_;    // by the seq of the alarm
+    uint64_t                                wakeup_;    // the tick the thread waits till
+    Thread                                  thread_;
+};
+
+}
+
 bool Alarm::Start(int _after) {
     ScopedLock lock(sg_lock);
 
@@ -43,10 +157,9 @@ bool Alarm::Start(int _after) {
 
     int64_t seq = sg_seq++;
     uint64_t starttime = gettickcount();
-    MessageQueue::MessagePost_t mqId = MessageQueue::BroadcastMessage(MessageQueue::GetDefMessageQueue(), MessageQueue::Message(KALARM_MESSAGETITLE, (int64_t)seq, 1), MessageQueue::MessageTiming(_after));
 
-    if (MessageQueue::KNullPost == mqId) {
-        xerror2(TSF"mq alarm return null post, id:%0, after:%1, seq:%2", (uintptr_t)this, _after, seq);
+    if (!AlarmTimer::Instance().Add(seq, _after, reg_async_.Get(), (MessageQueue::MessageTitle_t)this, boost::bind(&Alarm::OnAlarm, this, seq, _1))) {
+        xerror2(TSF"alarm timer add error, id:%0, after:%1, seq:%2", (uintptr_t)this, _after, seq);
         return false;
     }
 
@@ -54,7 +167,7 @@ bool Alarm::Start(int _after) {
 
     if (!::startAlarm((int64_t) seq, _after)) {
         xerror2(TSF"startAlarm error, id:%0, after:%1, seq:%2", (uintptr_t)this, _after, seq);
-        MessageQueue::CancelMessage(mqId);
+        AlarmTimer::Instance().Remove(seq);
         return false;
     }
 
@@ -65,7 +178,7 @@ bool Alarm::Start(int _after) {
     endtime_ = 0;
     after_ = _after;
     seq_ = seq;
-    xinfo2(TSF"alarm id:%0, after:%1, seq:%2, po.reg.q:%3,po.reg.s:%4,po.s:%5", (uintptr_t)this, _after, seq, mqId.reg.queue, mqId.reg.seq, mqId.seq);
+    xinfo2(TSF"alarm id:%0, after:%1, seq:%2", (uintptr_t)this, _after, seq);
 
     return true;
 }
@@ -76,6 +189,8 @@ bool Alarm::Cancel() {
 
     if (INVAILD_SEQ == seq_) return true;
 
+    AlarmTimer::Instance().Remove(seq_);
+
 #ifdef ANDROID
 
     if (!::stopAlarm((int64_t)seq_)) {
@@ -114,23 +229,16 @@ int64_t Alarm::ElapseTime() const {
     return endtime_ -  starttime_;
 }
 
-void Alarm::OnAlarm(const MessageQueue::MessagePost_t& _id, MessageQueue::Message& _message) {
-    if (KALARM_MESSAGETITLE != _message.title) return;
-
+void Alarm::OnAlarm(int64_t _seq, bool _android) {
     ScopedLock lock(sg_lock);
 
-    if (MessageQueue::CurrentThreadMessageQueue() != MessageQueue::Handler2Queue(reg_async_.Get())) {
-        MessageQueue::AsyncInvoke(boost::bind(&Alarm::OnAlarm, this, _id, _message), (MessageQueue::MessageTitle_t)this, reg_async_.Get());
-        return;
-    }
-
-    if (seq_ != boost::any_cast<int64_t>(_message.body1)) return;
+    if (seq_ != _seq) return;
 
     uint64_t  curtime = gettickcount();
     int64_t   elapseTime = curtime - starttime_;
     int64_t   missTime = after_ - elapseTime;
     xgroup2_define(group);
-    xinfo2(TSF"OnAlarm id:%_, seq:%_, elapsed:%_, after:%_, miss:%_, android alarm:%_, ", (uintptr_t)this, seq_, elapseTime, after_, -missTime, !bool(boost::any_cast<int>(_message.body2))) >> group;
+    xinfo2(TSF"OnAlarm id:%_, seq:%_, elapsed:%_, after:%_, miss:%_, android alarm:%_, ", (uintptr_t)this, seq_, elapseTime, after_, -missTime, _android) >> group;
 
 #ifdef ANDROID
 
@@ -153,6 +261,7 @@ void Alarm::OnAlarm(const MessageQueue::MessagePost_t& _id, MessageQueue::Messag
 #endif
 
     xinfo2(TSF"runing") >> group;
+    AlarmTimer::Instance().Remove(seq_);    // the android alarm may go off before the timer
     status_ = kOnAlarm;
     seq_ = INVAILD_SEQ;
     endtime_ = curtime;
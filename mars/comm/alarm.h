@@ -47,7 +47,6 @@ class Alarm {
         , inthread_(_inthread)
         , seq_(0), status_(kInit)
         , after_(0) , starttime_(0) , endtime_(0)
-        , reg_(MessageQueue::InstallMessageHandler(boost::bind(&Alarm::OnAlarm, this, _1, _2), true))
 #ifdef ANDROID
         , wakelock_(NULL)
 #endif
@@ -61,7 +60,6 @@ class Alarm {
         , inthread_(false)
         , seq_(0), status_(kInit)
         , after_(0) , starttime_(0) , endtime_(0)
-        , reg_(MessageQueue::InstallMessageHandler(boost::bind(&Alarm::OnAlarm, this, _1, _2), true))
 #ifdef ANDROID
         , wakelock_(NULL)
 #endif
@@ -69,7 +67,6 @@ class Alarm {
 
     virtual ~Alarm() {
         Cancel();
-        reg_.CancelAndWait();
         reg_async_.CancelAndWait();
         runthread_.join();
         delete target_;
@@ -92,7 +89,8 @@ class Alarm {
     Alarm(const Alarm&);
     Alarm& operator=(const Alarm&);
 
-    void OnAlarm(const MessageQueue::MessagePost_t& _id, MessageQueue::Message& _message);
+    // on the queue of reg_async_, posted by the alarm timer once due, or the android alarm if _android.
+    void OnAlarm(int64_t _seq, bool _android);
     virtual void    __Run();
 
   private:
@@ -108,7 +106,6 @@ class Alarm {
     uint64_t          			starttime_;
     uint64_t          			endtime_;
 
-    MessageQueue::ScopeRegister reg_;
 #ifdef ANDROID
     WakeUpLock*                 wakelock_;
 #endif
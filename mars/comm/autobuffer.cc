@@ -20,6 +20,7 @@
 #endif
 
 #include "comm/assert/__assert.h"
+#include "comm/autobuffer_pool.h"
 
 
 const AutoBuffer KNullAtuoBuffer;
@@ -272,7 +273,7 @@ void* AutoBuffer::Detach(size_t* _plen) {
 
 void AutoBuffer::Reset() {
     if (NULL != parray_)
-        free(parray_);
+        AutoBufferPool::Free(parray_, capacity_);
 
     parray_ = NULL;
     pos_ = 0;
@@ -283,8 +284,17 @@ void AutoBuffer::Reset() {
 void AutoBuffer::__FitSize(size_t _len) {
     if (_len > capacity_) {
         size_t mallocsize = ((_len + malloc_unitsize_ -1)/malloc_unitsize_)*malloc_unitsize_ ;
-
-        void* p = realloc(parray_, mallocsize);
+        size_t poolsize = 0;
+        void* p = AutoBufferPool::IsEnabled() ? AutoBufferPool::Alloc(mallocsize, poolsize) : NULL;
+
+        if (NULL != p) {
+            // grows by the classes instead of malloc_unitsize_
+            mallocsize = poolsize;
+            if (NULL != parray_) memcpy(p, parray_, capacity_);
+            AutoBufferPool::Free(parray_, capacity_);
+        } else {
+            p = realloc(parray_, mallocsize);
+        }
 
         if (NULL == p) {
             ASSERT2(p, "_len=%" PRIu64 ", m_nMallocUnitSize=%" PRIu64 ", nMallocSize=%" PRIu64", m_nCapacity=%" PRIu64,
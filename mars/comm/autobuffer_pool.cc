@@ -0,0 +1,173 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * autobuffer_pool.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include "autobuffer_pool.h"
+
+#include <stdlib.h>
+
+#include "comm/thread/atomic_oper.h"
+#include "comm/thread/tss.h"
+
+static const size_t kPoolClassMin = 128;
+static const int kPoolClassCount = 10;         // 128 ... 64k
+static const size_t kPoolThreadBytesMax = 256 * 1024;
+static const uint32_t kPoolStatFlush = 64;    // the counters of a thread are added to the global ones every so many allocs
+
+static volatile uint32_t sg_enable = 0;
+static volatile uint32_t sg_alloc_count = 0;
+static volatile uint32_t sg_hit_count = 0;
+static volatile uint32_t sg_retained_bytes = 0;
+
+namespace {
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct ThreadCache {
+    FreeBlock* heads[kPoolClassCount];
+    size_t bytes;
+    size_t flushed_bytes;   // the part of bytes in sg_retained_bytes
+    uint32_t alloc_count;
+    uint32_t hit_count;
+};
+
+}
+
+static void __FlushStat(ThreadCache* _cache) {
+    atomic_add32(&sg_alloc_count, _cache->alloc_count);
+    atomic_add32(&sg_hit_count, _cache->hit_count);
+    atomic_add32(&sg_retained_bytes, (uint32_t)(_cache->bytes - _cache->flushed_bytes));
+    _cache->alloc_count = 0;
+    _cache->hit_count = 0;
+    _cache->flushed_bytes = _cache->bytes;
+}
+
+static void __FreeCache(ThreadCache* _cache) {
+    for (int i = 0; i < kPoolClassCount; ++i) {
+        while (NULL != _cache->heads[i]) {
+            FreeBlock* block = _cache->heads[i];
+            _cache->heads[i] = block->next;
+            free(block);
+        }
+    }
+
+    _cache->bytes = 0;
+    __FlushStat(_cache);
+}
+
+static void __OnThreadExit(void* _cache) {
+    __FreeCache((ThreadCache*)_cache);
+    delete (ThreadCache*)_cache;
+}
+
+// never deleted, AutoBuffers are freed till the end of the static destructors.
+static Tss& __CacheTss() {
+    static Tss* tss = new Tss(&__OnThreadExit);
+    return *tss;
+}
+
+static ThreadCache* __Cache(bool _create) {
+    ThreadCache* cache = (ThreadCache*)__CacheTss().get();
+
+    if (NULL != cache || !_create) return cache;
+
+    cache = new ThreadCache;
+    for (int i = 0; i < kPoolClassCount; ++i) cache->heads[i] = NULL;
+    cache->bytes = 0;
+    cache->flushed_bytes = 0;
+    cache->alloc_count = 0;
+    cache->hit_count = 0;
+    __CacheTss().set(cache);
+    return cache;
+}
+
+// -1 if bigger than the classes
+static int __ClassIndex(size_t _size) {
+    size_t class_size = kPoolClassMin;
+
+    for (int i = 0; i < kPoolClassCount; ++i, class_size <<= 1) {
+        if (_size <= class_size) return i;
+    }
+
+    return -1;
+}
+
+void AutoBufferPool::Enable(bool _enable) {
+    atomic_write32(&sg_enable, _enable ? 1 : 0);
+}
+
+bool AutoBufferPool::IsEnabled() {
+    return 0 != sg_enable;
+}
+
+void AutoBufferPool::GetStat(Stat& _stat) {
+    ThreadCache* cache = __Cache(false);
+    if (NULL != cache) __FlushStat(cache);
+
+    _stat.alloc_count = atomic_read32(&sg_alloc_count);
+    _stat.hit_count = atomic_read32(&sg_hit_count);
+    _stat.retained_bytes = atomic_read32(&sg_retained_bytes);
+}
+
+void AutoBufferPool::Trim() {
+    ThreadCache* cache = __Cache(false);
+    if (NULL != cache) __FreeCache(cache);
+}
+
+void* AutoBufferPool::Alloc(size_t _size, size_t& _capacity) {
+    int index = __ClassIndex(_size);
+    if (0 > index) return NULL;
+
+    _capacity = kPoolClassMin << index;
+
+    ThreadCache* cache = __Cache(true);
+    FreeBlock* block = cache->heads[index];
+
+    if (kPoolStatFlush <= ++cache->alloc_count) __FlushStat(cache);
+    if (NULL == block) return malloc(_capacity);
+
+    cache->heads[index] = block->next;
+    cache->bytes -= _capacity;
+    ++cache->hit_count;
+    return block;
+}
+
+void AutoBufferPool::Free(void* _block, size_t _capacity) {
+    if (NULL == _block) return;
+
+    int index = __ClassIndex(_capacity);
+
+    if (!IsEnabled() || 0 > index || _capacity != (kPoolClassMin << index)) {
+        free(_block);
+        return;
+    }
+
+    ThreadCache* cache = __Cache(true);
+
+    if (kPoolThreadBytesMax < cache->bytes + _capacity) {
+        free(_block);
+        return;
+    }
+
+    FreeBlock* block = (FreeBlock*)_block;
+    block->next = cache->heads[index];
+    cache->heads[index] = block;
+    cache->bytes += _capacity;
+}
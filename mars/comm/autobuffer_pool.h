@@ -0,0 +1,52 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * autobuffer_pool.h
+ *
+ *  Created on: 2026-10-17
+ */
+
+#ifndef COMM_AUTOBUFFER_POOL_H_
+#define COMM_AUTOBUFFER_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * size-classed blocks for AutoBuffer, 128 bytes to 64k by powers of 2, in freelists of each thread.
+ * a thread keeps at most kPoolThreadBytesMax of them, bigger blocks are malloced and freed as before.
+ * the blocks are plain malloced ones, a buffer Detach()ed from an AutoBuffer is still free()d by its owner.
+ * off by default.
+ */
+class AutoBufferPool {
+  public:
+    struct Stat {
+        uint32_t alloc_count;       // of the blocks asked from the pool, the other threads add theirs every few dozens
+        uint32_t hit_count;         // of them from a freelist
+        uint32_t retained_bytes;    // in the freelists of all threads
+    };
+
+    static void Enable(bool _enable);
+    static bool IsEnabled();
+    static void GetStat(Stat& _stat);
+    // the freelists of the calling thread are freed.
+    static void Trim();
+
+    // NULL if _size is bigger than the classes, else a block of _capacity, the size of the class.
+    static void* Alloc(size_t _size, size_t& _capacity);
+    // kept if _capacity is the size of a class and the freelists have room, or else freed.
+    static void Free(void* _block, size_t _capacity);
+};
+
+#endif  // COMM_AUTOBUFFER_POOL_H_
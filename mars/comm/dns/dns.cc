@@ -19,6 +19,11 @@
  */
 
 #include "dns/dns.h"
+
+#include <algorithm>
+#include <list>
+#include <map>
+
 #include "socket/unix_socket.h"
 #include "xlogger/xlogger.h"
 #include "time_utils.h"
@@ -37,131 +42,285 @@ enum {
     kGetIPFail,
 };
 
-struct dnsinfo {
-    thread_tid      threadid;
-    DNS*            dns;
-    DNS::DNSFunc    dns_func;
-    std::string     host_name;
-    std::vector<std::string> result;
-    int status;
+static const unsigned int kDNSWorkerMax = 3;
+static const long kDNSWorkerIdle = 60 * 1000;          // an idle worker quits after it
+static const uint64_t kDNSCacheTTL = 5 * 60 * 1000;
+static const uint64_t kDNSNegativeCacheTTL = 15 * 1000;
+
+struct dnsrequest;
+
+// a GetHostByName waiting for a lookup, on the stack of the caller if blocking, owned by the request if with a callback.
+struct dnswaiter {
+    DNS*                        dns;
+    dnsrequest*                 request;    // NULL once answered
+    int                         status;
+    std::vector<std::string>    result;
+    DNS::DNSCallback            callback;
+};
+
+struct dnsrequest {
+    std::string                 host_name;
+    DNS::DNSFunc                dns_func;
+    bool                        doing;
+    std::vector<dnswaiter*>     waiters;
 };
 
-static std::vector<dnsinfo> sg_dnsinfo_vec;
-static Condition sg_condition;
-static Mutex sg_mutex;
+struct dnscache {
+    std::vector<std::string>    result;     // empty, no ip
+    uint64_t                    expire_time;
+};
 
-static void __GetIP() {
+// a callback answered, called by its worker without the lock. Cancel waits for a calling one.
+struct dnscallback {
+    dnswaiter*                  waiter;
+    std::string                 host_name;
+    thread_tid                  worker;
+    bool                        calling;
+};
+
+// never deleted, the workers are detached and may still wait on them while the statics are destroyed at exit.
+#define sg_dnsrequest_list dnsrequest_list()
+static std::list<dnsrequest>& dnsrequest_list() {
+    static std::list<dnsrequest>* list = new std::list<dnsrequest>;
+    return *list;
+}
+#define sg_dnscache_map dnscache_map()
+static std::map<std::string, dnscache>& dnscache_map() {
+    static std::map<std::string, dnscache>* map = new std::map<std::string, dnscache>;
+    return *map;
+}
+#define sg_dnscallback_list dnscallback_list()
+static std::list<dnscallback>& dnscallback_list() {
+    static std::list<dnscallback>* list = new std::list<dnscallback>;
+    return *list;
+}
+#define sg_condition dns_condition()
+static Condition& dns_condition() {     // for the waiters
+    static Condition* condition = new Condition;
+    return *condition;
+}
+#define sg_worker_condition dns_worker_condition()
+static Condition& dns_worker_condition() {  // for the workers
+    static Condition* condition = new Condition;
+    return *condition;
+}
+#define sg_mutex dns_mutex()
+static Mutex& dns_mutex() {
+    static Mutex* mutex = new Mutex;
+    return *mutex;
+}
+
+static unsigned int sg_worker_count = 0;
+static unsigned int sg_idle_worker_count = 0;
+
+static bool __GetIP(const std::string& _host_name, DNS::DNSFunc _dnsfunc, std::vector<std::string>& _result) {
     xverbose_function();
 
+    if (NULL != _dnsfunc) {
+        _result = _dnsfunc(_host_name);
+        return !_result.empty();
+    }
 
-    std::string host_name;
-    DNS::DNSFunc dnsfunc = NULL;
+    struct addrinfo hints, *single, *result;
 
-    ScopedLock lock(sg_mutex);
-    std::vector<dnsinfo>::iterator iter = sg_dnsinfo_vec.begin();
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = PF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    //in iOS work fine, in Android ipv6 stack get ipv4-ip fail
+    //and in ipv6 stack AI_ADDRCONFIGd will filter ipv4-ip but we ipv4-ip can use by nat64
+//    hints.ai_flags = AI_V4MAPPED|AI_ADDRCONFIG;
+    int error = getaddrinfo(_host_name.c_str(), NULL, &hints, &result);
 
-    for (; iter != sg_dnsinfo_vec.end(); ++iter) {
-        if (iter->threadid == ThreadUtil::currentthreadid()) {
-            host_name = iter->host_name;
-            dnsfunc = iter->dns_func;
-            break;
-        }
+    if (error != 0) {
+        xwarn2(TSF"error, error:%0, hostname:%1", error, _host_name.c_str());
+        return false;
     }
 
-    lock.unlock();
+    for (single = result; single; single = single->ai_next) {
+        if (PF_INET != single->ai_family) {
+            xassert2(false);
+            continue;
+        }
 
-    if (NULL == dnsfunc) {
-        
-        struct addrinfo hints, *single, *result;
+        sockaddr_in* addr_in = (sockaddr_in*)single->ai_addr;
+        struct in_addr convertAddr;
 
-        memset(&hints, 0, sizeof(hints));
-        hints.ai_family = PF_INET;
-        hints.ai_socktype = SOCK_STREAM;
-        //in iOS work fine, in Android ipv6 stack get ipv4-ip fail
-        //and in ipv6 stack AI_ADDRCONFIGd will filter ipv4-ip but we ipv4-ip can use by nat64
-    //    hints.ai_flags = AI_V4MAPPED|AI_ADDRCONFIG;
-        int error = getaddrinfo(host_name.c_str(), NULL, &hints, &result);
+        // In Indonesia, if there is no ipv6's ip, operators return 0.0.0.0.
+        if (INADDR_ANY == addr_in->sin_addr.s_addr || INADDR_NONE == addr_in->sin_addr.s_addr) {
+            xwarn2(TSF"hehe, addr_in->sin_addr.s_addr:%0", addr_in->sin_addr.s_addr);
+            continue;
+        }
 
-        lock.lock();
+        convertAddr.s_addr = addr_in->sin_addr.s_addr;
+        const char* ip = socket_address(convertAddr).ip();
 
-        iter = sg_dnsinfo_vec.begin();
-        for (; iter != sg_dnsinfo_vec.end(); ++iter) {
-            if (iter->threadid == ThreadUtil::currentthreadid()) {
-                break;
-            }
+        if (!socket_address(ip, 0).valid()) {
+            xerror2(TSF"ip is invalid, ip:%0", ip);
+            continue;
         }
 
-        if (error != 0) {
-            xwarn2(TSF"error, error:%0, hostname:%1", error, host_name.c_str());
+        _result.push_back(ip);
+    }
 
-            if (iter != sg_dnsinfo_vec.end()) iter->status = kGetIPFail;
+    if (_result.empty()) {
+        xgroup2_define(log_group);
+        std::vector<socket_address> dnssvraddrs;
+        getdnssvraddrs(dnssvraddrs);
 
-            sg_condition.notifyAll();
-            return;
-        } else {
-            if (iter == sg_dnsinfo_vec.end()) {
-                freeaddrinfo(result);
-                return;
-            }
+        xinfo2("dns server:") >> log_group;
+        for (std::vector<socket_address>::iterator iter = dnssvraddrs.begin(); iter != dnssvraddrs.end(); ++iter) {
+            xinfo2(TSF"%_:%_ ", iter->ip(), iter->port()) >> log_group;
+        }
+    }
+
+    freeaddrinfo(result);
+    // the same as before, no ip but getaddrinfo ok is a success with nothing in it.
+    return true;
+}
 
-            for (single = result; single; single = single->ai_next) {
-                if (PF_INET != single->ai_family) {
-                    xassert2(false);
-                    continue;
-                }
+// only the system dns is cached, a DNSFunc may have its own mind.
+static bool __FindCache(const std::string& _host_name, DNS::DNSFunc _dnsfunc, std::vector<std::string>& _result, bool& _success) {
+    if (NULL != _dnsfunc) return false;
 
-                sockaddr_in* addr_in = (sockaddr_in*)single->ai_addr;
-                struct in_addr convertAddr;
+    std::map<std::string, dnscache>::iterator it = sg_dnscache_map.find(_host_name);
+    if (sg_dnscache_map.end() == it) return false;
 
-                // In Indonesia, if there is no ipv6's ip, operators return 0.0.0.0.
-                if (INADDR_ANY == addr_in->sin_addr.s_addr || INADDR_NONE == addr_in->sin_addr.s_addr) {
-                    xwarn2(TSF"hehe, addr_in->sin_addr.s_addr:%0", addr_in->sin_addr.s_addr);
-                    continue;
-                }
+    if (it->second.expire_time <= gettickcount()) {
+        sg_dnscache_map.erase(it);
+        return false;
+    }
 
-                convertAddr.s_addr = addr_in->sin_addr.s_addr;
-    			const char* ip = socket_address(convertAddr).ip();
+    _result = it->second.result;
+    _success = !_result.empty();
+    return true;
+}
 
-                if (!socket_address(ip, 0).valid()) {
-                    xerror2(TSF"ip is invalid, ip:%0", ip);
-                    continue;
-                }
+static void __AddCache(const std::string& _host_name, DNS::DNSFunc _dnsfunc, bool _success, const std::vector<std::string>& _result) {
+    if (NULL != _dnsfunc) return;
 
-                iter->result.push_back(ip);
-            }
+    dnscache& cache = sg_dnscache_map[_host_name];
+    cache.result = _success ? _result : std::vector<std::string>();
+    cache.expire_time = gettickcount() + (cache.result.empty() ? kDNSNegativeCacheTTL : kDNSCacheTTL);
+}
 
-            if(iter->result.empty()) {
-                xgroup2_define(log_group);
-                std::vector<socket_address> dnssvraddrs;
-                getdnssvraddrs(dnssvraddrs);
-                
-                xinfo2("dns server:") >> log_group;
-                for (std::vector<socket_address>::iterator iter = dnssvraddrs.begin(); iter != dnssvraddrs.end(); ++iter) {
-                    xinfo2(TSF"%_:%_ ", iter->ip(), iter->port()) >> log_group;
-                }
+static void __DNSWorker();
+
+// the lookup of the same host by the same func in progress or queued, or a new one queued.
+// NULL if there is no worker to do it.
+static dnsrequest* __Request(const std::string& _host_name, DNS::DNSFunc _dnsfunc) {
+    for (std::list<dnsrequest>::iterator it = sg_dnsrequest_list.begin(); it != sg_dnsrequest_list.end(); ++it) {
+        if (it->dns_func == _dnsfunc && it->host_name == _host_name) return &*it;
+    }
+
+    sg_dnsrequest_list.push_back(dnsrequest());
+    dnsrequest& request = sg_dnsrequest_list.back();
+    request.host_name = _host_name;
+    request.dns_func = _dnsfunc;
+    request.doing = false;
+
+    if (0 < sg_idle_worker_count || kDNSWorkerMax <= sg_worker_count) {
+        sg_worker_condition.notifyOne();
+        return &request;
+    }
+
+    // the thread goes on after the Thread object is gone.
+    Thread thread(&__DNSWorker, "dns");
+    if (0 == thread.start()) {
+        ++sg_worker_count;
+        return &request;
+    }
+
+    xerror2(TSF"start the thread fail, workers:%_", sg_worker_count);
+    // the busy ones take it later
+    if (0 < sg_worker_count) return &request;
+
+    sg_dnsrequest_list.pop_back();
+    return NULL;
+}
+
+static void __RemoveWaiter(dnswaiter& _waiter) {
+    if (NULL == _waiter.request) return;
+
+    std::vector<dnswaiter*>& waiters = _waiter.request->waiters;
+    waiters.erase(std::remove(waiters.begin(), waiters.end(), &_waiter), waiters.end());
+    _waiter.request = NULL;
+}
+
+static void __DNSWorker() {
+    xinfo_function();
+    ScopedLock lock(sg_mutex);
+
+    while (true) {
+        std::list<dnsrequest>::iterator it = sg_dnsrequest_list.begin();
+        while (it != sg_dnsrequest_list.end() && it->doing) ++it;
+
+        if (sg_dnsrequest_list.end() == it) {
+            ++sg_idle_worker_count;
+            int ret = sg_worker_condition.wait(lock, kDNSWorkerIdle);
+            --sg_idle_worker_count;
+
+            if (ETIMEDOUT == ret) {
+                bool pending = false;
+                for (it = sg_dnsrequest_list.begin(); it != sg_dnsrequest_list.end() && !pending; ++it) pending = !it->doing;
+                if (!pending) break;
             }
-            
-            freeaddrinfo(result);
-            iter->status = kGetIPSuc;
-            sg_condition.notifyAll();
+            continue;
         }
-    } else {
-        std::vector<std::string> ips = dnsfunc(host_name);
+
+        it->doing = true;
+        std::string host_name = it->host_name;
+        DNS::DNSFunc dnsfunc = it->dns_func;
+
+        lock.unlock();
+        std::vector<std::string> result;
+        bool success = __GetIP(host_name, dnsfunc, result);
         lock.lock();
-        
-        iter = sg_dnsinfo_vec.begin();
-        for (; iter != sg_dnsinfo_vec.end(); ++iter) {
-            if (iter->threadid == ThreadUtil::currentthreadid()) {
-                break;
+
+        __AddCache(host_name, dnsfunc, success, result);
+
+        thread_tid self = ThreadUtil::currentthreadid();
+        bool callbacks = false;
+        for (std::vector<dnswaiter*>::iterator waiter = it->waiters.begin(); waiter != it->waiters.end(); ++waiter) {
+            (*waiter)->request = NULL;
+
+            if (!(*waiter)->callback.empty()) {
+                dnscallback callback = {*waiter, host_name, self, false};
+                sg_dnscallback_list.push_back(callback);
+                callbacks = true;
+                continue;
             }
+
+            if (kGetIPDoing != (*waiter)->status) continue;
+
+            (*waiter)->status = success ? kGetIPSuc : kGetIPFail;
+            (*waiter)->result = result;
         }
-        
-        if (iter != sg_dnsinfo_vec.end()) {
-            iter->status = ips.empty()? kGetIPFail:kGetIPSuc;
-            iter->result = ips;
-        }
+
+        sg_dnsrequest_list.erase(it);
         sg_condition.notifyAll();
+
+        if (!callbacks) continue;
+
+        // one by one, a DNS cancelled meanwhile takes its ones not called yet away.
+        while (true) {
+            std::list<dnscallback>::iterator callback = sg_dnscallback_list.begin();
+            while (callback != sg_dnscallback_list.end() && (callback->worker != self || callback->calling)) ++callback;
+            if (sg_dnscallback_list.end() == callback) break;
+
+            callback->calling = true;
+            dnswaiter* waiter = callback->waiter;
+
+            lock.unlock();
+            waiter->callback(success, result);
+            lock.lock();
+
+            sg_dnscallback_list.erase(callback);
+            delete waiter;
+            sg_condition.notifyAll();
+        }
     }
+
+    --sg_worker_count;
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -185,98 +344,126 @@ bool DNS::GetHostByName(const std::string& _host_name, std::vector<std::string>&
 
     if (_breaker && _breaker->isbreak) return false;
 
-    Thread thread(&__GetIP, _host_name.c_str());
-    int startRet = thread.start();
-
-    if (startRet != 0) {
-        xerror2(TSF"start the thread fail");
-        return false;
+    bool success = false;
+    if (__FindCache(_host_name, dnsfunc_, ips, success)) {
+        xverbose2(TSF"dns cache host:%_, size:%_", _host_name, ips.size());
+        return success;
     }
 
-    dnsinfo info;
-    info.threadid = thread.tid();
-    info.host_name = _host_name;
-    info.dns_func = dnsfunc_;
-    info.dns = this;
-    info.status = kGetIPDoing;
-    sg_dnsinfo_vec.push_back(info);
+    dnswaiter waiter;
+    waiter.dns = this;
+    waiter.request = __Request(_host_name, dnsfunc_);
+    if (NULL == waiter.request) return false;
 
-    if (_breaker) _breaker->dnsstatus = &(sg_dnsinfo_vec.back().status);
+    waiter.status = kGetIPDoing;
+    waiter.request->waiters.push_back(&waiter);
+
+    if (_breaker) _breaker->dnsstatus = &waiter.status;
 
     uint64_t time_end = gettickcount() + (uint64_t)millsec;
 
-    while (true) {
+    while (kGetIPDoing == waiter.status) {
         uint64_t time_cur = gettickcount();
         uint64_t time_wait = time_end > time_cur ? time_end - time_cur : 0;
 
-        int wait_ret = sg_condition.wait(lock, (long)time_wait);
-
-        std::vector<dnsinfo>::iterator it = sg_dnsinfo_vec.begin();
-
-        for (; it != sg_dnsinfo_vec.end(); ++it) {
-            if (info.threadid == it->threadid)
-                break;
+        if (ETIMEDOUT == sg_condition.wait(lock, (long)time_wait) && kGetIPDoing == waiter.status) {
+            waiter.status = kGetIPTimeout;
         }
+    }
 
-        xassert2(it != sg_dnsinfo_vec.end());
-        
-        if (it != sg_dnsinfo_vec.end()){
-
-            if (ETIMEDOUT == wait_ret) {
-                it->status = kGetIPTimeout;
-            }
-
-            if (kGetIPDoing == it->status) {
-                continue;
-            }
-
-            if (kGetIPSuc == it->status) {
-                ips = it->result;
-
-                if (_breaker) _breaker->dnsstatus = NULL;
+    // the lookup goes on for the others and the cache.
+    __RemoveWaiter(waiter);
+    if (_breaker) _breaker->dnsstatus = NULL;
 
-                sg_dnsinfo_vec.erase(it);
-                return true;
-            }
+    if (kGetIPSuc == waiter.status) {
+        ips = waiter.result;
+        return true;
+    }
 
-            if (kGetIPTimeout == it->status || kGetIPCancel == it->status || kGetIPFail == it->status) {
-                if (_breaker) _breaker->dnsstatus = NULL;
+    xinfo2(TSF "dns get ip status:%_", waiter.status);
+    return false;
+}
 
-                xinfo2(TSF "dns get ip status:%_", it->status);
-                sg_dnsinfo_vec.erase(it);
-                return false;
-            }
+void DNS::GetHostByName(const std::string& _host_name, const DNSCallback& _callback) {
+    xverbose_function();
+    xassert2(!_host_name.empty() && !_callback.empty());
 
-            xassert2(false, "%d", it->status);
+    ScopedLock lock(sg_mutex);
 
-            if (_breaker) _breaker->dnsstatus = NULL;
+    std::vector<std::string> ips;
+    bool success = false;
+    if (_host_name.empty() || __FindCache(_host_name, dnsfunc_, ips, success)) {
+        lock.unlock();
+        _callback(success, ips);
+        return;
+    }
 
-            sg_dnsinfo_vec.erase(it);
-        }
-        return false;
+    dnsrequest* request = __Request(_host_name, dnsfunc_);
+    if (NULL == request) {
+        lock.unlock();
+        _callback(false, ips);
+        return;
     }
 
-    return false;
+    dnswaiter* waiter = new dnswaiter;
+    waiter->dns = this;
+    waiter->request = request;
+    waiter->status = kGetIPDoing;
+    waiter->callback = _callback;
+    waiter->request->waiters.push_back(waiter);
 }
 
 void DNS::Cancel(const std::string& _host_name) {
     xverbose_function();
     ScopedLock lock(sg_mutex);
 
-    for (unsigned int i = 0; i < sg_dnsinfo_vec.size(); ++i) {
-        dnsinfo& info = sg_dnsinfo_vec.at(i);
+    for (std::list<dnsrequest>::iterator it = sg_dnsrequest_list.begin(); it != sg_dnsrequest_list.end(); ++it) {
+        if (!_host_name.empty() && it->host_name != _host_name) continue;
 
-        if (_host_name.empty() && info.dns == this) {
-            info.status = kGetIPCancel;
-        }
+        for (size_t i = 0; i < it->waiters.size();) {
+            dnswaiter* waiter = it->waiters[i];
+
+            if (waiter->dns != this) {
+                ++i;
+                continue;
+            }
 
-        if (info.host_name.compare(_host_name) == 0 && info.dns == this) {
-            info.status = kGetIPCancel;
-            break;
+            if (waiter->callback.empty()) {
+                waiter->status = kGetIPCancel;
+                ++i;
+                continue;
+            }
+
+            it->waiters.erase(it->waiters.begin() + i);
+            delete waiter;
         }
     }
 
     sg_condition.notifyAll();
+
+    // the ones answered are dropped if not called yet, waited for if being called, unless by this very callback.
+    thread_tid self = ThreadUtil::currentthreadid();
+    std::list<dnscallback>::iterator callback = sg_dnscallback_list.begin();
+    while (callback != sg_dnscallback_list.end()) {
+        if (callback->waiter->dns != this || (!_host_name.empty() && callback->host_name != _host_name)) {
+            ++callback;
+            continue;
+        }
+
+        if (!callback->calling) {
+            delete callback->waiter;
+            callback = sg_dnscallback_list.erase(callback);
+            continue;
+        }
+
+        if (callback->worker == self) {
+            ++callback;
+            continue;
+        }
+
+        sg_condition.wait(lock);
+        callback = sg_dnscallback_list.begin();
+    }
 }
 
 void DNS::Cancel(DNSBreaker& _breaker) {
@@ -287,3 +474,9 @@ void DNS::Cancel(DNSBreaker& _breaker) {
 
     sg_condition.notifyAll();
 }
+
+void DNS::ClearCache() {
+    ScopedLock lock(sg_mutex);
+    xinfo2(TSF"dns cache cleared:%_", sg_dnscache_map.size());
+    sg_dnscache_map.clear();
+}
@@ -24,15 +24,23 @@
 #include <string>
 #include <vector>
 
+#include "boost/function.hpp"
+
 struct DNSBreaker {
 	DNSBreaker(): isbreak(false), dnsstatus(NULL) {}
 	bool isbreak;
 	int* dnsstatus;
 };
 
+/*
+ * the lookups are done by a few worker threads shared by all DNS objects, the same host asked meanwhile waits for the same lookup.
+ * the answers of the system dns (no DNSFunc) are cached, kDNSCacheTTL for the ips, kDNSNegativeCacheTTL for no ip.
+ * getaddrinfo doesn't tell the ttl of the records, so they are fixed ones. ClearCache() on network change.
+ */
 class DNS {
   public:
    typedef std::vector<std::string> (*DNSFunc)(const std::string& host);
+   typedef boost::function<void (bool _success, const std::vector<std::string>& _ips)> DNSCallback;
 
   public:
     DNS(DNSFunc _dnsfunc=NULL);
@@ -40,8 +48,13 @@ class DNS {
     
   public:
     bool GetHostByName(const std::string& _host_name, std::vector<std::string>& ips, long millsec = 2 * 1000, DNSBreaker* _breaker = NULL);
+    // doesn't block, _callback is called in a worker thread, or before it returns if the answer is cached or no worker can be started.
+    // not called once cancelled, Cancel and ~DNS wait for one being called unless called by it.
+    void GetHostByName(const std::string& _host_name, const DNSCallback& _callback);
     void Cancel(const std::string& _host_name = std::string());
     void Cancel(DNSBreaker& _breaker);
+
+    static void ClearCache();
     
   private:
     DNSFunc dnsfunc_;
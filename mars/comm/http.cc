@@ -20,7 +20,11 @@
 #include "http.h"
 
 #include <cstddef>
+#include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "comm/strutil.h"
 #include "comm/xlogger/xlogger.h"
@@ -344,29 +348,130 @@ std::pair<const std::string, std::string> HeaderFields::MakeContentTypeOctetStre
 }
 
 
+// the interned names, by their id
+static const char* const* const kKnownFields[] = {
+    &HeaderFields::KStringHost,
+    &HeaderFields::KStringAccept,
+    &HeaderFields::KStringUserAgent,
+    &HeaderFields::KStringCacheControl,
+    &HeaderFields::KStringConnection,
+    &HeaderFields::KStringContentType,
+    &HeaderFields::KStringContentLength,
+    &HeaderFields::KStringTransferEncoding,
+    &HeaderFields::kStringContentEncoding,
+    &HeaderFields::KStringAcceptEncoding,
+    &HeaderFields::KStringContentRange,
+    &HeaderFields::KStringRange,
+    &HeaderFields::KStringLocation,
+    &HeaderFields::KStringReferer,
+};
+
+static const int kKnownFieldCount = (int)(sizeof(kKnownFields) / sizeof(kKnownFields[0]));
+
+static int __KnownFieldId(const char* _name, size_t _name_length) {
+    for (int i = 0; i < kKnownFieldCount; ++i) {
+        if (*kKnownFields[i] == _name) return i;
+    }
+
+    for (int i = 0; i < kKnownFieldCount; ++i) {
+        const char* known = *kKnownFields[i];
+
+        if (tolower((unsigned char)known[0]) != tolower((unsigned char)_name[0])) continue;
+        if (_name_length == strlen(known) && 0 == strncasecmp(known, _name, _name_length)) return i;
+    }
+
+    return -1;
+}
+
+HeaderFields::HeaderFields(): count_(0) {
+    xassert2(kKnownFieldCount <= kKnownFieldMax);
+
+    for (int i = 0; i < kKnownFieldMax; ++i) {
+        known_[i] = -1;
+    }
+}
+
 void HeaderFields::HeaderFiled(const char* _name, const char* _value) {
-    headers_.insert(std::pair<const std::string, std::string>(_name, _value));
+    HeaderFiled(_name, strlen(_name), _value, strlen(_value));
+}
+
+void HeaderFields::HeaderFiled(const char* _name, size_t _name_length, const char* _value, size_t _value_length) {
+    int id = __KnownFieldId(_name, _name_length);
+
+    if (0 <= id ? -1 != known_[id] : -1 != __Find(_name, _name_length)) return;
+
+    Field field;
+    field.id = id;
+    field.name = (uint32_t)data_.size();
+    data_.append(_name, _name_length);
+    data_.push_back('\0');
+    field.value = (uint32_t)data_.size();
+    data_.append(_value, _value_length);
+    data_.push_back('\0');
+
+    if (0 <= id) known_[id] = (int)count_;
+
+    if (kInlineFields > count_) {
+        fields_[count_] = field;
+    } else {
+        more_fields_.push_back(field);
+    }
+
+    ++count_;
 }
 
 void HeaderFields::HeaderFiled(const std::pair<const std::string, std::string>& _headerfield) {
-    headers_.insert(_headerfield);
+    HeaderFiled(_headerfield.first.data(), _headerfield.first.size(), _headerfield.second.data(), _headerfield.second.size());
 }
 
 void HeaderFields::HeaderFiled(const http::HeaderFields& _headerfields) {
-    headers_.insert(_headerfields.headers_.begin(), _headerfields.headers_.end());
+    for (size_t i = 0; i < _headerfields.count_; ++i) {
+        const Field& field = _headerfields.__At(i);
+        const char* name = _headerfields.data_.c_str() + field.name;
+        const char* value = _headerfields.data_.c_str() + field.value;
+        HeaderFiled(name, field.value - field.name - 1, value, strlen(value));
+    }
 }
 
 const char* HeaderFields::HeaderField(const char* _key) const {
-    std::map<const std::string, std::string, less>::const_iterator iter = headers_.find(_key);
+    size_t key_length = strlen(_key);
+    int id = __KnownFieldId(_key, key_length);
+    int index = 0 <= id ? known_[id] : __Find(_key, key_length);
+
+    if (-1 == index) return NULL;
+
+    return data_.c_str() + __At((size_t)index).value;
+}
+
+std::map<const std::string, std::string, less> HeaderFields::GetHeaders() const {
+    std::map<const std::string, std::string, less> headers;
 
-    if (iter != headers_.end()) {
-        return iter->second.c_str();
+    for (size_t i = 0; i < count_; ++i) {
+        const Field& field = __At(i);
+        headers.insert(std::pair<const std::string, std::string>(data_.c_str() + field.name, data_.c_str() + field.value));
     }
 
-    return NULL;
+    return headers;
+}
+
+const HeaderFields::Field& HeaderFields::__At(size_t _index) const {
+    return kInlineFields > _index ? fields_[_index] : more_fields_[_index - kInlineFields];
+}
+
+// the ones not interned
+int HeaderFields::__Find(const char* _name, size_t _name_length) const {
+    for (size_t i = 0; i < count_; ++i) {
+        const Field& field = __At(i);
+
+        if (0 <= field.id || field.value - field.name - 1 != _name_length) continue;
+        if (0 == strncasecmp(data_.c_str() + field.name, _name, _name_length)) return (int)i;
+    }
+
+    return -1;
 }
 
-bool HeaderFields::IsTransferEncodingChunked() {
+bool HeaderFields::IsTransferEncodingChunked() const {
+
     const char* transferEncoding = HeaderField(HeaderFields::KStringTransferEncoding);
 
     if (transferEncoding && 0 == strcasecmp(transferEncoding, KStringChunked)) return true;
@@ -374,7 +479,7 @@ bool HeaderFields::IsTransferEncodingChunked() {
     return false;
 }
 
-int HeaderFields::ContentLength() {
+int HeaderFields::ContentLength() const {
     const char* strContentLength = HeaderField(HeaderFields::KStringContentLength);
     int contentLength = 0;
 
@@ -386,7 +491,7 @@ int HeaderFields::ContentLength() {
 }
 
 
-bool HeaderFields::ContentRange(int* start, int* end, int* total) {
+bool HeaderFields::ContentRange(int* start, int* end, int* total) const {
     // Content-Range: bytes 0-102400/102399
 
     *start = 0;
@@ -430,12 +535,18 @@ bool HeaderFields::ContentRange(int* start, int* end, int* total) {
 }
 
 const std::string HeaderFields::ToStrig() const {
-    if (headers_.empty()) return "";
+    if (0 == count_) return "";
 
     std::string str;
-
-    for (std::map<const std::string, std::string, less>::const_iterator iter = headers_.begin(); iter != headers_.end(); ++iter) {
-        str += iter->first + KStringColon + KStringSpace + iter->second + KStringCRLF;
+    str.reserve(data_.size() + count_ * 2);
+
+    for (size_t i = 0; i < count_; ++i) {
+        const Field& field = __At(i);
+        str += data_.c_str() + field.name;
+        str += KStringColon;
+        str += KStringSpace;
+        str += data_.c_str() + field.value;
+        str += KStringCRLF;
     }
 
     return str;
@@ -604,9 +715,24 @@ bool Builder::HttpToBuffer(AutoBuffer& _http) {
 
 
 // implement of Parser
+static const size_t kFirstLineMax = 8 * 1024;
+static const size_t kHeaderFieldsMax = 128 * 1024;
+static const size_t kChunkLineMax = 8 * 1024;
+
+static bool __IsSpace(char _c) {
+    return ' ' == _c || '\t' == _c || '\r' == _c || '\n' == _c;
+}
+
+static void __Trim(const char*& _begin, const char*& _end) {
+    while (_begin < _end && __IsSpace(*_begin)) ++_begin;
+    while (_end > _begin && __IsSpace(*(_end - 1))) --_end;
+}
+
 Parser::Parser(BodyReceiver* _body, bool _manage)
     : recvstatus_(kStart)
     , csmode_(kRespond)
+    , chunkstatus_(kNoChunk)
+    , body_left_(0)
     , headfields_()
     , bodyreceiver_(_body)
     , is_manage_body_(_manage)
@@ -630,344 +756,244 @@ Parser::TRecvStatus Parser::Recv(const void* _buffer, size_t _length) {
         return recvstatus_;
     }
     
-    recvbuf_.Write(_buffer, _length);
-    
-    while (true) {
+    __Recv((const char*)_buffer, _length);
+    return recvstatus_;
+}
+
+Parser::TRecvStatus Parser::Recv(AutoBuffer& _recv_buffer) {
+
+    if (NULL == _recv_buffer.Ptr() || 0 == _recv_buffer.Length()) {
+        xwarn2(TSF"Recv(%_, %_), status:%_", _recv_buffer.Ptr() , _recv_buffer.Length(), recvstatus_);
+        return recvstatus_;
+    }
+
+    size_t parsed = __Recv((const char*)_recv_buffer.Ptr(), _recv_buffer.Length());
+    _recv_buffer.Move(-(off_t)parsed);
+    return recvstatus_;
+}
+
+size_t Parser::__Recv(const char* _buffer, size_t _length) {
+    const char* pos = _buffer;
+    const char* end = _buffer + _length;
+    const char* line = NULL;
+    size_t linelength = 0;
+
+    while (pos < end) {
         switch (recvstatus_) {
             case kStart:
             case kFirstLine: {
-                char* pBuf = (char*)recvbuf_.Ptr();
-                char* pos = string_strnstr(pBuf, KStringCRLF, (int)recvbuf_.Length());
-                
-                if (NULL == pos && 8 * 1024 < recvbuf_.Length()) {
-                    xerror2(TSF"wrong first line 8k buffer no found CRLF");
-                    recvstatus_ = kFirstLineError;
-                    return recvstatus_;
-                }
-                
-                if (NULL == pos) {
-                    recvstatus_ = kFirstLine;
-                    return recvstatus_;
-                }
-                
-                ptrdiff_t firstlinelength = pos - pBuf + 2;
-                std::string firstline = std::string(pBuf, (size_t)firstlinelength);
-                
-                bool parseFirstlineSuc = false;
-                
-                if (strutil::StartsWith(firstline, "HTTP/")) {
-                    if (statusline_.FromString(firstline)) {
-                        csmode_ = kRespond;
-                        parseFirstlineSuc = true;
-                    }
-                } else {
-                    if (requestline_.FromString(firstline)) {
-                        csmode_ = kRequest;
-                        parseFirstlineSuc = true;
+                recvstatus_ = kFirstLine;
+
+                if (!__Line(pos, end, kFirstLineMax, line, linelength)) {
+                    if (kFirstLineMax < recvbuf_.Length()) {
+                        xerror2(TSF"wrong first line 8k buffer no found CRLF");
+                        recvstatus_ = kFirstLineError;
                     }
+                    return (size_t)(pos - _buffer);
                 }
-                
-                if (!parseFirstlineSuc) {
-                    xerror2(TSF"wrong first line: %0", firstline);
+
+                if (!__FirstLine(line, linelength)) {
+                    xerror2(TSF"wrong first line: %0", std::string(line, linelength));
                     recvstatus_ = kFirstLineError;
-                    return recvstatus_;
+                    return (size_t)(pos - _buffer);
                 }
-                
+
+                recvbuf_.Reset();
                 recvstatus_ = kHeaderFields;
-                recvbuf_.Move(- firstlinelength);
             }
                 break;
-                
+
             case kHeaderFields: {
-                char* pBuf = (char*)recvbuf_.Ptr();
-                char* pos = string_strnstr(pBuf, "\r\n\r\n", (int)recvbuf_.Length());
-                
-                if (NULL == pos && 128 * 1024 < recvbuf_.Length()) {
-                    xerror2(TSF"wrong header fields 128k buffer no found CRLFCRLF");
-                    recvstatus_ = kHeaderFieldsError;
-                    return recvstatus_;
+                if (!__Line(pos, end, kHeaderFieldsMax, line, linelength)) {
+                    if (kHeaderFieldsMax < headerlength_ + recvbuf_.Length()) {
+                        xerror2(TSF"wrong header fields 128k buffer no found CRLFCRLF");
+                        recvstatus_ = kHeaderFieldsError;
+                    }
+                    return (size_t)(pos - _buffer);
                 }
-                
-                if (NULL == pos) return recvstatus_;
-                
-                ptrdiff_t headerslength = pos - pBuf + 4;
-                std::string headers = std::string(pBuf, (size_t)headerslength);
-                
-                bool ret = __ParserHeaders(headers, headfields_);
-                
-                if (false == ret) {
+
+                headerlength_ += linelength;
+                if (kHeaderFieldsMax < headerlength_) {
+                    xerror2(TSF"wrong header fields over 128k, length:%_", headerlength_);
                     recvstatus_ = kHeaderFieldsError;
-                    return recvstatus_;
+                    return (size_t)(pos - _buffer);
                 }
-                
-                recvstatus_ = kBody;
-                recvbuf_.Move(-headerslength);
-            }
-                break;
-                
-            case kBody: {
-                xassert2(bodyreceiver_);
-                
-                if (bodyreceiver_) {
-                    // chunked
-                    
-                    if (headfields_.IsTransferEncodingChunked()) {
-                        char* chunkSizeBegin = (char*)recvbuf_.Ptr();
-                        char* chunkSizeEnd = string_strnstr(chunkSizeBegin, KStringCRLF, (int)recvbuf_.Length());
-                        
-                        if (NULL == chunkSizeEnd) {
-                            return recvstatus_;
-                        }
-                        
-                        std::string strChunkSize = std::string(chunkSizeBegin, chunkSizeEnd);
-                        strutil::Trim(strChunkSize);
-                        
-                        int64_t chunkSize = strtol(strChunkSize.c_str(), NULL, 16);
-                        
-                        ptrdiff_t sizeLen = chunkSizeEnd - chunkSizeBegin;
-                        
-                        if (0 != chunkSize) {
-                            if ((ptrdiff_t)recvbuf_.Length() < chunkSize + sizeLen + 4)  return recvstatus_;
-                            
-                            char* chunkBegin = chunkSizeEnd + 2;
-                            char* chunkEnd = chunkBegin + chunkSize;
-                            
-                            if (*chunkEnd != '\r' || *(chunkEnd + 1) != '\n') {
-                                recvstatus_ = kBodyError;
-                                return recvstatus_;
-                            }
-                            
-                            bodyreceiver_->AppendData(chunkBegin, (size_t)chunkSize);
-                            
-                            recvbuf_.Move(-(chunkEnd - chunkSizeBegin + 2));
-                        } else {  // last chunk
-                            char* trailerBegin = chunkSizeEnd + 2;
-                            
-                            if (recvbuf_.Length() < (unsigned int)(sizeLen + 4)) return recvstatus_;
-                            
-                            char* trailerEnd = string_strnstr(trailerBegin, KStringCRLF, (int)recvbuf_.Length());
-                            
-                            if (NULL == trailerEnd)
-                                return recvstatus_;
-                            
-                            recvstatus_ = kEnd;
-                            bodyreceiver_->EndData();
-                            
-                            
-                            recvbuf_.Move(-(trailerEnd - chunkSizeBegin + 2));
-                        }
-                    } else {  // no chunk
-                        int contentLength = headfields_.ContentLength();
-                        int appendlen = 0;
-                        
-                        if (int(recvbuf_.Length() + bodyreceiver_->Length()) <= contentLength)
-                            appendlen = int(recvbuf_.Length());
-                        else
-                            appendlen = contentLength - int(bodyreceiver_->Length());
-                        
-                        
-                        bodyreceiver_->AppendData(recvbuf_.Ptr(), (size_t)appendlen);
-                        recvbuf_.Move(-appendlen);
-                        
-                        if ((int)bodyreceiver_->Length() == contentLength) {
-                            recvstatus_ = kEnd;
-                            bodyreceiver_->EndData();
-                            return  recvstatus_;
-                        }
-                    }
+
+                const char* lineend = line + linelength;
+                __Trim(line, lineend);
+
+                if (line == lineend) {
+                    recvbuf_.Reset();
+                    __BodyBegin();
+                    if (kEnd == recvstatus_) return (size_t)(pos - _buffer);
+                } else {
+                    __HeaderField(line, (size_t)(lineend - line));
                 }
-                
-                if (0 == recvbuf_.Length())
-                    return recvstatus_;
-            }
-                break;
-                
-            case kEnd: {
-                return recvstatus_;
+
+                recvbuf_.Reset();
             }
                 break;
-                
-            default:
-                break;
-        }
-    }
-    
-    xassert2(false, TSF"status:%_", recvstatus_);
-    return recvstatus_;
-}
 
-    
-Parser::TRecvStatus Parser::Recv(AutoBuffer& _recv_buffer) {
+            case kBody: {
+                xassert2(bodyreceiver_);
 
-    if (NULL == _recv_buffer.Ptr() || 0 == _recv_buffer.Length()) {
-        xwarn2(TSF"Recv(%_, %_), status:%_", _recv_buffer.Ptr() , _recv_buffer.Length(), recvstatus_);
-        return recvstatus_;
-    }
+                if (NULL == bodyreceiver_) return (size_t)(pos - _buffer);
 
+                if (kNoChunk == chunkstatus_ || kChunkData == chunkstatus_) {
+                    size_t appendlen = (size_t)std::min((uint64_t)(end - pos), body_left_);
 
-    while (true) {
-        switch (recvstatus_) {
-        case kStart:
-        case kFirstLine: {
-            char* pBuf = (char*)_recv_buffer.Ptr();
-            char* pos = string_strnstr(pBuf, KStringCRLF, (int)_recv_buffer.Length());
-
-            if (NULL == pos && 8 * 1024 < _recv_buffer.Length()) {
-                xerror2(TSF"wrong first line 8k buffer no found CRLF");
-                recvstatus_ = kFirstLineError;
-                return recvstatus_;
-            }
+                    if (0 < appendlen) bodyreceiver_->AppendData(pos, appendlen);
+                    pos += appendlen;
+                    body_left_ -= appendlen;
 
-            if (NULL == pos) {
-                recvstatus_ = kFirstLine;
-                return recvstatus_;
-            }
+                    if (0 < body_left_) return (size_t)(pos - _buffer);
 
-            ptrdiff_t firstlinelength = pos - pBuf + 2;
-            std::string firstline = std::string(pBuf, (size_t)firstlinelength);
-
-            bool parseFirstlineSuc = false;
+                    if (kNoChunk == chunkstatus_) {
+                        recvstatus_ = kEnd;
+                        bodyreceiver_->EndData();
+                        return (size_t)(pos - _buffer);
+                    }
 
-            if (strutil::StartsWith(firstline, "HTTP/")) {
-                if (statusline_.FromString(firstline)) {
-                    csmode_ = kRespond;
-                    parseFirstlineSuc = true;
+                    chunkstatus_ = kChunkDataEnd;
+                    break;
                 }
-            } else {
-                if (requestline_.FromString(firstline)) {
-                    csmode_ = kRequest;
-                    parseFirstlineSuc = true;
+
+                if (!__Line(pos, end, kChunkLineMax, line, linelength)) {
+                    if (kChunkLineMax < recvbuf_.Length()) {
+                        xerror2(TSF"wrong chunk line 8k buffer no found CRLF");
+                        recvstatus_ = kBodyError;
+                    }
+                    return (size_t)(pos - _buffer);
                 }
-            }
 
-            if (!parseFirstlineSuc) {
-                xerror2(TSF"wrong first line: %0", firstline);
-                recvstatus_ = kFirstLineError;
-                return recvstatus_;
-            }
+                const char* lineend = line + linelength;
+                __Trim(line, lineend);
 
-            recvstatus_ = kHeaderFields;
-            _recv_buffer.Move(- firstlinelength);
-        }
-        break;
+                if (kChunkDataEnd == chunkstatus_) {
+                    // the CRLF right after the data
+                    if (line != lineend) {
+                        recvstatus_ = kBodyError;
+                        return (size_t)(pos - _buffer);
+                    }
+                    recvbuf_.Reset();
+                    chunkstatus_ = kChunkSize;
+                    break;
+                }
 
-        case kHeaderFields: {
-            char* pBuf = (char*)_recv_buffer.Ptr();
-            char* pos = string_strnstr(pBuf, "\r\n\r\n", (int)_recv_buffer.Length());
+                if (kChunkTrailer == chunkstatus_) {
+                    recvbuf_.Reset();
+                    if (line != lineend) break;
 
-            if (NULL == pos && 128 * 1024 < _recv_buffer.Length()) {
-                xerror2(TSF"wrong header fields 128k buffer no found CRLFCRLF");
-                recvstatus_ = kHeaderFieldsError;
-                return recvstatus_;
-            }
+                    recvstatus_ = kEnd;
+                    bodyreceiver_->EndData();
+                    return (size_t)(pos - _buffer);
+                }
 
-            if (NULL == pos) return recvstatus_;
+                // chunk-size [; chunk-ext]
+                uint64_t chunksize = 0;
+                const char* digit = line;
 
-            ptrdiff_t headerslength = pos - pBuf + 4;
-            std::string headers = std::string(pBuf, (size_t)headerslength);
+                for (; digit < lineend && isxdigit((unsigned char)*digit); ++digit) {
+                    chunksize = chunksize * 16 + (uint64_t)(isdigit((unsigned char)*digit) ? *digit - '0' : tolower((unsigned char)*digit) - 'a' + 10);
+                }
 
-            bool ret = __ParserHeaders(headers, headfields_);
+                if (digit == line || 16 < digit - line) {
+                    xerror2(TSF"wrong chunk size line:%_", std::string(line, lineend));
+                    recvstatus_ = kBodyError;
+                    return (size_t)(pos - _buffer);
+                }
 
-            if (false == ret) {
-                recvstatus_ = kHeaderFieldsError;
-                return recvstatus_;
+                recvbuf_.Reset();
+                body_left_ = chunksize;
+                chunkstatus_ = (0 == chunksize) ? kChunkTrailer : kChunkData;
             }
+                break;
 
-            recvstatus_ = kBody;
-            _recv_buffer.Move(-headerslength);
-            headerlength_ = headerslength;
+            case kEnd:
+            default:
+                return (size_t)(pos - _buffer);
         }
-        break;
-
-        case kBody: {
-            xassert2(bodyreceiver_);
-
-            if (bodyreceiver_) {
-                // chunked
-
-                if (headfields_.IsTransferEncodingChunked()) {
-                    char* chunkSizeBegin = (char*)_recv_buffer.Ptr();
-                    char* chunkSizeEnd = string_strnstr(chunkSizeBegin, KStringCRLF, (int)_recv_buffer.Length());
-
-                    if (NULL == chunkSizeEnd) {
-                        return recvstatus_;
-                    }
-
-                    std::string strChunkSize = std::string(chunkSizeBegin, chunkSizeEnd);
-                    strutil::Trim(strChunkSize);
-
-                    int64_t chunkSize = strtol(strChunkSize.c_str(), NULL, 16);
-
-                    ptrdiff_t sizeLen = chunkSizeEnd - chunkSizeBegin;
+    }
 
-                    if (0 != chunkSize) {
-                        if ((ptrdiff_t)_recv_buffer.Length() < chunkSize + sizeLen + 4)  return recvstatus_;
+    return (size_t)(pos - _buffer);
+}
 
-                        char* chunkBegin = chunkSizeEnd + 2;
-                        char* chunkEnd = chunkBegin + chunkSize;
+// a line ended with LF, from _pos if nothing kept in recvbuf_, or else recvbuf_ with the rest of it appended.
+// if no LF, all of them are kept in recvbuf_, up to _max.
+bool Parser::__Line(const char*& _pos, const char* _end, size_t _max, const char*& _line, size_t& _line_length) {
+    const char* lf = (const char*)memchr(_pos, '\n', (size_t)(_end - _pos));
 
-                        if (*chunkEnd != '\r' || *(chunkEnd + 1) != '\n') {
-                            recvstatus_ = kBodyError;
-                            return recvstatus_;
-                        }
+    if (NULL == lf) {
+        if (_max >= recvbuf_.Length()) recvbuf_.Write(_pos, (size_t)std::min((size_t)(_end - _pos), _max + 1 - recvbuf_.Length()));
+        _pos = _end;
+        return false;
+    }
 
-                        bodyreceiver_->AppendData(chunkBegin, (size_t)chunkSize);
+    if (0 == recvbuf_.Length()) {
+        _line = _pos;
+        _line_length = (size_t)(lf + 1 - _pos);
+    } else {
+        recvbuf_.Write(_pos, (size_t)(lf + 1 - _pos));
+        _line = (const char*)recvbuf_.Ptr();
+        _line_length = recvbuf_.Length();
+    }
 
-                        _recv_buffer.Move(-(chunkEnd - chunkSizeBegin + 2));
-                    } else {  // last chunk
-                        char* trailerBegin = chunkSizeEnd + 2;
+    _pos = lf + 1;
+    return true;
+}
 
-                        if (recvbuf_.Length() < (unsigned int)(sizeLen + 4)) return recvstatus_;
+bool Parser::__FirstLine(const char* _line, size_t _length) {
+    std::string firstline(_line, _length);
 
-                        char* trailerEnd = string_strnstr(trailerBegin, KStringCRLF, (int)_recv_buffer.Length());
+    if (strutil::StartsWith(firstline, "HTTP/")) {
+        if (!statusline_.FromString(firstline)) return false;
+        csmode_ = kRespond;
+        return true;
+    }
 
-                        if (NULL == trailerEnd)
-                            return recvstatus_;
+    if (!requestline_.FromString(firstline)) return false;
+    csmode_ = kRequest;
+    return true;
+}
 
-                        recvstatus_ = kEnd;
-                        bodyreceiver_->EndData();
+// name: value, trimmed already
+void Parser::__HeaderField(const char* _line, size_t _length) {
+    const char* lineend = _line + _length;
+    const char* colon = (const char*)memchr(_line, ':', _length);
 
+    if (NULL == colon) return;
 
-                        _recv_buffer.Move(-(trailerEnd - chunkSizeBegin + 2));
-                    }
-                } else {  // no chunk
-                    int contentLength = headfields_.ContentLength();
-                    int appendlen = 0;
+    const char* namebegin = _line;
+    const char* nameend = colon;
+    const char* valuebegin = colon + 1;
+    const char* valueend = lineend;
 
-                    if (int(_recv_buffer.Length() + bodyreceiver_->Length()) <= contentLength)
-                        appendlen = int(_recv_buffer.Length());
-                    else
-                        appendlen = contentLength - int(bodyreceiver_->Length());
+    __Trim(namebegin, nameend);
+    __Trim(valuebegin, valueend);
 
+    if (namebegin == nameend || valuebegin == valueend) return;
 
-                    bodyreceiver_->AppendData(_recv_buffer.Ptr(), (size_t)appendlen);
-                    _recv_buffer.Move(-appendlen);
+    headfields_.HeaderFiled(namebegin, (size_t)(nameend - namebegin), valuebegin, (size_t)(valueend - valuebegin));
+}
 
-                    if ((int)bodyreceiver_->Length() == contentLength) {
-                        recvstatus_ = kEnd;
-                        bodyreceiver_->EndData();
-                        return  recvstatus_;
-                    }
-                }
-            }
+// like before, no Content-Length is an empty body.
+void Parser::__BodyBegin() {
+    recvstatus_ = kBody;
+    body_left_ = 0;
 
-            if (0 == _recv_buffer.Length())
-                return recvstatus_;
-        }
-        break;
+    if (headfields_.IsTransferEncodingChunked()) {
+        chunkstatus_ = kChunkSize;
+        return;
+    }
 
-        case kEnd: {
-            return recvstatus_;
-        }
-        break;
+    chunkstatus_ = kNoChunk;
+    int contentlength = headfields_.ContentLength();
+    body_left_ = 0 < contentlength ? (uint64_t)contentlength : 0;
 
-        default:
-            break;
-        }
-    }
+    if (0 < body_left_) return;
 
-    xassert2(false, TSF"status:%_", recvstatus_);
-    return recvstatus_;
+    recvstatus_ = kEnd;
+    if (bodyreceiver_) bodyreceiver_->EndData();
 }
 
 Parser::TRecvStatus Parser::RecvStatus() const {
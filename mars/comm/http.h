@@ -21,8 +21,10 @@
 #ifndef HTTP_H_
 #define HTTP_H_
 
+#include <stdint.h>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "autobuffer.h"
 
@@ -123,8 +125,16 @@ class StatusLine {
 };
 
 
+/*
+ * the fields in the order they are added, the first one of a name wins like before.
+ * the names and values are kept NUL terminated in one string, and the table inline up to kInlineFields,
+ * so a response costs a couple of allocations instead of a node and two strings for each field.
+ * the names of KString* are interned, their lookups are by index.
+ * a pointer from HeaderField() is good until the next field is added.
+ */
 class HeaderFields {
   public:
+    HeaderFields();
     // HeaderFields(const HeaderFields&);
     // HeaderFields& operator=(const HeaderFields&);
 
@@ -155,20 +165,42 @@ class HeaderFields {
     static const char* const KStringReferer;
 
     void HeaderFiled(const char* _name, const char* _value);
+    void HeaderFiled(const char* _name, size_t _name_length, const char* _value, size_t _value_length);
     void HeaderFiled(const std::pair<const std::string, std::string>& _headerfield);
     void HeaderFiled(const HeaderFields& _headerfields);
     const char* HeaderField(const char* _key) const;
-    std::map<const std::string, std::string, less>& GetHeaders() {return headers_;}
+    size_t Size() const { return count_;}
+    // built on each call, Size() for the count.
+    std::map<const std::string, std::string, less> GetHeaders() const;
 
-    bool IsTransferEncodingChunked();
-    int ContentLength();
+    bool IsTransferEncodingChunked() const;
+    int ContentLength() const;
 
-    bool ContentRange(int* start, int* end, int* total);
+    bool ContentRange(int* start, int* end, int* total) const;
 
     const std::string ToStrig() const;
 
   private:
-    std::map<const std::string, std::string, less> headers_;
+    enum {
+        kInlineFields = 16,
+        kKnownFieldMax = 16,
+    };
+
+    struct Field {
+        int         id;       // of the interned name, -1 if not one of them
+        uint32_t    name;     // offset in data_
+        uint32_t    value;
+    };
+
+    const Field& __At(size_t _index) const;
+    int __Find(const char* _name, size_t _name_length) const;
+
+  private:
+    Field                   fields_[kInlineFields];
+    std::vector<Field>      more_fields_;
+    size_t                  count_;
+    int                     known_[kKnownFieldMax];   // index of the field of each interned name, -1 if none
+    std::string             data_;
 };
 
 class IBlockBodyProvider {
@@ -285,6 +317,10 @@ class MemoryBodyReceiver : public BodyReceiver {
     AutoBuffer& body_;
 };
 
+/*
+ * an incremental parser, the lines are scanned once as they come and only a partial one is kept in recvbuf_,
+ * the body and the chunks go to the BodyReceiver straight from the buffer given to Recv.
+ */
 class Parser {
   public:
     enum TRecvStatus {
@@ -308,6 +344,7 @@ class Parser {
 
   public:
     TRecvStatus Recv(const void* _buffer, size_t _length);
+    // the bytes parsed are moved out of _recv_buffer, the ones after the end of the message are left.
     TRecvStatus Recv(AutoBuffer& _recv_buffer);
     TRecvStatus RecvStatus() const;
 
@@ -329,10 +366,27 @@ class Parser {
     bool Error() const;
     bool Success() const;
 
+  private:
+    enum TChunkStatus {
+        kNoChunk,
+        kChunkSize,
+        kChunkData,
+        kChunkDataEnd,
+        kChunkTrailer,
+    };
+
+    size_t __Recv(const char* _buffer, size_t _length);
+    bool __Line(const char*& _pos, const char* _end, size_t _max, const char*& _line, size_t& _line_length);
+    bool __FirstLine(const char* _line, size_t _length);
+    void __HeaderField(const char* _line, size_t _length);
+    void __BodyBegin();
+
   private:
     TRecvStatus recvstatus_;
-    AutoBuffer    recvbuf_;
+    AutoBuffer    recvbuf_;   // the partial line, no CRLF in it
     TCsMode csmode_;
+    TChunkStatus chunkstatus_;
+    uint64_t body_left_;        // of the content or the chunk
 
     StatusLine statusline_;
     RequestLine requestline_;
@@ -18,9 +18,10 @@
  *      Author: yerungui
  */
 
-#include <map>
 #include <list>
 #include <string>
+#include <vector>
+#include <map>
 #include <algorithm>
 #ifndef _WIN32
 #define __STDC_FORMAT_MACROS
@@ -30,8 +31,10 @@
 #include "boost/bind.hpp"
 
 #include "comm/thread/lock.h"
+#include "comm/thread/atomic_oper.h"
 #include "comm/anr.h"
 #include "comm/messagequeue/message_queue.h"
+#include "comm/messagequeue/message_queue_executor.h"
 #include "comm/time_utils.h"
 #ifdef __APPLE__
 #include "comm/debugger/debugger_utils.h"
@@ -41,14 +44,14 @@
 namespace MessageQueue {
 
 static unsigned int __MakeSeq() {
-    static unsigned int s_seq = 0;
+    static uint32_t s_seq = 0;
 
-    return ++s_seq;
+    return atomic_inc32(&s_seq) + 1;
 }
 
 struct MessageWrapper {
     MessageWrapper(const MessageHandler_t& _handlerid, const Message& _message, const MessageTiming& _timing, unsigned int _seq)
-        : message(_message), timing(_timing) {
+        : message(_message), timing(_timing), due_time(0), order(0), heap_index(0) {
         postid.reg = _handlerid;
         postid.seq = _seq;
         periodstatus = kImmediately;
@@ -72,6 +75,12 @@ struct MessageWrapper {
     TMessageTiming periodstatus;
     uint64_t record_time;
     boost::shared_ptr<Condition> wait_end_cond;
+
+    // scheduling state, owned by MessageQueueContent
+    uint64_t due_time;
+    uint64_t order;
+    size_t heap_index;
+    std::list<MessageWrapper*>::iterator handler_it;
 };
 
 struct HandlerWrapper {
@@ -121,29 +130,197 @@ private:
     
 struct MessageQueueContent {
 public:
-    MessageQueueContent(): breakflag(false), anr_timeout(-1) {}
+    MessageQueueContent(): breakflag(false), anr_timeout(-1), message_order(0), released(false) {}
 
+    // guards everything below, only creating and releasing a queue take the map mutex as well.
+    Mutex mutex;
     MessageHandler_t invoke_reg;
     bool breakflag;
     boost::shared_ptr<RunloopCond> breaker;
-    std::list<MessageWrapper*> lst_message;
+    // pending messages: a min-heap on (due_time, order), the post id index and the per-handler lists in post order.
+    std::vector<MessageWrapper*> heap_message;
+    std::map<unsigned int, MessageWrapper*> index_message;
+    std::map<unsigned int, std::list<MessageWrapper*> > handler_message;
     std::list<HandlerWrapper*> lst_handler;
     int anr_timeout;
+    uint64_t message_order;
+    bool released;
     
     std::list<RunLoopInfo> lst_runloop_info;
 };
 
+static bool __EarlierThan(const MessageWrapper* _lhs, const MessageWrapper* _rhs) {
+    if (_lhs->due_time != _rhs->due_time) return _lhs->due_time < _rhs->due_time;
+    return _lhs->order < _rhs->order;
+}
+
+static void __HeapSet(std::vector<MessageWrapper*>& _heap, size_t _index, MessageWrapper* _wrap) {
+    _heap[_index] = _wrap;
+    _wrap->heap_index = _index;
+}
+
+static void __HeapUp(std::vector<MessageWrapper*>& _heap, size_t _index) {
+    MessageWrapper* wrap = _heap[_index];
+
+    while (0 < _index) {
+        size_t parent = (_index - 1) / 2;
+        if (!__EarlierThan(wrap, _heap[parent])) break;
+        __HeapSet(_heap, _index, _heap[parent]);
+        _index = parent;
+    }
+
+    __HeapSet(_heap, _index, wrap);
+}
+
+static void __HeapDown(std::vector<MessageWrapper*>& _heap, size_t _index) {
+    MessageWrapper* wrap = _heap[_index];
+
+    while (true) {
+        size_t child = _index * 2 + 1;
+        if (child >= _heap.size()) break;
+        if (child + 1 < _heap.size() && __EarlierThan(_heap[child + 1], _heap[child])) ++child;
+        if (!__EarlierThan(_heap[child], wrap)) break;
+        __HeapSet(_heap, _index, _heap[child]);
+        _index = child;
+    }
+
+    __HeapSet(_heap, _index, wrap);
+}
+
+static uint64_t __ComputerDueTime(const MessageWrapper& _wrap) {
+    if (kImmediately == _wrap.timing.type) return ::gettickcount();
+
+    int64_t wait_time = (kPeriod == _wrap.timing.type && kPeriod == _wrap.periodstatus) ? _wrap.timing.period : _wrap.timing.after;
+    return _wrap.record_time + (0 < wait_time ? wait_time : 0);
+}
+
+static void __AddMessage(MessageQueueContent& _content, MessageWrapper* _wrap) {
+    _wrap->due_time = __ComputerDueTime(*_wrap);
+    _wrap->order = ++_content.message_order;
+
+    _content.heap_message.push_back(_wrap);
+    __HeapUp(_content.heap_message, _content.heap_message.size() - 1);
+
+    _content.index_message[_wrap->postid.seq] = _wrap;
+
+    std::list<MessageWrapper*>& lst_message = _content.handler_message[_wrap->postid.reg.seq];
+    _wrap->handler_it = lst_message.insert(lst_message.end(), _wrap);
+}
+
+// takes the message out of the queue, the caller deletes it.
+static void __RemoveMessage(MessageQueueContent& _content, MessageWrapper* _wrap) {
+    std::vector<MessageWrapper*>& heap = _content.heap_message;
+    size_t index = _wrap->heap_index;
+    MessageWrapper* last = heap.back();
+    heap.pop_back();
+
+    if (last != _wrap) {
+        __HeapSet(heap, index, last);
+        if (0 < index && __EarlierThan(last, heap[(index - 1) / 2]))
+            __HeapUp(heap, index);
+        else
+            __HeapDown(heap, index);
+    }
+
+    _content.index_message.erase(_wrap->postid.seq);
+
+    std::map<unsigned int, std::list<MessageWrapper*> >::iterator it = _content.handler_message.find(_wrap->postid.reg.seq);
+    it->second.erase(_wrap->handler_it);
+    if (it->second.empty()) _content.handler_message.erase(it);
+}
+
+// the period message stays in the queue, due again after the period.
+static void __RearmMessage(MessageQueueContent& _content, MessageWrapper* _wrap) {
+    _wrap->record_time = ::gettickcount();
+    _wrap->periodstatus = kPeriod;
+    _wrap->due_time = __ComputerDueTime(*_wrap);
+    __HeapDown(_content.heap_message, _wrap->heap_index);
+}
+
+static MessageWrapper* __FindMessage(MessageQueueContent& _content, const MessagePost_t& _postid) {
+    std::map<unsigned int, MessageWrapper*>::iterator it = _content.index_message.find(_postid.seq);
+    if (_content.index_message.end() == it || _postid != it->second->postid) return NULL;
+    return it->second;
+}
+
+// the earliest posted one, as the handler may have several messages of the same title.
+static MessageWrapper* __FindMessage(MessageQueueContent& _content, const MessageHandler_t& _handlerid, const Message& _message) {
+    std::map<unsigned int, std::list<MessageWrapper*> >::iterator it = _content.handler_message.find(_handlerid.seq);
+    if (_content.handler_message.end() == it) return NULL;
+
+    for (std::list<MessageWrapper*>::iterator wrap = it->second.begin(); wrap != it->second.end(); ++wrap) {
+        if ((*wrap)->postid.reg == _handlerid && (*wrap)->message == _message) return *wrap;
+    }
+
+    return NULL;
+}
+
+// removes the messages of the handler, with the title if _title isn't NULL.
+static void __CancelMessage(MessageQueueContent& _content, const MessageHandler_t& _handlerid, const MessageTitle_t* _title) {
+    std::map<unsigned int, std::list<MessageWrapper*> >::iterator it = _content.handler_message.find(_handlerid.seq);
+    if (_content.handler_message.end() == it) return;
+
+    std::vector<MessageWrapper*> lst_cancel;
+    for (std::list<MessageWrapper*>::iterator wrap = it->second.begin(); wrap != it->second.end(); ++wrap) {
+        if (_handlerid == (*wrap)->postid.reg && (NULL == _title || *_title == (*wrap)->message.title))
+            lst_cancel.push_back(*wrap);
+    }
+
+    for (std::vector<MessageWrapper*>::iterator wrap = lst_cancel.begin(); wrap != lst_cancel.end(); ++wrap) {
+        __RemoveMessage(_content, *wrap);
+        delete(*wrap);
+    }
+}
+
 #define sg_messagequeue_map_mutex messagequeue_map_mutex()
 static Mutex& messagequeue_map_mutex() {
     static Mutex* mutex = new Mutex;
     return *mutex;
 }
 #define sg_messagequeue_map messagequeue_map()
-static std::map<MessageQueue_t, MessageQueueContent>& messagequeue_map() {
-    static std::map<MessageQueue_t, MessageQueueContent>* mq_map = new std::map<MessageQueue_t, MessageQueueContent>;
+static std::map<MessageQueue_t, boost::shared_ptr<MessageQueueContent> >& messagequeue_map() {
+    static std::map<MessageQueue_t, boost::shared_ptr<MessageQueueContent> >* mq_map = new std::map<MessageQueue_t, boost::shared_ptr<MessageQueueContent> >;
     return *mq_map;
 }
 
+static boost::shared_ptr<MessageQueueContent> __FindContent(const MessageQueue_t& _id) {
+    ScopedLock lock(sg_messagequeue_map_mutex);
+    std::map<MessageQueue_t, boost::shared_ptr<MessageQueueContent> >::iterator it = sg_messagequeue_map.find(_id);
+    if (sg_messagequeue_map.end() == it) return boost::shared_ptr<MessageQueueContent>();
+    return it->second;
+}
+
+// the content of a queue with its mutex locked, false if there is no such queue or its runloop has quit.
+class ScopedContent {
+  public:
+    explicit ScopedContent(const MessageQueue_t& _id)
+    : content_(__FindContent(_id)), lock_(content_ ? content_->mutex : __NullMutex(), false) {
+        if (!content_) return;
+
+        lock_.lock();
+        if (content_->released) lock_.unlock();
+    }
+
+    operator bool() const { return lock_.islocked(); }
+    MessageQueueContent* operator->() { return content_.get(); }
+    MessageQueueContent& operator*() { return *content_; }
+    ScopedLock& lock() { return lock_; }
+
+  private:
+    ScopedContent(const ScopedContent&);
+    ScopedContent& operator=(const ScopedContent&);
+
+  private:
+    static Mutex& __NullMutex() {
+        static Mutex* mutex = new Mutex;
+        return *mutex;
+    }
+
+  private:
+    boost::shared_ptr<MessageQueueContent> content_;
+    ScopedLock lock_;
+};
+
 MessageQueue_t CurrentThreadMessageQueue() {
     ScopedLock lock(sg_messagequeue_map_mutex);
     MessageQueue_t id = (MessageQueue_t)ThreadUtil::currentthreadid();
@@ -172,56 +349,54 @@ thread_tid  MessageQueue2TID(MessageQueue_t _id) {
 }
 
 void WaitForRuningLockEnd(const MessagePost_t&  _message) {
+    if (IsExecutorQueue(Handler2Queue(Post2Handler(_message)))) { ExecutorWaitForRuningLockEnd(_message); return; }
     if (Handler2Queue(Post2Handler(_message)) == CurrentThreadMessageQueue()) return;
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
     const MessageQueue_t& id = Handler2Queue(Post2Handler(_message));
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) return;
-    MessageQueueContent& content = sg_messagequeue_map[id];
-    
-    if (content.lst_runloop_info.empty()) return;
+    if (!content) return;
+    if (content->lst_runloop_info.empty()) return;
     
-    auto find_it = std::find_if(content.lst_runloop_info.begin(), content.lst_runloop_info.end(),
+    auto find_it = std::find_if(content->lst_runloop_info.begin(), content->lst_runloop_info.end(),
                                 [&_message](const RunLoopInfo& _v){ return _message == _v.runing_message_id; });
     
-    if (find_it == content.lst_runloop_info.end()) return;
+    if (find_it == content->lst_runloop_info.end()) return;
 
     boost::shared_ptr<Condition> runing_cond = find_it->runing_cond;
-    runing_cond->wait(lock);
+    runing_cond->wait(content.lock());
 }
 
 void WaitForRuningLockEnd(const MessageQueue_t&  _messagequeueid) {
+    ASSERT2(!IsExecutorQueue(_messagequeueid), "%" PRIu64, _messagequeueid);
     if (_messagequeueid == CurrentThreadMessageQueue()) return;
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
     const MessageQueue_t& id = _messagequeueid;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) return;
-    MessageQueueContent& content = sg_messagequeue_map[id];
-
-    if (content.lst_runloop_info.empty()) return;
-    if (KNullPost == content.lst_runloop_info.front().runing_message_id) return;
+    if (!content) return;
+    if (content->lst_runloop_info.empty()) return;
+    if (KNullPost == content->lst_runloop_info.front().runing_message_id) return;
 
-    boost::shared_ptr<Condition> runing_cond = content.lst_runloop_info.front().runing_cond;
-    runing_cond->wait(lock);
+    boost::shared_ptr<Condition> runing_cond = content->lst_runloop_info.front().runing_cond;
+    runing_cond->wait(content.lock());
 }
 
 void WaitForRuningLockEnd(const MessageHandler_t&  _handler) {
+    if (IsExecutorQueue(Handler2Queue(_handler))) { ExecutorWaitForRuningLockEnd(_handler); return; }
     if (Handler2Queue(_handler) == CurrentThreadMessageQueue()) return;
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
     const MessageQueue_t& id = Handler2Queue(_handler);
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) { return; }
-    MessageQueueContent& content = sg_messagequeue_map[id];
-    if (content.lst_runloop_info.empty()) return;
+    if (!content) { return; }
+    if (content->lst_runloop_info.empty()) return;
 
-    for(auto& i : content.lst_runloop_info) {
+    for(auto& i : content->lst_runloop_info) {
         for (auto& x : i.runing_handler) {
             if (_handler==x) {
                 boost::shared_ptr<Condition> runing_cond = i.runing_cond;
-                runing_cond->wait(lock);
+                runing_cond->wait(content.lock());
                 return;
             }
         }
@@ -231,31 +406,31 @@ void WaitForRuningLockEnd(const MessageHandler_t&  _handler) {
 void BreakMessageQueueRunloop(const MessageQueue_t&  _messagequeueid) {
     ASSERT(0 != _messagequeueid);
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
     const MessageQueue_t& id = _messagequeueid;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
+    if (!content) {
         ASSERT2(false, "%" PRIu64, id);
         return;
     }
 
-    sg_messagequeue_map[id].breakflag = true;
-    sg_messagequeue_map[id].breaker->Notify(lock);
+    content->breakflag = true;
+    content->breaker->Notify(content.lock());
 }
 
 MessageHandler_t InstallMessageHandler(const MessageHandler& _handler, bool _recvbroadcast, const MessageQueue_t& _messagequeueid) {
     ASSERT(bool(_handler));
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
     const MessageQueue_t& id = _messagequeueid;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
+    if (!content) {
         ASSERT2(false, "%" PRIu64, id);
         return KNullHandler;
     }
 
     HandlerWrapper* handler = new HandlerWrapper(_handler, _recvbroadcast, _messagequeueid, __MakeSeq());
-    sg_messagequeue_map[id].lst_handler.push_back(handler);
+    content->lst_handler.push_back(handler);
     return handler->reg;
 }
 
@@ -265,87 +440,81 @@ void UnInstallMessageHandler(const MessageHandler_t& _handlerid) {
 
     if (0 == _handlerid.queue || 0 == _handlerid.seq) return;
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
-    const MessageQueue_t& id = _handlerid.queue;
+    if (IsExecutorQueue(_handlerid.queue)) { ExecutorUnInstallHandler(_handlerid); return; }
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) return;
+    const MessageQueue_t& id = _handlerid.queue;
+    ScopedContent content(id);
 
-    MessageQueueContent& content = sg_messagequeue_map[id];
+    if (!content) return;
 
-    for (std::list<HandlerWrapper*>::iterator it = content.lst_handler.begin(); it != content.lst_handler.end(); ++it) {
+    for (std::list<HandlerWrapper*>::iterator it = content->lst_handler.begin(); it != content->lst_handler.end(); ++it) {
         if (_handlerid == (*it)->reg) {
             delete(*it);
-            content.lst_handler.erase(it);
+            content->lst_handler.erase(it);
             break;
         }
     }
 }
 
 MessagePost_t PostMessage(const MessageHandler_t& _handlerid, const Message& _message, const MessageTiming& _timing) {
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    if (IsExecutorQueue(_handlerid.queue)) return ExecutorPostMessage(_handlerid, _message, _timing);
+
     const MessageQueue_t& id = _handlerid.queue;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
+    if (!content) {
         ASSERT2(false, "%" PRIu64, id);
         return KNullPost;
     }
 
-    MessageQueueContent& content = sg_messagequeue_map[id];
-
     MessageWrapper* messagewrapper = new MessageWrapper(_handlerid, _message, _timing, __MakeSeq());
 
-    content.lst_message.push_back(messagewrapper);
-    content.breaker->Notify(lock);
+    __AddMessage(*content, messagewrapper);
+    content->breaker->Notify(content.lock());
     return messagewrapper->postid;
 }
 
 MessagePost_t SingletonMessage(bool _replace, const MessageHandler_t& _handlerid, const Message& _message, const MessageTiming& _timing) {
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    ASSERT2(!IsExecutorQueue(_handlerid.queue), "%" PRIu64, _handlerid.queue);
     const MessageQueue_t& id = _handlerid.queue;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) return KNullPost;
-
-    MessageQueueContent& content = sg_messagequeue_map[id];
+    if (!content) return KNullPost;
 
     MessagePost_t post_id;
+    MessageWrapper* found = __FindMessage(*content, _handlerid, _message);
 
-    for (std::list<MessageWrapper*>::iterator it = content.lst_message.begin(); it != content.lst_message.end(); ++it) {
-        if ((*it)->postid.reg == _handlerid && (*it)->message == _message) {
-            if (_replace) {
-                post_id = (*it)->postid;
-                delete(*it);
-                content.lst_message.erase(it);
-                break;
-            } else {
-                return (*it)->postid;
-            }
-        }
+    if (NULL != found) {
+        if (!_replace) return found->postid;
+
+        post_id = found->postid;
+        __RemoveMessage(*content, found);
+        delete found;
     }
 
     MessageWrapper* messagewrapper = new MessageWrapper(_handlerid, _message, _timing, 0 != post_id.seq ? post_id.seq : __MakeSeq());
-    content.lst_message.push_back(messagewrapper);
-    content.breaker->Notify(lock);
+    __AddMessage(*content, messagewrapper);
+    content->breaker->Notify(content.lock());
     return messagewrapper->postid;
 }
 
 MessagePost_t BroadcastMessage(const MessageQueue_t& _messagequeueid,  const Message& _message, const MessageTiming& _timing) {
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    ASSERT2(!IsExecutorQueue(_messagequeueid), "%" PRIu64, _messagequeueid);
     const MessageQueue_t& id = _messagequeueid;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
+    if (!content) {
         ASSERT2(false, "%" PRIu64, id);
         return KNullPost;
     }
 
-    MessageQueueContent& content = sg_messagequeue_map[id];
-
     MessageHandler_t reg;
     reg.queue = _messagequeueid;
     reg.seq = 0;
     MessageWrapper* messagewrapper = new MessageWrapper(reg, _message, _timing, __MakeSeq());
 
-    content.lst_message.push_back(messagewrapper);
-    content.breaker->Notify(lock);
+    __AddMessage(*content, messagewrapper);
+    content->breaker->Notify(content.lock());
     return messagewrapper->postid;
 }
 
@@ -371,74 +540,66 @@ static int64_t __ComputerWaitTime(const MessageWrapper& _wrap) {
 }
 
 MessagePost_t FasterMessage(const MessageHandler_t& _handlerid, const Message& _message, const MessageTiming& _timing) {
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    ASSERT2(!IsExecutorQueue(_handlerid.queue), "%" PRIu64, _handlerid.queue);
     const MessageQueue_t& id = _handlerid.queue;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) return KNullPost;
-
-    MessageQueueContent& content = sg_messagequeue_map[id];
+    if (!content) return KNullPost;
 
     MessageWrapper* messagewrapper = new MessageWrapper(_handlerid, _message, _timing, __MakeSeq());
 
-    for (std::list<MessageWrapper*>::iterator it = content.lst_message.begin(); it != content.lst_message.end(); ++it) {
-        if ((*it)->postid.reg == _handlerid && (*it)->message == _message) {
-            if (__ComputerWaitTime(**it) < __ComputerWaitTime(*messagewrapper)) {
-                delete messagewrapper;
-                return (*it)->postid;
-            }
+    MessageWrapper* found = __FindMessage(*content, _handlerid, _message);
 
-            messagewrapper->postid = (*it)->postid;
-            delete(*it);
-            content.lst_message.erase(it);
-            break;
+    if (NULL != found) {
+        if (__ComputerWaitTime(*found) < __ComputerWaitTime(*messagewrapper)) {
+            delete messagewrapper;
+            return found->postid;
         }
+
+        messagewrapper->postid = found->postid;
+        __RemoveMessage(*content, found);
+        delete found;
     }
 
-    content.lst_message.push_back(messagewrapper);
-    content.breaker->Notify(lock);
+    __AddMessage(*content, messagewrapper);
+    content->breaker->Notify(content.lock());
     return messagewrapper->postid;
 }
 
 bool WaitMessage(const MessagePost_t& _message) {
+    if (IsExecutorQueue(Handler2Queue(Post2Handler(_message)))) return ExecutorWaitMessage(_message);
+
     bool is_in_mq = Handler2Queue(Post2Handler(_message)) == CurrentThreadMessageQueue();
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
     const MessageQueue_t& id = Handler2Queue(Post2Handler(_message));
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) return false;
-    MessageQueueContent& content = sg_messagequeue_map[id];
+    ScopedContent content(id);
+    if (!content) return false;
 
-    auto find_it = std::find_if(content.lst_message.begin(), content.lst_message.end(),
-                                [&_message](const MessageWrapper * const &_v) {
-                                    return _message == _v->postid;
-                                });
+    MessageWrapper* found = __FindMessage(*content, _message);
     
-    if (find_it == content.lst_message.end()) {
-        auto find_it = std::find_if(content.lst_runloop_info.begin(), content.lst_runloop_info.end(),
+    if (NULL == found) {
+        auto find_it = std::find_if(content->lst_runloop_info.begin(), content->lst_runloop_info.end(),
                      [&_message](const RunLoopInfo& _v){ return _message == _v.runing_message_id; });
         
-        if (find_it != content.lst_runloop_info.end()) {
+        if (find_it != content->lst_runloop_info.end()) {
             if (is_in_mq) return false;
             
             boost::shared_ptr<Condition> runing_cond = find_it->runing_cond;
-            runing_cond->wait(lock);
+            runing_cond->wait(content.lock());
         }
     } else {
         
         if (is_in_mq) {
-            lock.unlock();
-            RunLoop( [&_message](){
-                        MessageQueueContent& content = sg_messagequeue_map[Handler2Queue(Post2Handler(_message))];
-                        return content.lst_message.end() == std::find_if(content.lst_message.begin(), content.lst_message.end(),
-                                                                [&_message](const MessageWrapper *  const &_v) {
-                                                                    return _message == _v->postid;
-                                                                });
+            content.lock().unlock();
+            RunLoop( [&content, &_message](){
+                        return NULL == __FindMessage(*content, _message);
             }).Run();
             
         } else {
-            if (!((*find_it)->wait_end_cond))(*find_it)->wait_end_cond = boost::make_shared<Condition>();
+            if (!(found->wait_end_cond)) found->wait_end_cond = boost::make_shared<Condition>();
 
-            boost::shared_ptr<Condition> wait_end_cond = (*find_it)->wait_end_cond;
-            wait_end_cond->wait(lock);
+            boost::shared_ptr<Condition> wait_end_cond = found->wait_end_cond;
+            wait_end_cond->wait(content.lock());
         }
     }
 
@@ -446,23 +607,20 @@ bool WaitMessage(const MessagePost_t& _message) {
 }
 
 bool FoundMessage(const MessagePost_t& _message) {
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    if (IsExecutorQueue(Handler2Queue(Post2Handler(_message)))) return ExecutorFoundMessage(_message);
+
     const MessageQueue_t& id = Handler2Queue(Post2Handler(_message));
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) return false;
-    MessageQueueContent& content = sg_messagequeue_map[id];
-    if (content.lst_runloop_info.empty()) return false;
+    if (!content) return false;
+    if (content->lst_runloop_info.empty()) return false;
 
-    auto find_it = std::find_if(content.lst_runloop_info.begin(), content.lst_runloop_info.end(),
+    auto find_it = std::find_if(content->lst_runloop_info.begin(), content->lst_runloop_info.end(),
                                 [&_message](const RunLoopInfo& _v){ return _message == _v.runing_message_id; });
     
-    if (find_it != content.lst_runloop_info.end())  { return true; }
+    if (find_it != content->lst_runloop_info.end())  { return true; }
 
-    for (std::list<MessageWrapper*>::iterator it = content.lst_message.begin(); it != content.lst_message.end(); ++it) {
-        if (_message == (*it)->postid) { return true;}
-    }
-
-    return false;
+    return NULL != __FindMessage(*content, _message);
 }
 
 bool CancelMessage(const MessagePost_t& _postid) {
@@ -472,25 +630,22 @@ bool CancelMessage(const MessagePost_t& _postid) {
     // 0==_postid.reg.seq for BroadcastMessage
     if (0 == _postid.reg.queue || 0 == _postid.seq) return false;
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    if (IsExecutorQueue(_postid.reg.queue)) return ExecutorCancelMessage(_postid);
+
     const MessageQueue_t& id = _postid.reg.queue;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
+    if (!content) {
         ASSERT2(false, "%" PRIu64, id);
         return false;
     }
 
-    MessageQueueContent& content = sg_messagequeue_map[id];
-
-    for (std::list<MessageWrapper*>::iterator it = content.lst_message.begin(); it != content.lst_message.end(); ++it) {
-        if (_postid == (*it)->postid) {
-            delete(*it);
-            content.lst_message.erase(it);
-            return true;
-        }
-    }
+    MessageWrapper* found = __FindMessage(*content, _postid);
+    if (NULL == found) return false;
 
-    return false;
+    __RemoveMessage(*content, found);
+    delete found;
+    return true;
 }
 
 void CancelMessage(const MessageHandler_t& _handlerid) {
@@ -499,24 +654,17 @@ void CancelMessage(const MessageHandler_t& _handlerid) {
     // 0==_handlerid.seq for BroadcastMessage
     if (0 == _handlerid.queue) return;
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    if (IsExecutorQueue(_handlerid.queue)) { ExecutorCancelMessage(_handlerid, NULL); return; }
+
     const MessageQueue_t& id = _handlerid.queue;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
+    if (!content) {
         //        ASSERT2(false, "%lu", id);
         return;
     }
 
-    MessageQueueContent& content = sg_messagequeue_map[id];
-
-    for (std::list<MessageWrapper*>::iterator it = content.lst_message.begin(); it != content.lst_message.end();) {
-        if (_handlerid == (*it)->postid.reg) {
-            delete(*it);
-            it = content.lst_message.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    __CancelMessage(*content, _handlerid, NULL);
 }
 
 void CancelMessage(const MessageHandler_t& _handlerid, const MessageTitle_t& _title) {
@@ -525,36 +673,28 @@ void CancelMessage(const MessageHandler_t& _handlerid, const MessageTitle_t& _ti
     // 0==_handlerid.seq for BroadcastMessage
     if (0 == _handlerid.queue) return;
 
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    if (IsExecutorQueue(_handlerid.queue)) { ExecutorCancelMessage(_handlerid, &_title); return; }
+
     const MessageQueue_t& id = _handlerid.queue;
+    ScopedContent content(id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
+    if (!content) {
         ASSERT2(false, "%" PRIu64, id);
         return;
     }
 
-    MessageQueueContent& content = sg_messagequeue_map[id];
-
-    for (std::list<MessageWrapper*>::iterator it = content.lst_message.begin(); it != content.lst_message.end();) {
-        if (_handlerid == (*it)->postid.reg && _title == (*it)->message.title) {
-            delete(*it);
-            it = content.lst_message.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    __CancelMessage(*content, _handlerid, &_title);
 }
     
 const Message& RuningMessage() {
     MessageQueue_t id = (MessageQueue_t)ThreadUtil::currentthreadid();
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    ScopedContent content(id);
     
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
+    if (!content) {
         return KNullMessage;
     }
     
-    MessageQueueContent& content = sg_messagequeue_map[id];
-    return *(content.lst_runloop_info.back().runing_message);
+    return *(content->lst_runloop_info.back().runing_message);
 }
     
 MessagePost_t RuningMessageID() {
@@ -563,14 +703,14 @@ MessagePost_t RuningMessageID() {
 }
 
 MessagePost_t RuningMessageID(const MessageQueue_t& _id) {
-    ScopedLock lock(sg_messagequeue_map_mutex);
+    ASSERT2(!IsExecutorQueue(_id), "%" PRIu64, _id);
+    ScopedContent content(_id);
 
-    if (sg_messagequeue_map.end() == sg_messagequeue_map.find(_id)) {
+    if (!content) {
         return KNullPost;
     }
 
-    MessageQueueContent& content = sg_messagequeue_map[_id];
-    return content.lst_runloop_info.back().runing_message_id;
+    return content->lst_runloop_info.back().runing_message_id;
 }
 
 static void __AsyncInvokeHandler(const MessagePost_t& _id, Message& _message) {
@@ -579,6 +719,7 @@ static void __AsyncInvokeHandler(const MessagePost_t& _id, Message& _message) {
 
 MessageHandler_t InstallAsyncHandler(const MessageQueue_t& id) {
     ASSERT(0 != id);
+    if (IsExecutorQueue(id)) return ExecutorInstallAsyncHandler(id);
     return InstallMessageHandler(__AsyncInvokeHandler, false, id);
 }
     
@@ -589,60 +730,65 @@ static MessageQueue_t __CreateMessageQueueInfo(boost::shared_ptr<RunloopCond>& _
     MessageQueue_t id = (MessageQueue_t)_tid;
 
     if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) {
-        MessageQueueContent& content = sg_messagequeue_map[id];
+        boost::shared_ptr<MessageQueueContent> content = boost::make_shared<MessageQueueContent>();
+        sg_messagequeue_map[id] = content;
         HandlerWrapper* handler = new HandlerWrapper(&__AsyncInvokeHandler, false, id, __MakeSeq());
-        content.lst_handler.push_back(handler);
-        content.invoke_reg = handler->reg;
-        content.anr_timeout = _anr_timeout;
+        content->lst_handler.push_back(handler);
+        content->invoke_reg = handler->reg;
+        content->anr_timeout = _anr_timeout;
         if (_breaker)
-            content.breaker = _breaker;
+            content->breaker = _breaker;
         else
-            content.breaker = boost::make_shared<Cond>();
-        content.breakflag = false;
+            content->breaker = boost::make_shared<Cond>();
+        content->breakflag = false;
     }
 
     return id;
 }
     
-static void __ReleaseMessageQueueInfo() {
+// called by the runloop with the content locked, the queue is gone for everyone from now on.
+static void __ReleaseMessageQueueInfo(MessageQueueContent& _content) {
 
     MessageQueue_t id = (MessageQueue_t)ThreadUtil::currentthreadid();
 
-    if (sg_messagequeue_map.end() != sg_messagequeue_map.find(id)) {
-        MessageQueueContent& content = sg_messagequeue_map[id];
+    for (std::vector<MessageWrapper*>::iterator it = _content.heap_message.begin(); it != _content.heap_message.end(); ++it) {
+        delete(*it);
+    }
 
-        for (std::list<MessageWrapper*>::iterator it = content.lst_message.begin(); it != content.lst_message.end(); ++it) {
-            delete(*it);
-        }
+    for (std::list<HandlerWrapper*>::iterator it = _content.lst_handler.begin(); it != _content.lst_handler.end(); ++it) {
+        delete(*it);
+    }
 
-        for (std::list<HandlerWrapper*>::iterator it = content.lst_handler.begin(); it != content.lst_handler.end(); ++it) {
-            delete(*it);
-        }
+    _content.heap_message.clear();
+    _content.index_message.clear();
+    _content.handler_message.clear();
+    _content.lst_handler.clear();
+    _content.released = true;
 
-        sg_messagequeue_map.erase(id);
-    }
+    ScopedLock lock(sg_messagequeue_map_mutex);
+    sg_messagequeue_map.erase(id);
 }
 
 void RunLoop::Run() {
     MessageQueue_t id = CurrentThreadMessageQueue();
     ASSERT(0 != id);
+    boost::shared_ptr<MessageQueueContent> content = __FindContent(id);
     {
-        ScopedLock lock(sg_messagequeue_map_mutex);
-        sg_messagequeue_map[id].lst_runloop_info.push_back(RunLoopInfo());
+        ScopedLock lock(content->mutex);
+        content->lst_runloop_info.push_back(RunLoopInfo());
     }
 
     while (true) {
-        ScopedLock lock(sg_messagequeue_map_mutex);
-        MessageQueueContent& content = sg_messagequeue_map[id];
-        content.lst_runloop_info.back().runing_message_id = KNullPost;
-        content.lst_runloop_info.back().runing_message = NULL;
-        content.lst_runloop_info.back().runing_handler.clear();
-        content.lst_runloop_info.back().runing_cond->notifyAll(lock);
-
-        if ((content.breakflag || (breaker_func_ && breaker_func_()))) {
-            content.lst_runloop_info.pop_back();
-            if (content.lst_runloop_info.empty())
-                __ReleaseMessageQueueInfo();
+        ScopedLock lock(content->mutex);
+        content->lst_runloop_info.back().runing_message_id = KNullPost;
+        content->lst_runloop_info.back().runing_message = NULL;
+        content->lst_runloop_info.back().runing_handler.clear();
+        content->lst_runloop_info.back().runing_cond->notifyAll(lock);
+
+        if ((content->breakflag || (breaker_func_ && breaker_func_()))) {
+            content->lst_runloop_info.pop_back();
+            if (content->lst_runloop_info.empty())
+                __ReleaseMessageQueueInfo(*content);
             break;
         }
 
@@ -650,70 +796,41 @@ void RunLoop::Run() {
         MessageWrapper* messagewrapper = NULL;
         bool delmessage = true;
 
-        for (std::list<MessageWrapper*>::iterator it = content.lst_message.begin(); it != content.lst_message.end(); ++it) {
-            if (kImmediately == (*it)->timing.type) {
-                messagewrapper = *it;
-                content.lst_message.erase(it);
-                break;
-            } else if (kAfter == (*it)->timing.type) {
-                int64_t time_cost = ::gettickspan((*it)->record_time);
-
-                if ((*it)->timing.after <= time_cost) {
-                    messagewrapper = *it;
-                    content.lst_message.erase(it);
-                    break;
-                } else {
-                    wait_time = std::min(wait_time, (*it)->timing.after - time_cost);
-                }
-            } else if (kPeriod == (*it)->timing.type) {
-                if (kAfter == (*it)->periodstatus) {
-                    int64_t time_cost = ::gettickspan((*it)->record_time);
-
-                    if ((*it)->timing.after <= time_cost) {
-                        messagewrapper = *it;
-                        (*it)->record_time = ::gettickcount();
-                        (*it)->periodstatus = kPeriod;
-                        delmessage = false;
-                        break;
-                    } else {
-                        wait_time = std::min(wait_time, (*it)->timing.after - time_cost);
-                    }
-                } else if (kPeriod == (*it)->periodstatus) {
-                    int64_t time_cost = ::gettickspan((*it)->record_time);
-
-                    if ((*it)->timing.period <= time_cost) {
-                        messagewrapper = *it;
-                        (*it)->record_time = ::gettickcount();
-                        delmessage = false;
-                        break;
-                    } else {
-                        wait_time = std::min(wait_time, (*it)->timing.period - time_cost);
-                    }
+        if (!content->heap_message.empty()) {
+            MessageWrapper* earliest = content->heap_message.front();
+            uint64_t now = ::gettickcount();
+
+            if (earliest->due_time <= now) {
+                messagewrapper = earliest;
+
+                if (kPeriod == earliest->timing.type) {
+                    __RearmMessage(*content, earliest);
+                    delmessage = false;
                 } else {
-                    ASSERT(false);
+                    __RemoveMessage(*content, earliest);
                 }
             } else {
-                ASSERT(false);
+                wait_time = std::min(wait_time, (int64_t)(earliest->due_time - now));
             }
         }
 
         if (NULL == messagewrapper) {
-            content.breaker->Wait(lock, (long)wait_time);
+            content->breaker->Wait(lock, (long)wait_time);
             continue;
         }
 
         std::list<HandlerWrapper> fit_handler;
 
-        for (std::list<HandlerWrapper*>::iterator it = content.lst_handler.begin(); it != content.lst_handler.end(); ++it) {
+        for (std::list<HandlerWrapper*>::iterator it = content->lst_handler.begin(); it != content->lst_handler.end(); ++it) {
             if (messagewrapper->postid.reg == (*it)->reg || ((*it)->recvbroadcast && messagewrapper->postid.reg.isbroadcast())) {
                 fit_handler.push_back(**it);
-                content.lst_runloop_info.back().runing_handler.push_back((*it)->reg);
+                content->lst_runloop_info.back().runing_handler.push_back((*it)->reg);
             }
         }
 
-        content.lst_runloop_info.back().runing_message_id = messagewrapper->postid;
-        content.lst_runloop_info.back().runing_message = &messagewrapper->message;
-        int anr_timeout = content.anr_timeout;
+        content->lst_runloop_info.back().runing_message_id = messagewrapper->postid;
+        content->lst_runloop_info.back().runing_message = &messagewrapper->message;
+        int anr_timeout = content->anr_timeout;
         lock.unlock();
 
         for (std::list<HandlerWrapper>::iterator it = fit_handler.begin(); it != fit_handler.end(); ++it) {
@@ -739,8 +856,7 @@ boost::shared_ptr<RunloopCond> RunloopCond::CurrentCond() {
     MessageQueue_t id = (MessageQueue_t)ThreadUtil::currentthreadid();
     
     if (sg_messagequeue_map.end() != sg_messagequeue_map.find(id)) {
-        MessageQueueContent& content = sg_messagequeue_map[id];
-        return content.breaker;
+        return sg_messagequeue_map[id]->breaker;
     } else {
         return boost::shared_ptr<RunloopCond>();
     }
@@ -841,13 +957,14 @@ MessageQueue_t GetDefTaskQueue() {
 }
 
 MessageHandler_t DefAsyncInvokeHandler(const MessageQueue_t& _messagequeue) {
+    if (IsExecutorQueue(_messagequeue)) return ExecutorDefAsyncInvokeHandler(_messagequeue);
+
     ScopedLock lock(sg_messagequeue_map_mutex);
     const MessageQueue_t& id = _messagequeue;
 
     if (sg_messagequeue_map.end() == sg_messagequeue_map.find(id)) return KNullHandler;
 
-    MessageQueueContent& content = sg_messagequeue_map[id];
-    return content.invoke_reg;
+    return sg_messagequeue_map[id]->invoke_reg;
 }
 
 }  // namespace MessageQueue
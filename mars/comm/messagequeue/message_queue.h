@@ -142,6 +142,7 @@ MessagePost_t    RuningMessageID();
 MessagePost_t    RuningMessageID(const MessageQueue_t& _id);
 MessageQueue_t   GetDefMessageQueue();
 MessageQueue_t   GetDefTaskQueue();
+MessageQueue_t   GetDefExecutor();
 MessageHandler_t DefAsyncInvokeHandler(const MessageQueue_t& _messagequeue = CurrentThreadMessageQueue());
 
 void WaitForRuningLockEnd(const MessagePost_t&  _message);
@@ -261,6 +262,32 @@ class MessageQueueCreater {
     boost::shared_ptr<RunloopCond>   breaker_;
 };
 
+/*
+ * _workers threads behind one MessageQueue_t, for the cpu bound work posted by AsyncInvoke, AsyncResult and WaitInvoke.
+ * each worker runs the messages of its own deque, and steals from the back of the others once it's empty.
+ * the messages of the same title run one at a time in the post order, the ones titled 0 in any order and at the same time.
+ * immediate messages to the handlers of DefAsyncInvokeHandler or InstallAsyncHandler only, no broadcast nor RunLoop,
+ * nor SingletonMessage, FasterMessage, RuningMessageID and WaitForRuningLockEnd(queue), which assert on its id.
+ * a worker waiting for a message of its executor runs that one itself if it's still pending, or blocks till it ends,
+ * so don't wait on all the workers for the messages they haven't taken yet.
+ */
+class MessageQueueExecutor {
+  public:
+    explicit MessageQueueExecutor(int _workers, const char* _executor_name = NULL);
+    ~MessageQueueExecutor();
+
+    MessageQueue_t GetMessageQueue() const;
+    // the pending messages are cancelled and the running ones waited for, not to be called by a worker.
+    void CancelAndWait();
+
+  private:
+    MessageQueueExecutor(const MessageQueueExecutor&);
+    MessageQueueExecutor& operator=(const MessageQueueExecutor&);
+
+  private:
+    MessageQueue_t                      messagequeue_id_;
+};
+
 template <typename R>
 class AsyncResult {
   private:
@@ -517,7 +544,8 @@ template <typename R>
 bool  WaitInvoke(const AsyncResult<R>& _func, const MessageHandler_t& _handlerid = DefAsyncInvokeHandler()) {
     
     if (CurrentThreadMessageQueue() == Handler2Queue(_handlerid)) {
-        _func();
+        AsyncResult<R> func(_func);  // a copy shares the result, operator() isn't const
+        func();
         return (bool)(_func);
     } else {
         WaitMessage(AsyncInvoke(_func, _handlerid));
@@ -0,0 +1,597 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * message_queue_executor.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include "comm/messagequeue/message_queue_executor.h"
+
+#include <deque>
+#include <list>
+#include <map>
+#include <vector>
+#ifndef _WIN32
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#include "boost/bind.hpp"
+
+#include "comm/assert/__assert.h"
+#include "comm/thread/atomic_oper.h"
+#include "comm/thread/condition.h"
+#include "comm/thread/lock.h"
+#include "comm/thread/thread.h"
+
+namespace MessageQueue {
+
+namespace {
+
+static const int kExecutorWorkerMax = 8;
+
+enum TTaskStatus {
+    kTaskPending,
+    kTaskRunning,
+    kTaskCancelled,
+};
+
+struct Task {
+    Task(): status(kTaskPending), runner(0) {}
+
+    MessagePost_t       postid;
+    Message             message;
+    volatile uint32_t   status;     // pending to running by the worker, to cancelled by CancelMessage, whoever first
+    thread_tid          runner;
+};
+
+class Executor {
+  public:
+    Executor(MessageQueue_t _id, int _workers, const char* _name)
+    : id_(_id), stop_(false), handler_seq_(0), post_seq_(0), next_worker_(0), sleeping_(0), waiting_(0) {
+        for (int i = 0; i < _workers; ++i) {
+            workers_.push_back(new Worker(boost::bind(&Executor::__Run, this, i), _name));
+        }
+
+        invoke_reg_ = InstallAsyncHandler();
+    }
+
+    ~Executor() {
+        for (std::vector<Worker*>::iterator it = workers_.begin(); it != workers_.end(); ++it) {
+            delete (*it);
+        }
+    }
+
+    bool Start() {
+        for (std::vector<Worker*>::iterator it = workers_.begin(); it != workers_.end(); ++it) {
+            if (0 != (*it)->thread.start()) return false;
+        }
+
+        return true;
+    }
+
+    void Stop() {
+        ASSERT2(0 > __CurrentWorker(), "executor %" PRIu64 " stopped by its worker", id_);
+
+        std::vector<Task*> cancelled;
+        ScopedLock lock(mutex_);
+        stop_ = true;
+        __Cancel(NULL, NULL, cancelled);
+        cond_.notifyAll(lock);
+        lock.unlock();
+
+        __Delete(cancelled);
+
+        for (std::vector<Worker*>::iterator it = workers_.begin(); it != workers_.end(); ++it) {
+            (*it)->thread.join();
+        }
+    }
+
+    MessageHandler_t InstallAsyncHandler() {
+        ScopedLock lock(mutex_);
+        MessageHandler_t handler;
+        handler.queue = id_;
+        handler.seq = ++handler_seq_;
+        handlers_[handler.seq] = true;
+        return handler;
+    }
+
+    void UnInstallHandler(const MessageHandler_t& _handlerid) {
+        ScopedLock lock(mutex_);
+        handlers_.erase(_handlerid.seq);
+    }
+
+    const MessageHandler_t& DefAsyncInvokeHandler() const {
+        return invoke_reg_;
+    }
+
+    MessagePost_t Post(const MessageHandler_t& _handlerid, const Message& _message, const MessageTiming& _timing) {
+        if (kImmediately != _timing.type) {
+            ASSERT2(false, "executor %" PRIu64 " takes immediate messages only", id_);
+            return KNullPost;
+        }
+
+        if (NULL == boost::any_cast<boost::shared_ptr<AsyncInvokeFunction> >(&_message.body1)) {
+            ASSERT2(false, "executor %" PRIu64 " takes AsyncInvoke messages only", id_);
+            return KNullPost;
+        }
+
+        int worker = __CurrentWorker();
+        ScopedLock lock(mutex_);
+
+        if (stop_ || handlers_.end() == handlers_.find(_handlerid.seq)) return KNullPost;
+
+        Task* task = new Task;
+        task->postid.reg = _handlerid;
+        task->postid.seq = ++post_seq_;
+        task->message = _message;
+        index_[task->postid.seq] = task;
+
+        // one at a time for a title, the others wait in its lane till the one before ends.
+        if (0 != _message.title.title) {
+            std::map<uintptr_t, std::list<Task*> >::iterator lane = lanes_.find(_message.title.title);
+
+            if (lanes_.end() != lane) {
+                lane->second.push_back(task);
+                return task->postid;
+            }
+
+            lanes_[_message.title.title];
+        }
+
+        __Push(0 <= worker ? worker : (next_worker_++ % workers_.size()), task);
+        return task->postid;
+    }
+
+    bool Wait(const MessagePost_t& _message) {
+        int worker = __CurrentWorker();
+        ScopedLock lock(mutex_);
+
+        while (true) {
+            std::map<unsigned int, Task*>::iterator it = index_.find(_message.seq);
+            if (index_.end() == it || _message != it->second->postid) return true;
+
+            Task* task = it->second;
+
+            if (0 > worker) {
+                ++waiting_;
+                done_cond_.wait(lock);
+                --waiting_;
+                continue;
+            }
+
+            if (kTaskRunning == task->status && ThreadUtil::currentthreadid() == task->runner) return false;
+            // it's after one of the same title this thread is running, which doesn't end before the wait.
+            if (kTaskPending == task->status && __RunningTitle(task->message.title.title, ThreadUtil::currentthreadid())) return false;
+
+            // a worker runs the awaited one itself if it's still in a deque, or the one of its title before it,
+            // but never an unrelated one on its stack, which could take a lock the caller holds.
+            Task* awaited = kTaskPending == task->status ? __Remove(task) : NULL;
+
+            if (NULL != awaited) {
+                lock.unlock();
+                __Execute(worker, awaited);
+                lock.lock();
+                continue;
+            }
+
+            ++waiting_;
+            done_cond_.wait(lock);
+            --waiting_;
+        }
+    }
+
+    bool Found(const MessagePost_t& _message) {
+        ScopedLock lock(mutex_);
+        std::map<unsigned int, Task*>::iterator it = index_.find(_message.seq);
+        return index_.end() != it && _message == it->second->postid;
+    }
+
+    bool Cancel(const MessagePost_t& _postid) {
+        std::vector<Task*> cancelled;
+        ScopedLock lock(mutex_);
+
+        std::map<unsigned int, Task*>::iterator it = index_.find(_postid.seq);
+        if (index_.end() == it || _postid != it->second->postid) return false;
+        if (!__Cancel(it->second, cancelled)) return false;
+
+        lock.unlock();
+        __Delete(cancelled);
+        return true;
+    }
+
+    void Cancel(const MessageHandler_t& _handlerid, const MessageTitle_t* _title) {
+        std::vector<Task*> cancelled;
+        ScopedLock lock(mutex_);
+        __Cancel(&_handlerid, _title, cancelled);
+        lock.unlock();
+        __Delete(cancelled);
+    }
+
+    // for the ones run by the other threads, it's the caller of the one of its own.
+    void WaitRunning(const MessageHandler_t* _handlerid, const MessagePost_t* _message) {
+        thread_tid self = ThreadUtil::currentthreadid();
+        ScopedLock lock(mutex_);
+
+        while (true) {
+            bool running = false;
+
+            for (std::map<unsigned int, Task*>::iterator it = index_.begin(); it != index_.end() && !running; ++it) {
+                Task* task = it->second;
+                if (kTaskRunning != task->status || self == task->runner) continue;
+                if (NULL != _handlerid && *_handlerid != task->postid.reg) continue;
+                if (NULL != _message && *_message != task->postid) continue;
+                running = true;
+            }
+
+            if (!running) return;
+
+            ++waiting_;
+            done_cond_.wait(lock);
+            --waiting_;
+        }
+    }
+
+  private:
+    Executor(const Executor&);
+    Executor& operator=(const Executor&);
+
+    struct Worker {
+        Worker(const boost::function<void ()>& _run, const char* _name): thread(_run, _name) {}
+
+        Mutex               mutex;
+        std::deque<Task*>   tasks;
+        Thread              thread;
+    };
+
+    int __CurrentWorker() const {
+        thread_tid self = ThreadUtil::currentthreadid();
+
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            if (workers_[i]->thread.isruning() && self == workers_[i]->thread.tid()) return (int)i;
+        }
+
+        return -1;
+    }
+
+    // with mutex_ locked.
+    void __Push(size_t _worker, Task* _task) {
+        ScopedLock lock(workers_[_worker]->mutex);
+        workers_[_worker]->tasks.push_back(_task);
+        lock.unlock();
+
+        if (0 < sleeping_) cond_.notifyOne();
+    }
+
+    // its own from the front, the others' from the back.
+    Task* __Take(size_t _worker) {
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            Worker* worker = workers_[(_worker + i) % workers_.size()];
+            ScopedLock lock(worker->mutex);
+
+            if (worker->tasks.empty()) continue;
+
+            Task* task = NULL;
+
+            if (0 == i) {
+                task = worker->tasks.front();
+                worker->tasks.pop_front();
+            } else {
+                task = worker->tasks.back();
+                worker->tasks.pop_back();
+            }
+
+            return task;
+        }
+
+        return NULL;
+    }
+
+    // with mutex_ locked, out of the deque it's in, or the one of its title there if it's still in the lane.
+    Task* __Remove(Task* _task) {
+        uintptr_t title = _task->message.title.title;
+
+        for (std::vector<Worker*>::iterator it = workers_.begin(); it != workers_.end(); ++it) {
+            ScopedLock lock((*it)->mutex);
+
+            for (std::deque<Task*>::iterator task = (*it)->tasks.begin(); task != (*it)->tasks.end(); ++task) {
+                if (_task != *task && (0 == title || title != (*task)->message.title.title)) continue;
+
+                Task* found = *task;
+                (*it)->tasks.erase(task);
+                return found;
+            }
+        }
+
+        return NULL;
+    }
+
+    // with mutex_ locked.
+    bool __HasTask() {
+        for (std::vector<Worker*>::iterator it = workers_.begin(); it != workers_.end(); ++it) {
+            ScopedLock lock((*it)->mutex);
+            if (!(*it)->tasks.empty()) return true;
+        }
+
+        return false;
+    }
+
+    // with mutex_ locked.
+    bool __RunningTitle(uintptr_t _title, thread_tid _runner) {
+        if (0 == _title) return false;
+
+        for (std::map<unsigned int, Task*>::iterator it = index_.begin(); it != index_.end(); ++it) {
+            Task* task = it->second;
+            if (kTaskRunning == task->status && _runner == task->runner && _title == task->message.title.title) return true;
+        }
+
+        return false;
+    }
+
+    void __Execute(size_t _worker, Task* _task) {
+        _task->runner = ThreadUtil::currentthreadid();
+
+        if (kTaskPending == atomic_cas32(&_task->status, kTaskRunning, kTaskPending)) {
+            (*boost::any_cast<boost::shared_ptr<AsyncInvokeFunction> >(_task->message.body1))();
+        }
+
+        ScopedLock lock(mutex_);
+
+        // a cancelled one has been taken out of the index by CancelMessage.
+        if (kTaskCancelled != _task->status) index_.erase(_task->postid.seq);
+
+        if (0 != _task->message.title.title) {
+            std::map<uintptr_t, std::list<Task*> >::iterator lane = lanes_.find(_task->message.title.title);
+            ASSERT(lanes_.end() != lane);
+
+            if (lane->second.empty()) {
+                lanes_.erase(lane);
+            } else {
+                __Push(_worker, lane->second.front());
+                lane->second.pop_front();
+            }
+        }
+
+        if (0 < waiting_) done_cond_.notifyAll();
+        lock.unlock();
+
+        // the function may be an AsyncResult calling back from its destructor.
+        delete _task;
+    }
+
+    void __Run(int _worker) {
+        while (true) {
+            Task* task = __Take(_worker);
+
+            if (NULL != task) {
+                __Execute(_worker, task);
+                continue;
+            }
+
+            ScopedLock lock(mutex_);
+            if (__HasTask()) continue;
+            if (stop_) break;
+
+            ++sleeping_;
+            cond_.wait(lock);
+            --sleeping_;
+        }
+    }
+
+    // with mutex_ locked, false if it's running. the ones in a lane are appended to _cancelled for the caller to delete,
+    // the one in a deque is deleted by the worker taking it.
+    bool __Cancel(Task* _task, std::vector<Task*>& _cancelled) {
+        if (kTaskPending != atomic_cas32(&_task->status, kTaskCancelled, kTaskPending)) return false;
+
+        index_.erase(_task->postid.seq);
+
+        if (0 == _task->message.title.title) return true;
+
+        std::list<Task*>& lane = lanes_[_task->message.title.title];
+
+        for (std::list<Task*>::iterator it = lane.begin(); it != lane.end(); ++it) {
+            if (_task != *it) continue;
+            lane.erase(it);
+            _cancelled.push_back(_task);
+            break;
+        }
+
+        return true;
+    }
+
+    // with mutex_ locked, all of them if _handlerid is NULL.
+    void __Cancel(const MessageHandler_t* _handlerid, const MessageTitle_t* _title, std::vector<Task*>& _cancelled) {
+        std::vector<Task*> found;
+
+        for (std::map<unsigned int, Task*>::iterator it = index_.begin(); it != index_.end(); ++it) {
+            if (NULL != _handlerid && *_handlerid != it->second->postid.reg) continue;
+            if (NULL != _title && *_title != it->second->message.title) continue;
+            found.push_back(it->second);
+        }
+
+        for (std::vector<Task*>::iterator it = found.begin(); it != found.end(); ++it) {
+            __Cancel(*it, _cancelled);
+        }
+    }
+
+    static void __Delete(std::vector<Task*>& _tasks) {
+        for (std::vector<Task*>::iterator it = _tasks.begin(); it != _tasks.end(); ++it) {
+            delete (*it);
+        }
+
+        _tasks.clear();
+    }
+
+  private:
+    const MessageQueue_t                                id_;
+    std::vector<Worker*>                                workers_;
+    MessageHandler_t                                    invoke_reg_;
+
+    Mutex                                               mutex_;     // all below, before the mutex of a worker
+    Condition                                           cond_;      // for the idle workers
+    Condition                                           done_cond_; // for the ones waiting for a message
+    bool                                                stop_;
+    std::map<unsigned int, bool>                        handlers_;
+    unsigned int                                        handler_seq_;
+    unsigned int                                        post_seq_;
+    size_t                                              next_worker_;
+    int                                                 sleeping_;
+    int                                                 waiting_;
+
+    std::map<unsigned int, Task*>                       index_;     // the pending and running ones by the post seq
+    std::map<uintptr_t, std::list<Task*> >              lanes_;     // the title with one pending or running -> the ones after it
+};
+
+}
+
+#define sg_executor_map_mutex executor_map_mutex()
+static Mutex& executor_map_mutex() {
+    static Mutex* mutex = new Mutex;
+    return *mutex;
+}
+#define sg_executor_map executor_map()
+static std::map<MessageQueue_t, boost::shared_ptr<Executor> >& executor_map() {
+    static std::map<MessageQueue_t, boost::shared_ptr<Executor> >* map = new std::map<MessageQueue_t, boost::shared_ptr<Executor> >;
+    return *map;
+}
+
+static boost::shared_ptr<Executor> __FindExecutor(const MessageQueue_t& _id) {
+    ScopedLock lock(sg_executor_map_mutex);
+    std::map<MessageQueue_t, boost::shared_ptr<Executor> >::iterator it = sg_executor_map.find(_id);
+    if (sg_executor_map.end() == it) return boost::shared_ptr<Executor>();
+    return it->second;
+}
+
+static int __CPUCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return 0 < count ? count : 1;
+}
+
+MessageQueueExecutor::MessageQueueExecutor(int _workers, const char* _executor_name)
+: messagequeue_id_(KInvalidQueueID) {
+    ASSERT(0 < _workers);
+
+    static uint32_t s_seq = 0;
+    MessageQueue_t id = ((MessageQueue_t)(atomic_inc32(&s_seq) + 1) << 1) | 1;
+
+    boost::shared_ptr<Executor> executor = boost::make_shared<Executor>(id, 0 < _workers ? _workers : 1, _executor_name);
+
+    ScopedLock lock(sg_executor_map_mutex);
+    sg_executor_map[id] = executor;
+    lock.unlock();
+
+    messagequeue_id_ = id;
+
+    if (!executor->Start()) {
+        ASSERT2(false, "executor %" PRIu64 " start fail", id);
+        CancelAndWait();
+    }
+}
+
+MessageQueueExecutor::~MessageQueueExecutor() {
+    CancelAndWait();
+}
+
+MessageQueue_t MessageQueueExecutor::GetMessageQueue() const {
+    return messagequeue_id_;
+}
+
+void MessageQueueExecutor::CancelAndWait() {
+    ScopedLock lock(sg_executor_map_mutex);
+    std::map<MessageQueue_t, boost::shared_ptr<Executor> >::iterator it = sg_executor_map.find(messagequeue_id_);
+    if (sg_executor_map.end() == it) return;
+
+    boost::shared_ptr<Executor> executor = it->second;
+    sg_executor_map.erase(it);
+    lock.unlock();
+
+    executor->Stop();
+}
+
+MessageQueue_t GetDefExecutor() {
+    static MessageQueueExecutor* s_defexecutor = new MessageQueueExecutor(kExecutorWorkerMax < __CPUCount() ? kExecutorWorkerMax : __CPUCount(), "def_executor");
+    return s_defexecutor->GetMessageQueue();
+}
+
+MessageHandler_t ExecutorInstallAsyncHandler(const MessageQueue_t& _id) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_id);
+    if (!executor) return KNullHandler;
+    return executor->InstallAsyncHandler();
+}
+
+void ExecutorUnInstallHandler(const MessageHandler_t& _handlerid) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_handlerid.queue);
+    if (executor) executor->UnInstallHandler(_handlerid);
+}
+
+MessageHandler_t ExecutorDefAsyncInvokeHandler(const MessageQueue_t& _id) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_id);
+    if (!executor) return KNullHandler;
+    return executor->DefAsyncInvokeHandler();
+}
+
+MessagePost_t ExecutorPostMessage(const MessageHandler_t& _handlerid, const Message& _message, const MessageTiming& _timing) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_handlerid.queue);
+
+    if (!executor) {
+        ASSERT2(false, "%" PRIu64, _handlerid.queue);
+        return KNullPost;
+    }
+
+    return executor->Post(_handlerid, _message, _timing);
+}
+
+bool ExecutorWaitMessage(const MessagePost_t& _message) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_message.reg.queue);
+    if (!executor) return false;
+    return executor->Wait(_message);
+}
+
+bool ExecutorFoundMessage(const MessagePost_t& _message) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_message.reg.queue);
+    if (!executor) return false;
+    return executor->Found(_message);
+}
+
+bool ExecutorCancelMessage(const MessagePost_t& _postid) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_postid.reg.queue);
+    if (!executor) return false;
+    return executor->Cancel(_postid);
+}
+
+void ExecutorCancelMessage(const MessageHandler_t& _handlerid, const MessageTitle_t* _title) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_handlerid.queue);
+    if (executor) executor->Cancel(_handlerid, _title);
+}
+
+void ExecutorWaitForRuningLockEnd(const MessagePost_t& _message) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_message.reg.queue);
+    if (executor) executor->WaitRunning(NULL, &_message);
+}
+
+void ExecutorWaitForRuningLockEnd(const MessageHandler_t& _handler) {
+    boost::shared_ptr<Executor> executor = __FindExecutor(_handler.queue);
+    if (executor) executor->WaitRunning(&_handler, NULL);
+}
+
+}  // namespace MessageQueue
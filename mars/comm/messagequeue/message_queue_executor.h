@@ -0,0 +1,45 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * message_queue_executor.h
+ *
+ *  Created on: 2026-10-17
+ */
+
+#ifndef MESSAGEQUEUE_EXECUTOR_H_
+#define MESSAGEQUEUE_EXECUTOR_H_
+
+#include "comm/messagequeue/message_queue.h"
+
+namespace MessageQueue {
+
+// for message_queue.cc, the calls with the queue id of a MessageQueueExecutor go to it.
+// the id of an executor has the lowest bit set, a thread id never has.
+inline bool IsExecutorQueue(const MessageQueue_t& _id) { return 0 != (_id & 1); }
+
+MessageHandler_t ExecutorInstallAsyncHandler(const MessageQueue_t& _id);
+void ExecutorUnInstallHandler(const MessageHandler_t& _handlerid);
+MessageHandler_t ExecutorDefAsyncInvokeHandler(const MessageQueue_t& _id);
+
+MessagePost_t ExecutorPostMessage(const MessageHandler_t& _handlerid, const Message& _message, const MessageTiming& _timing);
+bool ExecutorWaitMessage(const MessagePost_t& _message);
+bool ExecutorFoundMessage(const MessagePost_t& _message);
+bool ExecutorCancelMessage(const MessagePost_t& _postid);
+// all titles if _title is NULL.
+void ExecutorCancelMessage(const MessageHandler_t& _handlerid, const MessageTitle_t* _title);
+void ExecutorWaitForRuningLockEnd(const MessagePost_t& _message);
+void ExecutorWaitForRuningLockEnd(const MessageHandler_t& _handler);
+
+}  // namespace MessageQueue
+
+#endif  // MESSAGEQUEUE_EXECUTOR_H_
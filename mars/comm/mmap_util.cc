@@ -49,6 +49,28 @@ bool OpenMmapFile(const char* _filepath, unsigned int _size, boost::iostreams::m
     bool file_exist = boost::filesystem::exists(_filepath);
     if (!file_exist) {
         param.new_file_size = _size;
+    } else {
+        // a file created with a smaller size, grow it with zero data and keep what it holds.
+        // a short file would be mapped short, so it is not opened at all if it can't grow.
+        boost::system::error_code ec;
+        uintmax_t file_size = boost::filesystem::file_size(_filepath, ec);
+        if (!ec && file_size < _size) {
+            FILE* file = fopen(_filepath, "ab");
+            if (NULL == file) {
+                return false;
+            }
+
+            size_t grow_size = (size_t)(_size - file_size);
+            char* zero_data = new char[grow_size];
+            memset(zero_data, 0, grow_size);
+            bool grown = (grow_size == fwrite(zero_data, sizeof(char), grow_size, file));
+            grown = (0 == fclose(file)) && grown;
+            delete[] zero_data;
+
+            if (!grown) {
+                return false;
+            }
+        }
     }
 
     _mmmap_file.open(param);
@@ -26,6 +26,8 @@
 #include "comm/socket/socketselect.h"
 #include "comm/socket/tcpclient_fsm.h"
 #include "comm/socket/socket_address.h"
+#include "comm/socket/ipv6_address_utils.h"
+#include "comm/thread/lock.h"
 #include "comm/time_utils.h"
 #include "comm/platform_comm.h"
 
@@ -34,12 +36,12 @@ namespace COMPLEX_CONNECT_NAMESPACE {
 #endif
     
 ComplexConnect::ComplexConnect(unsigned int _timeout, unsigned int _interval)
-    : timeout_(_timeout), interval_(_interval), error_interval_(_interval), max_connect_(3), trycount_(0), index_(-1), errcode_(0)
+    : timeout_(_timeout), interval_(_interval), error_interval_(_interval), max_connect_(3), racing_(false), trycount_(0), index_(-1), errcode_(0)
     , index_conn_rtt_(0), index_conn_totalcost_(0), totalcost_(0)
 {}
 
 ComplexConnect::ComplexConnect(unsigned int _timeout /*ms*/, unsigned int _interval /*ms*/, unsigned int _error_interval /*ms*/, unsigned int _max_connect)
-    : timeout_(_timeout), interval_(_interval), error_interval_(_error_interval), max_connect_(_max_connect),  trycount_(0), index_(-1), errcode_(0)
+    : timeout_(_timeout), interval_(_interval), error_interval_(_error_interval), max_connect_(_max_connect), racing_(false), trycount_(0), index_(-1), errcode_(0)
     , index_conn_rtt_(0), index_conn_totalcost_(0), totalcost_(0)
 {}
 
@@ -56,6 +58,111 @@ int ComplexConnect::__ConnectTimeout(unsigned int _index) const {
 
 namespace {
 
+static const int kRacingIntervalMin = 100;
+static const int kRacingIntervalDefault = 250;
+
+enum TAddrFamily {
+    kFamilyV4,
+    kFamilyV6,
+    kFamilyNAT64,
+    kFamilyCount,
+};
+
+// a nat64 address of a prefix other than the well known one counts as v6.
+static TAddrFamily __Family(const socket_address& _addr) {
+    if (AF_INET6 != _addr.address().sa_family) return kFamilyV4;
+
+    in6_addr addr6 = ((const sockaddr_in6&)_addr.address()).sin6_addr;
+    if (IN6_IS_ADDR_V4MAPPED(&addr6)) return kFamilyV4;
+    if (IN6_IS_ADDR_NAT64(&addr6)) return kFamilyNAT64;
+    return kFamilyV6;
+}
+
+// the connect rtts and failures of each family, from all the ComplexConnects.
+class FamilyRecord {
+  public:
+    FamilyRecord() {
+        for (int i = 0; i < kFamilyCount; ++i) {
+            srtt_[i] = 0;
+            rttvar_[i] = 0;
+            failed_[i] = false;
+        }
+    }
+
+    void OnConnected(TAddrFamily _family, int _rtt) {
+        ScopedLock lock(mutex_);
+        failed_[_family] = false;
+
+        if (0 == srtt_[_family]) {
+            srtt_[_family] = _rtt;
+            rttvar_[_family] = _rtt / 2;
+            return;
+        }
+
+        rttvar_[_family] = (3 * rttvar_[_family] + std::abs(srtt_[_family] - _rtt)) / 4;
+        srtt_[_family] = (7 * srtt_[_family] + _rtt) / 8;
+    }
+
+    void OnFailed(TAddrFamily _family) {
+        ScopedLock lock(mutex_);
+        failed_[_family] = true;
+    }
+
+    bool Failed(TAddrFamily _family) {
+        ScopedLock lock(mutex_);
+        return failed_[_family];
+    }
+
+    int Interval(TAddrFamily _family, int _max) {
+        ScopedLock lock(mutex_);
+
+        if (0 == srtt_[_family]) return std::min(kRacingIntervalDefault, _max);
+        return std::min(std::max(srtt_[_family] + 4 * rttvar_[_family], kRacingIntervalMin), _max);
+    }
+
+  private:
+    Mutex mutex_;
+    int srtt_[kFamilyCount];
+    int rttvar_[kFamilyCount];
+    bool failed_[kFamilyCount];
+};
+
+static FamilyRecord sg_family_record;
+
+// the families in the order they first come in _vecaddr, the failed ones last, then one address of each in turn.
+static std::vector<unsigned int> __RacingOrder(const std::vector<socket_address>& _vecaddr) {
+    std::vector<std::vector<unsigned int> > families;
+    std::vector<TAddrFamily> family_types;
+
+    for (unsigned int i = 0; i < _vecaddr.size(); ++i) {
+        TAddrFamily family = __Family(_vecaddr[i]);
+        size_t pos = std::find(family_types.begin(), family_types.end(), family) - family_types.begin();
+
+        if (family_types.size() == pos) {
+            family_types.push_back(family);
+            families.push_back(std::vector<unsigned int>());
+        }
+
+        families[pos].push_back(i);
+    }
+
+    std::vector<std::vector<unsigned int> > ordered;
+    for (int failed = 0; failed < 2; ++failed) {
+        for (size_t i = 0; i < families.size(); ++i) {
+            if ((0 != failed) == sg_family_record.Failed(family_types[i])) ordered.push_back(families[i]);
+        }
+    }
+
+    std::vector<unsigned int> order;
+    for (size_t round = 0; order.size() < _vecaddr.size(); ++round) {
+        for (size_t i = 0; i < ordered.size(); ++i) {
+            if (round < ordered[i].size()) order.push_back(ordered[i][round]);
+        }
+    }
+
+    return order;
+}
+
 class ConnectCheckFSM : public TcpClientFSM {
   public:
     enum TCheckStatus {
@@ -132,6 +239,13 @@ class ConnectCheckFSM : public TcpClientFSM {
 static bool __isconnecting(const ConnectCheckFSM* _ref) { return NULL != _ref && INVALID_SOCKET != _ref->Socket(); }
 }
 
+int ComplexConnect::__NextInterval(int _lasterror, const socket_address* _last) const {
+    if (!racing_) return (int)((0 == _lasterror) ? interval_ : error_interval_);
+    if (0 != _lasterror || NULL == _last) return 0;
+
+    return sg_family_record.Interval(__Family(*_last), (int)interval_);
+}
+
 SOCKET ComplexConnect::ConnectImpatient(const std::vector<socket_address>& _vecaddr, SocketSelectBreaker& _breaker, MComplexConnect* _observer) {
     trycount_ = 0;
     index_ = -1;
@@ -145,15 +259,22 @@ SOCKET ComplexConnect::ConnectImpatient(const std::vector<socket_address>& _veca
         return INVALID_SOCKET;
     }
 
-    xinfo2(TSF"_vecaddr size:%_, m_timeout:%_, m_interval:%_, m_error_interval:%_, m_max_connect:%_, @%_", _vecaddr.size(), timeout_, interval_, error_interval_, max_connect_, this);
+    xinfo2(TSF"_vecaddr size:%_, m_timeout:%_, m_interval:%_, m_error_interval:%_, m_max_connect:%_, m_racing:%_, @%_", _vecaddr.size(), timeout_, interval_, error_interval_, max_connect_, racing_, this);
     
     uint64_t  starttime = gettickcount();
     std::vector<ConnectCheckFSM*> vecsocketfsm;
+    std::vector<unsigned int> order;    // the index in _vecaddr of vecsocketfsm[i]
 
-    for (unsigned int i = 0; i < _vecaddr.size(); ++i) {
-        xinfo2(TSF"complex.conn %_", _vecaddr[i].url());
+    if (racing_) {
+        order = __RacingOrder(_vecaddr);
+    } else {
+        for (unsigned int i = 0; i < _vecaddr.size(); ++i) order.push_back(i);
+    }
+
+    for (unsigned int i = 0; i < order.size(); ++i) {
+        xinfo2(TSF"complex.conn %_", _vecaddr[order[i]].url());
 
-        ConnectCheckFSM* ic = new ConnectCheckFSM(_vecaddr[i], timeout_, i, _observer);
+        ConnectCheckFSM* ic = new ConnectCheckFSM(_vecaddr[order[i]], timeout_, order[i], _observer);
         vecsocketfsm.push_back(ic);
     }
 
@@ -172,7 +293,8 @@ SOCKET ComplexConnect::ConnectImpatient(const std::vector<socket_address>& _veca
         SocketSelect sel(_breaker);
         sel.PreSelect();
 
-        int next_connect_timeout = int(((0 == lasterror) ? interval_ : error_interval_) - (curtime - laststart_connecttime));
+        const socket_address* last = 0 < index ? &_vecaddr[order[index - 1]] : NULL;
+        int next_connect_timeout = int(__NextInterval(lasterror, last) - (int64_t)(curtime - laststart_connecttime));
 
         int timeout = (int)timeout_;
         unsigned int runing_count = (unsigned int)std::count_if(vecsocketfsm.begin(), vecsocketfsm.end(), &__isconnecting);
@@ -187,7 +309,7 @@ SOCKET ComplexConnect::ConnectImpatient(const std::vector<socket_address>& _veca
         if (index < vecsocketfsm.size()
                 && 0 >= next_connect_timeout
                 && runing_count < max_connect_) {
-            if (runing_count + 1 < max_connect_) timeout = std::min(timeout, (int)interval_);
+            if (runing_count + 1 < max_connect_) timeout = std::min(timeout, __NextInterval(0, &_vecaddr[order[index]]));
 
             laststart_connecttime = gettickcount();
             lasterror = 0;
@@ -201,7 +323,7 @@ SOCKET ComplexConnect::ConnectImpatient(const std::vector<socket_address>& _veca
 
             xgroup2_define(group);
             vecsocketfsm[i]->PreSelect(sel, group);
-            xgroup2_if(!group.Empty(), TSF"index:%_, @%_, ", i, this) << group;
+            xgroup2_if(!group.Empty(), TSF"index:%_, @%_, ", order[i], this) << group;
             timeout = std::min(timeout, vecsocketfsm[i]->Timeout());
         }
 
@@ -238,10 +360,12 @@ SOCKET ComplexConnect::ConnectImpatient(const std::vector<socket_address>& _veca
 
             xgroup2_define(group);
             vecsocketfsm[i]->AfterSelect(sel, group);
-            xgroup2_if(!group.Empty(), TSF"index:%_, @%_, ", i, this) << group;
+            xgroup2_if(!group.Empty(), TSF"index:%_, @%_, ", order[i], this) << group;
 
             if (TcpClientFSM::EEnd == vecsocketfsm[i]->Status()) {
-                if (_observer) _observer->OnFinished(i, socket_address(&vecsocketfsm[i]->Address()), vecsocketfsm[i]->Socket(), vecsocketfsm[i]->Error(),
+                // failed to connect, not the verify
+                if (TcpClientFSM::EReadWrite != vecsocketfsm[i]->LastStatus()) sg_family_record.OnFailed(__Family(_vecaddr[order[i]]));
+                if (_observer) _observer->OnFinished(order[i], socket_address(&vecsocketfsm[i]->Address()), vecsocketfsm[i]->Socket(), vecsocketfsm[i]->Error(),
                                                          vecsocketfsm[i]->Rtt(), vecsocketfsm[i]->TotalRtt(), (int)(gettickcount() - starttime));
 
                 vecsocketfsm[i]->Close();
@@ -252,7 +376,7 @@ SOCKET ComplexConnect::ConnectImpatient(const std::vector<socket_address>& _veca
             }
 
             if (TcpClientFSM::EReadWrite == vecsocketfsm[i]->Status() && ConnectCheckFSM::ECheckFail == vecsocketfsm[i]->CheckStatus()) {
-                if (_observer) _observer->OnFinished(i, socket_address(&vecsocketfsm[i]->Address()), vecsocketfsm[i]->Socket(), vecsocketfsm[i]->Error(),
+                if (_observer) _observer->OnFinished(order[i], socket_address(&vecsocketfsm[i]->Address()), vecsocketfsm[i]->Socket(), vecsocketfsm[i]->Error(),
                                                          vecsocketfsm[i]->Rtt(), vecsocketfsm[i]->TotalRtt(), (int)(gettickcount() - starttime));
 
                 vecsocketfsm[i]->Close();
@@ -263,13 +387,14 @@ SOCKET ComplexConnect::ConnectImpatient(const std::vector<socket_address>& _veca
             }
 
             if (TcpClientFSM::EReadWrite == vecsocketfsm[i]->Status() && ConnectCheckFSM::ECheckOK == vecsocketfsm[i]->CheckStatus()) {
-                if (_observer) _observer->OnFinished(i, socket_address(&vecsocketfsm[i]->Address()), vecsocketfsm[i]->Socket(), vecsocketfsm[i]->Error(),
+                sg_family_record.OnConnected(__Family(_vecaddr[order[i]]), vecsocketfsm[i]->Rtt());
+                if (_observer) _observer->OnFinished(order[i], socket_address(&vecsocketfsm[i]->Address()), vecsocketfsm[i]->Socket(), vecsocketfsm[i]->Error(),
                                                          vecsocketfsm[i]->Rtt(), vecsocketfsm[i]->TotalRtt(), (int)(gettickcount() - starttime));
 
-                xinfo2(TSF"index:%_, sock:%_, suc ConnectImpatient:%_:%_, RTT:(%_, %_), @%_", i, vecsocketfsm[i]->Socket(),
+                xinfo2(TSF"index:%_, sock:%_, suc ConnectImpatient:%_:%_, RTT:(%_, %_), @%_", order[i], vecsocketfsm[i]->Socket(),
                        vecsocketfsm[i]->IP(), vecsocketfsm[i]->Port(), vecsocketfsm[i]->Rtt(), vecsocketfsm[i]->TotalRtt(), this);
                 retsocket = vecsocketfsm[i]->Socket();
-                index_ = i;
+                index_ = order[i];
                 index_conn_rtt_ = vecsocketfsm[i]->Rtt();
                 index_conn_totalcost_ = vecsocketfsm[i]->TotalRtt();
                 vecsocketfsm[i]->Socket(INVALID_SOCKET);
@@ -59,6 +59,14 @@ class ComplexConnect {
 
     SOCKET ConnectImpatient(const std::vector<socket_address>& _vecaddr, SocketSelectBreaker& _breaker, MComplexConnect* _observer = NULL);
 
+    /*
+     * happy eyeballs(rfc 8305) like racing, off by default.
+     * the addresses are tried with the v4, v6 and nat64 ones interleaved, the family failed since its last success goes last.
+     * the next one starts once the one before failed, or after an interval from the connect rtts of its family, at most _interval.
+     * the indexes of Index() and MComplexConnect are still the ones of _vecaddr.
+     */
+    void Racing(bool _racing) { racing_ = _racing;}
+
     unsigned int TryCount() const { return trycount_;}
     int Index() const { return index_;}
     int ErrorCode() const { return errcode_;}
@@ -70,6 +78,7 @@ class ComplexConnect {
   private:
     int __ConnectTime(unsigned int _index) const;
     int __ConnectTimeout(unsigned int _index) const;
+    int __NextInterval(int _lasterror, const socket_address* _last) const;
 
   private:
     ComplexConnect(const ComplexConnect&);
@@ -80,6 +89,7 @@ class ComplexConnect {
     const unsigned int interval_;
     const unsigned int error_interval_;
     const unsigned int max_connect_;
+    bool racing_;
 
     unsigned int trycount_;  // tried ip count
     int index_;  // used ip index
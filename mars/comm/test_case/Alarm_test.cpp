@@ -0,0 +1,212 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * Alarm_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "boost/bind.hpp"
+
+#include "comm/alarm.h"
+#include "comm/messagequeue/message_queue.h"
+#include "comm/time_utils.h"
+#include "comm/timing_wheel.h"
+
+namespace
+{
+
+struct TestTimer : TimingWheel::Timer
+{
+	uint64_t due;
+	bool fired;
+};
+
+static int sg_count = 0;
+
+static void count()
+{
+	++sg_count;
+}
+
+static void fire(std::vector<uint64_t>* _fired, int _i)
+{
+	(*_fired)[_i] = ::gettickcount();
+}
+
+// posts an empty message and waits for it, the alarms due before it have been handled then.
+static void wait_for(const MessageQueue::MessageHandler_t& _handler, int64_t _after)
+{
+	MessageQueue::WaitMessage(MessageQueue::AsyncInvokeAfter(_after, &count, _handler));
+}
+
+}
+
+TEST(Alarm_test, timing_wheel_expire)
+{
+	const uint64_t start = 1000;
+	TimingWheel wheel(start);
+	std::vector<TestTimer> timers(3000);
+	srand(1);
+
+	for (size_t i = 0; i < timers.size(); ++i)
+	{
+		// up to 2^31ms, the farther ones are placed again by the top level
+		uint64_t after = (i % 3 == 0) ? rand() % 100 : (i % 3 == 1) ? rand() % 100000 : ((uint64_t)rand() << 16 | rand()) % ((uint64_t)1 << 31);
+		timers[i].due = start + after;
+		timers[i].fired = false;
+		wheel.Add(&timers[i], timers[i].due);
+	}
+
+	EXPECT_EQ(timers.size(), wheel.Size());
+
+	uint64_t now = start;
+	std::vector<TimingWheel::Timer*> expired;
+
+	while (0 < wheel.Size())
+	{
+		now += 1 + (uint64_t)rand() % (rand() % 2 ? 50 : 50000000);
+		wheel.Advance(now, expired);
+
+		for (size_t i = 0; i < expired.size(); ++i)
+		{
+			TestTimer* timer = static_cast<TestTimer*>(expired[i]);
+			EXPECT_FALSE(timer->fired);
+			EXPECT_FALSE(timer->IsAdded());
+			EXPECT_LE(timer->due, now);
+			if (0 < i) EXPECT_LE(expired[i - 1]->expire, timer->expire);
+			timer->fired = true;
+		}
+
+		expired.clear();
+
+		// none of the due ones left behind
+		for (size_t i = 0; i < timers.size(); ++i)
+			ASSERT_TRUE(timers[i].fired || timers[i].due > now);
+	}
+}
+
+TEST(Alarm_test, timing_wheel_remove_and_next_tick)
+{
+	TimingWheel wheel(0);
+	EXPECT_EQ(~(uint64_t)0, wheel.NextTick());
+
+	TestTimer near_timer, far_timer, late_timer;
+	wheel.Add(&near_timer, 10);
+	wheel.Add(&far_timer, 300000);
+	wheel.Add(&late_timer, 0);    // at or before Now(), due at the next tick
+	EXPECT_EQ(3u, wheel.Size());
+	EXPECT_EQ(1u, wheel.NextTick());
+
+	wheel.Remove(&late_timer);
+	wheel.Remove(&late_timer);
+	EXPECT_FALSE(late_timer.IsAdded());
+	EXPECT_EQ(2u, wheel.Size());
+	EXPECT_EQ(10u, wheel.NextTick());
+
+	// added again is moved
+	wheel.Add(&near_timer, 20);
+	EXPECT_EQ(2u, wheel.Size());
+	EXPECT_EQ(20u, wheel.NextTick());
+	wheel.Remove(&near_timer);
+
+	// the far one is cascaded down a level at a time, never after it's due
+	std::vector<TimingWheel::Timer*> expired;
+	int steps = 0;
+
+	while (expired.empty())
+	{
+		uint64_t next = wheel.NextTick();
+		ASSERT_LE(next, 300000u);
+		wheel.Advance(next, expired);
+		++steps;
+	}
+
+	EXPECT_EQ(300000u, wheel.Now());
+	EXPECT_GE(TimingWheel::kLevels, steps);
+	EXPECT_EQ(&far_timer, expired[0]);
+	EXPECT_EQ(0u, wheel.Size());
+}
+
+TEST(Alarm_test, start_and_cancel)
+{
+	MessageQueue::MessageQueueCreater creater(true);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(creater.GetMessageQueue());
+	std::vector<uint64_t> fired(2, 0);
+
+	Alarm alarm(boost::bind(&fire, &fired, 0), creater.GetMessageQueue());
+	Alarm cancelled(boost::bind(&fire, &fired, 1), creater.GetMessageQueue());
+
+	uint64_t start = ::gettickcount();
+	EXPECT_TRUE(alarm.Start(50));
+	EXPECT_FALSE(alarm.Start(50));
+	EXPECT_TRUE(cancelled.Start(30));
+	EXPECT_TRUE(alarm.IsWaiting());
+	EXPECT_TRUE(cancelled.Cancel());
+	EXPECT_EQ(Alarm::kCancel, cancelled.Status());
+
+	wait_for(handler, 150);
+
+	EXPECT_LE(start + 50, fired[0]);
+	EXPECT_EQ(0u, fired[1]);
+	EXPECT_EQ(Alarm::kOnAlarm, alarm.Status());
+	EXPECT_LE(50, alarm.ElapseTime());
+
+	// started again after it went off or was cancelled
+	EXPECT_TRUE(cancelled.Start(10));
+	wait_for(handler, 100);
+	EXPECT_NE(0u, fired[1]);
+}
+
+TEST(Alarm_test, many_alarms)
+{
+	MessageQueue::MessageQueueCreater creater(true);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(creater.GetMessageQueue());
+	const int kCount = 1000;
+	std::vector<uint64_t> fired(kCount, 0);
+	std::vector<uint64_t> due(kCount, 0);
+	std::vector<Alarm*> alarms;
+
+	for (int i = 0; i < kCount; ++i)
+		alarms.push_back(new Alarm(boost::bind(&fire, &fired, i), creater.GetMessageQueue()));
+
+	uint64_t start = ::clock_app_monotonic();
+
+	// none due before the cancelling is done
+	for (int i = 0; i < kCount; ++i)
+	{
+		due[i] = ::gettickcount() + 50 + i % 200;
+		alarms[i]->Start(50 + i % 200);
+	}
+
+	// the odd ones are cancelled
+	for (int i = 1; i < kCount; i += 2)
+		alarms[i]->Cancel();
+
+	printf("start %d alarms and cancel half of them: %llu ms\n", kCount, (unsigned long long)(::clock_app_monotonic() - start));
+
+	wait_for(handler, 350);
+
+	for (int i = 0; i < kCount; ++i)
+	{
+		if (i % 2) EXPECT_EQ(0u, fired[i]);
+		else EXPECT_LE(due[i], fired[i]);
+	}
+
+	for (int i = 0; i < kCount; ++i)
+		delete alarms[i];
+}
@@ -0,0 +1,173 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * AutoBufferPool_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+#include "comm/autobuffer.h"
+#include "comm/autobuffer_pool.h"
+#include "comm/thread/thread.h"
+#include "comm/time_utils.h"
+
+namespace
+{
+
+struct PoolScope
+{
+	PoolScope(bool _enable)
+	{
+		AutoBufferPool::Trim();
+		AutoBufferPool::Enable(_enable);
+	}
+
+	~PoolScope()
+	{
+		AutoBufferPool::Trim();
+		AutoBufferPool::Enable(false);
+	}
+};
+
+static AutoBufferPool::Stat stat()
+{
+	AutoBufferPool::Stat s;
+	AutoBufferPool::GetStat(s);
+	return s;
+}
+
+// a frame like the longlink ones, header and body
+static size_t frame(size_t _body)
+{
+	AutoBuffer header;
+	AutoBuffer body;
+	char data[2048] = {0};
+
+	header.Write(data, 20);
+	for (size_t len = 0; len < _body; len += sizeof(data)) body.Write(data, std::min(sizeof(data), _body - len));
+	return header.Length() + body.Length();
+}
+
+static void thread_frames()
+{
+	for (int i = 0; i < 10; ++i) frame(1000);
+}
+
+}
+
+TEST(AutoBufferPool_test, class_and_reuse)
+{
+	PoolScope scope(true);
+	AutoBufferPool::Stat before = stat();
+
+	AutoBuffer buffer;
+	buffer.Write("0123456789", 10);
+	EXPECT_EQ(128u, buffer.Capacity());
+
+	// by the classes, the data kept
+	char data[300];
+	memset(data, 'x', sizeof(data));
+	buffer.Write(data, sizeof(data));
+	EXPECT_EQ(512u, buffer.Capacity());
+	EXPECT_EQ(0, memcmp(buffer.Ptr(), "0123456789", 10));
+	EXPECT_EQ(0, memcmp(buffer.Ptr(10), data, sizeof(data)));
+
+	buffer.Reset();
+	AutoBufferPool::Stat reset = stat();
+	EXPECT_EQ(before.retained_bytes + 128 + 512, reset.retained_bytes);
+
+	AutoBuffer again;
+	again.AllocWrite(400);
+	EXPECT_EQ(512u, again.Capacity());
+	EXPECT_EQ(reset.hit_count + 1, stat().hit_count);
+	EXPECT_EQ(reset.retained_bytes - 512, stat().retained_bytes);
+
+	// bigger than the classes
+	AutoBuffer big;
+	big.AllocWrite(100 * 1024);
+	EXPECT_EQ(100u * 1024, big.Capacity());
+
+	// a detached block is still the owner's to free
+	size_t len = 0;
+	void* detached = again.Detach(&len);
+	EXPECT_EQ(400u, len);
+	free(detached);
+
+	AutoBufferPool::Trim();
+	EXPECT_EQ(before.retained_bytes, stat().retained_bytes);
+}
+
+TEST(AutoBufferPool_test, disabled)
+{
+	PoolScope scope(false);
+	AutoBufferPool::Stat before = stat();
+
+	AutoBuffer buffer;
+	buffer.AllocWrite(300);
+	EXPECT_EQ(384u, buffer.Capacity());
+	buffer.Reset();
+
+	EXPECT_EQ(before.alloc_count, stat().alloc_count);
+	EXPECT_EQ(before.retained_bytes, stat().retained_bytes);
+}
+
+TEST(AutoBufferPool_test, thread_exit)
+{
+	PoolScope scope(true);
+	uint32_t retained = stat().retained_bytes;
+
+	Thread thread(&thread_frames);
+	thread.start();
+	thread.join();
+
+	// the freelists of the thread are gone with it
+	EXPECT_EQ(retained, stat().retained_bytes);
+}
+
+TEST(AutoBufferPool_test, benchmark)
+{
+	static const int kCount = 200000;
+	size_t total = 0;
+
+	uint64_t begin = gettickcount();
+	{
+		PoolScope scope(false);
+		for (int i = 0; i < kCount; ++i) total += frame(100 + i % 4000);
+	}
+	uint64_t malloc_cost = gettickcount() - begin;
+
+	AutoBufferPool::Stat before = stat();
+	begin = gettickcount();
+	size_t pooled_total = 0;
+	uint32_t hits = 0;
+	uint32_t allocs = 0;
+	{
+		PoolScope scope(true);
+		for (int i = 0; i < kCount; ++i) pooled_total += frame(100 + i % 4000);
+		hits = stat().hit_count - before.hit_count;
+		allocs = stat().alloc_count - before.alloc_count;
+	}
+	uint64_t pool_cost = gettickcount() - begin;
+
+	printf("autobuffer %d frames, malloc:%" PRIu64 "ms, pool:%" PRIu64 "ms, hit rate:%.3f\n",
+		   kCount, malloc_cost, pool_cost, allocs ? (double)hits / allocs : 0.0);
+	EXPECT_EQ(total, pooled_total);
+	EXPECT_LT(0.9, (double)hits / allocs);
+}
@@ -0,0 +1,140 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * ComplexConnect_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "comm/socket/complexconnect.h"
+#include "comm/socket/socket_address.h"
+#include "comm/socket/socketselect.h"
+
+namespace
+{
+
+// a port listened on 127.0.0.1, and one nobody listens on.
+struct Ports
+{
+	Ports(): listen_sock(socket(AF_INET, SOCK_STREAM, 0)), open_port(0), closed_port(0)
+	{
+		open_port = Bind(listen_sock);
+		EXPECT_EQ(0, listen(listen_sock, 8));
+
+		SOCKET sock = socket(AF_INET, SOCK_STREAM, 0);
+		closed_port = Bind(sock);
+		close(sock);
+	}
+
+	~Ports()
+	{
+		close(listen_sock);
+	}
+
+	static uint16_t Bind(SOCKET _sock)
+	{
+		sockaddr_in addr = {0};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		EXPECT_EQ(0, bind(_sock, (sockaddr*)&addr, sizeof(addr)));
+
+		socklen_t len = sizeof(addr);
+		EXPECT_EQ(0, getsockname(_sock, (sockaddr*)&addr, &len));
+		return ntohs(addr.sin_port);
+	}
+
+	SOCKET listen_sock;
+	uint16_t open_port;
+	uint16_t closed_port;
+};
+
+struct Observer : public MComplexConnect
+{
+	virtual void OnCreated(unsigned int _index, const socket_address& _addr, SOCKET _socket)
+	{
+		created.push_back(_index);
+	}
+
+	std::vector<unsigned int> created;
+};
+
+static SOCKET connect(bool _racing, const std::vector<socket_address>& _vecaddr, Observer& _observer, int& _index)
+{
+	SocketSelectBreaker breaker;
+	ComplexConnect conn(5000, 4000, 200, 3);
+	conn.Racing(_racing);
+
+	SOCKET sock = conn.ConnectImpatient(_vecaddr, breaker, &_observer);
+	_index = conn.Index();
+	return sock;
+}
+
+}
+
+TEST(ComplexConnect_test, racing)
+{
+	Ports ports;
+	std::vector<socket_address> vecaddr;
+	vecaddr.push_back(socket_address("127.0.0.1", ports.closed_port));
+	vecaddr.push_back(socket_address("127.0.0.1", ports.open_port));
+	vecaddr.push_back(socket_address("::1", ports.closed_port));
+
+	// v4, v6, v4, the next one at once after a failure
+	Observer observer;
+	int index = -1;
+	SOCKET sock = connect(true, vecaddr, observer, index);
+	ASSERT_NE(INVALID_SOCKET, sock);
+	close(sock);
+	EXPECT_EQ(1, index);
+	ASSERT_EQ(3u, observer.created.size());
+	EXPECT_EQ(0u, observer.created[0]);
+	EXPECT_EQ(2u, observer.created[1]);
+	EXPECT_EQ(1u, observer.created[2]);
+
+	// v6 failed last time, v4 goes first
+	std::vector<socket_address> vecaddr2;
+	vecaddr2.push_back(socket_address("::1", ports.closed_port));
+	vecaddr2.push_back(socket_address("127.0.0.1", ports.open_port));
+
+	Observer observer2;
+	sock = connect(true, vecaddr2, observer2, index);
+	ASSERT_NE(INVALID_SOCKET, sock);
+	close(sock);
+	EXPECT_EQ(1, index);
+	ASSERT_EQ(1u, observer2.created.size());
+	EXPECT_EQ(1u, observer2.created[0]);
+}
+
+TEST(ComplexConnect_test, not_racing)
+{
+	Ports ports;
+	std::vector<socket_address> vecaddr;
+	vecaddr.push_back(socket_address("::1", ports.closed_port));
+	vecaddr.push_back(socket_address("127.0.0.1", ports.open_port));
+
+	Observer observer;
+	int index = -1;
+	SOCKET sock = connect(false, vecaddr, observer, index);
+	ASSERT_NE(INVALID_SOCKET, sock);
+	close(sock);
+	EXPECT_EQ(1, index);
+	ASSERT_EQ(2u, observer.created.size());
+	EXPECT_EQ(0u, observer.created[0]);
+	EXPECT_EQ(1u, observer.created[1]);
+}
@@ -0,0 +1,190 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * DNS_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "boost/bind.hpp"
+
+#include "comm/dns/dns.h"
+#include "comm/thread/atomic_oper.h"
+#include "comm/thread/thread.h"
+
+namespace
+{
+
+static volatile uint32_t sg_lookups = 0;
+
+static std::vector<std::string> slow_dns(const std::string& _host)
+{
+	atomic_inc32(&sg_lookups);
+	usleep(200 * 1000);
+
+	std::vector<std::string> ips;
+	if (_host != "none.qq.com") ips.push_back("10.0.0.1");
+	return ips;
+}
+
+struct Lookup
+{
+	Lookup(DNS& _dns, const std::string& _host, long _timeout)
+		: dns(_dns), host(_host), timeout(_timeout), ret(false), thread(boost::bind(&Lookup::Run, this))
+	{
+		thread.start();
+	}
+
+	void Run()
+	{
+		ret = dns.GetHostByName(host, ips, timeout);
+	}
+
+	DNS& dns;
+	std::string host;
+	long timeout;
+	bool ret;
+	std::vector<std::string> ips;
+	Thread thread;
+};
+
+struct Result
+{
+	Result(): called(0), success(false) {}
+
+	void OnDNS(bool _success, const std::vector<std::string>& _ips)
+	{
+		success = _success;
+		ips = _ips;
+		atomic_inc32(&called);
+	}
+
+	volatile uint32_t called;
+	bool success;
+	std::vector<std::string> ips;
+};
+
+// a callback still running when the DNS is cancelled
+struct SlowResult
+{
+	SlowResult(): dns(NULL), started(0), finished(0) {}
+
+	void OnDNS(bool _success, const std::vector<std::string>& _ips)
+	{
+		atomic_inc32(&started);
+		if (NULL != dns) dns->Cancel();
+		usleep(200 * 1000);
+		atomic_inc32(&finished);
+	}
+
+	DNS* dns;   // cancelled from the callback if set
+	volatile uint32_t started;
+	volatile uint32_t finished;
+};
+
+}
+
+TEST(DNS_test, coalesce)
+{
+	sg_lookups = 0;
+	DNS dns(&slow_dns);
+
+	Lookup* lookups[4];
+	for (int i = 0; i < 4; ++i) lookups[i] = new Lookup(dns, "a.qq.com", 2000);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		lookups[i]->thread.join();
+		EXPECT_TRUE(lookups[i]->ret);
+		ASSERT_EQ(1u, lookups[i]->ips.size());
+		EXPECT_EQ("10.0.0.1", lookups[i]->ips[0]);
+		delete lookups[i];
+	}
+
+	EXPECT_EQ(1u, sg_lookups);
+
+	// a DNSFunc isn't cached
+	std::vector<std::string> ips;
+	EXPECT_FALSE(dns.GetHostByName("none.qq.com", ips));
+	EXPECT_TRUE(ips.empty());
+	EXPECT_EQ(2u, sg_lookups);
+}
+
+TEST(DNS_test, timeout_and_cancel)
+{
+	DNS dns(&slow_dns);
+	std::vector<std::string> ips;
+	EXPECT_FALSE(dns.GetHostByName("b.qq.com", ips, 50));
+
+	Lookup lookup(dns, "c.qq.com", 2000);
+	usleep(50 * 1000);
+	dns.Cancel("c.qq.com");
+	lookup.thread.join();
+	EXPECT_FALSE(lookup.ret);
+
+	DNSBreaker breaker;
+	dns.Cancel(breaker);
+	EXPECT_FALSE(dns.GetHostByName("c.qq.com", ips, 2000, &breaker));
+	// let the workers be done with the lookups before dns is gone
+	usleep(300 * 1000);
+}
+
+TEST(DNS_test, callback)
+{
+	DNS dns(&slow_dns);
+	Result result;
+	Result cancelled;
+
+	dns.GetHostByName("d.qq.com", boost::bind(&Result::OnDNS, &result, _1, _2));
+	dns.GetHostByName("e.qq.com", boost::bind(&Result::OnDNS, &cancelled, _1, _2));
+	EXPECT_EQ(0u, result.called);
+	dns.Cancel("e.qq.com");
+
+	for (int i = 0; i < 100 && 0 == result.called; ++i) usleep(10 * 1000);
+	usleep(300 * 1000);
+
+	EXPECT_EQ(1u, result.called);
+	EXPECT_TRUE(result.success);
+	ASSERT_EQ(1u, result.ips.size());
+	EXPECT_EQ("10.0.0.1", result.ips[0]);
+	EXPECT_EQ(0u, cancelled.called);
+}
+
+TEST(DNS_test, cancel_waits_for_callback)
+{
+	SlowResult result;
+	DNS* dns = new DNS(&slow_dns);
+	dns->GetHostByName("f.qq.com", boost::bind(&SlowResult::OnDNS, &result, _1, _2));
+
+	for (int i = 0; i < 100 && 0 == result.started; ++i) usleep(10 * 1000);
+	ASSERT_EQ(1u, result.started);
+
+	// the callback may use what goes with dns, it's done once dns is
+	delete dns;
+	EXPECT_EQ(1u, result.finished);
+}
+
+TEST(DNS_test, cancel_in_callback)
+{
+	SlowResult result;
+	DNS dns(&slow_dns);
+	result.dns = &dns;
+	dns.GetHostByName("g.qq.com", boost::bind(&SlowResult::OnDNS, &result, _1, _2));
+
+	for (int i = 0; i < 100 && 0 == result.finished; ++i) usleep(10 * 1000);
+	EXPECT_EQ(1u, result.finished);
+}
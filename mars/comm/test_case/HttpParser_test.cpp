@@ -0,0 +1,280 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * HttpParser_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "comm/autobuffer.h"
+#include "comm/http.h"
+#include "comm/strutil.h"
+#include "comm/time_utils.h"
+
+namespace
+{
+
+static const char* const kResponse = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 11\r\nX-Empty:\r\n\r\nhello world";
+static const char* const kChunked = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                    "5;ext=1\r\nhello\r\n6\r\n world\r\n0\r\nX-Trailer: 1\r\n\r\n";
+
+// in pieces of _step bytes
+static http::Parser::TRecvStatus parse(http::Parser& _parser, const char* _http, size_t _step)
+{
+	size_t length = strlen(_http);
+	http::Parser::TRecvStatus status = _parser.RecvStatus();
+
+	for (size_t pos = 0; pos < length; pos += _step)
+	{
+		status = _parser.Recv(_http + pos, std::min(_step, length - pos));
+	}
+
+	return status;
+}
+
+// the Parser before the incremental one, kept as reference and baseline.
+// every piece is staged, the terminators searched from the start of the stage and the body copied out of it.
+class StagingParser
+{
+public:
+	StagingParser(AutoBuffer& _body): body_(_body), status_(0), content_length_(0) {}
+
+	bool Recv(const void* _buffer, size_t _length)
+	{
+		buf_.Write(_buffer, _length);
+
+		if (0 == status_)
+		{
+			std::string stage((const char*)buf_.Ptr(), buf_.Length());
+			size_t pos = stage.find("\r\n");
+			if (std::string::npos == pos) return false;
+
+			status_line_.FromString(stage.substr(0, pos + 2));
+			buf_.Move(-(off_t)(pos + 2));
+			status_ = 1;
+		}
+
+		if (1 == status_)
+		{
+			std::string stage((const char*)buf_.Ptr(), buf_.Length());
+			size_t pos = stage.find("\r\n\r\n");
+			if (std::string::npos == pos) return false;
+
+			std::string headers = stage.substr(0, pos + 4);
+			for (size_t begin = 0, end = 0; std::string::npos != (end = headers.find("\r\n", begin)); begin = end + 2)
+			{
+				std::string line = headers.substr(begin, end - begin);
+				size_t colon = line.find(':');
+				if (std::string::npos == colon) continue;
+
+				std::string name = line.substr(0, colon);
+				std::string value = line.substr(colon + 1);
+				strutil::Trim(name);
+				strutil::Trim(value);
+				fields_.HeaderFiled(name.c_str(), value.c_str());
+			}
+
+			content_length_ = fields_.ContentLength();
+			buf_.Move(-(off_t)(pos + 4));
+			status_ = 2;
+		}
+
+		size_t append = std::min(buf_.Length(), content_length_ - body_.Length());
+		body_.Write(buf_.Ptr(), append);
+		buf_.Move(-(off_t)append);
+		return body_.Length() == content_length_;
+	}
+
+private:
+	AutoBuffer& body_;
+	AutoBuffer buf_;
+	int status_;
+	size_t content_length_;
+	http::StatusLine status_line_;
+	http::HeaderFields fields_;
+};
+
+}
+
+TEST(HttpParser_test, content_length)
+{
+	for (size_t step = 1; step <= strlen(kResponse); ++step)
+	{
+		AutoBuffer body;
+		http::Parser parser(new http::MemoryBodyReceiver(body), true);
+		ASSERT_EQ(http::Parser::kEnd, parse(parser, kResponse, step)) << "step:" << step;
+
+		EXPECT_EQ(200, parser.Status().StatusCode());
+		EXPECT_EQ(http::kVersion_1_1, parser.Status().Version());
+		EXPECT_STREQ("text/plain", parser.Fields().HeaderField("content-type"));
+		EXPECT_TRUE(NULL == parser.Fields().HeaderField("X-Empty"));
+		EXPECT_EQ(strlen("Content-Type: text/plain\r\nContent-Length: 11\r\nX-Empty:\r\n\r\n"), parser.HeaderLength());
+		EXPECT_EQ("hello world", std::string((const char*)body.Ptr(), body.Length()));
+	}
+}
+
+TEST(HttpParser_test, chunked)
+{
+	for (size_t step = 1; step <= strlen(kChunked); ++step)
+	{
+		AutoBuffer body;
+		http::Parser parser(new http::MemoryBodyReceiver(body), true);
+		ASSERT_EQ(http::Parser::kEnd, parse(parser, kChunked, step)) << "step:" << step;
+		EXPECT_EQ("hello world", std::string((const char*)body.Ptr(), body.Length()));
+	}
+}
+
+TEST(HttpParser_test, no_body_and_left)
+{
+	http::Parser parser;
+	EXPECT_EQ(http::Parser::kEnd, parse(parser, "HTTP/1.0 204 No Content\r\n\r\n", 3));
+	EXPECT_EQ(0u, parser.Body().Length());
+
+	// the next response of a keep-alive connection is left
+	std::string two = std::string(kResponse) + kResponse;
+	AutoBuffer buffer;
+	buffer.Write(two.data(), two.size());
+
+	http::Parser first;
+	EXPECT_EQ(http::Parser::kEnd, first.Recv(buffer));
+	EXPECT_EQ(strlen(kResponse), buffer.Length());
+	EXPECT_EQ(0, memcmp(buffer.Ptr(), kResponse, buffer.Length()));
+}
+
+TEST(HttpParser_test, error)
+{
+	http::Parser first_line;
+	EXPECT_EQ(http::Parser::kFirstLineError, parse(first_line, "HTTP/9.9 200 OK\r\n\r\n", 4));
+
+	http::Parser chunk;
+	EXPECT_EQ(http::Parser::kBodyError, parse(chunk, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nokx\r\n", 1));
+
+	http::Parser chunk_size;
+	EXPECT_EQ(http::Parser::kBodyError, parse(chunk_size, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 100));
+
+	http::Parser header;
+	std::string huge = "HTTP/1.1 200 OK\r\nX-Huge: " + std::string(200 * 1024, 'x');
+	EXPECT_EQ(http::Parser::kHeaderFieldsError, parse(header, huge.c_str(), 1400));
+
+	// every line complete, too many of them
+	http::Parser headers;
+	std::string many = "HTTP/1.1 200 OK\r\n";
+	for (int i = 0; i < 200; ++i) many += "X-Many: " + std::string(1024, 'x') + "\r\n";
+	many += "\r\n";
+	EXPECT_EQ(http::Parser::kHeaderFieldsError, parse(headers, many.c_str(), many.size()));
+}
+
+TEST(HttpParser_test, benchmark)
+{
+	static const int kCount = 200;
+	static const size_t kHeaderStep = 16;
+	static const size_t kBodyStep = 1400;
+
+	std::string http = "HTTP/1.1 200 OK\r\n";
+	for (int i = 0; i < 24; ++i)
+	{
+		char field[64];
+		snprintf(field, sizeof(field), "X-Field-%d: value of the field %d\r\n", i, i);
+		http += field;
+	}
+	std::string body(256 * 1024, 'b');
+	char length[64];
+	snprintf(length, sizeof(length), "Content-Length: %d\r\n\r\n", (int)body.size());
+	http += length;
+	size_t header_length = http.size();
+	http += body;
+
+	uint64_t begin = gettickcount();
+	size_t staging_len = 0;
+	for (int i = 0; i < kCount; ++i)
+	{
+		AutoBuffer out;
+		StagingParser parser(out);
+		size_t pos = 0;
+		for (; pos < header_length; pos += kHeaderStep) parser.Recv(http.data() + pos, std::min(kHeaderStep, header_length - pos));
+		for (pos = header_length; pos < http.size(); pos += kBodyStep) parser.Recv(http.data() + pos, std::min(kBodyStep, http.size() - pos));
+		staging_len += out.Length();
+	}
+	uint64_t staging_cost = gettickcount() - begin;
+
+	begin = gettickcount();
+	size_t incremental_len = 0;
+	for (int i = 0; i < kCount; ++i)
+	{
+		AutoBuffer out;
+		http::Parser parser(new http::MemoryBodyReceiver(out), true);
+		size_t pos = 0;
+		for (; pos < header_length; pos += kHeaderStep) parser.Recv(http.data() + pos, std::min(kHeaderStep, header_length - pos));
+		for (pos = header_length; pos < http.size(); pos += kBodyStep) parser.Recv(http.data() + pos, std::min(kBodyStep, http.size() - pos));
+		EXPECT_EQ(http::Parser::kEnd, parser.RecvStatus());
+		incremental_len += out.Length();
+	}
+	uint64_t incremental_cost = gettickcount() - begin;
+
+	printf("http parse %d responses of %d bytes, staging:%" PRIu64 "ms, incremental:%" PRIu64 "ms\n",
+		   kCount, (int)http.size(), staging_cost, incremental_cost);
+	EXPECT_EQ(staging_len, incremental_len);
+	EXPECT_EQ(kCount * body.size(), incremental_len);
+}
+
+TEST(HttpParser_test, header_fields)
+{
+	http::HeaderFields fields;
+	fields.HeaderFiled("content-length", "10");
+	fields.HeaderFiled(http::HeaderFields::KStringContentLength, "20");
+	fields.HeaderFiled("X-Custom", "a");
+	fields.HeaderFiled("x-custom", "b");
+	fields.HeaderFiled(http::HeaderFields::MakeTransferEncodingChunked());
+
+	// the first one wins, the names in any case
+	EXPECT_EQ(3u, fields.Size());
+	EXPECT_EQ(10, fields.ContentLength());
+	EXPECT_STREQ("10", fields.HeaderField("Content-Length"));
+	EXPECT_STREQ("a", fields.HeaderField("X-CUSTOM"));
+	EXPECT_TRUE(fields.IsTransferEncodingChunked());
+	EXPECT_TRUE(NULL == fields.HeaderField(http::HeaderFields::KStringHost));
+	EXPECT_TRUE(NULL == fields.HeaderField("X-Custo"));
+	EXPECT_EQ("content-length: 10\r\nX-Custom: a\r\nTransfer-Encoding: chunked\r\n", fields.ToStrig());
+
+	std::map<const std::string, std::string, http::less> headers = fields.GetHeaders();
+	EXPECT_EQ(3u, headers.size());
+	EXPECT_EQ("a", headers["x-custom"]);
+
+	// more than the inline ones
+	http::HeaderFields more;
+	for (int i = 0; i < 40; ++i)
+	{
+		char name[32];
+		char value[32];
+		snprintf(name, sizeof(name), "X-Field-%d", i);
+		snprintf(value, sizeof(value), "%d", i);
+		more.HeaderFiled(name, value);
+	}
+	more.HeaderFiled(fields);
+
+	EXPECT_EQ(43u, more.Size());
+	EXPECT_STREQ("39", more.HeaderField("x-field-39"));
+	EXPECT_STREQ("0", more.HeaderField("X-Field-0"));
+	EXPECT_EQ(10, more.ContentLength());
+
+	http::HeaderFields copy = more;
+	EXPECT_STREQ("25", copy.HeaderField("X-Field-25"));
+	EXPECT_TRUE(copy.IsTransferEncodingChunked());
+}
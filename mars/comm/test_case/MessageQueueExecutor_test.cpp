@@ -0,0 +1,248 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * MessageQueueExecutor_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include <stdio.h>
+#include <vector>
+#include <zlib.h>
+
+#include "gtest/gtest.h"
+#include "boost/bind.hpp"
+
+#include "comm/messagequeue/message_queue.h"
+#include "comm/messagequeue/message_queue_utils.h"
+#include "comm/thread/atomic_oper.h"
+#include "comm/thread/lock.h"
+#include "comm/time_utils.h"
+
+namespace
+{
+
+static const int kTitles = 4;
+
+static std::vector<int> sg_lanes[kTitles];
+static volatile uint32_t sg_running[kTitles];
+static volatile uint32_t sg_overlapped = 0;
+static volatile uint32_t sg_untitled = 0;
+
+static void in_lane(int _title, int _i)
+{
+	if (0 != atomic_inc32(&sg_running[_title])) atomic_inc32(&sg_overlapped);
+	sg_lanes[_title].push_back(_i);
+	ThreadUtil::usleep(50);
+	atomic_dec32(&sg_running[_title]);
+}
+
+static void untitled()
+{
+	atomic_inc32(&sg_untitled);
+}
+
+static int add(int _a, int _b)
+{
+	return _a + _b;
+}
+
+// waits for another message of the executor on the worker, ran by the worker itself if it's the only one.
+static int nested(const MessageQueue::MessageHandler_t& _handler)
+{
+	return MessageQueue::WaitInvoke(boost::bind(&add, 1, 2), _handler) + 1;
+}
+
+// waits for one of its own title, which can't run before it ends.
+static bool nested_title(const MessageQueue::MessageHandler_t& _handler)
+{
+	MessageQueue::MessagePost_t post = MessageQueue::AsyncInvoke(&untitled, MessageQueue::MessageTitle_t(1), _handler);
+	return MessageQueue::WaitMessage(post);
+}
+
+// waits for one posted after an unrelated one, which is left to the worker.
+static uint32_t nested_unrelated(const MessageQueue::MessageHandler_t& _handler)
+{
+	MessageQueue::AsyncInvoke(&untitled, _handler);
+	MessageQueue::WaitInvoke(boost::bind(&add, 1, 2), _handler);
+	return atomic_read32(&sg_untitled);
+}
+
+// waits for one still in the lane, after the one of its title in the deque.
+static uint32_t nested_lane(const MessageQueue::MessageHandler_t& _handler)
+{
+	MessageQueue::AsyncInvoke(&untitled, MessageQueue::MessageTitle_t(2), _handler);
+	MessageQueue::WaitMessage(MessageQueue::AsyncInvoke(&untitled, MessageQueue::MessageTitle_t(2), _handler));
+	return atomic_read32(&sg_untitled);
+}
+
+static volatile uint32_t sg_blocked = 0;
+
+static void block(Mutex* _mutex)
+{
+	atomic_write32(&sg_blocked, 1);
+	ScopedLock lock(*_mutex);
+}
+
+static uLong checksum(const std::vector<Bytef>* _data)
+{
+	uLong crc = crc32(0L, Z_NULL, 0);
+	for (int i = 0; i < 8; ++i) crc = crc32(crc, &(*_data)[0], (uInt)_data->size());
+	return crc;
+}
+
+static void checksum_to(const std::vector<Bytef>* _data, uLong* _crc)
+{
+	*_crc = checksum(_data);
+}
+
+}
+
+TEST(MessageQueueExecutor_test, title_order)
+{
+	MessageQueue::MessageQueueExecutor executor(4);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(executor.GetMessageQueue());
+	ASSERT_NE(MessageQueue::KNullHandler, handler);
+
+	for (int t = 0; t < kTitles; ++t) sg_lanes[t].clear();
+	sg_overlapped = 0;
+	sg_untitled = 0;
+
+	std::vector<MessageQueue::MessagePost_t> posts;
+	for (int i = 0; i < 200; ++i)
+	{
+		for (int t = 0; t < kTitles; ++t)
+			posts.push_back(MessageQueue::AsyncInvoke(boost::bind(&in_lane, t, i), MessageQueue::MessageTitle_t(t + 1), handler));
+
+		posts.push_back(MessageQueue::AsyncInvoke(&untitled, handler));
+	}
+
+	for (size_t i = 0; i < posts.size(); ++i)
+	{
+		ASSERT_NE(MessageQueue::KNullPost, posts[i]);
+		EXPECT_TRUE(MessageQueue::WaitMessage(posts[i]));
+	}
+
+	EXPECT_EQ(0u, sg_overlapped);
+	EXPECT_EQ(200u, sg_untitled);
+
+	for (int t = 0; t < kTitles; ++t)
+	{
+		ASSERT_EQ(200u, sg_lanes[t].size());
+		for (int i = 0; i < 200; ++i) EXPECT_EQ(i, sg_lanes[t][i]);
+	}
+
+	// only the immediate ones
+	EXPECT_EQ(MessageQueue::KNullPost, MessageQueue::AsyncInvokeAfter(10, &untitled, handler));
+	EXPECT_FALSE(MessageQueue::FoundMessage(posts[0]));
+}
+
+TEST(MessageQueueExecutor_test, wait_invoke)
+{
+	MessageQueue::MessageQueueExecutor executor(1);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(executor.GetMessageQueue());
+
+	EXPECT_EQ(5, MessageQueue::WaitInvoke(boost::bind(&add, 2, 3), handler));
+
+	MessageQueue::AsyncResult<int> result(boost::bind(&add, 4, 5));
+	EXPECT_TRUE(MessageQueue::WaitInvoke(result, handler));
+	EXPECT_EQ(9, result.Result());
+
+	// the only worker waits for a message of its own executor
+	EXPECT_EQ(4, MessageQueue::WaitInvoke(boost::bind(&nested, handler), handler));
+
+	sg_untitled = 0;
+	MessageQueue::AsyncResult<bool> same_title(boost::bind(&nested_title, handler));
+	MessageQueue::MessagePost_t post = MessageQueue::AsyncInvoke(same_title, MessageQueue::MessageTitle_t(1), handler);
+	EXPECT_TRUE(MessageQueue::WaitMessage(post));
+	EXPECT_FALSE(same_title.Result());
+
+	// the one it waited for runs after it all the same, before the next of the title
+	EXPECT_TRUE(MessageQueue::WaitMessage(MessageQueue::AsyncInvoke(&untitled, MessageQueue::MessageTitle_t(1), handler)));
+	EXPECT_EQ(2u, sg_untitled);
+
+	// only the awaited one, or the one of its title before it, runs on the waiting worker
+	sg_untitled = 0;
+	EXPECT_EQ(0u, MessageQueue::WaitInvoke(boost::bind(&nested_unrelated, handler), handler));
+	EXPECT_EQ(3u, MessageQueue::WaitInvoke(boost::bind(&nested_lane, handler), handler));
+}
+
+TEST(MessageQueueExecutor_test, cancel)
+{
+	MessageQueue::MessageQueueExecutor executor(1);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(executor.GetMessageQueue());
+	sg_untitled = 0;
+	sg_blocked = 0;
+
+	Mutex mutex;
+	ScopedLock lock(mutex);
+	MessageQueue::MessagePost_t blocked = MessageQueue::AsyncInvoke(boost::bind(&block, &mutex), handler);
+	while (0 == atomic_read32(&sg_blocked)) ThreadUtil::usleep(1000);
+	EXPECT_TRUE(MessageQueue::FoundMessage(blocked));
+	EXPECT_FALSE(MessageQueue::CancelMessage(blocked));   // running
+
+	MessageQueue::MessagePost_t first = MessageQueue::AsyncInvoke(&untitled, MessageQueue::MessageTitle_t(1), handler);
+	MessageQueue::MessagePost_t second = MessageQueue::AsyncInvoke(&untitled, MessageQueue::MessageTitle_t(1), handler);
+	MessageQueue::AsyncInvoke(&untitled, MessageQueue::MessageTitle_t(2), handler);
+	MessageQueue::MessagePost_t last = MessageQueue::AsyncInvoke(&untitled, handler);
+
+	EXPECT_TRUE(MessageQueue::CancelMessage(first));
+	EXPECT_FALSE(MessageQueue::CancelMessage(first));
+	EXPECT_TRUE(MessageQueue::FoundMessage(second));
+	MessageQueue::CancelMessage(handler, MessageQueue::MessageTitle_t(2));
+
+	{
+		MessageQueue::ScopeRegister reg(MessageQueue::InstallAsyncHandler(executor.GetMessageQueue()));
+		for (int i = 0; i < 10; ++i) MessageQueue::AsyncInvoke(&untitled, reg.Get());
+		reg.Cancel();
+		EXPECT_EQ(MessageQueue::KNullPost, MessageQueue::AsyncInvoke(&untitled, reg.Get()));
+	}
+
+	lock.unlock();
+	EXPECT_TRUE(MessageQueue::WaitMessage(last));
+	EXPECT_TRUE(MessageQueue::WaitMessage(second));
+	EXPECT_EQ(2u, sg_untitled);
+
+	executor.CancelAndWait();
+	EXPECT_EQ(MessageQueue::KNullHandler, MessageQueue::DefAsyncInvokeHandler(executor.GetMessageQueue()));
+}
+
+// the serial task queue as the reference and baseline
+TEST(MessageQueueExecutor_test, checksum_benchmark)
+{
+	const int kTasks = 32;
+	std::vector<Bytef> data(256 * 1024);
+	for (size_t i = 0; i < data.size(); ++i) data[i] = (Bytef)(i * 131);
+	uLong expected = checksum(&data);
+
+	MessageQueue::MessageHandler_t task_handler = MessageQueue::DefAsyncInvokeHandler(MessageQueue::GetDefTaskQueue());
+	MessageQueue::MessageHandler_t executor_handler = MessageQueue::DefAsyncInvokeHandler(MessageQueue::GetDefExecutor());
+	MessageQueue::MessageHandler_t handlers[2] = {task_handler, executor_handler};
+	uint64_t cost[2] = {0, 0};
+
+	for (int h = 0; h < 2; ++h)
+	{
+		std::vector<uLong> crcs(kTasks, 0);
+		std::vector<MessageQueue::MessagePost_t> posts;
+		uint64_t start = ::clock_app_monotonic();
+
+		for (int i = 0; i < kTasks; ++i)
+			posts.push_back(MessageQueue::AsyncInvoke(boost::bind(&checksum_to, &data, &crcs[i]), handlers[h]));
+
+		for (int i = 0; i < kTasks; ++i) MessageQueue::WaitMessage(posts[i]);
+
+		cost[h] = ::clock_app_monotonic() - start;
+		for (int i = 0; i < kTasks; ++i) EXPECT_EQ(expected, crcs[i]);
+	}
+
+	printf("%d checksums of 2M, task queue: %llu ms, executor: %llu ms\n", kTasks, (unsigned long long)cost[0], (unsigned long long)cost[1]);
+}
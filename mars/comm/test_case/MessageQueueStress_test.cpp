@@ -0,0 +1,102 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * MessageQueueStress_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "boost/bind.hpp"
+
+#include "comm/messagequeue/message_queue.h"
+#include "comm/thread/thread.h"
+#include "comm/time_utils.h"
+
+namespace
+{
+
+static const int kMaxQueues = 8;
+static const int kMessages = 20000;
+
+static int sg_handled[kMaxQueues] = {0};
+
+// runs in the queue thread only.
+static void handle(int _queue)
+{
+	++sg_handled[_queue];
+}
+
+// posts to its own queue, with a timer set and cancelled now and then, and waits for the last one.
+static void produce(MessageQueue::MessageHandler_t _handler, int _queue)
+{
+	MessageQueue::MessagePost_t last;
+	for (int i = 0; i < kMessages; ++i)
+	{
+		last = MessageQueue::AsyncInvoke(boost::bind(&handle, _queue), _handler);
+
+		if (0 == i % 16)
+		{
+			MessageQueue::MessagePost_t timer = MessageQueue::AsyncInvokeAfter(60 * 1000, boost::bind(&handle, _queue), _handler);
+			EXPECT_TRUE(MessageQueue::FoundMessage(timer));
+			EXPECT_TRUE(MessageQueue::CancelMessage(timer));
+		}
+	}
+
+	MessageQueue::WaitMessage(last);
+}
+
+// the time _queues producers take to get kMessages each handled by their own queue.
+static uint64_t run(int _queues)
+{
+	std::vector<MessageQueue::MessageQueueCreater*> creaters;
+	std::vector<Thread*> producers;
+
+	for (int i = 0; i < _queues; ++i)
+	{
+		sg_handled[i] = 0;
+		creaters.push_back(new MessageQueue::MessageQueueCreater(true));
+		MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(creaters.back()->GetMessageQueue());
+		producers.push_back(new Thread(boost::bind(&produce, handler, i)));
+	}
+
+	uint64_t begin = gettickcount();
+	for (int i = 0; i < _queues; ++i) producers[i]->start();
+	for (int i = 0; i < _queues; ++i) producers[i]->join();
+	uint64_t cost = gettickcount() - begin;
+
+	for (int i = 0; i < _queues; ++i)
+	{
+		EXPECT_EQ(kMessages, sg_handled[i]);
+		delete producers[i];
+		delete creaters[i];
+	}
+
+	return cost;
+}
+
+}
+
+TEST(MessageQueueStress_test, multi_queue_benchmark)
+{
+	uint64_t single_cost = run(1);
+	uint64_t multi_cost = run(kMaxQueues);
+
+	printf("%d messages per queue, 1 queue:%" PRIu64 "ms, %d queues:%" PRIu64 "ms, %.0f messages/s with %d queues\n",
+		   kMessages, single_cost, kMaxQueues, multi_cost, kMessages * kMaxQueues * 1000.0 / (multi_cost ? multi_cost : 1), kMaxQueues);
+}
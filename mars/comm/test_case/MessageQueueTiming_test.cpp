@@ -0,0 +1,189 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * MessageQueueTiming_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "boost/bind.hpp"
+
+#include "comm/messagequeue/message_queue.h"
+#include "comm/time_utils.h"
+
+namespace
+{
+
+static std::vector<int> sg_fired;
+static int sg_count = 0;
+
+static void fire(int _i)
+{
+	sg_fired.push_back(_i);
+}
+
+static void count()
+{
+	++sg_count;
+}
+
+// posts an empty message and waits for it, the messages due before it have been handled then.
+static void wait_for(const MessageQueue::MessageHandler_t& _handler, int64_t _after)
+{
+	MessageQueue::WaitMessage(MessageQueue::AsyncInvokeAfter(_after, &count, _handler));
+}
+
+}
+
+TEST(MessageQueueTiming_test, due_order)
+{
+	MessageQueue::MessageQueueCreater creater(true);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(creater.GetMessageQueue());
+	sg_fired.clear();
+
+	MessageQueue::AsyncInvokeAfter(60, boost::bind(&fire, 60), handler);
+	MessageQueue::AsyncInvokeAfter(20, boost::bind(&fire, 20), handler);
+	MessageQueue::AsyncInvokeAfter(40, boost::bind(&fire, 40), handler);
+	MessageQueue::AsyncInvoke(boost::bind(&fire, 0), handler);
+	MessageQueue::AsyncInvoke(boost::bind(&fire, 1), handler);
+	wait_for(handler, 100);
+
+	ASSERT_EQ(5u, sg_fired.size());
+	EXPECT_EQ(0, sg_fired[0]);
+	EXPECT_EQ(1, sg_fired[1]);
+	EXPECT_EQ(20, sg_fired[2]);
+	EXPECT_EQ(40, sg_fired[3]);
+	EXPECT_EQ(60, sg_fired[4]);
+}
+
+TEST(MessageQueueTiming_test, period)
+{
+	MessageQueue::MessageQueueCreater creater(true);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(creater.GetMessageQueue());
+	sg_count = 0;
+
+	uint64_t begin = gettickcount();
+	MessageQueue::MessagePost_t post = MessageQueue::AsyncInvokePeriod(50, 20, &count, handler);
+	MessageQueue::WaitMessage(MessageQueue::AsyncInvokeAfter(40, boost::bind(&fire, 0), handler));
+	EXPECT_EQ(0, sg_count);     // not before _after
+
+	while (gettickcount() - begin < 165) ThreadUtil::usleep(1000);
+	EXPECT_TRUE(MessageQueue::CancelMessage(post));
+	int fired = sg_count;
+	EXPECT_LE(4, fired);        // 50, 70, 90, ... 150
+	EXPECT_GE(7, fired);
+
+	wait_for(handler, 60);
+	EXPECT_EQ(fired + 1, sg_count);
+	EXPECT_FALSE(MessageQueue::FoundMessage(post));
+}
+
+TEST(MessageQueueTiming_test, cancel_and_find)
+{
+	MessageQueue::MessageQueueCreater creater(true);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(creater.GetMessageQueue());
+	MessageQueue::MessageHandler_t other = MessageQueue::InstallAsyncHandler(creater.GetMessageQueue());
+	sg_fired.clear();
+	wait_for(handler, 0);   // FoundMessage needs the runloop running
+
+	std::vector<MessageQueue::MessagePost_t> posts;
+	for (int i = 0; i < 100; ++i)
+	{
+		posts.push_back(MessageQueue::AsyncInvokeAfter(10 + i % 7, boost::bind(&fire, i), i % 10, 0 == i % 2 ? handler : other));
+	}
+
+	for (int i = 0; i < 100; i += 3) EXPECT_TRUE(MessageQueue::CancelMessage(posts[i]));
+	EXPECT_FALSE(MessageQueue::CancelMessage(posts[0]));
+	EXPECT_FALSE(MessageQueue::FoundMessage(posts[3]));
+	EXPECT_TRUE(MessageQueue::FoundMessage(posts[4]));
+
+	MessageQueue::CancelMessage(other, MessageQueue::MessageTitle_t(5));    // 5, 25, 35, 55, 65, 85, 95
+	MessageQueue::CancelMessage(handler, MessageQueue::MessageTitle_t(4));  // 4, 14, 34, 44, 64, 74, 94
+	wait_for(handler, 30);
+
+	std::vector<int> expected;
+	for (int i = 0; i < 100; ++i)
+	{
+		if (0 != i % 3 && 5 != i % 10 && 4 != i % 10) expected.push_back(i);
+	}
+	std::sort(sg_fired.begin(), sg_fired.end());
+	EXPECT_EQ(expected, sg_fired);
+
+	for (int i = 0; i < 10; ++i) MessageQueue::AsyncInvokeAfter(1000, boost::bind(&fire, i), other);
+	MessageQueue::CancelMessage(other);
+	for (size_t i = 0; i < posts.size(); ++i) EXPECT_FALSE(MessageQueue::FoundMessage(posts[i]));
+}
+
+TEST(MessageQueueTiming_test, singleton_and_faster)
+{
+	MessageQueue::MessageQueueCreater creater(true);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(creater.GetMessageQueue());
+	sg_fired.clear();
+
+	MessageQueue::MessagePost_t first = MessageQueue::SingletonMessage(false, handler, MessageQueue::Message(1, boost::bind(&fire, 1)), MessageQueue::MessageTiming(40));
+	EXPECT_EQ(first, MessageQueue::SingletonMessage(false, handler, MessageQueue::Message(1, boost::bind(&fire, 2)), MessageQueue::MessageTiming(10)));
+
+	// replaced, keeps the post id
+	EXPECT_EQ(first, MessageQueue::SingletonMessage(true, handler, MessageQueue::Message(1, boost::bind(&fire, 3)), MessageQueue::MessageTiming(60)));
+
+	// the pending one is due earlier
+	EXPECT_EQ(first, MessageQueue::FasterMessage(handler, MessageQueue::Message(1, boost::bind(&fire, 4)), MessageQueue::MessageTiming(200)));
+	// the new one is due earlier, replaces the pending one
+	EXPECT_EQ(first, MessageQueue::FasterMessage(handler, MessageQueue::Message(1, boost::bind(&fire, 5)), MessageQueue::MessageTiming(20)));
+
+	MessageQueue::AsyncInvokeAfter(30, boost::bind(&fire, 30), handler);
+	wait_for(handler, 100);
+
+	ASSERT_EQ(2u, sg_fired.size());
+	EXPECT_EQ(5, sg_fired[0]);
+	EXPECT_EQ(30, sg_fired[1]);
+}
+
+TEST(MessageQueueTiming_test, benchmark)
+{
+	static const int kPendingTimers = 20000;
+	static const int kMessages = 20000;
+
+	MessageQueue::MessageQueueCreater creater(true);
+	MessageQueue::MessageHandler_t handler = MessageQueue::DefAsyncInvokeHandler(creater.GetMessageQueue());
+
+	uint64_t costs[2] = {0};
+	for (int round = 0; round < 2; ++round)
+	{
+		std::vector<MessageQueue::MessagePost_t> timers;
+		for (int i = 0; 1 == round && i < kPendingTimers; ++i)
+		{
+			timers.push_back(MessageQueue::AsyncInvokeAfter(60 * 1000 + i, &count, handler));
+		}
+
+		sg_count = 0;
+		uint64_t begin = gettickcount();
+		MessageQueue::MessagePost_t last;
+		for (int i = 0; i < kMessages; ++i) last = MessageQueue::AsyncInvoke(&count, handler);
+		MessageQueue::WaitMessage(last);
+		for (size_t i = 0; i < timers.size(); ++i) MessageQueue::CancelMessage(timers[i]);
+		costs[round] = gettickcount() - begin;
+
+		EXPECT_EQ(kMessages, sg_count);
+	}
+
+	printf("%d messages posted, dispatched and %d timers cancelled, no timers:%" PRIu64 "ms, with %d timers pending:%" PRIu64 "ms\n",
+		   kMessages, kPendingTimers, costs[0], kPendingTimers, costs[1]);
+}
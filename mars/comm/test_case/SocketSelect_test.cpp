@@ -0,0 +1,197 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * SocketSelect_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "comm/socket/socketselect.h"
+#include "comm/time_utils.h"
+
+namespace
+{
+
+static const int kPairs = 64;
+
+struct Pairs
+{
+	Pairs()
+	{
+		for (int i = 0; i < kPairs; ++i)
+		{
+			int fds[2] = {-1, -1};
+			EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+			local.push_back(fds[0]);
+			remote.push_back(fds[1]);
+		}
+	}
+
+	~Pairs()
+	{
+		for (int i = 0; i < kPairs; ++i)
+		{
+			close(local[i]);
+			close(remote[i]);
+		}
+	}
+
+	std::vector<int> local;
+	std::vector<int> remote;
+};
+
+// one round like the longlink does, the ready one is read and answered.
+static int round(SocketSelect& _sel, Pairs& _pairs, int _ready)
+{
+	_sel.PreSelect();
+	for (int i = 0; i < kPairs; ++i)
+	{
+		_sel.Read_FD_SET(_pairs.local[i]);
+		_sel.Exception_FD_SET(_pairs.local[i]);
+	}
+
+	EXPECT_EQ(1, write(_pairs.remote[_ready], "x", 1));
+	int ret = _sel.Select(1000);
+
+	int readable = 0;
+	for (int i = 0; i < kPairs; ++i)
+	{
+		if (!_sel.Read_FD_ISSET(_pairs.local[i])) continue;
+
+		char c = 0;
+		EXPECT_EQ(1, read(_pairs.local[i], &c, 1));
+		EXPECT_EQ(_ready, i);
+		++readable;
+	}
+
+	EXPECT_EQ(1, ret);
+	EXPECT_EQ(1, readable);
+	return readable;
+}
+
+}
+
+TEST(SocketSelect_test, break_and_clear)
+{
+	SocketSelectBreaker breaker;
+	ASSERT_TRUE(breaker.IsCreateSuc());
+	SocketSelect sel(breaker, true);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		sel.PreSelect();
+		EXPECT_EQ(0, sel.Select(0));
+		EXPECT_FALSE(sel.IsBreak());
+
+		EXPECT_TRUE(breaker.Break());
+		EXPECT_TRUE(breaker.IsBreak());
+		sel.PreSelect();
+		EXPECT_EQ(1, sel.Select(1000));
+		EXPECT_TRUE(sel.IsBreak());
+		EXPECT_FALSE(breaker.IsBreak());    // autoclear
+	}
+}
+
+TEST(SocketSelect_test, rounds)
+{
+	SocketSelectBreaker breaker;
+	SocketSelect sel(breaker);
+	Pairs pairs;
+
+	for (int i = 0; i < 3 * kPairs; ++i) round(sel, pairs, i * 7 % kPairs);
+
+	// writable only when asked for, not left over from the last round
+	sel.PreSelect();
+	sel.Read_FD_SET(pairs.local[0]);
+	EXPECT_EQ(0, sel.Select(0));
+	EXPECT_FALSE(sel.Write_FD_ISSET(pairs.local[0]));
+
+	sel.PreSelect();
+	sel.Write_FD_SET(pairs.local[0]);
+	EXPECT_EQ(1, sel.Select(0));
+	EXPECT_TRUE(sel.Write_FD_ISSET(pairs.local[0]));
+	EXPECT_FALSE(sel.Read_FD_ISSET(pairs.local[0]));
+
+	// the peer has gone
+	close(pairs.remote[1]);
+	pairs.remote[1] = socket(AF_UNIX, SOCK_STREAM, 0);
+	sel.PreSelect();
+	sel.Read_FD_SET(pairs.local[1]);
+	EXPECT_EQ(1, sel.Select(1000));
+	EXPECT_TRUE(sel.Read_FD_ISSET(pairs.local[1]));
+}
+
+TEST(SocketSelect_test, forget)
+{
+	SocketSelectBreaker breaker;
+	SocketSelect sel(breaker);
+	int fds[2] = {-1, -1};
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+	for (int i = 0; i < 2; ++i)
+	{
+		sel.PreSelect();
+		sel.Read_FD_SET(fds[0]);
+		EXPECT_EQ(0, sel.Select(0));
+	}
+
+	// a new socket with the fd of the closed one, set with the same events in the next round
+	int fd = fds[0];
+	close(fds[0]);
+	close(fds[1]);
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+	ASSERT_EQ(fd, fds[0]);
+	sel.Forget(fd);
+
+	EXPECT_EQ(1, write(fds[1], "x", 1));
+	sel.PreSelect();
+	sel.Read_FD_SET(fds[0]);
+	EXPECT_EQ(1, sel.Select(1000));
+	EXPECT_TRUE(sel.Read_FD_ISSET(fds[0]));
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+TEST(SocketSelect_test, benchmark)
+{
+	static const int kRounds = 20000;
+
+	SocketSelectBreaker breaker;
+	Pairs pairs;
+
+	uint64_t begin = gettickcount();
+	for (int i = 0; i < kRounds; ++i)
+	{
+		SocketSelect sel(breaker);
+		round(sel, pairs, i % kPairs);
+	}
+	uint64_t new_cost = gettickcount() - begin;
+
+	SocketSelect sel(breaker);
+	begin = gettickcount();
+	for (int i = 0; i < kRounds; ++i) round(sel, pairs, i % kPairs);
+	uint64_t kept_cost = gettickcount() - begin;
+
+	printf("%d rounds over %d sockets, a selector per round:%" PRIu64 "ms, one selector kept:%" PRIu64 "ms\n",
+		   kRounds, kPairs, new_cost, kept_cost);
+}
@@ -0,0 +1,138 @@
+#include "../xlogger/xlogger.h"
+#include "gtest/gtest.h"
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <string>
+
+#include "../time_utils.h"
+
+
+namespace
+{
+
+enum TestEnum { kTestEnumA = 3 };
+
+// the TVariant based format before variadic TSF, kept as reference and baseline.
+static std::string tvariant_format(const char* _format, const TVariant** _args)
+{
+	std::string message;
+	message.reserve(512);
+	const char* current = _format;
+	int count = 0;
+	while ('\0' != *current)
+	{
+		if ('%' != *current)
+		{
+			message += *current;
+			++current;
+			continue;
+		}
+
+		char nextch = *(current+1);
+		if (('0' <= nextch && nextch <= '9') || nextch == '_')
+		{
+			int argIndex = count;
+			if (nextch != '_') argIndex = nextch - '0';
+			if (_args[argIndex] != NULL && _args[argIndex]->ToString() != NULL) message += _args[argIndex]->ToString();
+			count++;
+			current += 2;
+		}
+		else if (nextch == '%') {
+			message += '%';
+			current += 2;
+		} else {
+			++current;
+		}
+	}
+	return message;
+}
+
+static std::string tvariant_format(const char* _format, const TVariant& a0, const TVariant& a1, const TVariant& a2, const TVariant& a3,
+								   const TVariant& a4, const TVariant& a5)
+{
+	const TVariant* args[16] = {&a0, &a1, &a2, &a3, &a4, &a5};
+	return tvariant_format(_format, args);
+}
+
+}
+
+TEST(XLogger_test, same_as_tvariant)
+{
+	std::string host = "long.weixin.qq.com";
+	char buffer[16] = "buffer";
+	int64_t i64 = -9223372036854775807LL - 1;
+
+	EXPECT_EQ(tvariant_format("svr(%_:%_, %_, %_), ", "10.0.0.1", (unsigned short)8080, TestEnum(kTestEnumA), host, 0, 0),
+			  XMessage()(TSF"svr(%_:%_, %_, %_), ", "10.0.0.1", (unsigned short)8080, kTestEnumA, host).String());
+	EXPECT_EQ(tvariant_format("%_ %_ %_ %_ %_ %_", true, 'c', (unsigned char)200, i64, (uint64_t)-1, (void*)buffer),
+			  XMessage()(TSF"%_ %_ %_ %_ %_ %_", true, 'c', (unsigned char)200, i64, (uint64_t)-1, (void*)buffer).String());
+	EXPECT_EQ(tvariant_format("%_, %_, %_ %% %5", 1.5f, 3.25, buffer, (long)-1, 0, (size_t)12345),
+			  XMessage()(TSF"%_, %_, %_ %% %5", 1.5f, 3.25, buffer, (long)-1, 0, (size_t)12345).String());
+	EXPECT_EQ(tvariant_format("%1%0%1", "a", "b", 0, 0, 0, 0), XMessage()(TSF"%1%0%1", "a", "b").String());
+	EXPECT_EQ("cost:35ms", XMessage()(TSF"cost:%_ms", TVariant(35).ToString()).String());
+
+	EXPECT_EQ("", XMessage()(TSF"", 1).String());
+	EXPECT_EQ("no args", XMessage()(TSF"no args").String());
+}
+
+TEST(XLogger_test, fixed_buffer)
+{
+	char buf[16];
+	EXPECT_EQ(20u, xlogger_tsf_snprintf(buf, sizeof(buf), TSF"%_:%_, seq:%_", "10.0.0.1", 8080, 1));
+	EXPECT_STREQ("10.0.0.1:8080, ", buf);
+
+	EXPECT_EQ(5u, xlogger_tsf_snprintf(buf, sizeof(buf), TSF"%_%%%_", 10, 20));
+	EXPECT_STREQ("10%20", buf);
+
+	EXPECT_EQ(3u, xlogger_tsf_snprintf(buf, 0, TSF"%_", 123));
+
+	std::string body(3000, 'x');
+	XMessage message;
+	message(TSF"head %_ tail %_", body, 1);
+	EXPECT_EQ("head " + body + " tail 1", message.String());
+}
+
+#ifdef NDEBUG  // bad arguments assert
+TEST(XLogger_test, bad_args_as_tvariant)
+{
+	const char* null_str = NULL;
+	EXPECT_EQ("a(null)b", XMessage()(TSF"a%_b", null_str).String());
+	EXPECT_EQ("a1:b", XMessage()(TSF"a%_:%1b", 1).String());
+	EXPECT_EQ("aqb", XMessage()(TSF"a%qb").String());
+}
+#endif
+
+TEST(XLogger_test, benchmark)
+{
+	static const int kCount = 200000;
+	std::string host = "long.weixin.qq.com";
+
+	uint64_t begin = gettickcount();
+	size_t tvariant_len = 0;
+	for (int i = 0; i < kCount; ++i)
+	{
+		tvariant_len += tvariant_format("svr(%_:%_, %_), taskid:%_, cost:%_, seq:%_", "10.0.0.1", 8080, host, i, 35LL, (unsigned int)i).size();
+	}
+	uint64_t tvariant_cost = gettickcount() - begin;
+
+	begin = gettickcount();
+	size_t tsf_len = 0;
+	for (int i = 0; i < kCount; ++i)
+	{
+		tsf_len += XMessage()(TSF"svr(%_:%_, %_), taskid:%_, cost:%_, seq:%_", "10.0.0.1", 8080, host, i, 35LL, (unsigned int)i).String().size();
+	}
+	uint64_t tsf_cost = gettickcount() - begin;
+
+	begin = gettickcount();
+	for (int i = 0; i < kCount; ++i)
+	{
+		char buf[512];
+		xlogger_tsf_snprintf(buf, sizeof(buf), TSF"svr(%_:%_, %_), taskid:%_, cost:%_, seq:%_", "10.0.0.1", 8080, host, i, 35LL, (unsigned int)i);
+	}
+	uint64_t fixed_cost = gettickcount() - begin;
+
+	printf("type safe format %d records, tvariant:%" PRIu64 "ms, variadic:%" PRIu64 "ms, fixed buffer:%" PRIu64 "ms\n",
+		   kCount, tvariant_cost, tsf_cost, fixed_cost);
+	EXPECT_EQ(tvariant_len, tsf_len);
+}
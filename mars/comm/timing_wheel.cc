@@ -0,0 +1,142 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * timing_wheel.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include "comm/timing_wheel.h"
+
+static void __Link(TimingWheel::Timer* _head, TimingWheel::Timer* _timer) {
+    _timer->prev = _head->prev;
+    _timer->next = _head;
+    _head->prev->next = _timer;
+    _head->prev = _timer;
+}
+
+static void __Unlink(TimingWheel::Timer* _timer) {
+    _timer->prev->next = _timer->next;
+    _timer->next->prev = _timer->prev;
+    _timer->prev = NULL;
+    _timer->next = NULL;
+}
+
+static bool __IsEmpty(const TimingWheel::Timer& _head) {
+    return _head.next == &_head;
+}
+
+TimingWheel::TimingWheel(uint64_t _now)
+: now_(_now), size_(0) {
+    for (int level = 0; level < kLevels; ++level) {
+        for (int slot = 0; slot < kSlots; ++slot) {
+            slots_[level][slot].prev = &slots_[level][slot];
+            slots_[level][slot].next = &slots_[level][slot];
+        }
+    }
+}
+
+void TimingWheel::Add(Timer* _timer, uint64_t _expire) {
+    if (_timer->IsAdded()) Remove(_timer);
+
+    _timer->expire = _expire > now_ ? _expire : now_ + 1;
+    __Place(_timer);
+    ++size_;
+}
+
+void TimingWheel::Remove(Timer* _timer) {
+    if (!_timer->IsAdded()) return;
+
+    __Unlink(_timer);
+    --size_;
+}
+
+uint64_t TimingWheel::NextTick() const {
+    uint64_t next = ~(uint64_t)0;
+    if (0 == size_) return next;
+
+    // a slot of level 0 is its tick, a slot above is cascaded at the tick its index comes round with the lower bits all 0.
+    for (int level = 0; level < kLevels; ++level) {
+        int shift = level * kSlotBits;
+        uint64_t index = now_ >> shift;
+
+        for (uint64_t i = index + 1; i <= index + kSlots; ++i) {
+            if (__IsEmpty(slots_[level][i & (kSlots - 1)])) continue;
+
+            uint64_t tick = i << shift;
+            if (tick < next) next = tick;
+            break;
+        }
+    }
+
+    return next;
+}
+
+void TimingWheel::Advance(uint64_t _now, std::vector<Timer*>& _expired) {
+    while (now_ < _now) {
+        uint64_t next = NextTick();
+
+        if (next > _now) {
+            // no slot comes round in between, the timers stay where they are.
+            now_ = _now;
+            break;
+        }
+
+        now_ = next;
+
+        for (int level = 1; level < kLevels; ++level) {
+            if (0 != (now_ & (((uint64_t)1 << (level * kSlotBits)) - 1))) break;
+            __Cascade(level);
+        }
+
+        __Expire(_expired);
+    }
+}
+
+void TimingWheel::__Place(Timer* _timer) {
+    uint64_t delta = _timer->expire - now_;
+
+    for (int level = 0; level < kLevels; ++level) {
+        int shift = level * kSlotBits;
+
+        if (delta < ((uint64_t)1 << (shift + kSlotBits))) {
+            __Link(&slots_[level][(_timer->expire >> shift) & (kSlots - 1)], _timer);
+            return;
+        }
+    }
+
+    // too far away, at the last slot the top level reaches.
+    int shift = (kLevels - 1) * kSlotBits;
+    uint64_t farthest = now_ + ((uint64_t)1 << (shift + kSlotBits)) - 1;
+    __Link(&slots_[kLevels - 1][(farthest >> shift) & (kSlots - 1)], _timer);
+}
+
+void TimingWheel::__Cascade(int _level) {
+    Timer& head = slots_[_level][(now_ >> (_level * kSlotBits)) & (kSlots - 1)];
+
+    while (!__IsEmpty(head)) {
+        Timer* timer = head.next;
+        __Unlink(timer);
+        __Place(timer);
+    }
+}
+
+void TimingWheel::__Expire(std::vector<Timer*>& _expired) {
+    Timer& head = slots_[0][now_ & (kSlots - 1)];
+
+    while (!__IsEmpty(head)) {
+        Timer* timer = head.next;
+        __Unlink(timer);
+        --size_;
+        _expired.push_back(timer);
+    }
+}
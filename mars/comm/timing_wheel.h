@@ -0,0 +1,76 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+/*
+ * timing_wheel.h
+ *
+ *  Created on: 2026-10-17
+ */
+
+#ifndef COMM_TIMING_WHEEL_H_
+#define COMM_TIMING_WHEEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+ * a hierarchical timing wheel of 1ms ticks, kLevels levels of kSlots slots each.
+ * Add and Remove are O(1), a timer is cascaded down at most kLevels - 1 times before it expires.
+ * the wheel has no clock nor lock of its own, the owner advances it with its clock and serializes the calls.
+ */
+class TimingWheel {
+  public:
+    // linked in a slot, the owner embeds it in its own timer.
+    struct Timer {
+        Timer(): prev(NULL), next(NULL), expire(0) {}
+        bool IsAdded() const { return NULL != prev; }
+
+        Timer*      prev;
+        Timer*      next;
+        uint64_t    expire;
+    };
+
+    enum {
+        kSlotBits = 6,
+        kSlots = 1 << kSlotBits,
+        kLevels = 5,    // 2^30 ms, beyond it a timer is cascaded at the end of the top level and placed again.
+    };
+
+  public:
+    explicit TimingWheel(uint64_t _now);
+
+    // the ones at or before Now() expire at the next Advance.
+    void Add(Timer* _timer, uint64_t _expire);
+    void Remove(Timer* _timer);
+
+    size_t Size() const { return size_; }
+    uint64_t Now() const { return now_; }
+    // the tick Advance has something to do at, expiring or cascading, ~0 if the wheel is empty.
+    uint64_t NextTick() const;
+    // the ones due by _now are appended to _expired, in order of their ticks, and no longer added.
+    void Advance(uint64_t _now, std::vector<Timer*>& _expired);
+
+  private:
+    TimingWheel(const TimingWheel&);
+    TimingWheel& operator=(const TimingWheel&);
+
+    void __Place(Timer* _timer);
+    void __Cascade(int _level);
+    void __Expire(std::vector<Timer*>& _expired);
+
+  private:
+    Timer       slots_[kLevels][kSlots];    // the heads of circular lists
+    uint64_t    now_;                       // the ticks up to it are done
+    size_t      size_;
+};
+
+#endif  // COMM_TIMING_WHEEL_H_
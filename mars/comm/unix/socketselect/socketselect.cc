@@ -26,6 +26,10 @@
 #include <unistd.h>
 #include <algorithm>
 
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
 #include "mars/comm/xlogger/xlogger.h"
 
 
@@ -51,6 +55,19 @@ bool SocketSelectBreaker::ReCreate()
     pipes_[0] = -1;
     pipes_[1] = -1;
 
+#ifdef __linux__
+    // one eventfd for both ends
+    int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    xassert2(-1 != efd, "eventfd errno=%d", errno);
+
+    if (-1 != efd) {
+        pipes_[0] = efd;
+        pipes_[1] = efd;
+        create_success_ = true;
+        return create_success_;
+    }
+#endif
+
     int Ret;
     Ret = pipe(pipes_);
     xassert2(-1 != Ret, "pipe errno=%d", errno);
@@ -102,10 +119,14 @@ bool SocketSelectBreaker::Break()
     if (broken_) return true;
 
     char dummy[] = "1";
-    int ret = (int)write(pipes_[1], dummy, strlen(dummy));
+    uint64_t count = 1;
+    const void* buf = pipes_[0] == pipes_[1] ? (const void*)&count : (const void*)dummy;
+    size_t len = pipes_[0] == pipes_[1] ? sizeof(count) : strlen(dummy);
+
+    int ret = (int)write(pipes_[1], buf, len);
     broken_ = true;
 
-    if (ret < 0 || ret != (int)strlen(dummy))
+    if (ret < 0 || ret != (int)len)
     {
         xerror2(TSF"Ret:%_, errno:(%_, %_)", ret, errno, strerror(errno));
         broken_ =  false;
@@ -133,7 +154,7 @@ bool SocketSelectBreaker::Clear()
 void SocketSelectBreaker::Close()
 {
     broken_ =  true;
-    if(pipes_[1] >= 0)
+    if(pipes_[1] >= 0 && pipes_[1] != pipes_[0])
         close(pipes_[1]);
     if(pipes_[0] >= 0)
         close(pipes_[0]);
@@ -315,25 +336,39 @@ int SocketSelect::Errno() const
 
 SocketSelect::SocketSelect(SocketSelectBreaker& _breaker, bool _autoclear)
 : breaker_(_breaker), ret_(0), errno_(0), autoclear_(_autoclear)
+#ifdef __linux__
+, epfd_(-1), rounds_(0), poll_only_(false)
+#endif
 {}
 
-SocketSelect::~SocketSelect() {}
+SocketSelect::~SocketSelect() {
+#ifdef __linux__
+    __EpollClose();
+#endif
+}
 
 void SocketSelect::PreSelect()
 {
+    for (size_t i = 0; i < vfds_.size(); i++){
+        if (0 <= vfds_[i].fd && vfds_[i].fd < (int)fd_index_.size())
+            fd_index_[vfds_[i].fd] = 0;
+    }
+
     vfds_.clear();
 
-    int fd = breaker_.BreakerFD();
-    struct pollfd fditem = {0};
-    fditem.fd = fd;
-    fditem.events = POLLIN|POLLPRI|POLLERR;
-    vfds_.push_back(fditem);
+    __Set(breaker_.BreakerFD(), POLLIN|POLLPRI|POLLERR);
 
     ret_ = 0;
     errno_ = 0;
 }
 
 void SocketSelect::Consign(SocketSelect& _consignor) {
+#ifdef __linux__
+    // the fds come and go with the consignors, not worth registering.
+    poll_only_ = true;
+    __EpollClose();
+#endif
+
     int fd = _consignor.Breaker().BreakerFD();
     struct pollfd fditem = {0};
     fditem.fd = fd;
@@ -350,7 +385,15 @@ int SocketSelect::Select()
 
 int SocketSelect::Select(int _msec)
 {
+#ifdef __linux__
+    // a one round selector polls, epoll only pays off when the registration is kept.
+    if (!poll_only_ && 0 < rounds_++ && __EpollUpdate())
+        ret_ = __EpollWait(_msec);
+    else
+        ret_ = poll(&vfds_[0], (nfds_t)vfds_.size(), _msec);
+#else
     ret_ = poll(&vfds_[0], (nfds_t)vfds_.size(), _msec);
+#endif
     if (0 > ret_) { errno_ = errno; }
     
     if (autoclear_) Breaker().Clear();
@@ -394,82 +437,82 @@ bool SocketSelect::Report(SocketSelect& _consignor, int64_t _timeout) {
     return false;
 }
 
-void SocketSelect::Read_FD_SET(int _socket)
+struct pollfd* SocketSelect::__Find(int _socket)
 {
-    for (size_t i = 0; i < vfds_.size(); i++){
-        if (vfds_[i].fd == _socket){
-            vfds_[i].events |= POLLIN|POLLERR;
-            return;
-        }
-    }
-
-    struct pollfd fditem = {0};
-    fditem.fd = _socket;
-    fditem.events = POLLIN|POLLERR;
+    if (0 > _socket || _socket >= (int)fd_index_.size() || 0 == fd_index_[_socket]) return NULL;
+    return &vfds_[fd_index_[_socket] - 1];
+}
 
-    vfds_.push_back(fditem);
+const struct pollfd* SocketSelect::__Find(int _socket) const
+{
+    if (0 > _socket || _socket >= (int)fd_index_.size() || 0 == fd_index_[_socket]) return NULL;
+    return &vfds_[fd_index_[_socket] - 1];
 }
 
-void SocketSelect::Write_FD_SET(int _socket)
+void SocketSelect::__Set(int _socket, short _events)
 {
-    for (size_t i = 0; i < vfds_.size(); i++){
-        if (vfds_[i].fd == _socket){
-            vfds_[i].events |= POLLOUT|POLLERR;
-            return;
-        }
+    struct pollfd* item = __Find(_socket);
+
+    if (NULL != item) {
+        item->events |= _events;
+        return;
     }
 
     struct pollfd fditem = {0};
     fditem.fd = _socket;
-    fditem.events = POLLOUT|POLLERR;
+    fditem.events = _events;
 
     vfds_.push_back(fditem);
+
+    if (0 > _socket) return;
+    if (_socket >= (int)fd_index_.size()) fd_index_.resize(_socket + 1, 0);
+    fd_index_[_socket] = (int)vfds_.size();
+}
+
+void SocketSelect::Read_FD_SET(int _socket)
+{
+    __Set(_socket, POLLIN|POLLERR);
+}
+
+void SocketSelect::Write_FD_SET(int _socket)
+{
+    __Set(_socket, POLLOUT|POLLERR);
 }
 
 void SocketSelect::Exception_FD_SET(int _socket)
 {
-    for (size_t i = 0; i < vfds_.size(); i++){
-        if (vfds_[i].fd == _socket){
-            vfds_[i].events |= POLLERR;
-            return;
-        }
-    }
+    __Set(_socket, POLLERR);
+}
 
-    struct pollfd fditem = {0};
-    fditem.fd = _socket;
-    fditem.events = POLLERR;
+// a socket set later with the same fd is registered again, even with the same events.
+void SocketSelect::Forget(int _socket)
+{
+#ifdef __linux__
+    if (0 > _socket || _socket >= (int)epoll_events_.size() || 0 == epoll_events_[_socket]) return;
 
-    vfds_.push_back(fditem);
+    // gone from epfd_ already if it was closed
+    epoll_ctl(epfd_, EPOLL_CTL_DEL, _socket, NULL);
+    epoll_events_[_socket] = 0;
+    epoll_fds_.erase(std::remove(epoll_fds_.begin(), epoll_fds_.end(), _socket), epoll_fds_.end());
+#endif
 }
 
 int SocketSelect::Read_FD_ISSET(int _socket) const
 {
-    for (size_t i = 0; i < vfds_.size(); i++){
-        if (vfds_[i].fd == _socket)
-            return vfds_[i].revents & (POLLIN|POLLHUP);
-    }
-
-    return 0;
+    const struct pollfd* item = __Find(_socket);
+    return NULL != item ? item->revents & (POLLIN|POLLHUP) : 0;
 }
 
 int SocketSelect::Write_FD_ISSET(int _socket) const
 {
-    for (size_t i = 0; i < vfds_.size(); i++){
-        if (vfds_[i].fd == _socket)
-            return vfds_[i].revents & (POLLOUT);
-    }
-
-    return 0;
+    const struct pollfd* item = __Find(_socket);
+    return NULL != item ? item->revents & (POLLOUT) : 0;
 }
 
 int SocketSelect::Exception_FD_ISSET(int _socket) const
 {
-    for (size_t i = 0; i < vfds_.size(); i++){
-        if (vfds_[i].fd == _socket)
-            return vfds_[i].revents & (POLLERR|POLLNVAL);
-    }
-
-    return 0;
+    const struct pollfd* item = __Find(_socket);
+    return NULL != item ? item->revents & (POLLERR|POLLNVAL) : 0;
 }
 
 bool SocketSelect::IsException() const
@@ -480,16 +523,112 @@ bool SocketSelect::IsException() const
 
 bool SocketSelect::IsBreak() const
 {
-    int breakfd = breaker_.BreakerFD();
+    const struct pollfd* item = __Find(breaker_.BreakerFD());
+    return NULL != item ? item->revents & POLLIN : 0;
+}
 
-    for (size_t i = 0; i < vfds_.size(); i++){
-        if (vfds_[i].fd == breakfd)
-            return vfds_[i].revents & POLLIN;
+#ifdef __linux__
+static uint32_t __PollToEpoll(short _events) {
+    uint32_t events = 0;
+    if (_events & POLLIN) events |= EPOLLIN;
+    if (_events & POLLPRI) events |= EPOLLPRI;
+    if (_events & POLLOUT) events |= EPOLLOUT;
+    return events;
+}
+
+static short __EpollToPoll(uint32_t _events) {
+    short events = 0;
+    if (_events & EPOLLIN) events |= POLLIN;
+    if (_events & EPOLLPRI) events |= POLLPRI;
+    if (_events & EPOLLOUT) events |= POLLOUT;
+    if (_events & EPOLLERR) events |= POLLERR;
+    if (_events & EPOLLHUP) events |= POLLHUP;
+    return events;
+}
+
+// brings the registration up to this round's fds, false to poll this round instead.
+bool SocketSelect::__EpollUpdate()
+{
+    if (-1 == epfd_) {
+        epfd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (-1 == epfd_) {
+            poll_only_ = true;
+            return false;
+        }
     }
 
-    return 0;
+    // the ones left out of this round
+    for (size_t i = 0; i < epoll_fds_.size();) {
+        int fd = epoll_fds_[i];
+
+        if (NULL != __Find(fd)) {
+            ++i;
+            continue;
+        }
+
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, NULL);
+        epoll_events_[fd] = 0;
+        epoll_fds_[i] = epoll_fds_.back();
+        epoll_fds_.pop_back();
+    }
+
+    for (size_t i = 0; i < vfds_.size(); i++) {
+        int fd = vfds_[i].fd;
+        vfds_[i].revents = 0;
+
+        if (0 > fd) continue;
+        if (fd >= (int)epoll_events_.size()) epoll_events_.resize(fd + 1, 0);
+        if (epoll_events_[fd] == vfds_[i].events) continue;
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = __PollToEpoll(vfds_[i].events);
+        ev.data.fd = fd;
+
+        bool registered = 0 != epoll_events_[fd];
+        int ret = epoll_ctl(epfd_, registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+        if (0 != ret && registered && ENOENT == errno) ret = epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev);
+
+        if (0 != ret) {
+            // e.g. a closed fd, poll tells the caller with POLLNVAL.
+            xwarn2(TSF"epoll_ctl fd:%_, errno:(%_, %_)", fd, errno, strerror(errno));
+            __EpollClose();
+            poll_only_ = true;
+            return false;
+        }
+
+        if (!registered) epoll_fds_.push_back(fd);
+        epoll_events_[fd] = vfds_[i].events;
+    }
+
+    return true;
+}
+
+int SocketSelect::__EpollWait(int _msec)
+{
+    epoll_ready_.resize(vfds_.size());
+    int ret = epoll_wait(epfd_, &epoll_ready_[0], (int)epoll_ready_.size(), _msec);
+
+    for (int i = 0; i < ret; i++) {
+        struct pollfd* item = __Find(epoll_ready_[i].data.fd);
+        if (NULL != item) item->revents = __EpollToPoll(epoll_ready_[i].events);
+    }
+
+    return ret;
 }
 
+void SocketSelect::__EpollClose()
+{
+    if (-1 == epfd_) return;
+
+    close(epfd_);
+    epfd_ = -1;
+
+    for (size_t i = 0; i < epoll_fds_.size(); i++) epoll_events_[epoll_fds_[i]] = 0;
+    epoll_fds_.clear();
+}
+#endif
+
 SocketSelectBreaker& SocketSelect::Breaker()
 {
     return breaker_;
@@ -26,6 +26,10 @@
 #include <poll.h>
 #include <vector>
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
 #if __APPLE__
 #import <TargetConditionals.h>
 #if TARGET_OS_MAC
@@ -103,6 +107,12 @@ class SocketSelect {
 };
 
 #else
+/*
+ * on linux a selector used for more than one round waits on epoll, level-triggered, and keeps the fds
+ * registered between rounds, only the ones set or unset since the last round are updated.
+ * so don't close a socket and set another one with the same fd on the same selector in the next round,
+ * let a round go without it, Forget it once it's closed or use a new selector.
+ */
 class SocketSelect {
   public:
     SocketSelect(SocketSelectBreaker& _breaker, bool _autoclear = false);
@@ -110,6 +120,7 @@ class SocketSelect {
 
     void PreSelect();
     void Consign(SocketSelect& _consignor);
+    void Forget(int _socket);
     void Read_FD_SET(int _socket);
     void Write_FD_SET(int _socket);
     void Exception_FD_SET(int _socket);
@@ -133,13 +144,32 @@ class SocketSelect {
     SocketSelect(const SocketSelect&);
     SocketSelect& operator=(const SocketSelect&);
 
+    struct pollfd* __Find(int _socket);
+    const struct pollfd* __Find(int _socket) const;
+    void __Set(int _socket, short _events);
+#ifdef __linux__
+    bool __EpollUpdate();
+    int  __EpollWait(int _msec);
+    void __EpollClose();
+#endif
+
   protected:
     SocketSelectBreaker&       breaker_;
     std::vector<struct pollfd> vfds_;
+    std::vector<int>           fd_index_;   // fd -> 1 + its index in vfds_, 0 if not set in this round
 
     int         ret_;
     int         errno_;
     const bool  autoclear_;
+
+#ifdef __linux__
+    int                 epfd_;
+    int                 rounds_;
+    bool                poll_only_;
+    std::vector<int>    epoll_fds_;         // fds registered in epfd_
+    std::vector<short>  epoll_events_;      // by fd, poll events registered in epfd_
+    std::vector<struct epoll_event> epoll_ready_;
+#endif
 };
 
 #endif
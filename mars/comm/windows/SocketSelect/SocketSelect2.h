@@ -55,6 +55,7 @@ class SocketSelect {
     ~SocketSelect();
 
     void PreSelect();
+    void Forget(SOCKET _socket);
     void Read_FD_SET(SOCKET _socket);
     void Write_FD_SET(SOCKET _socket);
     void Exception_FD_SET(SOCKET _socket);
@@ -312,6 +312,10 @@ void SocketSelect::Exception_FD_SET(SOCKET _socket) {
     m_filter_map[_socket] |= (FD_CLOSE);
 }
 
+// nothing is kept between rounds.
+void SocketSelect::Forget(SOCKET _socket) {
+}
+
 int SocketSelect::Read_FD_ISSET(SOCKET _socket) const {
     return FD_ISSET(_socket, &readfd_);
 }
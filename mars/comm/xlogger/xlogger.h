@@ -128,9 +128,235 @@ private:
     char m_valuecache[65];
 };
 
+const struct TypeSafeFormat {TypeSafeFormat(){}} __tsf__;
+
+#if __cplusplus >= 201103L
+/*
+ * type safe format without TVariant: arguments are kept by reference and only formatted when their
+ * placeholder is reached, straight into a fixed buffer. like snprintf, Length() reports the full
+ * length even if the buffer is too small.
+ */
+class XLoggerTSFBuffer
+{
+public:
+    // _xlogger: bad arguments are spelled out in the message like XLogger::DoTypeSafeFormat did, XMessage only asserts
+    XLoggerTSFBuffer(char* _buf, size_t _size, bool _xlogger = false): m_buf(_buf), m_size(_size), m_pos(0), m_error(false), m_xlogger(_xlogger), m_arg(0) {}
+
+    void Write(const char* _str, size_t _len)
+    {
+        if (m_pos < m_size) memcpy(m_buf + m_pos, _str, _len < m_size - m_pos ? _len : m_size - m_pos);
+        m_pos += _len;
+    }
+
+    void Write(char _ch)
+    {
+        if (m_pos < m_size) m_buf[m_pos] = _ch;
+        ++m_pos;
+    }
+
+    void Error(const char* _msg) { m_error = true; Write(_msg, strlen(_msg)); assert(false); }
+
+    void BeginArg(size_t _index) { m_arg = _index; }
+
+    void NullArg()
+    {
+        if (!m_xlogger)
+        {
+            Write("(null)", 6);
+            assert(false);
+            return;
+        }
+
+        char temp[128] = {'\0'};
+        snprintf(temp, sizeof(temp), "{!!! void XLogger::DoTypeSafeFormat: _args[%d]->ToString() == NULL !!!}", (int)m_arg);
+        Error(temp);
+    }
+
+    void MissingArg(size_t _index)
+    {
+        if (!m_xlogger)
+        {
+            assert(false);
+            return;
+        }
+
+        char temp[128] = {'\0'};
+        snprintf(temp, sizeof(temp), "{!!! void XLogger::DoTypeSafeFormat: _args[%d] == NULL !!!}", (int)_index);
+        Error(temp);
+    }
+
+    void NotFitMode(char _ch)
+    {
+        if (!m_xlogger)
+        {
+            assert(false);
+            return;
+        }
+
+        char temp[128] = {'\0'};
+        snprintf(temp, sizeof(temp), "{!!! void XLogger::DoTypeSafeFormat: %%%c not fit mode !!!}", _ch);
+        Error(temp);
+    }
+
+    size_t Length() const { return m_pos; }
+    bool HasError() const { return m_error; }
+
+private:
+    char* m_buf;
+    size_t m_size;
+    size_t m_pos;
+    bool m_error;
+    bool m_xlogger;
+    size_t m_arg;
+};
+
+template<typename T>
+inline void xlogger_tsf_write_integer(XLoggerTSFBuffer& _buf, T _value)
+{
+    // digits are generated backwards, no reverse and no strlen
+    char temp[24];
+    char* end = temp + sizeof(temp);
+    char* ptr = end;
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wtype-limits"
+#endif
+    bool negative = _value < 0;
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+    do
+    {
+        T quotient = _value / 10;
+        *(--ptr) = (char)('0' + (negative ? quotient*10 - _value : _value - quotient*10));
+        _value = quotient;
+    } while (_value);
+
+    if (negative) *(--ptr) = '-';
+    _buf.Write(ptr, end - ptr);
+}
+
+template<typename T>
+inline void xlogger_tsf_write_float(XLoggerTSFBuffer& _buf, T _value, const char* _format) { char temp[65]; int len = snprintf(temp, sizeof(temp), _format, _value); if (0 < len) _buf.Write(temp, len < (int)sizeof(temp) ? len : sizeof(temp) - 1); }
+
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, bool _value) { if (_value) _buf.Write("true", 4); else _buf.Write("false", 5); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, char _value) { _buf.Write(_value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, signed char _value) { _buf.Write((char)_value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, unsigned char _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, short _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, unsigned short _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, int _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, unsigned int _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, long _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, unsigned long _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, long long _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, unsigned long long _value) { xlogger_tsf_write_integer(_buf, _value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, float _value) { xlogger_tsf_write_float(_buf, _value, "%E"); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, double _value) { xlogger_tsf_write_float(_buf, _value, "%E"); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, long double _value) { xlogger_tsf_write_float(_buf, _value, "%LE"); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, const void* _value) { char temp[65] = {'0', 'x'}; xlogger_itoa<16>((uintptr_t)_value, temp+2); _buf.Write(temp, strlen(temp)); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, const char* _value) { if (NULL != _value) _buf.Write(_value, strlen(_value)); else _buf.NullArg(); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, char* _value) { xlogger_tsf_write(_buf, (const char*)_value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, const unsigned char* _value) { xlogger_tsf_write(_buf, (const char*)_value); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, const std::string& _value) { _buf.Write(_value.data(), _value.size()); }
+inline void xlogger_tsf_write(XLoggerTSFBuffer& _buf, const TVariant& _value) { xlogger_tsf_write(_buf, _value.ToString()); }
+
+struct XLoggerTSFArg
+{
+    void (*write)(XLoggerTSFBuffer& _buf, const void* _value);
+    const void* value;
+};
+
+template<typename T>
+void xlogger_tsf_write_arg(XLoggerTSFBuffer& _buf, const void* _value) { xlogger_tsf_write(_buf, *(const T*)_value); }
+
+// literal runs are copied in one piece, %_ takes the next argument, %0-%9 the indexed one, %% is '%'.
+inline void xlogger_tsf_format(XLoggerTSFBuffer& _buf, const char* _format, const XLoggerTSFArg* _args, size_t _count)
+{
+    const char* current = _format;
+    size_t count = 0;
+
+    while ('\0' != *current)
+    {
+        const char* percent = strchr(current, '%');
+        if (NULL == percent)
+        {
+            _buf.Write(current, strlen(current));
+            break;
+        }
+
+        _buf.Write(current, percent - current);
+
+        char nextch = *(percent+1);
+        if (('0' <= nextch && nextch <= '9') || nextch == '_')
+        {
+            size_t index = count;
+            if (nextch != '_') index = nextch - '0';
+
+            if (index < _count)
+            {
+                _buf.BeginArg(index);
+                _args[index].write(_buf, _args[index].value);
+            } else {
+                _buf.MissingArg(index);
+            }
+            count++;
+            current = percent + 2;
+        }
+        else if (nextch == '%') {
+            _buf.Write('%');
+            current = percent + 2;
+        } else {
+            _buf.NotFitMode(nextch);
+            current = percent + 1;
+        }
+    }
+}
+
+#define XLOGGER_TSF_ARGS(args) XLoggerTSFArg args[sizeof...(Args) + 1] = { {&xlogger_tsf_write_arg<Args>, &_args}..., {NULL, NULL} }
+
+/*
+ * format into a caller provided buffer, returns the length which would have been written like snprintf.
+ * e.g. xlogger_tsf_snprintf(buf, sizeof(buf), TSF"%_:%_", ip, port);
+ */
+template<typename... Args>
+size_t xlogger_tsf_snprintf(char* _buf, size_t _size, const TypeSafeFormat&, const char* _format, const Args&... _args)
+{
+    if (NULL == _format) return 0;
+
+    XLOGGER_TSF_ARGS(args);
+    XLoggerTSFBuffer buffer(_buf, _size);
+    xlogger_tsf_format(buffer, _format, args, sizeof...(Args));
+
+    if (0 < _size) _buf[buffer.Length() < _size ? buffer.Length() : _size - 1] = '\0';
+    return buffer.Length();
+}
+
+// format into a stack buffer first, only an oversized message is formatted again in place of _holder.
+inline bool xlogger_tsf_append(std::string& _holder, const char* _format, const XLoggerTSFArg* _args, size_t _count, bool _xlogger)
+{
+    char temp[1024];
+    XLoggerTSFBuffer buffer(temp, sizeof(temp), _xlogger);
+    xlogger_tsf_format(buffer, _format, _args, _count);
+
+    if (buffer.Length() <= sizeof(temp))
+    {
+        _holder.append(temp, buffer.Length());
+        return !buffer.HasError();
+    }
+
+    size_t pos = _holder.size();
+    _holder.resize(pos + buffer.Length());
+    XLoggerTSFBuffer holder_buffer(&_holder[pos], buffer.Length(), _xlogger);
+    xlogger_tsf_format(holder_buffer, _format, _args, _count);
+    return !buffer.HasError();
+}
+#endif
+
 
 
-const struct TypeSafeFormat {TypeSafeFormat(){}} __tsf__;
 const struct XLoggerTag {XLoggerTag(){}} __xlogger_tag__;
 const struct XLoggerInfoNull {XLoggerInfoNull(){}} __xlogger_info_null__;
 
@@ -173,6 +399,10 @@ public:
 #endif
 	XMessage& VPrintf(const char* _format, va_list _list);
 
+#if __cplusplus >= 201103L
+	template<typename... Args>
+	XMessage&  operator()(const TypeSafeFormat&, const char* _format, const Args&... _args);
+#else
 #define XLOGGER_FORMAT_ARGS(n) PP_ENUM_TRAILING_PARAMS(n, const TVariant& a)
 	XMessage&  operator()(const TypeSafeFormat&, const char*_format XLOGGER_FORMAT_ARGS(0));
 	XMessage&  operator()(const TypeSafeFormat&, const char*_format XLOGGER_FORMAT_ARGS(1));
@@ -192,9 +422,14 @@ public:
 	XMessage&  operator()(const TypeSafeFormat&, const char*_format XLOGGER_FORMAT_ARGS(15));
 	XMessage&  operator()(const TypeSafeFormat&, const char*_format XLOGGER_FORMAT_ARGS(16));
 #undef XLOGGER_FORMAT_ARGS
+#endif
 
 private:
+#if __cplusplus >= 201103L
+	void DoTypeSafeFormat(const char* _format, const XLoggerTSFArg* _args, size_t _count);
+#else
 	void DoTypeSafeFormat(const char* _format, const TVariant** _args);
+#endif
 
 private:
 //    XMessage(const XMessage&);
@@ -293,6 +528,10 @@ public:
 #endif
 	XLogger& VPrintf(const char* _format, va_list _list);
 
+#if __cplusplus >= 201103L
+	template<typename... Args>
+	XLogger&  operator()(const TypeSafeFormat&, const char* _format, const Args&... _args);
+#else
 #define XLOGGER_FORMAT_ARGS(n) PP_ENUM_TRAILING_PARAMS(n, const TVariant& a)
 	XLogger&  operator()(const TypeSafeFormat&, const char*_format XLOGGER_FORMAT_ARGS(0));
 	XLogger&  operator()(const TypeSafeFormat&, const char*_format XLOGGER_FORMAT_ARGS(1));
@@ -312,9 +551,14 @@ public:
 	XLogger&  operator()(const TypeSafeFormat&, const char*_format XLOGGER_FORMAT_ARGS(15));
 	XLogger&  operator()(const TypeSafeFormat&, const char*_format XLOGGER_FORMAT_ARGS(16));
 #undef XLOGGER_FORMAT_ARGS
+#endif
 
 private:
+#if __cplusplus >= 201103L
+	void DoTypeSafeFormat(const char* _format, const XLoggerTSFArg* _args, size_t _count);
+#else
 	void DoTypeSafeFormat(const char* _format, const TVariant** _args);
+#endif
     
 private:
     XLogger(const XLogger&);
@@ -441,6 +685,20 @@ inline XMessage& XMessage::operator()(const char* _format, ...)
     return *this;
 }
 
+#if __cplusplus >= 201103L
+template<typename... Args>
+inline XMessage& XMessage::operator()(const TypeSafeFormat&, const char* _format, const Args&... _args) {
+	if (_format != NULL) {
+		XLOGGER_TSF_ARGS(args);
+		DoTypeSafeFormat(_format, args, sizeof...(Args));
+	}
+	return *this;
+}
+
+inline void XMessage::DoTypeSafeFormat(const char* _format, const XLoggerTSFArg* _args, size_t _count) {
+	xlogger_tsf_append(m_message, _format, _args, _count, false);
+}
+#else
 #define XLOGGER_FORMAT_ARGS(n) PP_ENUM_TRAILING_PARAMS(n, const TVariant& a)
 #define XLOGGER_VARIANT_ARGS(n) PP_ENUM_PARAMS(n, &a)
 #define XLOGGER_VARIANT_ARGS_NULL(n) PP_ENUM(n, NULL)
@@ -519,6 +777,7 @@ inline void XMessage::DoTypeSafeFormat(const char* _format, const TVariant** _ar
 		}
 	}
 }
+#endif
 
 ///////////////////////////XLogger////////////////////
 inline XLogger& XLogger::operator<<(const TVariant& _value)
@@ -578,6 +837,20 @@ inline XLogger& XLogger::operator()(const char* _format, ...)
     return *this;
 }
 
+#if __cplusplus >= 201103L
+template<typename... Args>
+inline XLogger& XLogger::operator()(const TypeSafeFormat&, const char* _format, const Args&... _args) {
+	if (_format != NULL) {
+		XLOGGER_TSF_ARGS(args);
+		DoTypeSafeFormat(_format, args, sizeof...(Args));
+	}
+	return *this;
+}
+
+inline void XLogger::DoTypeSafeFormat(const char* _format, const XLoggerTSFArg* _args, size_t _count) {
+	if (!xlogger_tsf_append(m_message, _format, _args, _count, true)) m_info.level = kLevelFatal;
+}
+#else
 #define XLOGGER_FORMAT_ARGS(n) PP_ENUM_TRAILING_PARAMS(n, const TVariant& a)
 #define XLOGGER_VARIANT_ARGS(n) PP_ENUM_PARAMS(n, &a)
 #define XLOGGER_VARIANT_ARGS_NULL(n) PP_ENUM(n, NULL)
@@ -669,7 +942,9 @@ inline void XLogger::DoTypeSafeFormat(const char* _format, const TVariant** _arg
 		}
 	}
 }
+#endif
 
+#undef XLOGGER_TSF_ARGS
 #endif //cpp
 
 
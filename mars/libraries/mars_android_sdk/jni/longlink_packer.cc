@@ -67,8 +67,7 @@ static int __unpack_test(const void* _packed, size_t _packed_len, uint32_t& _cmd
     return LONGLINK_UNPACK_OK;
 }
 
-void longlink_pack(uint32_t _cmdid, uint32_t _seq, const void* _raw, size_t _raw_len, AutoBuffer& _packed) {
-    
+static void __pack_header(uint32_t _cmdid, uint32_t _seq, size_t _raw_len, AutoBuffer& _packed) {
     __STNetMsgXpHeader st = {0};
     st.head_length = htonl(sizeof(__STNetMsgXpHeader));
     st.client_version = htonl(sg_client_version);
@@ -76,14 +75,25 @@ void longlink_pack(uint32_t _cmdid, uint32_t _seq, const void* _raw, size_t _raw
     st.seq = htonl(_seq);
     st.body_length = htonl(_raw_len);
 
-    _packed.AllocWrite(sizeof(__STNetMsgXpHeader) + _raw_len);
     _packed.Write(&st, sizeof(st));
+}
+
+void longlink_pack(uint32_t _cmdid, uint32_t _seq, const void* _raw, size_t _raw_len, AutoBuffer& _packed) {
+    
+    _packed.AllocWrite(sizeof(__STNetMsgXpHeader) + _raw_len);
+    __pack_header(_cmdid, _seq, _raw_len, _packed);
     
     if (NULL != _raw) _packed.Write(_raw, _raw_len);
     
     _packed.Seek(0, AutoBuffer::ESeekStart);
 }
 
+bool longlink_pack_header(uint32_t _cmdid, uint32_t _seq, size_t _raw_len, AutoBuffer& _header) {
+    __pack_header(_cmdid, _seq, _raw_len, _header);
+    _header.Seek(0, AutoBuffer::ESeekStart);
+    return true;
+}
+
 
 int longlink_unpack(const AutoBuffer& _packed, uint32_t& _cmdid, uint32_t& _seq, size_t& _package_len, AutoBuffer& _body) {
    size_t body_len = 0;
@@ -96,6 +106,35 @@ int longlink_unpack(const AutoBuffer& _packed, uint32_t& _cmdid, uint32_t& _seq,
     return ret;
 }
 
+int longlink_unpack_batch(const void* _packed, size_t _packed_len, std::vector<LongLinkPackInfo>& _packs, LongLinkPackInfo& _pending) {
+    _packs.clear();
+    memset(&_pending, 0, sizeof(_pending));
+    
+    const char* packed = (const char*)_packed;
+    size_t offset = 0;
+    
+    while (offset < _packed_len) {
+        LongLinkPackInfo info = {0};
+        info.offset = offset;
+        
+        int ret = __unpack_test(packed + offset, _packed_len - offset, info.cmdid, info.seq, info.package_len, info.body_len);
+        
+        // a header claiming less than itself would never move on
+        if (LONGLINK_UNPACK_OK == ret && info.package_len < sizeof(__STNetMsgXpHeader) + info.body_len) ret = LONGLINK_UNPACK_FALSE;
+        
+        if (LONGLINK_UNPACK_OK != ret) {
+            _pending = info;
+            return ret;
+        }
+        
+        info.body_offset = offset + info.package_len - info.body_len;
+        _packs.push_back(info);
+        offset += info.package_len;
+    }
+    
+    return LONGLINK_UNPACK_OK;
+}
+
 /**
  * nooping param
  */
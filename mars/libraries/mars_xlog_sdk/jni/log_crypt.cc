@@ -12,9 +12,11 @@
 #include <string.h>
 #include <sys/time.h>
 #include <time.h>
+#include <stdio.h>
 
 static const char kMagicSyncStart = '\x03';
 static const char kMagicAsyncStart ='\x04';
+static const char kMagicAsyncPendingStart = '\x05';
 static const char kMagicEnd  = '\0';
 
 static uint16_t __GetSeq(bool _is_async) {
@@ -46,10 +48,12 @@ uint32_t LogCrypt::GetTailerLen() {
     return sizeof(kMagicEnd);
 }
 
-void LogCrypt::SetHeaderInfo(char* _data, bool _is_async) {
+void LogCrypt::SetHeaderInfo(char* _data, bool _is_async, bool _is_pending) {
 
     
-    if (_is_async) {
+    if (_is_async && _is_pending) {
+        memcpy(_data, &kMagicAsyncPendingStart, sizeof(kMagicAsyncPendingStart));
+    } else if (_is_async) {
         memcpy(_data, &kMagicAsyncStart, sizeof(kMagicAsyncStart));
     } else {
         memcpy(_data, &kMagicSyncStart, sizeof(kMagicSyncStart));
@@ -81,11 +85,38 @@ void LogCrypt::SetTailerInfo(char* _data) {
     memcpy(_data, &kMagicEnd, sizeof(kMagicEnd));
 }
 
+bool LogCrypt::IsPending(const char* const _data, size_t _len) {
+    if (_len < GetHeaderLen()) return false;
+    
+    return kMagicAsyncPendingStart == _data[0];
+}
+
+void LogCrypt::CommitPending(char* _data, bool _is_compress, uint32_t _log_len) {
+    if (_is_compress) {
+        memcpy(_data, &kMagicAsyncStart, sizeof(kMagicAsyncStart));
+    } else {
+        memcpy(_data, &kMagicSyncStart, sizeof(kMagicSyncStart));
+    }
+    
+    memcpy(_data + GetHeaderLen() - sizeof(uint32_t) * 2, &_log_len, sizeof(_log_len));
+}
+
+uint16_t LogCrypt::GetSeq(const char* const _data, size_t _len) {
+    if (_len < GetHeaderLen()) return 0;
+    
+    char start = _data[0];
+    if (kMagicAsyncStart != start && kMagicSyncStart != start && kMagicAsyncPendingStart != start) return 0;
+    
+    uint16_t seq = 0;
+    memcpy(&seq, _data + sizeof(start), sizeof(seq));
+    return seq;
+}
+
 uint32_t LogCrypt::GetLogLen(const char*  const _data, size_t _len) {
     if (_len < GetHeaderLen()) return 0;
     
     char start = _data[0];
-    if (kMagicAsyncStart != start && kMagicSyncStart != start) return 0;
+    if (kMagicAsyncStart != start && kMagicSyncStart != start && kMagicAsyncPendingStart != start) return 0;
     
     uint32_t len = 0;
     memcpy(&len, _data + GetHeaderLen() - sizeof(uint32_t) * 2, sizeof(len));
@@ -104,7 +135,7 @@ bool LogCrypt::GetLogHour(const char* const _data, size_t _len, int& _begin_hour
     if (_len < GetHeaderLen()) return false;
     
     char start = _data[0];
-    if (kMagicAsyncStart != start && kMagicSyncStart != start) return false;
+    if (kMagicAsyncStart != start && kMagicSyncStart != start && kMagicAsyncPendingStart != start) return false;
     
     char begin_hour = _data[sizeof(char)+sizeof(uint16_t)];
     char end_hour = _data[sizeof(char)+sizeof(uint16_t)+sizeof(char)];
@@ -308,7 +339,7 @@ bool LogCrypt::Fix(char* _data, size_t _data_len, bool& _is_async, uint32_t& _ra
     }
     
     char start = _data[0];
-    if (kMagicAsyncStart != start && kMagicSyncStart != start) {
+    if (kMagicAsyncStart != start && kMagicSyncStart != start && kMagicAsyncPendingStart != start) {
         return false;
     }
     
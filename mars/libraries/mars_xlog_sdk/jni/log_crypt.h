@@ -25,9 +25,14 @@ public:
     uint32_t GetHeaderLen();
     uint32_t GetTailerLen();
     
-    void SetHeaderInfo(char* _data, bool _is_async);
+    void SetHeaderInfo(char* _data, bool _is_async, bool _is_pending = false);
     void SetTailerInfo(char* _data);
     
+    // pending block holds raw async logs which will be compressed when flushed, it only exists in the mmap cache.
+    bool IsPending(const char* const _data, size_t _len);
+    void CommitPending(char* _data, bool _is_compress, uint32_t _log_len);
+    
+    uint16_t GetSeq(const char* const _data, size_t _len);
     uint32_t GetLogLen(const char* const _data, size_t _len);
     void UpdateLogLen(char* _data, uint32_t _add_len);
     
@@ -13,6 +13,7 @@ public class Xlog implements Log.LogImp {
 
 	public static final int AppednerModeAsync = 0;
 	public static final int AppednerModeSync = 1;
+	public static final int AppednerModeBinary = 2;
 
 	static class XLoggerInfo {
 		public int level;
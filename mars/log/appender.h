@@ -28,6 +28,7 @@ enum TAppenderMode
 {
     kAppednerAsync,
     kAppednerSync,
+    kAppednerBinary,    // async, compact binary records formatted offline by decode_mars_log_file.py
 };
 
 void appender_open(TAppenderMode _mode, const char* _dir, const char* _nameprefix);
@@ -40,6 +41,10 @@ bool appender_getfilepath_from_timespan(int _timespan, const char* _prefix, std:
 bool appender_get_current_log_path(char* _log_path, unsigned int _len);
 bool appender_get_current_log_cache_path(char* _logPath, unsigned int _len);
 void appender_set_console_log(bool _is_open);
+// zlib level used when the async buffer is flushed, default Z_BEST_COMPRESSION.
+void appender_set_compress_level(int _level);
+// async mode only, every thread formats into its own lock-free ring and a drainer thread batches them into the buffer.
+void appender_set_staging_ring(bool _is_open);
 
 
 #endif /* APPENDER_H_ */
@@ -5,6 +5,7 @@ import os
 import glob
 import zlib
 import struct
+import time
 
 
 MAGIC_NO_COMPRESS_START = 0x03;
@@ -12,6 +13,14 @@ MAGIC_COMPRESS_START = 0x04;
 
 MAGIC_END  = 0x00;
 
+BINARY_SIGNATURE = bytearray(b'\x1bXB\x01')
+BINARY_RECORD_SYNC = 1
+BINARY_RECORD_CALLSITE = 2
+BINARY_RECORD_LOG = 3
+BINARY_RECORD_TEXT = 4
+BINARY_LEVEL_NO_TIME = 0x80
+LEVEL_STRINGS = ['V', 'D', 'I', 'W', 'E', 'F']
+
 lastseq = 0;
 
 def IsGoodLogBuffer(_buffer, _offset, count):
@@ -45,6 +54,80 @@ def GetLogStartPos(_buffer, _count):
 		
 	return -1	
 	
+def ReadVarint(_buffer, _offset):
+	value = 0
+	shift = 0
+	while True:
+		b = _buffer[_offset]
+		_offset += 1
+		value |= (b & 0x7f) << shift
+		if b < 0x80: return (value, _offset)
+		shift += 7
+
+def ReadZigzag(_buffer, _offset):
+	value, _offset = ReadVarint(_buffer, _offset)
+	return ((value >> 1) ^ -(value & 1), _offset)
+
+def ReadString(_buffer, _offset):
+	length, _offset = ReadVarint(_buffer, _offset)
+	if _offset + length > len(_buffer): raise IndexError('string length:%d out of buffer'%length)
+	return (_buffer[_offset:_offset+length], _offset+length)
+
+def FormatTime(_ms, _gmtoff):
+	t = time.gmtime(_ms // 1000 + _gmtoff)
+	return '%d-%02d-%02d %+.1f %02d:%02d:%02d.%.3d'%(t.tm_year, t.tm_mon, t.tm_mday, _gmtoff / 3600.0, t.tm_hour, t.tm_min, t.tm_sec, _ms % 1000)
+
+# records written by kAppednerBinary, see log/src/log_binary_formater.h
+def DecodeBinaryBuffer(_buffer, _outbuffer):
+	offset = len(BINARY_SIGNATURE)
+	callsites = {}
+	pid = maintid = base_time = gmtoff = 0
+
+	try:
+		while offset < len(_buffer):
+			record = _buffer[offset]
+			offset += 1
+
+			if BINARY_RECORD_SYNC == record:
+				pid, offset = ReadZigzag(_buffer, offset)
+				maintid, offset = ReadZigzag(_buffer, offset)
+				base_time, offset = ReadVarint(_buffer, offset)
+				gmtoff, offset = ReadZigzag(_buffer, offset)
+				callsites = {}
+			elif BINARY_RECORD_CALLSITE == record:
+				id, offset = ReadVarint(_buffer, offset)
+				line, offset = ReadZigzag(_buffer, offset)
+				tag, offset = ReadString(_buffer, offset)
+				filename, offset = ReadString(_buffer, offset)
+				funcname, offset = ReadString(_buffer, offset)
+				callsites[id] = bytearray(b'[') + tag + bytearray(b'][') + filename + bytearray(b', ') + funcname + bytearray(', %d]['%line, 'ascii')
+			elif BINARY_RECORD_LOG == record:
+				level = _buffer[offset]
+				offset += 1
+				id, offset = ReadVarint(_buffer, offset)
+				logtime = ''
+				if 0 == (level & BINARY_LEVEL_NO_TIME):
+					delta, offset = ReadZigzag(_buffer, offset)
+					base_time += delta
+					logtime = FormatTime(base_time, gmtoff)
+				tid, offset = ReadZigzag(_buffer, offset)
+				body, offset = ReadString(_buffer, offset)
+
+				level &= ~BINARY_LEVEL_NO_TIME
+				header = '[%s][%s][%d, %d%s]'%(LEVEL_STRINGS[level] if level < len(LEVEL_STRINGS) else '?', logtime, pid, tid, '*' if tid == maintid else '')
+				_outbuffer.extend(bytearray(header, 'ascii'))
+				_outbuffer.extend(callsites.get(id, bytearray(b'[?][?, ?, ?][')))
+				_outbuffer.extend(body)
+				if 0 == len(body) or 0x0a != body[-1]: _outbuffer.extend(b'\n')
+			elif BINARY_RECORD_TEXT == record:
+				text, offset = ReadString(_buffer, offset)
+				_outbuffer.extend(text)
+			else:
+				_outbuffer.extend(bytearray("[F]decode_log_file.py binary record:%d at %d is unknown\n"%(record, offset-1), 'ascii'))
+				return
+	except IndexError:
+		_outbuffer.extend(bytearray("[F]decode_log_file.py binary block is truncated at %d\n"%offset, 'ascii'))
+
 def DecodeBuffer(_buffer, _offset, _outbuffer):
 	
 	if _offset >= len(_buffer): return -1
@@ -92,7 +175,8 @@ def DecodeBuffer(_buffer, _offset, _outbuffer):
 		_outbuffer.extend("[F]decode_log_file.py decompress err, " + str(e) + "\n")
 		return _offset+headerLen+length+1
 
-	_outbuffer.extend(tmpbuffer)
+	if BINARY_SIGNATURE == bytearray(tmpbuffer[:len(BINARY_SIGNATURE)]): DecodeBinaryBuffer(bytearray(tmpbuffer), _outbuffer)
+	else: _outbuffer.extend(tmpbuffer)
 	
 	return _offset+headerLen+length+1
 
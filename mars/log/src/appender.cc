@@ -37,6 +37,7 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 #include <sys/mount.h>
+#include <sys/syscall.h>
 #endif
 
 #include <ctype.h>
@@ -46,6 +47,8 @@
 #include <zlib.h>
 
 #include <string>
+#include <list>
+#include <vector>
 #include <algorithm>
 
 #include "boost/bind.hpp"
@@ -68,6 +71,10 @@
 #include "mars/comm/verinfo.h"
 
 #include "log_buffer.h"
+#include "log_file_io.h"
+#include "log_index.h"
+#include "log_staging_ring.h"
+#include "log_binary_formater.h"
 
 #define LOG_EXT "xlog"
 
@@ -80,9 +87,22 @@ static std::string sg_logdir;
 static std::string sg_cache_logdir;
 static std::string sg_logfileprefix;
 
+static Mutex sg_mutex_log_queue;
+#ifdef _WIN32
+static Condition& sg_cond_log_written = *(new Condition());
+#else
+static Condition sg_cond_log_written;
+#endif
+static std::vector<struct iovec> sg_log_queue;     // guarded by sg_mutex_log_queue, blocks of callers waiting in __log2file
+static uint64_t sg_log_queued_seq = 0;             // guarded by sg_mutex_log_queue
+static uint64_t sg_log_written_seq = 0;            // guarded by sg_mutex_log_queue
+static bool sg_log_queue_writing = false;          // guarded by sg_mutex_log_queue
+
 static Mutex sg_mutex_log_file;
-static FILE* sg_logfile = NULL;
+static int sg_logfile = -1;                      // kept open until the day or the dir changes
 static time_t sg_openfiletime = 0;
+static time_t sg_logfile_expiretime = 0;         // next local midnight after sg_openfiletime
+static LogIndex sg_logindex;                     // of sg_logfile
 static std::string sg_current_dir;
 
 static Mutex sg_mutex_buffer_async;
@@ -92,7 +112,12 @@ static Condition& sg_cond_buffer_async = *(new Condition());  // 改成引用, 
 static Condition sg_cond_buffer_async;
 #endif
 
-static LogBuffer* sg_log_buff = NULL;
+// two blocks of the mmap cache swap roles: logs go to sg_log_buff while the other one is written to the file.
+static LogBuffer* sg_log_buffs[2] = {NULL, NULL};
+static LogBuffer* sg_log_buff = NULL;            // guarded by sg_mutex_buffer_async, one of sg_log_buffs
+static Mutex sg_mutex_buffer_flush;              // only one flusher at a time, the standby block is empty when it's held
+static LogBinaryFormater sg_binary_formater;     // guarded by sg_mutex_buffer_async
+static bool sg_buffer_binary = false;            // guarded by sg_mutex_buffer_async, kind of the current block
 
 static volatile bool sg_log_close = true;
 
@@ -104,6 +129,8 @@ static bool sg_consolelog_open = true;
 static bool sg_consolelog_open = false;
 #endif
 
+static void __closelogfile();
+static void __writetips2console(const char* _tips_format, ...);
 static void __async_log_thread();
 static Thread sg_thread_async(&__async_log_thread);
 
@@ -114,6 +141,26 @@ static std::string sg_log_extra_msg;
 
 static boost::iostreams::mapped_file sg_mmmap_file;
 
+static const unsigned int kStagingRingLength = 32 * 1024;
+static const unsigned int kStagingBatchLength = 16 * 1024;
+static const long kStagingDrainInterval = 100;  // ms
+
+static volatile bool sg_staging_ring_open = false;
+static Mutex sg_mutex_staging_rings;             // guard sg_staging_rings
+static std::list<LogStagingRing*> sg_staging_rings;
+static Mutex sg_mutex_staging_drain;             // only one consumer of the rings at a time
+#ifdef _WIN32
+static Condition& sg_cond_staging_drain = *(new Condition());
+#else
+static Condition sg_cond_staging_drain;
+#endif
+
+static void __staging_ring_thread_exit(void* _ring);
+static Tss sg_tss_staging_ring(&__staging_ring_thread_exit);
+
+static void __staging_drain_thread();
+static Thread sg_thread_staging_drain(&__staging_drain_thread);
+
 namespace {
 class ScopeErrno {
   public:
@@ -188,6 +235,43 @@ static void __del_timeout_file(const std::string& _log_path) {
     }
 }
 
+static bool __copy_file(int _src_fd, int _dst_fd, off_t _len) {
+    off_t copied = 0;
+
+#if defined(__linux__) && defined(__NR_copy_file_range)
+    // copied inside the kernel, it falls back to the loop below if the kernel or the filesystem can't.
+    while (copied < _len) {
+        ssize_t ret = syscall(__NR_copy_file_range, _src_fd, NULL, _dst_fd, NULL, (size_t)(_len - copied), 0);
+        if (0 < ret) {
+            copied += ret;
+        } else if (0 > ret && EINTR == errno) {
+            continue;
+        } else {
+            break;
+        }
+    }
+#endif
+
+    char buffer[64 * 1024];
+    while (copied < _len) {
+        ssize_t read_ret = read(_src_fd, buffer, sizeof(buffer));
+        if (0 > read_ret && EINTR == errno) continue;
+        if (0 >= read_ret) break;
+
+        ssize_t written = 0;
+        while (written < read_ret) {
+            ssize_t write_ret = write(_dst_fd, buffer + written, read_ret - written);
+            if (0 > write_ret && EINTR == errno) continue;
+            if (0 >= write_ret) return false;
+            written += write_ret;
+        }
+        copied += read_ret;
+    }
+
+    return copied >= _len;
+}
+
+// appends _src_file to _dst_file, the caller removes _src_file on success.
 static bool __append_file(const std::string& _src_file, const std::string& _dst_file) {
     if (_src_file == _dst_file) {
         return false;
@@ -198,54 +282,45 @@ static bool __append_file(const std::string& _src_file, const std::string& _dst_
     }
     
     if (0 == boost::filesystem::file_size(_src_file)){
+        remove(LogIndex::IndexPath(_src_file).c_str());
         return true;
     }
 
-    FILE* src_file = fopen(_src_file.c_str(), "rb");
-
-    if (NULL == src_file) {
-        return false;
+    // nothing to append to, the file is moved as a whole. fails across file systems.
+    if (!boost::filesystem::exists(_dst_file) && 0 == rename(_src_file.c_str(), _dst_file.c_str())) {
+        remove(LogIndex::IndexPath(_dst_file).c_str());
+        rename(LogIndex::IndexPath(_src_file).c_str(), LogIndex::IndexPath(_dst_file).c_str());
+        return true;
     }
 
-    FILE* dest_file = fopen(_dst_file.c_str(), "ab");
+    int src_fd = open(_src_file.c_str(), O_RDONLY | O_BINARY);
 
-    if (NULL == dest_file) {
-        fclose(src_file);
+    if (-1 == src_fd) {
         return false;
     }
 
-    fseek(src_file, 0, SEEK_END);
-    long src_file_len = ftell(src_file);
-    long dst_file_len = ftell(dest_file);
-    fseek(src_file, 0, SEEK_SET);
-
-    char buffer[4096] = {0};
-
-    while (true) {
-        if (feof(src_file)) break;
-
-        size_t read_ret = fread(buffer, 1, sizeof(buffer), src_file);
-
-        if (read_ret == 0)   break;
+    // copy_file_range doesn't accept O_APPEND
+    int dst_fd = open(_dst_file.c_str(), O_WRONLY | O_CREAT | O_BINARY, LOG_FILE_MODE);
 
-        if (ferror(src_file)) break;
+    if (-1 == dst_fd) {
+        close(src_fd);
+        return false;
+    }
 
-        fwrite(buffer, 1, read_ret, dest_file);
+    struct stat src_stat;
+    off_t dst_file_len = lseek(dst_fd, 0, SEEK_END);
+    bool ret = 0 <= dst_file_len && 0 == fstat(src_fd, &src_stat) && __copy_file(src_fd, dst_fd, src_stat.st_size);
 
-        if (ferror(dest_file))  break;
+    if (!ret && 0 <= dst_file_len && 0 != ftruncate(dst_fd, dst_file_len)) {
+        __writetips2console("truncate file error:%d, path:%s", errno, _dst_file.c_str());
     }
 
-    if (dst_file_len + src_file_len > ftell(dest_file)) {
-        ftruncate(fileno(dest_file), dst_file_len);
-        fclose(src_file);
-        fclose(dest_file);
-        return false;
-    }
+    close(src_fd);
+    close(dst_fd);
 
-    fclose(src_file);
-    fclose(dest_file);
+    if (ret) LogIndex::AppendFile(_src_file, _dst_file, dst_file_len, src_stat.st_size);
 
-    return true;
+    return ret;
 }
 
 static void __move_old_files(const std::string& _src_path, const std::string& _dest_path, const std::string& _nameprefix) {
@@ -259,6 +334,7 @@ static void __move_old_files(const std::string& _src_path, const std::string& _d
     }
     
     ScopedLock lock_file(sg_mutex_log_file);
+    __closelogfile();  // its index may get entries from the moved files
     
     boost::filesystem::directory_iterator end_iter;
     for (boost::filesystem::directory_iterator iter(path); iter != end_iter; ++iter) {
@@ -294,54 +370,93 @@ static void __writetips2console(const char* _tips_format, ...) {
     ConsoleLog(&info, tips_info);
 }
 
-static bool __writefile(const void* _data, size_t _len, FILE* _file) {
-    if (NULL == _file) {
+static bool __writefile(const struct iovec* _iov, int _iovcnt, int _fd) {
+    if (-1 == _fd) {
         assert(false);
         return false;
     }
 
-    long before_len = ftell(_file);
+    off_t before_len = lseek(_fd, 0, SEEK_END);
     if (before_len < 0) return false;
 
-    if (1 != fwrite(_data, _len, 1, _file)) {
-        int err = ferror(_file);
+    // writev takes at most IOV_MAX buffers and may write a part of them, go on from where it stopped.
+    struct iovec iov[IOV_MAX < 64 ? IOV_MAX : 64];
+    for (int done = 0; done < _iovcnt;) {
+        int iovcnt = std::min(_iovcnt - done, (int)(sizeof(iov) / sizeof(iov[0])));
+        memcpy(iov, _iov + done, sizeof(iov[0]) * iovcnt);
+        done += iovcnt;
+
+        int index = 0;
+        while (index < iovcnt) {
+            ssize_t ret = writev(_fd, iov + index, iovcnt - index);
+            if (0 > ret && EINTR == errno) continue;
 
-        __writetips2console("write file error:%d", err);
+            if (0 >= ret) {
+                int err = 0 > ret ? errno : ENOSPC;
 
+                __writetips2console("write file error:%d", err);
 
-        ftruncate(fileno(_file), before_len);
-        fseek(_file, 0, SEEK_END);
+                // the part written is dropped, a file that can't be cut back is left as it is.
+                if (0 != ftruncate(_fd, before_len)) {
+                    __writetips2console("truncate file error:%d", errno);
+                    return false;
+                }
 
-        char err_log[256] = {0};
-        snprintf(err_log, sizeof(err_log), "\nwrite file error:%d\n", err);
+                char err_log[256] = {0};
+                snprintf(err_log, sizeof(err_log), "\nwrite file error:%d\n", err);
 
-        char tmp[256] = {0};
-        size_t len = sizeof(tmp);
-        LogBuffer::Write(err_log, strnlen(err_log, sizeof(err_log)), tmp, len);
+                char tmp[256] = {0};
+                size_t len = sizeof(tmp);
+                LogBuffer::Write(err_log, strnlen(err_log, sizeof(err_log)), tmp, len);
+
+                // no half written note either
+                if ((ssize_t)len != write(_fd, tmp, len) && 0 != ftruncate(_fd, before_len)) {
+                    __writetips2console("truncate file error:%d", errno);
+                }
 
-        fwrite(tmp, len, 1, _file);
+                return false;
+            }
 
-        return false;
+            while (index < iovcnt && (size_t)ret >= iov[index].iov_len) {
+                ret -= iov[index].iov_len;
+                ++index;
+            }
+
+            if (index < iovcnt) {
+                iov[index].iov_base = (char*)iov[index].iov_base + ret;
+                iov[index].iov_len -= ret;
+            }
+        }
     }
 
+    sg_logindex.Append(before_len, _iov, _iovcnt);
     return true;
 }
 
+static bool __writefile(const void* _data, size_t _len, int _fd) {
+    struct iovec iov = {(void*)_data, _len};
+    return __writefile(&iov, 1, _fd);
+}
+
+static int __openfile(const char* _filepath) {
+    return open(_filepath, O_WRONLY | O_APPEND | O_CREAT | O_BINARY, LOG_FILE_MODE);
+}
+
 static bool __openlogfile(const std::string& _log_dir) {
     if (sg_logdir.empty()) return false;
 
     struct timeval tv;
     gettimeofday(&tv, NULL);
 
-    if (NULL != sg_logfile) {
-        time_t sec = tv.tv_sec;
-        tm tcur = *localtime((const time_t*)&sec);
-        tm filetm = *localtime(&sg_openfiletime);
+    if (-1 != sg_logfile) {
+        // the file may be removed by others while it's open, e.g. uploaded and cleaned.
+        struct stat file_stat;
+        if (sg_openfiletime <= tv.tv_sec && tv.tv_sec < sg_logfile_expiretime && sg_current_dir == _log_dir
+                && 0 == fstat(sg_logfile, &file_stat) && 0 < file_stat.st_nlink) return true;
 
-        if (filetm.tm_year == tcur.tm_year && filetm.tm_mon == tcur.tm_mon && filetm.tm_mday == tcur.tm_mday && sg_current_dir == _log_dir) return true;
-
-        fclose(sg_logfile);
-        sg_logfile = NULL;
+        sg_logindex.Close();
+        close(sg_logfile);
+        sg_logfile = -1;
     }
 
     static time_t s_last_time = 0;
@@ -351,33 +466,45 @@ static bool __openlogfile(const std::string& _log_dir) {
     uint64_t now_tick = gettickcount();
     time_t now_time = tv.tv_sec;
 
+    tm tm_expire = *localtime(&now_time);
+    tm_expire.tm_hour = 0;
+    tm_expire.tm_min = 0;
+    tm_expire.tm_sec = 0;
+    tm_expire.tm_mday += 1;
+    tm_expire.tm_isdst = -1;
+
     sg_openfiletime = tv.tv_sec;
+    sg_logfile_expiretime = mktime(&tm_expire);
     sg_current_dir = _log_dir;
 
     char logfilepath[1024] = {0};
     __make_logfilename(tv, _log_dir, sg_logfileprefix.c_str(), LOG_EXT, logfilepath , 1024);
 
     if (now_time < s_last_time) {
-        sg_logfile = fopen(s_last_file_path, "ab");
+        sg_logfile = __openfile(s_last_file_path);
 
-		if (NULL == sg_logfile) {
+		if (-1 == sg_logfile) {
             __writetips2console("open file error:%d %s, path:%s", errno, strerror(errno), s_last_file_path);
+        } else {
+            sg_logindex.Open(s_last_file_path, lseek(sg_logfile, 0, SEEK_END));
         }
 
 #ifdef __APPLE__
-        assert(sg_logfile);
+        assert(-1 != sg_logfile);
 #endif
-        return NULL != sg_logfile;
+        return -1 != sg_logfile;
     }
 
-    sg_logfile = fopen(logfilepath, "ab");
+    sg_logfile = __openfile(logfilepath);
 
-	if (NULL == sg_logfile) {
+	if (-1 == sg_logfile) {
         __writetips2console("open file error:%d %s, path:%s", errno, strerror(errno), logfilepath);
+    } else {
+        sg_logindex.Open(logfilepath, lseek(sg_logfile, 0, SEEK_END));
     }
 
 
-    if (0 != s_last_time && (now_time - s_last_time) > (time_t)((now_tick - s_last_tick) / 1000 + 300)) {
+    if (-1 != sg_logfile && 0 != s_last_time && (now_time - s_last_time) > (time_t)((now_tick - s_last_tick) / 1000 + 300)) {
 
         struct tm tm_tmp = *localtime((const time_t*)&s_last_time);
         char last_time_str[64] = {0};
@@ -400,33 +527,28 @@ static bool __openlogfile(const std::string& _log_dir) {
     s_last_time = now_time;
 
 #ifdef __APPLE__
-    assert(sg_logfile);
+    assert(-1 != sg_logfile);
 #endif
-    return NULL != sg_logfile;
+    return -1 != sg_logfile;
 }
 
 static void __closelogfile() {
-    if (NULL == sg_logfile) return;
+    if (-1 == sg_logfile) return;
 
     sg_openfiletime = 0;
-    fclose(sg_logfile);
-    sg_logfile = NULL;
+    sg_logindex.Close();
+    close(sg_logfile);
+    sg_logfile = -1;
 }
 
-static void __log2file(const void* _data, size_t _len)
+// several blocks are written by one writev, the file stays open between calls.
+static void __blocks2file(const struct iovec* _iov, int _iovcnt)
 {
-	if (NULL == _data || 0 == _len || sg_logdir.empty()) {
-		return;
-	}
-
 	ScopedLock lock_file(sg_mutex_log_file);
 
 	if (sg_cache_logdir.empty()) {
         if (__openlogfile(sg_logdir)) {
-            __writefile(_data, _len, sg_logfile);
-            if (kAppednerAsync == sg_mode) {
-                __closelogfile();
-            }
+            __writefile(_iov, _iovcnt, sg_logfile);
         }
         return;
 	}
@@ -438,46 +560,76 @@ static void __log2file(const void* _data, size_t _len)
     __make_logfilename(tv, sg_cache_logdir, sg_logfileprefix.c_str(), LOG_EXT, logcachefilepath , 1024);
     
     if(boost::filesystem::exists(logcachefilepath) && __openlogfile(sg_cache_logdir)) {
-        __writefile(_data, _len, sg_logfile);
-        if (kAppednerAsync == sg_mode) {
-            __closelogfile();
-        }
-
+        __writefile(_iov, _iovcnt, sg_logfile);
+        __closelogfile();
 
         char logfilepath[1024] = {0};
         __make_logfilename(tv, sg_logdir, sg_logfileprefix.c_str(), LOG_EXT, logfilepath , 1024);
         if (__append_file(logcachefilepath, logfilepath)) {
-            if (kAppednerSync == sg_mode) {
-                __closelogfile();
-            }
             remove(logcachefilepath);
         }
     } else {
         bool write_sucess = false;
-        bool open_success = __openlogfile(sg_logdir);
-        if (open_success) {
-            write_sucess = __writefile(_data, _len, sg_logfile);
-            if (kAppednerAsync == sg_mode) {
-                __closelogfile();
-            }
+        if (__openlogfile(sg_logdir)) {
+            write_sucess = __writefile(_iov, _iovcnt, sg_logfile);
         }
 
         if (!write_sucess) {
-            if (open_success && kAppednerSync == sg_mode) {
-                __closelogfile();
-            }
+            __closelogfile();
 
             if (__openlogfile(sg_cache_logdir)) {
-                __writefile(_data, _len, sg_logfile);
-                if (kAppednerAsync == sg_mode) {
-                    __closelogfile();
-                }
+                __writefile(_iov, _iovcnt, sg_logfile);
+                __closelogfile();
             }
         }
     }
 
 }
 
+// blocks queued by all threads are written together: the first one to find nobody writing writes
+// every queued block with one __blocks2file, the others wait for their blocks to be in the file.
+static void __log2file(const struct iovec* _iov, int _iovcnt)
+{
+	if (NULL == _iov || 0 >= _iovcnt || sg_logdir.empty()) {
+		return;
+	}
+
+    ScopedLock lock(sg_mutex_log_queue);
+    sg_log_queue.insert(sg_log_queue.end(), _iov, _iov + _iovcnt);
+    uint64_t seq = ++sg_log_queued_seq;
+
+    while (sg_log_written_seq < seq) {
+        if (sg_log_queue_writing) {
+            sg_cond_log_written.wait(lock);
+            continue;
+        }
+
+        std::vector<struct iovec> blocks;
+        blocks.swap(sg_log_queue);
+        uint64_t blocks_seq = sg_log_queued_seq;
+        sg_log_queue_writing = true;
+        lock.unlock();
+
+        __blocks2file(&blocks[0], (int)blocks.size());
+
+        lock.lock();
+        sg_log_written_seq = blocks_seq;
+        sg_log_queue_writing = false;
+        sg_cond_log_written.notifyAll(lock);
+    }
+}
+
+static void __log2file(const void* _data, size_t _len)
+{
+    struct iovec iov = {(void*)_data, _len};
+    __log2file(&iov, 1);
+}
+
+
+// crypts tips as a block of the log file
+static void __maketips(const char* _tips, char* _output, size_t& _len) {
+    if (!LogBuffer::Write(_tips, strnlen(_tips, 4096), _output, _len)) _len = 0;
+}
 
 static void __writetips2file(const char* _tips_format, ...) {
 
@@ -494,25 +646,41 @@ static void __writetips2file(const char* _tips_format, ...) {
     char tmp[8 * 1024] = {0};
     size_t len = sizeof(tmp);
     
-    LogBuffer::Write(tips_info, strnlen(tips_info, sizeof(tips_info)), tmp, len);
+    __maketips(tips_info, tmp, len);
     
     __log2file(tmp, len);
 }
 
-static void __async_log_thread() {
-    while (true) {
+// swaps the blocks and writes the sealed one to the file, writers go on with the empty block meanwhile.
+static bool __flush_buffer_async() {
+    ScopedLock lock_flush(sg_mutex_buffer_flush);
+    ScopedLock lock_buffer(sg_mutex_buffer_async);
 
-        ScopedLock lock_buffer(sg_mutex_buffer_async);
+    if (NULL == sg_log_buff) return false;
 
-        if (NULL == sg_log_buff) break;
+    LogBuffer* sealed = sg_log_buff;
+    if (!sealed->Seal()) return true;
 
-        AutoBuffer tmp;
-        sg_log_buff->Flush(tmp);
-        lock_buffer.unlock();
+    sg_log_buff = (sealed == sg_log_buffs[0]) ? sg_log_buffs[1] : sg_log_buffs[0];
+    lock_buffer.unlock();
 
-		if (NULL != tmp.Ptr())  __log2file(tmp.Ptr(), tmp.Length());
+    AutoBuffer tmp;
+    LogBuffer::Compress(sealed->GetData().Ptr(), sealed->GetData().Length(), tmp);
+    if (NULL != tmp.Ptr())  __log2file(tmp.Ptr(), tmp.Length());
 
-        if (sg_log_close) break;
+    // cleared after it's in the file, a crash before that finds it in the mmap cache at next open.
+    sealed->Clear();
+    return true;
+}
+
+static void __async_log_thread() {
+    while (true) {
+        // read it before flushing, logs written while this block is compressed must get another round.
+        bool is_close = sg_log_close;
+
+        if (!__flush_buffer_async()) break;
+
+        if (is_close) break;
 
         sg_cond_buffer_async.wait(15 * 60 *1000);
     }
@@ -531,25 +699,179 @@ static void __appender_sync(const XLoggerInfo* _info, const char* _log) {
     __log2file(buffer_crypt, len);
 }
 
+// caller must hold sg_mutex_buffer_async. a block keeps one kind of records until it is flushed.
+static bool __buffer_binary() {
+    if (0 == sg_log_buff->GetData().Length()) sg_buffer_binary = (kAppednerBinary == sg_mode);
+    return sg_buffer_binary;
+}
+
+// caller must hold sg_mutex_buffer_async
+static void __binary_begin(PtrBuffer& _log) {
+    if (0 != sg_log_buff->GetData().Length()) return;
+
+    _log.Write(LogBinaryFormater::kSignature, sizeof(LogBinaryFormater::kSignature));
+    sg_binary_formater.Reset();
+}
+
+// caller must hold sg_mutex_buffer_async. formats a log for the kind of the current block.
+static void __format2buffer_async(const XLoggerInfo* _info, const char* _log, PtrBuffer& _buff) {
+    if (!__buffer_binary()) {
+        log_formater(_info, _log, _buff);
+        return;
+    }
+
+    __binary_begin(_buff);
+    sg_binary_formater.Format(_info, _log, _buff);
+}
+
+// caller must hold sg_mutex_buffer_async. _text has been formatted already.
+static void __text2buffer_async(const char* _text, size_t _len, PtrBuffer& _buff) {
+    if (!__buffer_binary()) {
+        _buff.Attach((void*)_text, _len);
+        return;
+    }
+
+    static char s_record[16 * 1024 + 128];  // guarded by sg_mutex_buffer_async
+    _buff.Attach(s_record, 0, sizeof(s_record));
+    __binary_begin(_buff);
+    sg_binary_formater.Text(_text, _len, _buff);
+}
+
+// caller must hold sg_mutex_buffer_async. writers never wait for the flush thread: while it is behind,
+// a nearly full block keeps waking it and takes a warning in place of the log.
+static void __write2buffer_async(PtrBuffer& _buff, bool _is_fatal) {
+    char warning[128] = {0};
+    if (sg_log_buff->GetData().Length() >= kBufferBlockLength*4/5) {
+       if (sg_buffer_binary) sg_binary_formater.Reset();  // the replaced record may define callsites or the time base
+       int ret = snprintf(warning, sizeof(warning), "[F][ sg_buffer_async.Length() >= BUFFER_BLOCK_LENTH*4/5, len: %d\n", (int)sg_log_buff->GetData().Length());
+       __text2buffer_async(warning, ret, _buff);
+    }
+
+    if (0 == _buff.Length()) return;
+
+    if (!sg_log_buff->Write(_buff.Ptr(), (unsigned int)_buff.Length())) {
+        // the dropped record may define callsites or the time base
+        if (sg_buffer_binary) sg_binary_formater.Reset();
+        return;
+    }
+
+    if (sg_log_buff->GetData().Length() >= kBufferBlockLength*1/3 || _is_fatal) {
+       sg_cond_buffer_async.notifyAll(true);  // do not lose it while the flush thread is compressing
+    }
+}
+
 static void __appender_async(const XLoggerInfo* _info, const char* _log) {
     ScopedLock lock(sg_mutex_buffer_async);
     if (NULL == sg_log_buff) return;
 
     char temp[16*1024] = {0};       //tell perry,ray if you want modify size.
     PtrBuffer log_buff(temp, 0, sizeof(temp));
-    log_formater(_info, _log, log_buff);
+    __format2buffer_async(_info, _log, log_buff);
 
-    if (sg_log_buff->GetData().Length() >= kBufferBlockLength*4/5) {
-       int ret = snprintf(temp, sizeof(temp), "[F][ sg_buffer_async.Length() >= BUFFER_BLOCK_LENTH*4/5, len: %d\n", (int)sg_log_buff->GetData().Length());
-       log_buff.Length(ret, ret);
+    __write2buffer_async(log_buff, NULL!=_info && kLevelFatal == _info->level);
+}
+
+// caller must hold sg_mutex_buffer_async
+static void __appender_text_async(const char* _text, size_t _len, bool _is_fatal) {
+    PtrBuffer log_buff;
+    __text2buffer_async(_text, _len, log_buff);
+    __write2buffer_async(log_buff, _is_fatal);
+}
+
+static char sg_staging_batch[kStagingBatchLength];  // guarded by sg_mutex_staging_drain
+
+// caller must hold sg_mutex_staging_drain
+static void __staging_flush_batch(size_t& _batch_len) {
+    if (0 == _batch_len) return;
+
+    ScopedLock lock(sg_mutex_buffer_async);
+    if (NULL != sg_log_buff) __appender_text_async(sg_staging_batch, _batch_len, false);
+    _batch_len = 0;
+}
+
+// caller must hold sg_mutex_staging_drain
+static void __staging_drain_ring(LogStagingRing& _ring, size_t& _batch_len) {
+    uint32_t len = 0;
+    while (0 != (len = _ring.FrontLength())) {
+        if (_batch_len + len > sizeof(sg_staging_batch)) __staging_flush_batch(_batch_len);
+
+        _ring.Pop(sg_staging_batch + _batch_len);
+        _batch_len += len;
     }
+}
+
+static void __staging_drain_all() {
+    ScopedLock drain_lock(sg_mutex_staging_drain);
+    size_t batch_len = 0;
+
+    ScopedLock lock(sg_mutex_staging_rings);
+    for (std::list<LogStagingRing*>::iterator it = sg_staging_rings.begin(); it != sg_staging_rings.end();) {
+        LogStagingRing* ring = *it;
+        // check before draining, the owner thread has pushed its last record when it was orphaned
+        bool is_orphan = ring->IsOrphan();
+        __staging_drain_ring(*ring, batch_len);
+
+        if (is_orphan) {
+            delete ring;
+            it = sg_staging_rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    lock.unlock();
 
-    if (!sg_log_buff->Write(log_buff.Ptr(), (unsigned int)log_buff.Length())) return;
+    __staging_flush_batch(batch_len);
+}
 
-    if (sg_log_buff->GetData().Length() >= kBufferBlockLength*1/3 || (NULL!=_info && kLevelFatal == _info->level)) {
-       sg_cond_buffer_async.notifyAll();
+static void __staging_ring_thread_exit(void* _ring) {
+    ((LogStagingRing*)_ring)->Orphan();
+}
+
+static LogStagingRing* __staging_ring() {
+    LogStagingRing* ring = (LogStagingRing*)sg_tss_staging_ring.get();
+    if (NULL != ring) return ring;
+
+    ring = new LogStagingRing(kStagingRingLength);
+    sg_tss_staging_ring.set(ring);
+
+    ScopedLock lock(sg_mutex_staging_rings);
+    sg_staging_rings.push_back(ring);
+    return ring;
+}
+
+static void __staging_drain_thread() {
+    while (true) {
+        __staging_drain_all();
+
+        if (sg_log_close || !sg_staging_ring_open) break;
+
+        sg_cond_staging_drain.wait(kStagingDrainInterval);
+    }
+}
+
+static void __appender_staging(const XLoggerInfo* _info, const char* _log) {
+    char temp[16*1024] = {0};       //tell perry,ray if you want modify size.
+    PtrBuffer log_buff(temp, 0, sizeof(temp));
+    log_formater(_info, _log, log_buff);
+
+    LogStagingRing* ring = __staging_ring();
+    bool is_fatal = NULL != _info && kLevelFatal == _info->level;
+
+    if (!is_fatal && ring->Push(log_buff.Ptr(), log_buff.Length())) {
+        if (ring->Length() >= ring->Capacity() / 4) sg_cond_staging_drain.notifyAll();
+        return;
     }
 
+    // ring is full or fatal log: drain own ring first to keep the order of this thread, then write directly.
+    ScopedLock drain_lock(sg_mutex_staging_drain);
+    size_t batch_len = 0;
+    __staging_drain_ring(*ring, batch_len);
+    __staging_flush_batch(batch_len);
+
+    ScopedLock lock(sg_mutex_buffer_async);
+    if (NULL == sg_log_buff) return;
+
+    __appender_text_async(temp, log_buff.Length(), is_fatal);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -593,6 +915,8 @@ void xlogger_appender(const XLoggerInfo* _info, const char* _log) {
 
         if (kAppednerSync == sg_mode)
             __appender_sync(_info, _log);
+        else if (sg_staging_ring_open && kAppednerAsync == sg_mode)
+            __appender_staging(_info, _log);
         else
             __appender_async(_info, _log);
     }
@@ -721,23 +1045,37 @@ void appender_open(TAppenderMode _mode, const char* _dir, const char* _nameprefi
     snprintf(mmap_file_path, sizeof(mmap_file_path), "%s/%s.mmap2", sg_cache_logdir.empty()?_dir:sg_cache_logdir.c_str(), _nameprefix);
 
     bool use_mmap = false;
-    if (OpenMmapFile(mmap_file_path, kBufferBlockLength, sg_mmmap_file))  {
-        sg_log_buff = new LogBuffer(sg_mmmap_file.data(), kBufferBlockLength, true);
+    if (OpenMmapFile(mmap_file_path, kBufferBlockLength * 2, sg_mmmap_file) && sg_mmmap_file.size() >= kBufferBlockLength * 2)  {
+        sg_log_buffs[0] = new LogBuffer(sg_mmmap_file.data(), kBufferBlockLength, true);
+        sg_log_buffs[1] = new LogBuffer(sg_mmmap_file.data() + kBufferBlockLength, kBufferBlockLength, true);
         use_mmap = true;
     } else {
-        char* buffer = new char[kBufferBlockLength];
-        sg_log_buff = new LogBuffer(buffer, kBufferBlockLength, true);
+        if (sg_mmmap_file.is_open())  CloseMmapFile(sg_mmmap_file);
+        char* buffer = new char[kBufferBlockLength * 2];
+        sg_log_buffs[0] = new LogBuffer(buffer, kBufferBlockLength, true);
+        sg_log_buffs[1] = new LogBuffer(buffer + kBufferBlockLength, kBufferBlockLength, true);
         use_mmap = false;
     }
 
-    if (NULL == sg_log_buff->GetData().Ptr()) {
+    if (NULL == sg_log_buffs[0]->GetData().Ptr()) {
         if (use_mmap && sg_mmmap_file.is_open())  CloseMmapFile(sg_mmmap_file);
         return;
     }
 
+    // the process may be killed while a block is written to the file, then both blocks hold logs.
+    if (sg_log_buffs[0]->IsNewerThan(*sg_log_buffs[1])) std::swap(sg_log_buffs[0], sg_log_buffs[1]);
 
     AutoBuffer buffer;
-    sg_log_buff->Flush(buffer);
+    AutoBuffer buffer_newer;
+    if (sg_log_buffs[0]->Seal()) LogBuffer::Compress(sg_log_buffs[0]->GetData().Ptr(), sg_log_buffs[0]->GetData().Length(), buffer);
+    if (sg_log_buffs[1]->Seal()) LogBuffer::Compress(sg_log_buffs[1]->GetData().Ptr(), sg_log_buffs[1]->GetData().Length(), buffer_newer);
+    sg_log_buffs[0]->Clear();
+    sg_log_buffs[1]->Clear();
+    buffer.Write(AutoBuffer::ESeekEnd, buffer_newer.Ptr(), buffer_newer.Length());
+
+    ScopedLock buffer_lock(sg_mutex_buffer_async);
+    sg_log_buff = sg_log_buffs[0];
+    buffer_lock.unlock();
 
 	ScopedLock lock(sg_mutex_log_file);
 	sg_logdir = _dir;
@@ -745,14 +1083,27 @@ void appender_open(TAppenderMode _mode, const char* _dir, const char* _nameprefi
 	sg_log_close = false;
 	appender_setmode(_mode);
     lock.unlock();
+
+    if (sg_staging_ring_open && !sg_thread_staging_drain.isruning()) {
+        sg_thread_staging_drain.start();
+    }
     
     char mark_info[512] = {0};
     get_mark_info(mark_info, sizeof(mark_info));
 
     if (buffer.Ptr()) {
-        __writetips2file("~~~~~ begin of mmap ~~~~~\n");
-        __log2file(buffer.Ptr(), buffer.Length());
-        __writetips2file("~~~~~ end of mmap ~~~~~%s\n", mark_info);
+        char begin_tips[256] = {0};
+        size_t begin_len = sizeof(begin_tips);
+        __maketips("~~~~~ begin of mmap ~~~~~\n", begin_tips, begin_len);
+
+        char end_info[1024] = {0};
+        snprintf(end_info, sizeof(end_info), "~~~~~ end of mmap ~~~~~%s\n", mark_info);
+        char end_tips[2 * 1024] = {0};
+        size_t end_len = sizeof(end_tips);
+        __maketips(end_info, end_tips, end_len);
+
+        struct iovec iov[] = {{begin_tips, begin_len}, {buffer.Ptr(), buffer.Length()}, {end_tips, end_len}};
+        __log2file(iov, (int)(sizeof(iov) / sizeof(iov[0])));
     }
 
     tickcountdiff_t get_mmap_time = tickcount_t().gettickcount() - tick;
@@ -802,6 +1153,7 @@ void appender_open_with_cache(TAppenderMode _mode, const std::string& _cachedir,
 }
 
 void appender_flush() {
+    sg_cond_staging_drain.notifyAll();
     sg_cond_buffer_async.notifyAll();
 }
 
@@ -810,17 +1162,9 @@ void appender_flush_sync() {
         return;
     }
 
-    ScopedLock lock_buffer(sg_mutex_buffer_async);
-    
-    if (NULL == sg_log_buff) return;
-
-    AutoBuffer tmp;
-    sg_log_buff->Flush(tmp);
-
-    lock_buffer.unlock();
-
-	if (tmp.Ptr())  __log2file(tmp.Ptr(), tmp.Length());
+    __staging_drain_all();
 
+    __flush_buffer_async();
 }
 
 void appender_close() {
@@ -834,7 +1178,14 @@ void appender_close() {
 
     sg_log_close = true;
 
-    sg_cond_buffer_async.notifyAll();
+    sg_cond_staging_drain.notifyAll();
+
+    if (sg_thread_staging_drain.isruning())
+        sg_thread_staging_drain.join();
+
+    __staging_drain_all();
+
+    sg_cond_buffer_async.notifyAll(true);  // the thread may be flushing, it must not miss the close
 
     if (sg_thread_async.isruning())
         sg_thread_async.join();
@@ -842,14 +1193,17 @@ void appender_close() {
 	
     ScopedLock buffer_lock(sg_mutex_buffer_async);
     if (sg_mmmap_file.is_open()) {
-        if (!sg_mmmap_file.operator !()) memset(sg_mmmap_file.data(), 0, kBufferBlockLength);
+        if (!sg_mmmap_file.operator !()) memset(sg_mmmap_file.data(), 0, kBufferBlockLength * 2);
 
 		CloseMmapFile(sg_mmmap_file);
     } else {
-        delete[] (char*)((sg_log_buff->GetData()).Ptr());
+        delete[] (char*)std::min(sg_log_buffs[0]->GetData().Ptr(), sg_log_buffs[1]->GetData().Ptr());
     }
 
-    delete sg_log_buff;
+    delete sg_log_buffs[0];
+    delete sg_log_buffs[1];
+    sg_log_buffs[0] = NULL;
+    sg_log_buffs[1] = NULL;
     sg_log_buff = NULL;
     buffer_lock.unlock();
 
@@ -862,7 +1216,7 @@ void appender_setmode(TAppenderMode _mode) {
 
     sg_cond_buffer_async.notifyAll();
 
-    if (kAppednerAsync == sg_mode && !sg_thread_async.isruning()) {
+    if (kAppednerSync != sg_mode && !sg_thread_async.isruning()) {
         sg_thread_async.start();
     }
 }
@@ -890,6 +1244,24 @@ void appender_set_console_log(bool _is_open) {
     sg_consolelog_open = _is_open;
 }
 
+void appender_set_compress_level(int _level) {
+    LogBuffer::SetCompressLevel(_level);
+}
+
+void appender_set_staging_ring(bool _is_open) {
+    sg_staging_ring_open = _is_open;
+    sg_cond_staging_drain.notifyAll();
+
+    if (!_is_open) {
+        __staging_drain_all();
+        return;
+    }
+
+    if (!sg_log_close && !sg_thread_staging_drain.isruning()) {
+        sg_thread_staging_drain.start();
+    }
+}
+
 void appender_setExtraMSg(const char* _msg, unsigned int _len) {
     sg_log_extra_msg = std::string(_msg, _len);
 }
@@ -21,12 +21,15 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 #include <algorithm>
 
 #include "mars/comm/xlogger/xloggerbase.h"
 #include "mars/comm/xlogger/loginfo_extract.h"
 #include "mars/comm/ptrbuffer.h"
+#include "mars/comm/thread/tss.h"
 
 #ifdef _WIN32
 #define PRIdMAX "lld"
@@ -36,6 +39,129 @@
 #include <inttypes.h>
 #endif
 
+namespace {
+
+static const int kCallsiteCacheSize = 16;
+
+// header fragment of one log callsite: "[tag][file, func, line]["
+struct CallsiteHeader {
+    const char* tag;
+    const char* filename;
+    const char* func_name;
+    int line;
+    char raw_tag[64];
+    char raw_file[64];
+    char raw_func[128];
+    char header[320];
+    size_t header_len;
+};
+
+struct FormaterCache {
+    time_t sec;
+    char time_prefix[48];   // "2016-01-01 +8.0 12:00:00"
+    size_t time_prefix_len;
+    CallsiteHeader callsite[kCallsiteCacheSize];
+};
+
+}
+
+static Tss sg_tss_formater_cache(&free);
+
+static char* __write_uint(char* _dst, uintmax_t _value) {
+    char tmp[24];
+    char* pos = tmp + sizeof(tmp);
+
+    do {
+        *--pos = (char)('0' + _value % 10);
+        _value /= 10;
+    } while (0 != _value);
+
+    size_t len = tmp + sizeof(tmp) - pos;
+    memcpy(_dst, pos, len);
+    return _dst + len;
+}
+
+static char* __write_int(char* _dst, intmax_t _value) {
+    if (_value < 0) {
+        *_dst++ = '-';
+        return __write_uint(_dst, (uintmax_t)0 - (uintmax_t)_value);
+    }
+
+    return __write_uint(_dst, (uintmax_t)_value);
+}
+
+static char* __write_str(char* _dst, const char* _str, size_t _len) {
+    memcpy(_dst, _str, _len);
+    return _dst + _len;
+}
+
+static FormaterCache* __formater_cache() {
+    FormaterCache* cache = (FormaterCache*)sg_tss_formater_cache.get();
+    if (NULL != cache) return cache;
+
+    cache = (FormaterCache*)calloc(1, sizeof(FormaterCache));
+    sg_tss_formater_cache.set(cache);
+    return cache;
+}
+
+static size_t __format_time_prefix(time_t _sec, char* _buf, size_t _len) {
+    tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &_sec);
+    int ret = snprintf(_buf, _len, "%d-%02d-%02d %+.1f %02d:%02d:%02d", 1900 + tm.tm_year, 1 + tm.tm_mon, tm.tm_mday,
+                       (-_timezone) / 3600.0, tm.tm_hour, tm.tm_min, tm.tm_sec);
+#else
+    localtime_r(&_sec, &tm);
+    int ret = snprintf(_buf, _len, "%d-%02d-%02d %+.1f %02d:%02d:%02d", 1900 + tm.tm_year, 1 + tm.tm_mon, tm.tm_mday,
+                       tm.tm_gmtoff / 3600.0, tm.tm_hour, tm.tm_min, tm.tm_sec);
+#endif
+
+    return 0 < ret ? std::min((size_t)ret, _len - 1) : 0;
+}
+
+static bool __match_callsite(const CallsiteHeader& _callsite, const XLoggerInfo* _info, const char* _tag, const char* _filename, const char* _func_name) {
+    // the pointers may come from temporary strings(jni), so compare the content too.
+    return _callsite.tag == _info->tag && _callsite.filename == _info->filename && _callsite.func_name == _info->func_name
+           && _callsite.line == _info->line && 0 < _callsite.header_len
+           && 0 == strcmp(_callsite.raw_tag, _tag) && 0 == strcmp(_callsite.raw_file, _filename) && 0 == strcmp(_callsite.raw_func, _func_name);
+}
+
+static size_t __build_callsite_header(char* _header, size_t _len, const char* _tag, const char* _filename, const char* _func_name, int _line) {
+    char func_name[128] = {0};
+    ExtractFunctionName(_func_name, func_name, sizeof(func_name));
+
+    int ret = snprintf(_header, _len, "[%s][%s, %s, %d][", _tag, _filename, func_name, _line);
+    if (ret < 0) return 0;
+    return std::min((size_t)ret, _len - 1);
+}
+
+static const CallsiteHeader* __callsite_header(FormaterCache& _cache, const XLoggerInfo* _info) {
+    const char* tag = _info->tag ? _info->tag : "";
+    const char* filename = ExtractFileName(_info->filename);
+    const char* func_name = _info->func_name ? _info->func_name : "";
+
+    uintptr_t hash = (uintptr_t)_info->filename ^ ((uintptr_t)_info->func_name >> 4) ^ (uintptr_t)_info->line * 31;
+    CallsiteHeader& callsite = _cache.callsite[(hash ^ (hash >> 7)) % kCallsiteCacheSize];
+
+    if (__match_callsite(callsite, _info, tag, filename, func_name)) return &callsite;
+
+    if (strlen(tag) >= sizeof(callsite.raw_tag) || strlen(filename) >= sizeof(callsite.raw_file)
+            || strlen(func_name) >= sizeof(callsite.raw_func)) {
+        return NULL;
+    }
+
+    callsite.tag = _info->tag;
+    callsite.filename = _info->filename;
+    callsite.func_name = _info->func_name;
+    callsite.line = _info->line;
+    strcpy(callsite.raw_tag, tag);
+    strcpy(callsite.raw_file, filename);
+    strcpy(callsite.raw_func, func_name);
+    callsite.header_len = __build_callsite_header(callsite.header, sizeof(callsite.header), tag, filename, _info->func_name, _info->line);
+
+    return 0 < callsite.header_len ? &callsite : NULL;
+}
+
 void log_formater(const XLoggerInfo* _info, const char* _logbody, PtrBuffer& _log) {
     static const char* levelStrings[] = {
         "V",
@@ -69,36 +195,55 @@ void log_formater(const XLoggerInfo* _info, const char* _logbody, PtrBuffer& _lo
     }
 
     if (NULL != _info) {
-        const char* filename = ExtractFileName(_info->filename);
-        char strFuncName [128] = {0};
-        ExtractFunctionName(_info->func_name, strFuncName, sizeof(strFuncName));
+        FormaterCache* cache = __formater_cache();
+        char* begin = (char*)_log.PosPtr();
+        char* pos = begin;
 
-        char temp_time[64] = {0};
+        // [level][time][pid, tid*][tag][file, func, line][
+        *pos++ = '[';
+        pos = __write_str(pos, _logbody ? levelStrings[_info->level] : levelStrings[kLevelFatal], 1);
+        *pos++ = ']';
+        *pos++ = '[';
 
         if (0 != _info->timeval.tv_sec) {
             time_t sec = _info->timeval.tv_sec;
-            tm tm = *localtime((const time_t*)&sec);
-#ifdef ANDROID
-            snprintf(temp_time, sizeof(temp_time), "%d-%02d-%02d %+.1f %02d:%02d:%02d.%.3ld", 1900 + tm.tm_year, 1 + tm.tm_mon, tm.tm_mday,
-                     tm.tm_gmtoff / 3600.0, tm.tm_hour, tm.tm_min, tm.tm_sec, _info->timeval.tv_usec / 1000);
-#elif _WIN32
-            snprintf(temp_time, sizeof(temp_time), "%d-%02d-%02d %+.1f %02d:%02d:%02d.%.3d", 1900 + tm.tm_year, 1 + tm.tm_mon, tm.tm_mday,
-                     (-_timezone) / 3600.0, tm.tm_hour, tm.tm_min, tm.tm_sec, _info->timeval.tv_usec / 1000);
-#else
-            snprintf(temp_time, sizeof(temp_time), "%d-%02d-%02d %+.1f %02d:%02d:%02d.%.3d", 1900 + tm.tm_year, 1 + tm.tm_mon, tm.tm_mday,
-                     tm.tm_gmtoff / 3600.0, tm.tm_hour, tm.tm_min, tm.tm_sec, _info->timeval.tv_usec / 1000);
-#endif
+
+            if (NULL == cache) {
+                pos += __format_time_prefix(sec, pos, 64);
+            } else {
+                // localtime and snprintf only once per second
+                if (sec != cache->sec || 0 == cache->time_prefix_len) {
+                    cache->time_prefix_len = __format_time_prefix(sec, cache->time_prefix, sizeof(cache->time_prefix));
+                    cache->sec = sec;
+                }
+                pos = __write_str(pos, cache->time_prefix, cache->time_prefix_len);
+            }
+
+            int msec = (int)(_info->timeval.tv_usec / 1000);
+            *pos++ = '.';
+            *pos++ = (char)('0' + msec / 100 % 10);
+            *pos++ = (char)('0' + msec / 10 % 10);
+            *pos++ = (char)('0' + msec % 10);
         }
 
-        // _log.AllocWrite(30*1024, false);
-        int ret = snprintf((char*)_log.PosPtr(), 1024, "[%s][%s][%" PRIdMAX ", %" PRIdMAX "%s][%s][%s, %s, %d][",  // **CPPLINT SKIP**
-                           _logbody ? levelStrings[_info->level] : levelStrings[kLevelFatal], temp_time,
-                           _info->pid, _info->tid, _info->tid == _info->maintid ? "*" : "", _info->tag ? _info->tag : "",
-                           filename, strFuncName, _info->line);
+        *pos++ = ']';
+        *pos++ = '[';
+        pos = __write_int(pos, _info->pid);
+        *pos++ = ',';
+        *pos++ = ' ';
+        pos = __write_int(pos, _info->tid);
+        if (_info->tid == _info->maintid) *pos++ = '*';
+        *pos++ = ']';
 
-        assert(0 <= ret);
+        const CallsiteHeader* callsite = NULL == cache ? NULL : __callsite_header(*cache, _info);
+        if (NULL != callsite) {
+            pos = __write_str(pos, callsite->header, callsite->header_len);
+        } else {
+            pos += __build_callsite_header(pos, 1024, _info->tag ? _info->tag : "", ExtractFileName(_info->filename), _info->func_name, _info->line);
+        }
+
+        int ret = (int)(pos - begin);
         _log.Length(_log.Pos() + ret, _log.Length() + ret);
-        //      memcpy((char*)_log.PosPtr() + 1, "\0", 1);
 
         assert((unsigned int)_log.Pos() == _log.Length());
     }
@@ -119,4 +264,3 @@ void log_formater(const XLoggerInfo* _info, const char* _logbody, PtrBuffer& _lo
 
     if (*((char*)_log.PosPtr() - 1) != nextline) _log.Write(&nextline, 1);
 }
-
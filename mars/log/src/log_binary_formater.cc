@@ -0,0 +1,241 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * log_binary_formater.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include "log_binary_formater.h"
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#include "mars/comm/xlogger/loginfo_extract.h"
+#include "mars/comm/ptrbuffer.h"
+
+namespace {
+
+enum {
+    kRecordSync = 1,
+    kRecordCallsite = 2,
+    kRecordLog = 3,
+    kRecordText = 4,
+};
+
+static const unsigned char kLevelNoTime = 0x80;
+static const uint32_t kCallsiteCacheSize = 128;     // power of 2
+static const size_t kMaxRecordHeaderLen = 64;       // sync or log record without body
+static const size_t kMaxCallsiteLen = 512;
+static const size_t kMaxBodyLen = 0xFFFF;
+
+}
+
+struct LogBinaryFormater::Callsite {
+    uint32_t hash;
+    uint32_t epoch;
+    uint32_t id;
+    int line;
+    char tag[64];
+    char file[128];
+    char func[128];
+};
+
+const char LogBinaryFormater::kSignature[4] = {'\x1b', 'X', 'B', '\x01'};
+
+static char* __write_varint(char* _pos, uint64_t _value) {
+    while (_value >= 0x80) {
+        *_pos++ = (char)(_value | 0x80);
+        _value >>= 7;
+    }
+    *_pos++ = (char)_value;
+    return _pos;
+}
+
+static char* __write_zigzag(char* _pos, int64_t _value) {
+    return __write_varint(_pos, ((uint64_t)_value << 1) ^ (uint64_t)(_value >> 63));
+}
+
+static char* __write_string(char* _pos, const char* _str, size_t _len) {
+    _pos = __write_varint(_pos, _len);
+    memcpy(_pos, _str, _len);
+    return _pos + _len;
+}
+
+static uint32_t __hash(uint32_t _hash, const char* _str) {
+    // FNV-1a
+    for (const unsigned char* p = (const unsigned char*)_str; '\0' != *p; ++p) {
+        _hash = (_hash ^ *p) * 16777619u;
+    }
+    return _hash;
+}
+
+static int64_t __time_ms(const XLoggerInfo* _info) {
+    return (int64_t)_info->timeval.tv_sec * 1000 + _info->timeval.tv_usec / 1000;
+}
+
+static long __gmtoff(time_t _sec) {
+    tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &_sec);
+    return -_timezone;
+#else
+    localtime_r(&_sec, &tm);
+    return tm.tm_gmtoff;
+#endif
+}
+
+LogBinaryFormater::LogBinaryFormater()
+: callsites_(new Callsite[kCallsiteCacheSize]), epoch_(1), next_id_(0)
+, synced_(false), pid_(0), maintid_(0), last_time_(0) {
+    memset(callsites_, 0, sizeof(Callsite) * kCallsiteCacheSize);
+}
+
+LogBinaryFormater::~LogBinaryFormater() {
+    delete[] callsites_;
+}
+
+void LogBinaryFormater::Reset() {
+    synced_ = false;  // the next sync record drops the callsites too
+}
+
+bool LogBinaryFormater::Format(const XLoggerInfo* _info, const char* _logbody, PtrBuffer& _log) {
+    assert((unsigned int)_log.Pos() == _log.Length());
+
+    if (NULL == _info) {
+        if (NULL == _logbody) return false;
+
+        size_t len = strnlen(_logbody, kMaxBodyLen);
+        if (0 < len && '\n' == _logbody[len - 1]) return Text(_logbody, len, _log);
+
+        // keep the text mode behavior: every log ends with a new line
+        if (_log.MaxLength() - _log.Length() < kMaxRecordHeaderLen + len + 1) return false;
+
+        char* begin = (char*)_log.PosPtr();
+        char* pos = begin;
+        *pos++ = (char)kRecordText;
+        pos = __write_varint(pos, len + 1);
+        memcpy(pos, _logbody, len);
+        pos += len;
+        *pos++ = '\n';
+        _log.Length(_log.Pos() + (pos - begin), _log.Length() + (pos - begin));
+        return true;
+    }
+
+    if (_log.MaxLength() - _log.Length() < kMaxRecordHeaderLen * 2 + kMaxCallsiteLen) return false;
+
+    char* begin = (char*)_log.PosPtr();
+    char* end = (char*)_log.Ptr() + _log.MaxLength();
+    char* pos = begin;
+
+    bool has_time = 0 != _info->timeval.tv_sec;
+
+    if (!synced_ || _info->pid != pid_ || _info->maintid != maintid_) {
+        ++epoch_;
+        synced_ = true;
+        pid_ = _info->pid;
+        maintid_ = _info->maintid;
+        last_time_ = has_time ? __time_ms(_info) : 0;
+
+        *pos++ = (char)kRecordSync;
+        pos = __write_zigzag(pos, pid_);
+        pos = __write_zigzag(pos, maintid_);
+        pos = __write_varint(pos, (uint64_t)last_time_);
+        pos = __write_zigzag(pos, has_time ? __gmtoff(_info->timeval.tv_sec) : 0);
+    }
+
+    uint32_t id = __Callsite(_info, pos, end);
+
+    const char* logbody = NULL != _logbody ? _logbody : "error!! NULL==_logbody";
+    unsigned char level = (unsigned char)(NULL != _logbody ? _info->level : kLevelFatal);
+    if (!has_time) level |= kLevelNoTime;
+
+    *pos++ = (char)kRecordLog;
+    *pos++ = (char)level;
+    pos = __write_varint(pos, id);
+    if (has_time) {
+        int64_t now = __time_ms(_info);
+        pos = __write_zigzag(pos, now - last_time_);
+        last_time_ = now;
+    }
+    pos = __write_zigzag(pos, _info->tid);
+
+    size_t bodylen = (size_t)(end - pos) > kMaxRecordHeaderLen ? (size_t)(end - pos) - kMaxRecordHeaderLen : 0;
+    bodylen = strnlen(logbody, std::min(bodylen, kMaxBodyLen));
+    pos = __write_string(pos, logbody, bodylen);
+
+    _log.Length(_log.Pos() + (pos - begin), _log.Length() + (pos - begin));
+    return true;
+}
+
+bool LogBinaryFormater::Text(const char* _text, size_t _len, PtrBuffer& _log) {
+    if (NULL == _text || 0 == _len) return false;
+    if (_log.MaxLength() - _log.Length() < kMaxRecordHeaderLen + _len) return false;
+
+    char* begin = (char*)_log.PosPtr();
+    char* pos = begin;
+    *pos++ = (char)kRecordText;
+    pos = __write_string(pos, _text, _len);
+
+    _log.Length(_log.Pos() + (pos - begin), _log.Length() + (pos - begin));
+    return true;
+}
+
+uint32_t LogBinaryFormater::__Callsite(const XLoggerInfo* _info, char*& _pos, char* _end) {
+    const char* tag = NULL != _info->tag ? _info->tag : "";
+    const char* file = ExtractFileName(_info->filename);
+    const char* func = NULL != _info->func_name ? _info->func_name : "";
+
+    // the pointers may come from temporary strings(jni), so the content is hashed and compared.
+    uint32_t hash = __hash(__hash(__hash(2166136261u, tag), file), func) ^ (uint32_t)_info->line * 2654435761u;
+    Callsite& callsite = callsites_[hash & (kCallsiteCacheSize - 1)];
+
+    if (callsite.epoch == epoch_ && callsite.hash == hash && callsite.line == _info->line
+            && 0 == strcmp(callsite.tag, tag) && 0 == strcmp(callsite.file, file) && 0 == strcmp(callsite.func, func)) {
+        return callsite.id;
+    }
+
+    char func_name[128] = {0};
+    ExtractFunctionName(func, func_name, sizeof(func_name));
+
+    size_t tag_len = strnlen(tag, sizeof(callsite.tag) - 1);
+    size_t file_len = strnlen(file, sizeof(callsite.file) - 1);
+    size_t func_name_len = strnlen(func_name, sizeof(func_name) - 1);
+
+    uint32_t id = next_id_++;
+
+    assert(_pos + kMaxCallsiteLen <= _end);
+    *_pos++ = (char)kRecordCallsite;
+    _pos = __write_varint(_pos, id);
+    _pos = __write_zigzag(_pos, _info->line);
+    _pos = __write_string(_pos, tag, tag_len);
+    _pos = __write_string(_pos, file, file_len);
+    _pos = __write_string(_pos, func_name, func_name_len);
+
+    // too long to be compared later, define it again next time.
+    if (tag_len != strlen(tag) || file_len != strlen(file) || strlen(func) >= sizeof(callsite.func)) {
+        callsite.epoch = 0;
+        return id;
+    }
+
+    callsite.hash = hash;
+    callsite.epoch = epoch_;
+    callsite.id = id;
+    callsite.line = _info->line;
+    memcpy(callsite.tag, tag, tag_len + 1);
+    memcpy(callsite.file, file, file_len + 1);
+    strcpy(callsite.func, func);
+    return id;
+}
@@ -0,0 +1,73 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * log_binary_formater.h
+ *
+ *  Created on: 2026-10-17
+ */
+
+#ifndef LOG_BINARY_FORMATER_H_
+#define LOG_BINARY_FORMATER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mars/comm/xlogger/xloggerbase.h"
+
+class PtrBuffer;
+
+/*
+ * compact records for kAppednerBinary, decoded offline by log/crypt/decode_mars_log_file.py.
+ * a binary block starts with kSignature, then records:
+ *   sync:     |1|pid|maintid|time(ms)|gmtoff(s)|            base of the following time deltas
+ *   callsite: |2|id|line|tag|file|func|                     file and func are already extracted
+ *   log:      |3|level|callsite id|time delta(ms)|tid|body|  level|0x80 if the log has no time
+ *   text:     |4|text|                                      preformatted text, written as is
+ * integers are varint (signed ones zigzag), strings are |varint length|bytes|.
+ * callsite ids are only valid after their callsite record, a sync record forgets all of them.
+ * not thread safe, the caller serializes it with the buffer it writes to.
+ */
+class LogBinaryFormater {
+  public:
+    static const char kSignature[4];
+
+  public:
+    LogBinaryFormater();
+    ~LogBinaryFormater();
+
+  public:
+    // forget callsites and the time base, e.g. a new block is started or a record was dropped.
+    void Reset();
+    bool Format(const XLoggerInfo* _info, const char* _logbody, PtrBuffer& _log);
+    bool Text(const char* _text, size_t _len, PtrBuffer& _log);
+
+  private:
+    struct Callsite;
+    uint32_t __Callsite(const XLoggerInfo* _info, char*& _pos, char* _end);
+
+  private:
+    LogBinaryFormater(const LogBinaryFormater&);
+    LogBinaryFormater& operator=(const LogBinaryFormater&);
+
+  private:
+    Callsite* callsites_;
+    uint32_t epoch_;
+    uint32_t next_id_;
+
+    bool synced_;
+    intmax_t pid_;
+    intmax_t maintid_;
+    int64_t last_time_;
+};
+
+#endif /* LOG_BINARY_FORMATER_H_ */
@@ -28,6 +28,7 @@
 #include <assert.h>
 
 #include "log/crypt/log_crypt.h"
+#include "log_index.h"
 
 
 #ifdef WIN32
@@ -36,8 +37,19 @@
 
 
 LogCrypt* LogBuffer::s_log_crypt =  new LogCrypt();
+int LogBuffer::s_compress_level = Z_BEST_COMPRESSION;
 
 bool LogBuffer::GetPeriodLogs(const char* _log_path, int _begin_hour, int _end_hour, unsigned long& _begin_pos, unsigned long& _end_pos, std::string& _err_msg) {
+    if (LogIndex::GetPeriodLogs(_log_path, _begin_hour, _end_hour, _begin_pos, _end_pos)) {
+        if (_end_pos > _begin_pos) return true;
+
+        char msg[128] = {0};
+        snprintf(msg, sizeof(msg), "index begintpos:%lu, endpos:%lu.", _begin_pos, _end_pos);
+        _err_msg += msg;
+        return false;
+    }
+
+    // no index or it doesn't match the file, scan the blocks
     return s_log_crypt->GetPeriodLogs(_log_path, _begin_hour, _end_hour, _begin_pos, _end_pos, _err_msg);
 }
 
@@ -52,18 +64,84 @@ bool LogBuffer::Write(const void* _data, size_t _inputlen, void* _output, size_t
     return true;
 }
 
+void LogBuffer::Compress(const void* _block, size_t _len, AutoBuffer& _out) {
+    
+    const char* data = (const char*)_block;
+    size_t header_len = s_log_crypt->GetHeaderLen();
+    size_t tailer_len = s_log_crypt->GetTailerLen();
+    
+    _out.Reset();
+    if (NULL == data || _len < header_len + tailer_len || !s_log_crypt->IsPending(data, _len)) {
+        if (NULL != data) _out.Write(data, _len);
+        return;
+    }
+    
+    size_t raw_len = s_log_crypt->GetLogLen(data, _len);
+    if (header_len + raw_len + tailer_len > _len) {
+        assert(false);
+        raw_len = _len - header_len - tailer_len;
+    }
+    
+    z_stream cstream;
+    memset(&cstream, 0, sizeof(cstream));
+    
+    if (Z_OK != deflateInit2(&cstream, s_compress_level, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY)) {
+        __CommitRaw(data, _len, raw_len, _out);
+        return;
+    }
+    
+    size_t bound = deflateBound(&cstream, (uLong)raw_len);
+    _out.AllocWrite(header_len + bound + tailer_len);
+    
+    cstream.next_in = (Bytef*)data + header_len;
+    cstream.avail_in = (uInt)raw_len;
+    cstream.next_out = (Bytef*)_out.Ptr() + header_len;
+    cstream.avail_out = (uInt)bound;
+    
+    int ret = deflate(&cstream, Z_FINISH);
+    size_t compress_len = bound - cstream.avail_out;
+    deflateEnd(&cstream);
+    
+    if (Z_STREAM_END != ret) {
+        __CommitRaw(data, _len, raw_len, _out);
+        return;
+    }
+    
+    // crypt block by block, the output size equals to the input size
+    size_t crypt_pos = header_len;
+    while (crypt_pos < header_len + compress_len) {
+        char crypt_buffer[4096] = {0};
+        size_t crypt_buffer_len = sizeof(crypt_buffer);
+        size_t input_len = std::min(header_len + compress_len - crypt_pos, sizeof(crypt_buffer));
+        
+        s_log_crypt->CryptAsyncLog((char*)_out.Ptr() + crypt_pos, input_len, crypt_buffer, crypt_buffer_len);
+        memcpy((char*)_out.Ptr() + crypt_pos, crypt_buffer, crypt_buffer_len);
+        crypt_pos += crypt_buffer_len;
+    }
+    
+    memcpy(_out.Ptr(), data, header_len);
+    s_log_crypt->CommitPending((char*)_out.Ptr(), true, (uint32_t)(crypt_pos - header_len));
+    s_log_crypt->SetTailerInfo((char*)_out.Ptr() + crypt_pos);
+    _out.Length(0, crypt_pos + tailer_len);
+}
+
+void LogBuffer::__CommitRaw(const char* _block, size_t _len, size_t _raw_len, AutoBuffer& _out) {
+    _out.Reset();
+    _out.Write(_block, _len);
+    s_log_crypt->CommitPending((char*)_out.Ptr(), false, (uint32_t)_raw_len);
+}
+
+void LogBuffer::SetCompressLevel(int _level) {
+    s_compress_level = _level;
+}
+
 LogBuffer::LogBuffer(void* _pbuffer, size_t _len, bool _isCompress)
 : is_compress_(_isCompress) {
     buff_.Attach(_pbuffer, _len);
     __Fix();
-
-    memset(&cstream_, 0, sizeof(cstream_));
 }
 
 LogBuffer::~LogBuffer() {
-    if (Z_NULL != cstream_.state) {
-        deflateEnd(&cstream_);
-    }
 }
 
 PtrBuffer& LogBuffer::GetData() {
@@ -71,22 +149,30 @@ PtrBuffer& LogBuffer::GetData() {
 }
 
 
-void LogBuffer::Flush(AutoBuffer& _buff) {
+bool LogBuffer::Seal() {
+    
+    if (0 == buff_.Length()) return false;
     
-    if (Z_NULL != cstream_.state) {
-        deflateEnd(&cstream_);
-    }
-
     if (s_log_crypt->GetLogLen((char*)buff_.Ptr(), buff_.Length()) == 0){
         __Clear();
-        return;
+        return false;
     }
     
     __Flush();
-    _buff.Write(buff_.Ptr(), buff_.Length());
+    return true;
+}
+
+void LogBuffer::Clear() {
     __Clear();
 }
 
+bool LogBuffer::IsNewerThan(LogBuffer& _other) {
+    uint16_t seq = s_log_crypt->GetSeq((char*)buff_.Ptr(), buff_.Length());
+    uint16_t other_seq = s_log_crypt->GetSeq((char*)_other.buff_.Ptr(), _other.buff_.Length());
+    
+    // seq wraps around and skips 0
+    return (int16_t)(seq - other_seq) > 0;
+}
 
 bool LogBuffer::Write(const void* _data, size_t _length) {
     if (NULL == _data || 0 == _length) {
@@ -96,38 +182,18 @@ bool LogBuffer::Write(const void* _data, size_t _length) {
     if (buff_.Length() == 0) {
         if (!__Reset()) return false;
     }
-
-    size_t before_len = buff_.Length();
-    size_t write_len = _length;
     
-    if (is_compress_) {
-        cstream_.avail_in = (uInt)_length;
-        cstream_.next_in = (Bytef*)_data;
-
-        uInt avail_out = (uInt)(buff_.MaxLength() - buff_.Length());
-        cstream_.next_out = (Bytef*)buff_.PosPtr();
-        cstream_.avail_out = avail_out;
-
-        if (Z_OK != deflate(&cstream_, Z_SYNC_FLUSH)) {
-            return false;
-        }
+    // a recovered block written by an old version, must be flushed before appending.
+    if (is_compress_ && !s_log_crypt->IsPending((char*)buff_.Ptr(), buff_.Length())) {
+        return false;
+    }
 
-        write_len = avail_out - cstream_.avail_out;
-    } else {
-        buff_.Write(_data, _length);
+    if (buff_.Length() + _length + s_log_crypt->GetTailerLen() > buff_.MaxLength()) {
+        return false;
     }
-    
 
-    char crypt_buffer[4096] = {0};
-    size_t crypt_buffer_len = sizeof(crypt_buffer);
-    
-    
-    s_log_crypt->CryptAsyncLog((char*)buff_.Ptr() + before_len, write_len, crypt_buffer, crypt_buffer_len);
-    
-    buff_.Write(crypt_buffer, crypt_buffer_len, before_len);
-    buff_.Length(before_len + crypt_buffer_len, before_len + crypt_buffer_len);
-   
-    s_log_crypt->UpdateLogLen((char*)buff_.Ptr(), (uint32_t)crypt_buffer_len);
+    buff_.Write(_data, _length);
+    s_log_crypt->UpdateLogLen((char*)buff_.Ptr(), (uint32_t)_length);
 
     return true;
 }
@@ -136,18 +202,7 @@ bool LogBuffer::__Reset() {
     
     __Clear();
     
-    if (is_compress_) {
-        cstream_.zalloc = Z_NULL;
-        cstream_.zfree = Z_NULL;
-        cstream_.opaque = Z_NULL;
-        
-        if (Z_OK != deflateInit2(&cstream_, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY)) {
-            return false;
-        }
-        
-    }
-    
-    s_log_crypt->SetHeaderInfo((char*)buff_.Ptr(), is_compress_);
+    s_log_crypt->SetHeaderInfo((char*)buff_.Ptr(), is_compress_, is_compress_);
     buff_.Length(s_log_crypt->GetHeaderLen(), s_log_crypt->GetHeaderLen());
 
     return true;
@@ -170,7 +225,9 @@ void LogBuffer::__Clear() {
 
 void LogBuffer::__Fix() {
     uint32_t raw_log_len = 0;
-    if (s_log_crypt->Fix((char*)buff_.Ptr(), buff_.Length(), is_compress_, raw_log_len)) {
+    bool is_async = is_compress_;
+    if (s_log_crypt->Fix((char*)buff_.Ptr(), buff_.Length(), is_async, raw_log_len)
+            && raw_log_len + s_log_crypt->GetHeaderLen() + s_log_crypt->GetTailerLen() <= buff_.MaxLength()) {
         buff_.Length(raw_log_len + s_log_crypt->GetHeaderLen(), raw_log_len + s_log_crypt->GetHeaderLen());
     } else {
         buff_.Length(0, 0);
@@ -38,15 +38,25 @@ public:
     static bool GetPeriodLogs(const char* _log_path, int _begin_hour, int _end_hour, unsigned long& _begin_pos, unsigned long& _end_pos, std::string& _err_msg);
     static bool Write(const void* _data, size_t _inputlen, void* _output, size_t& _len);
 
+    // compress and crypt a block sealed by Seal into _out, call it without holding the buffer lock.
+    static void Compress(const void* _block, size_t _len, AutoBuffer& _out);
+    static void SetCompressLevel(int _level);
+
 public:
     PtrBuffer& GetData();
     
-
-    void Flush(AutoBuffer& _buff);
+    // finish the block for flushing, returns false if there is nothing to flush.
+    // GetData() holds the whole block until Clear, nothing can be written in the meantime.
+    bool Seal();
+    void Clear();
     bool Write(const void* _data, size_t _length);
+    // true if this block was started after _other, only meaningful when both hold logs.
+    bool IsNewerThan(LogBuffer& _other);
 
 private:
     
+    static void __CommitRaw(const char* _block, size_t _len, size_t _raw_len, AutoBuffer& _out);
+
     bool __Reset();
     void __Flush();
     void __Clear();
@@ -56,9 +66,9 @@ private:
 private:
     PtrBuffer buff_;
     bool is_compress_;
-    z_stream cstream_;
     
     static class LogCrypt* s_log_crypt;
+    static int s_compress_level;
 
 };
 
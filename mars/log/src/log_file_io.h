@@ -0,0 +1,82 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * log_file_io.h
+ *
+ *  Created on: 2026-10-18
+ */
+
+#ifndef LOG_FILE_IO_H_
+#define LOG_FILE_IO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * the raw fd calls the log files are written with. posix has them all, on windows the crt
+ * has open/lseek/write/close and comm/windows/unistd.h maps ftruncate, the rest is here.
+ */
+#ifdef _WIN32
+#include <io.h>
+
+struct iovec {
+    void* iov_base;
+    size_t iov_len;
+};
+
+// one crt write per buffer, stops at the first short write like a partial writev.
+static inline ssize_t writev(int _fd, const struct iovec* _iov, int _iovcnt) {
+    ssize_t total = 0;
+    for (int i = 0; i < _iovcnt; ++i) {
+        int ret = _write(_fd, _iov[i].iov_base, (unsigned int)_iov[i].iov_len);
+        if (0 > ret) return 0 < total ? total : -1;
+
+        total += ret;
+        if ((size_t)ret < _iov[i].iov_len) break;
+    }
+    return total;
+}
+
+// the file position moves, which is fine for files only accessed by offset.
+static inline ssize_t pread(int _fd, void* _buf, size_t _count, int64_t _offset) {
+    if (0 > _lseeki64(_fd, _offset, SEEK_SET)) return -1;
+    return _read(_fd, _buf, (unsigned int)_count);
+}
+
+static inline ssize_t pwrite(int _fd, const void* _buf, size_t _count, int64_t _offset) {
+    if (0 > _lseeki64(_fd, _offset, SEEK_SET)) return -1;
+    return _write(_fd, _buf, (unsigned int)_count);
+}
+
+#define LOG_FILE_MODE (_S_IREAD | _S_IWRITE)
+#else
+#include <sys/uio.h>
+
+#define LOG_FILE_MODE 0666
+#endif
+
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+
+// the crt opens files in text mode by default
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#endif  // LOG_FILE_IO_H_
@@ -0,0 +1,309 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * log_index.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include "log_index.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log/crypt/log_crypt.h"
+
+static const char kIndexMagic[4] = {'X', 'I', 'D', '\x01'};
+static const size_t kEntryLen = sizeof(uint32_t) * 2 + sizeof(char) * 2;
+static const uint64_t kMaxIndexLen = 16 * 1024 * 1024;
+
+static LogCrypt* sg_log_crypt = new LogCrypt();
+
+static void __encode(const LogIndex::Entry& _entry, char* _buff) {
+    memcpy(_buff, &_entry.offset, sizeof(_entry.offset));
+    memcpy(_buff + sizeof(uint32_t), &_entry.length, sizeof(_entry.length));
+    _buff[sizeof(uint32_t) * 2] = _entry.begin_hour;
+    _buff[sizeof(uint32_t) * 2 + 1] = _entry.end_hour;
+}
+
+static void __decode(const char* _buff, LogIndex::Entry& _entry) {
+    memcpy(&_entry.offset, _buff, sizeof(_entry.offset));
+    memcpy(&_entry.length, _buff + sizeof(uint32_t), sizeof(_entry.length));
+    _entry.begin_hour = _buff[sizeof(uint32_t) * 2];
+    _entry.end_hour = _buff[sizeof(uint32_t) * 2 + 1];
+}
+
+static bool __pwrite(int _fd, const char* _buff, size_t _len, uint64_t _offset) {
+    while (0 < _len) {
+        ssize_t ret = pwrite(_fd, _buff, _len, (off_t)_offset);
+        if (0 > ret && EINTR == errno) continue;
+        if (0 >= ret) return false;
+
+        _buff += ret;
+        _len -= ret;
+        _offset += ret;
+    }
+    return true;
+}
+
+LogIndex::LogIndex()
+: fd_(-1), size_(0), end_(0), has_last_(false) {
+    memset(&last_, 0, sizeof(last_));
+}
+
+LogIndex::~LogIndex() {
+    Close();
+}
+
+std::string LogIndex::IndexPath(const std::string& _log_path) {
+    return _log_path + ".idx";
+}
+
+bool LogIndex::GetPeriodLogs(const char* _log_path, int _begin_hour, int _end_hour, unsigned long& _begin_pos, unsigned long& _end_pos) {
+    if (NULL == _log_path || _end_hour <= _begin_hour) return false;
+
+    struct stat log_stat;
+    if (0 != stat(_log_path, &log_stat)) return false;
+
+    std::vector<Entry> entries;
+    if (!Load(_log_path, log_stat.st_size, entries)) return false;
+
+    // the same walk as LogCrypt::GetPeriodLogs, over entries instead of block headers.
+    _begin_pos = _end_pos = 0;
+
+    bool find_begin_pos = false;
+    int last_end_hour = -1;
+    unsigned long last_end_pos = 0;
+
+    for (std::vector<Entry>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter) {
+        int begin_hour = iter->begin_hour;
+        int end_hour = iter->end_hour;
+        unsigned long end_pos = (unsigned long)iter->offset + iter->length;
+
+        if (begin_hour > end_hour)  begin_hour = end_hour;
+
+        if (!find_begin_pos) {
+            if (_begin_hour > begin_hour && _begin_hour <= end_hour) {
+                _begin_pos = iter->offset;
+                find_begin_pos = true;
+            }
+
+            if (_begin_hour > last_end_hour && _begin_hour <= begin_hour) {
+                _begin_pos = iter->offset;
+                find_begin_pos = true;
+            }
+        }
+
+        if (find_begin_pos) {
+            if (_end_hour > begin_hour && _end_hour <= end_hour) {
+                _end_pos = end_pos;
+            }
+
+            if (_end_hour > last_end_hour && _end_hour <= begin_hour) {
+                _end_pos = last_end_pos;
+            }
+        }
+
+        last_end_hour = end_hour;
+        last_end_pos = end_pos;
+    }
+
+    if (find_begin_pos && _end_hour > last_end_hour) {
+        _end_pos = (unsigned long)log_stat.st_size;
+    }
+
+    return true;
+}
+
+void LogIndex::AppendFile(const std::string& _src_log, const std::string& _dst_log, uint64_t _dst_offset, uint64_t _src_size) {
+    std::vector<Entry> entries;
+    bool is_valid = __Read(_src_log, entries);
+
+    uint64_t end = 0;
+    for (std::vector<Entry>::const_iterator iter = entries.begin(); is_valid && iter != entries.end(); ++iter) {
+        is_valid = iter->offset == end;
+        end = (uint64_t)iter->offset + iter->length;
+    }
+
+    LogIndex index;
+    if (index.Open(_dst_log, _dst_offset)) {
+        if (is_valid && end == _src_size) {
+            for (std::vector<Entry>::iterator iter = entries.begin(); iter != entries.end(); ++iter) {
+                iter->offset += (uint32_t)_dst_offset;
+                index.__Add(*iter);
+            }
+        } else {
+            index.__AddUnknown(_dst_offset, _src_size);
+        }
+        index.Close();
+    }
+
+    remove(IndexPath(_src_log).c_str());
+}
+
+bool LogIndex::Load(const std::string& _log_path, uint64_t _log_size, std::vector<Entry>& _entries) {
+    if (!__Read(_log_path, _entries)) return false;
+
+    uint64_t end = 0;
+    for (std::vector<Entry>::const_iterator iter = _entries.begin(); iter != _entries.end(); ++iter) {
+        if (iter->offset != end || kUnknownHour == iter->begin_hour) return false;
+        end = (uint64_t)iter->offset + iter->length;
+    }
+
+    return end == _log_size;
+}
+
+bool LogIndex::Open(const std::string& _log_path, uint64_t _log_size) {
+    Close();
+
+    fd_ = open(IndexPath(_log_path).c_str(), O_RDWR | O_CREAT | O_BINARY, LOG_FILE_MODE);
+    if (-1 == fd_) return false;
+
+    struct stat index_stat;
+    char magic[sizeof(kIndexMagic)] = {0};
+    char last[kEntryLen] = {0};
+
+    if (0 == fstat(fd_, &index_stat) && (uint64_t)index_stat.st_size >= sizeof(kIndexMagic) + kEntryLen
+            && 0 == (index_stat.st_size - sizeof(kIndexMagic)) % kEntryLen
+            && sizeof(magic) == pread(fd_, magic, sizeof(magic), 0) && 0 == memcmp(magic, kIndexMagic, sizeof(magic))
+            && kEntryLen == pread(fd_, last, kEntryLen, index_stat.st_size - kEntryLen)) {
+        size_ = index_stat.st_size;
+        __decode(last, last_);
+        has_last_ = true;
+        end_ = (uint64_t)last_.offset + last_.length;
+    } else {
+        size_ = 0;
+        end_ = 0;
+    }
+
+    // a new or broken index, or one left by a log file removed since then.
+    if (0 == size_ || end_ > _log_size) {
+        has_last_ = false;
+        end_ = 0;
+        if (0 != ftruncate(fd_, 0) || !__pwrite(fd_, kIndexMagic, sizeof(kIndexMagic), 0)) {
+            Close();
+            return false;
+        }
+        size_ = sizeof(kIndexMagic);
+    }
+
+    if (end_ < _log_size) __AddUnknown(end_, _log_size - end_);
+    return true;
+}
+
+void LogIndex::Close() {
+    if (-1 == fd_) return;
+
+    close(fd_);
+    fd_ = -1;
+    size_ = 0;
+    end_ = 0;
+    has_last_ = false;
+}
+
+void LogIndex::Append(uint64_t _offset, const struct iovec* _iov, int _iovcnt) {
+    if (-1 == fd_) return;
+
+    // written by others, e.g. the error tips of a failed write
+    if (_offset > end_) __AddUnknown(end_, _offset - end_);
+    if (_offset != end_) return;
+
+    size_t header_len = sg_log_crypt->GetHeaderLen();
+    size_t tailer_len = sg_log_crypt->GetTailerLen();
+
+    for (int i = 0; i < _iovcnt; ++i) {
+        const char* data = (const char*)_iov[i].iov_base;
+        size_t len = _iov[i].iov_len;
+        size_t pos = 0;
+
+        while (pos < len) {
+            int begin_hour = 0;
+            int end_hour = 0;
+            size_t block_len = header_len + sg_log_crypt->GetLogLen(data + pos, len - pos) + tailer_len;
+
+            // only complete blocks LogCrypt::GetPeriodLogs accepts are indexed, pending blocks never get to the file.
+            if (len - pos < header_len + tailer_len || block_len > len - pos || sg_log_crypt->IsPending(data + pos, len - pos)
+                    || !sg_log_crypt->GetLogHour(data + pos, len - pos, begin_hour, end_hour)) {
+                __AddUnknown(end_, len - pos);
+                break;
+            }
+
+            Entry entry = {(uint32_t)end_, (uint32_t)block_len, (char)begin_hour, (char)end_hour};
+            __Add(entry);
+            pos += block_len;
+        }
+    }
+}
+
+bool LogIndex::__Read(const std::string& _log_path, std::vector<Entry>& _entries) {
+    _entries.clear();
+
+    FILE* file = fopen(IndexPath(_log_path).c_str(), "rb");
+    if (NULL == file) return false;
+
+    std::string content;
+    char buffer[4096];
+    size_t len = 0;
+    while (content.size() < kMaxIndexLen && 0 < (len = fread(buffer, 1, sizeof(buffer), file))) content.append(buffer, len);
+    fclose(file);
+
+    if (content.size() < sizeof(kIndexMagic) || 0 != memcmp(content.data(), kIndexMagic, sizeof(kIndexMagic))
+            || 0 != (content.size() - sizeof(kIndexMagic)) % kEntryLen) {
+        return false;
+    }
+
+    _entries.resize((content.size() - sizeof(kIndexMagic)) / kEntryLen);
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        __decode(content.data() + sizeof(kIndexMagic) + i * kEntryLen, _entries[i]);
+    }
+
+    return true;
+}
+
+void LogIndex::__Add(const Entry& _entry) {
+    if (-1 == fd_) return;
+
+    char buff[kEntryLen] = {0};
+
+    // blocks within one hour change nothing in GetPeriodLogs but the end of the range they cover.
+    if (has_last_ && (uint64_t)last_.offset + last_.length == _entry.offset && last_.begin_hour == last_.end_hour
+            && _entry.begin_hour == _entry.end_hour && last_.begin_hour == _entry.begin_hour) {
+        Entry merged = last_;
+        merged.length += _entry.length;
+        __encode(merged, buff);
+
+        if (!__pwrite(fd_, buff, kEntryLen, size_ - kEntryLen)) {
+            Close();
+            return;
+        }
+        last_ = merged;
+    } else {
+        __encode(_entry, buff);
+
+        if (!__pwrite(fd_, buff, kEntryLen, size_)) {
+            Close();
+            return;
+        }
+        size_ += kEntryLen;
+        last_ = _entry;
+        has_last_ = true;
+    }
+
+    end_ = (uint64_t)_entry.offset + _entry.length;
+}
+
+void LogIndex::__AddUnknown(uint64_t _offset, uint64_t _length) {
+    Entry entry = {(uint32_t)_offset, (uint32_t)_length, kUnknownHour, kUnknownHour};
+    __Add(entry);
+}
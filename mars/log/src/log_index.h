@@ -0,0 +1,81 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * log_index.h
+ *
+ *  Created on: 2026-10-17
+ */
+
+#ifndef LOG_INDEX_H_
+#define LOG_INDEX_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "log_file_io.h"
+
+/*
+ * sidecar index of a log file, prefix_yyyymmdd.xlog.idx next to prefix_yyyymmdd.xlog.
+ * |magic(4)|entry|entry|...  entry: |offset(uint32_t)|length(uint32_t)|begin hour(char)|end hour(char)|
+ * an entry describes blocks of the log file, blocks of one hour written one after another share one entry.
+ * ranges it knows nothing about, e.g. written by an old version, are entries with kUnknownHour.
+ * it's trusted only if the entries chain from 0 to the size of the log file, or the log file is scanned.
+ */
+class LogIndex {
+  public:
+    struct Entry {
+        uint32_t offset;
+        uint32_t length;
+        char begin_hour;
+        char end_hour;
+    };
+
+    static const char kUnknownHour = -1;
+
+  public:
+    LogIndex();
+    ~LogIndex();
+
+  public:
+    static std::string IndexPath(const std::string& _log_path);
+    // same result as LogCrypt::GetPeriodLogs, false if the index can't be trusted.
+    static bool GetPeriodLogs(const char* _log_path, int _begin_hour, int _end_hour, unsigned long& _begin_pos, unsigned long& _end_pos);
+    // _src_log has been appended to _dst_log at _dst_offset, moves the index along.
+    static void AppendFile(const std::string& _src_log, const std::string& _dst_log, uint64_t _dst_offset, uint64_t _src_size);
+    static bool Load(const std::string& _log_path, uint64_t _log_size, std::vector<Entry>& _entries);
+
+  public:
+    bool Open(const std::string& _log_path, uint64_t _log_size);
+    void Close();
+    // blocks appended to the log file at _offset, each iovec holds whole blocks.
+    void Append(uint64_t _offset, const struct iovec* _iov, int _iovcnt);
+
+  private:
+    LogIndex(const LogIndex&);
+    LogIndex& operator=(const LogIndex&);
+
+  private:
+    static bool __Read(const std::string& _log_path, std::vector<Entry>& _entries);
+    void __Add(const Entry& _entry);
+    void __AddUnknown(uint64_t _offset, uint64_t _length);
+
+  private:
+    int fd_;
+    uint64_t size_;         // of the index file
+    uint64_t end_;          // of the log file that has been indexed
+    Entry last_;
+    bool has_last_;
+};
+
+#endif /* LOG_INDEX_H_ */
@@ -0,0 +1,101 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * log_staging_ring.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include "log_staging_ring.h"
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+
+#include "mars/comm/thread/atomic_oper.h"
+
+LogStagingRing::LogStagingRing(size_t _capacity)
+: buffer_(new char[_capacity]), capacity_((uint32_t)_capacity), mask_((uint32_t)_capacity - 1)
+, head_(0), tail_(0), orphan_(0) {
+    assert(0 != _capacity && 0 == (_capacity & (_capacity - 1)));
+}
+
+LogStagingRing::~LogStagingRing() {
+    delete[] buffer_;
+}
+
+bool LogStagingRing::Push(const void* _data, size_t _len) {
+    if (NULL == _data || 0 == _len) return false;
+
+    size_t need = sizeof(uint32_t) + _len;
+    uint32_t head = head_;
+    uint32_t tail = atomic_read32(&tail_);
+
+    if (capacity_ - (head - tail) < need) return false;
+
+    uint32_t len = (uint32_t)_len;
+    __CopyIn(head, &len, sizeof(len));
+    __CopyIn(head + (uint32_t)sizeof(len), _data, _len);
+
+    // publish after the record is completely written
+    atomic_write32(&head_, head + (uint32_t)need);
+    return true;
+}
+
+uint32_t LogStagingRing::FrontLength() {
+    uint32_t tail = tail_;
+    uint32_t head = atomic_read32(&head_);
+
+    if (head == tail) return 0;
+
+    uint32_t len = 0;
+    __CopyOut(tail, &len, sizeof(len));
+    return len;
+}
+
+void LogStagingRing::Pop(void* _output) {
+    uint32_t tail = tail_;
+    uint32_t len = FrontLength();
+    if (0 == len) return;
+
+    __CopyOut(tail + (uint32_t)sizeof(len), _output, len);
+    atomic_write32(&tail_, tail + (uint32_t)sizeof(len) + len);
+}
+
+size_t LogStagingRing::Length() {
+    return atomic_read32(&head_) - atomic_read32(&tail_);
+}
+
+void LogStagingRing::Orphan() {
+    atomic_write32(&orphan_, 1);
+}
+
+bool LogStagingRing::IsOrphan() {
+    return 0 != atomic_read32(&orphan_);
+}
+
+void LogStagingRing::__CopyIn(uint32_t _pos, const void* _data, size_t _len) {
+    uint32_t offset = _pos & mask_;
+    size_t first = std::min(_len, (size_t)(capacity_ - offset));
+
+    memcpy(buffer_ + offset, _data, first);
+    if (first < _len) memcpy(buffer_, (const char*)_data + first, _len - first);
+}
+
+void LogStagingRing::__CopyOut(uint32_t _pos, void* _data, size_t _len) const {
+    uint32_t offset = _pos & mask_;
+    size_t first = std::min(_len, (size_t)(capacity_ - offset));
+
+    memcpy(_data, buffer_ + offset, first);
+    if (first < _len) memcpy((char*)_data + first, buffer_, _len - first);
+}
@@ -0,0 +1,72 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * log_staging_ring.h
+ *
+ *  Created on: 2026-10-17
+ */
+
+#ifndef LOG_STAGING_RING_H_
+#define LOG_STAGING_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * single producer / single consumer byte ring.
+ * the owner thread pushes formatted log records, the drainer pops them.
+ * record layout: |length(uint32_t)|data|, may wrap around the end of the ring.
+ */
+class LogStagingRing {
+  public:
+    explicit LogStagingRing(size_t _capacity);  // _capacity must be power of 2
+    ~LogStagingRing();
+
+  public:
+    // producer side
+    bool Push(const void* _data, size_t _len);
+
+    // consumer side
+    uint32_t FrontLength();   // 0 if empty
+    void Pop(void* _output);  // _output must hold FrontLength() bytes
+
+    size_t Length();
+    size_t Capacity() const { return capacity_; }
+
+    void Orphan();
+    bool IsOrphan();
+
+  private:
+    void __CopyIn(uint32_t _pos, const void* _data, size_t _len);
+    void __CopyOut(uint32_t _pos, void* _data, size_t _len) const;
+
+  private:
+    LogStagingRing(const LogStagingRing&);
+    LogStagingRing& operator=(const LogStagingRing&);
+
+  private:
+    char* buffer_;
+    uint32_t capacity_;
+    uint32_t mask_;
+
+    // head_ is only written by producer, tail_ is only written by consumer. keep them on different cache lines.
+    char pad0_[64];
+    volatile uint32_t head_;
+    char pad1_[64];
+    volatile uint32_t tail_;
+    char pad2_[64];
+
+    volatile uint32_t orphan_;
+};
+
+#endif /* LOG_STAGING_RING_H_ */
@@ -0,0 +1,201 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * appender_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "boost/filesystem.hpp"
+
+#include "mars/comm/xlogger/xloggerbase.h"
+#include "mars/comm/time_utils.h"
+#include "mars/log/appender.h"
+
+namespace
+{
+
+static const char* kPrefix = "appender_test";
+
+static std::string test_dir(const char* _name)
+{
+	static std::string s_root = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+	return s_root + "/" + _name;
+}
+
+// the appender is process wide, every test shares this one.
+static void open_appender()
+{
+	static bool s_opened = false;
+	if (s_opened) return;
+	s_opened = true;
+
+	boost::filesystem::create_directories(test_dir("cache"));
+	boost::filesystem::create_directories(test_dir("log"));
+	appender_set_compress_level(1);
+	appender_open_with_cache(kAppednerAsync, test_dir("cache"), test_dir("log"), kPrefix);
+	xlogger_SetLevel(kLevelAll);
+}
+
+static std::string today_file(const char* _dir)
+{
+	time_t now = time(NULL);
+	tm tcur = *localtime(&now);
+	char name[128] = {0};
+	snprintf(name, sizeof(name), "/%s_%d%02d%02d.xlog", kPrefix, 1900 + tcur.tm_year, 1 + tcur.tm_mon, tcur.tm_mday);
+	return test_dir(_dir) + name;
+}
+
+static std::string read_file(const std::string& _path)
+{
+	std::string content;
+	FILE* file = fopen(_path.c_str(), "rb");
+	if (NULL == file) return content;
+
+	char buffer[4096];
+	size_t len = 0;
+	while (0 < (len = fread(buffer, 1, sizeof(buffer), file))) content.append(buffer, len);
+	fclose(file);
+	return content;
+}
+
+static void write_file(const std::string& _path, const std::string& _content)
+{
+	FILE* file = fopen(_path.c_str(), "wb");
+	ASSERT_TRUE(NULL != file);
+	fwrite(_content.data(), 1, _content.size(), file);
+	fclose(file);
+}
+
+static void write_logs(int _count)
+{
+	for (int i = 0; i < _count; ++i)
+	{
+		XLoggerInfo info;
+		memset(&info, 0, sizeof(info));
+		info.level = kLevelInfo;
+		info.tag = "mars::stn";
+		info.filename = "/path/to/stn/src/longlink.cc";
+		info.func_name = "__RunReadWrite";
+		info.line = 100;
+		gettimeofday(&info.timeval, NULL);
+		info.pid = 1234;
+		info.tid = 1234 + i % 4;
+		info.maintid = 1234;
+
+		char body[128] = {0};
+		snprintf(body, sizeof(body), "task:%d, cmdid:%d, seq:%d, send len:%d, cost:%dms", i, i % 13, i * 3, i * 17 % 4096, i % 100);
+		xlogger_Write(&info, body);
+	}
+}
+
+}
+
+TEST(Appender_test, flush_benchmark)
+{
+	static const int kFlushCount = 2000;
+	static const int kLogsPerFlush = 400;
+
+	open_appender();
+	appender_flush_sync();
+	uint64_t begin_size = boost::filesystem::file_size(today_file("log"));
+
+	uint64_t flush_cost = 0;
+	uint64_t begin = gettickcount();
+	for (int i = 0; i < kFlushCount; ++i)
+	{
+		write_logs(kLogsPerFlush);
+
+		uint64_t flush_begin = gettickcount();
+		appender_flush_sync();
+		flush_cost += gettickcount() - flush_begin;
+	}
+	uint64_t total_cost = gettickcount() - begin;
+
+	uint64_t written = boost::filesystem::file_size(today_file("log")) - begin_size;
+	printf("%d flushes of %d logs, %" PRIu64 " bytes written, total:%" PRIu64 "ms, in flush:%" PRIu64 "ms, %.1f flushes/s\n",
+		   kFlushCount, kLogsPerFlush, written, total_cost, flush_cost, kFlushCount * 1000.0 / (flush_cost ? flush_cost : 1));
+	EXPECT_LT(0u, written);
+	EXPECT_FALSE(boost::filesystem::exists(today_file("cache")));
+}
+
+TEST(Appender_test, move_cache_file)
+{
+	open_appender();
+	appender_flush_sync();
+
+	// nothing in the log dir, the cache file is moved.
+	boost::filesystem::remove(today_file("log"));
+	write_file(today_file("cache"), "cached logs\n");
+
+	write_logs(10);
+	appender_flush_sync();
+
+	EXPECT_FALSE(boost::filesystem::exists(today_file("cache")));
+	std::string content = read_file(today_file("log"));
+	ASSERT_LT(12u, content.size());
+	EXPECT_EQ("cached logs\n", content.substr(0, 12));
+
+	// appended to the file in the log dir.
+	write_file(today_file("cache"), "more cached logs\n");
+
+	write_logs(10);
+	appender_flush_sync();
+
+	EXPECT_FALSE(boost::filesystem::exists(today_file("cache")));
+	std::string appended = read_file(today_file("log"));
+	ASSERT_LT(content.size() + 17, appended.size());
+	EXPECT_EQ(content, appended.substr(0, content.size()));
+	EXPECT_EQ("more cached logs\n", appended.substr(content.size(), 17));
+}
+
+TEST(Appender_test, move_cache_benchmark)
+{
+	static const size_t kCacheFileSize = 64 * 1024 * 1024;
+
+	open_appender();
+	appender_flush_sync();
+
+	std::string large_day(kCacheFileSize, 'x');
+
+	// a large day left in the cache dir, nothing in the log dir.
+	boost::filesystem::remove(today_file("log"));
+	write_file(today_file("cache"), large_day);
+	write_logs(10);
+
+	uint64_t begin = gettickcount();
+	appender_flush_sync();
+	uint64_t move_cost = gettickcount() - begin;
+
+	// and again, appended to the log dir file.
+	write_file(today_file("cache"), large_day);
+	write_logs(10);
+
+	begin = gettickcount();
+	appender_flush_sync();
+	uint64_t append_cost = gettickcount() - begin;
+
+	printf("flush with %" PRIu64 " bytes cached, moved:%" PRIu64 "ms, appended:%" PRIu64 "ms\n", (uint64_t)kCacheFileSize, move_cost, append_cost);
+	EXPECT_FALSE(boost::filesystem::exists(today_file("cache")));
+	EXPECT_LT(kCacheFileSize * 2, boost::filesystem::file_size(today_file("log")));
+	boost::filesystem::remove(today_file("log"));
+}
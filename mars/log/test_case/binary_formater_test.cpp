@@ -0,0 +1,252 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * binary_formater_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <map>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "mars/comm/xlogger/xloggerbase.h"
+#include "mars/comm/ptrbuffer.h"
+#include "mars/comm/time_utils.h"
+#include "mars/log/src/log_binary_formater.h"
+
+extern void log_formater(const XLoggerInfo* _info, const char* _logbody, PtrBuffer& _log);
+
+namespace
+{
+
+// same as DecodeBinaryBuffer in log/crypt/decode_mars_log_file.py
+class BinaryDecoder
+{
+public:
+	BinaryDecoder(const char* _data, size_t _len): data_((const unsigned char*)_data), len_(_len), pos_(0)
+	, pid_(0), maintid_(0), time_(0), gmtoff_(0) {}
+
+	bool Decode(std::string& _out)
+	{
+		static const char* levelStrings[] = {"V", "D", "I", "W", "E", "F"};
+
+		if (len_ < sizeof(LogBinaryFormater::kSignature) || 0 != memcmp(data_, LogBinaryFormater::kSignature, sizeof(LogBinaryFormater::kSignature))) return false;
+		pos_ = sizeof(LogBinaryFormater::kSignature);
+
+		while (pos_ < len_)
+		{
+			switch (data_[pos_++])
+			{
+			case 1:
+				pid_ = Zigzag();
+				maintid_ = Zigzag();
+				time_ = (int64_t)Varint();
+				gmtoff_ = Zigzag();
+				callsites_.clear();
+				break;
+			case 2:
+			{
+				uint64_t id = Varint();
+				int64_t line = Zigzag();
+				std::string tag = String();
+				std::string file = String();
+				std::string func = String();
+				char temp[32] = {0};
+				snprintf(temp, sizeof(temp), ", %d][", (int)line);
+				callsites_[id] = "[" + tag + "][" + file + ", " + func + temp;
+				break;
+			}
+			case 3:
+			{
+				unsigned char level = data_[pos_++];
+				uint64_t id = Varint();
+				char logtime[64] = {0};
+				if (0 == (level & 0x80))
+				{
+					time_ += Zigzag();
+					time_t sec = (time_t)(time_ / 1000 + gmtoff_);
+					tm tm;
+					gmtime_r(&sec, &tm);
+					snprintf(logtime, sizeof(logtime), "%d-%02d-%02d %+.1f %02d:%02d:%02d.%.3d", 1900 + tm.tm_year, 1 + tm.tm_mon, tm.tm_mday,
+							 gmtoff_ / 3600.0, tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(time_ % 1000));
+				}
+				int64_t tid = Zigzag();
+				std::string body = String();
+
+				char header[256] = {0};
+				snprintf(header, sizeof(header), "[%s][%s][%" PRId64 ", %" PRId64 "%s]", levelStrings[level & 0x7F], logtime, pid_, tid, tid == maintid_ ? "*" : "");
+				_out += header;
+				_out += callsites_[id];
+				_out += body;
+				if (body.empty() || '\n' != body[body.size() - 1]) _out += '\n';
+				break;
+			}
+			case 4:
+				_out += String();
+				break;
+			default:
+				return false;
+			}
+		}
+		return pos_ == len_;
+	}
+
+private:
+	uint64_t Varint()
+	{
+		uint64_t value = 0;
+		for (int shift = 0; pos_ < len_; shift += 7)
+		{
+			unsigned char b = data_[pos_++];
+			value |= (uint64_t)(b & 0x7F) << shift;
+			if (b < 0x80) break;
+		}
+		return value;
+	}
+
+	int64_t Zigzag()
+	{
+		uint64_t value = Varint();
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	std::string String()
+	{
+		size_t len = (size_t)Varint();
+		std::string str((const char*)data_ + pos_, len);
+		pos_ += len;
+		return str;
+	}
+
+private:
+	const unsigned char* data_;
+	size_t len_;
+	size_t pos_;
+
+	int64_t pid_;
+	int64_t maintid_;
+	int64_t time_;
+	int64_t gmtoff_;
+	std::map<uint64_t, std::string> callsites_;
+};
+
+static XLoggerInfo make_info(TLogLevel _level, const char* _tag, const char* _file, const char* _func, int _line)
+{
+	XLoggerInfo info;
+	memset(&info, 0, sizeof(info));
+	info.level = _level;
+	info.tag = _tag;
+	info.filename = _file;
+	info.func_name = _func;
+	info.line = _line;
+	gettimeofday(&info.timeval, NULL);
+	info.pid = 1234;
+	info.tid = 5678;
+	info.maintid = 1234;
+	return info;
+}
+
+}
+
+TEST(LogBinaryFormater_test, decodes_to_text)
+{
+	char func_tmp[64] = {0};
+	strncpy(func_tmp, "void LongLink::__RunReadWrite(int)", sizeof(func_tmp) - 1);
+
+	XLoggerInfo infos[] = {
+		make_info(kLevelInfo, "mars::stn", "/path/to/stn/src/longlink.cc", "__RunReadWrite", 100),
+		make_info(kLevelError, NULL, "longlink.cc", "LongLink::Send", 0),
+		make_info(kLevelDebug, "", NULL, NULL, -1),
+		make_info(kLevelVerbose, "mars::comm", "C:\\windows\\path\\file.cpp", func_tmp, 2147483647),
+	};
+	infos[1].tid = infos[1].maintid;
+	infos[1].timeval.tv_sec -= 3600;
+	infos[2].timeval.tv_sec = 0;
+	infos[3].timeval.tv_usec = 7000;
+
+	const char* bodies[] = {"hello world", "ends with new line\n", NULL, ""};
+
+	static char binary[64 * 1024];
+	static char text[64 * 1024];
+	PtrBuffer binary_buff(binary, 0, sizeof(binary));
+	PtrBuffer text_buff(text, 0, sizeof(text));
+
+	LogBinaryFormater formater;
+	binary_buff.Write(LogBinaryFormater::kSignature, sizeof(LogBinaryFormater::kSignature));
+
+	for (size_t round = 0; round < 3; ++round)
+	{
+		for (size_t i = 0; i < sizeof(infos) / sizeof(infos[0]); ++i)
+		{
+			const char* body = bodies[(i + round) % (sizeof(bodies) / sizeof(bodies[0]))];
+			ASSERT_TRUE(formater.Format(&infos[i], body, binary_buff));
+			log_formater(&infos[i], body, text_buff);
+		}
+
+		ASSERT_TRUE(formater.Format(NULL, "without info", binary_buff));
+		log_formater(NULL, "without info", text_buff);
+		ASSERT_TRUE(formater.Text("[F][ preformatted\n", 18, binary_buff));
+		text_buff.Write("[F][ preformatted\n", 18);
+
+		// jni passes temporary strings, the same address may hold another function name.
+		strncpy(func_tmp, "void LongLink::Send(int)", sizeof(func_tmp) - 1);
+		if (1 == round) formater.Reset();
+	}
+
+	std::string decoded;
+	EXPECT_TRUE(BinaryDecoder(binary, binary_buff.Length()).Decode(decoded));
+	EXPECT_EQ(std::string(text, text_buff.Length()), decoded);
+	EXPECT_LT(binary_buff.Length(), text_buff.Length());
+}
+
+TEST(LogBinaryFormater_test, benchmark)
+{
+	static const int kCount = 200000;
+	XLoggerInfo info = make_info(kLevelInfo, "mars::stn", "/path/to/stn/src/longlink.cc", "__RunReadWrite", 100);
+	const char* body = "task:1234, cmdid:10, seq:4567, send len:1024, cost:35ms";
+
+	size_t text_len = 0;
+	uint64_t begin = gettickcount();
+	for (int i = 0; i < kCount; ++i)
+	{
+		char temp[16 * 1024];
+		PtrBuffer log(temp, 0, sizeof(temp));
+		log_formater(&info, body, log);
+		text_len += log.Length();
+	}
+	uint64_t text_cost = gettickcount() - begin;
+
+	LogBinaryFormater formater;
+	size_t binary_len = 0;
+	begin = gettickcount();
+	for (int i = 0; i < kCount; ++i)
+	{
+		char temp[16 * 1024];
+		PtrBuffer log(temp, 0, sizeof(temp));
+		formater.Format(&info, body, log);
+		binary_len += log.Length();
+	}
+	uint64_t binary_cost = gettickcount() - begin;
+
+	printf("%d records, text:%" PRIu64 "ms %" PRIu64 "bytes, binary:%" PRIu64 "ms %" PRIu64 "bytes\n", kCount,
+		   text_cost, (uint64_t)text_len, binary_cost, (uint64_t)binary_len);
+	EXPECT_LT(binary_len, text_len);
+}
@@ -0,0 +1,147 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * formater_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "gtest/gtest.h"
+
+#include "mars/comm/xlogger/xloggerbase.h"
+#include "mars/comm/xlogger/loginfo_extract.h"
+#include "mars/comm/ptrbuffer.h"
+#include "mars/comm/time_utils.h"
+
+extern void log_formater(const XLoggerInfo* _info, const char* _logbody, PtrBuffer& _log);
+
+namespace
+{
+
+// the header formater before the per-second/per-callsite cache, kept as reference and baseline.
+static void snprintf_formater(const XLoggerInfo* _info, const char* _logbody, PtrBuffer& _log)
+{
+	static const char* levelStrings[] = {"V", "D", "I", "W", "E", "F"};
+
+	const char* filename = ExtractFileName(_info->filename);
+	char strFuncName [128] = {0};
+	ExtractFunctionName(_info->func_name, strFuncName, sizeof(strFuncName));
+
+	char temp_time[64] = {0};
+
+	if (0 != _info->timeval.tv_sec)
+	{
+		time_t sec = _info->timeval.tv_sec;
+		tm tm = *localtime((const time_t*)&sec);
+		snprintf(temp_time, sizeof(temp_time), "%d-%02d-%02d %+.1f %02d:%02d:%02d.%.3d", 1900 + tm.tm_year, 1 + tm.tm_mon, tm.tm_mday,
+				 tm.tm_gmtoff / 3600.0, tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(_info->timeval.tv_usec / 1000));
+	}
+
+	int ret = snprintf((char*)_log.PosPtr(), 1024, "[%s][%s][%" PRIdMAX ", %" PRIdMAX "%s][%s][%s, %s, %d][",
+					   _logbody ? levelStrings[_info->level] : levelStrings[kLevelFatal], temp_time,
+					   _info->pid, _info->tid, _info->tid == _info->maintid ? "*" : "", _info->tag ? _info->tag : "",
+					   filename, strFuncName, _info->line);
+	_log.Length(_log.Pos() + ret, _log.Length() + ret);
+
+	size_t bodylen = strnlen(_logbody, _log.MaxLength() - _log.Length() - 130);
+	_log.Write(_logbody, bodylen);
+
+	char nextline = '\n';
+	if (*((char*)_log.PosPtr() - 1) != nextline) _log.Write(&nextline, 1);
+}
+
+static XLoggerInfo make_info(TLogLevel _level, const char* _tag, const char* _file, const char* _func, int _line)
+{
+	XLoggerInfo info;
+	memset(&info, 0, sizeof(info));
+	info.level = _level;
+	info.tag = _tag;
+	info.filename = _file;
+	info.func_name = _func;
+	info.line = _line;
+	gettimeofday(&info.timeval, NULL);
+	info.pid = 1234;
+	info.tid = 5678;
+	info.maintid = 1234;
+	return info;
+}
+
+}
+
+TEST(LogFormater_test, same_as_snprintf)
+{
+	char func_tmp[64] = {0};
+	strncpy(func_tmp, "void LongLink::__RunReadWrite(int)", sizeof(func_tmp) - 1);
+
+	XLoggerInfo infos[] = {
+		make_info(kLevelInfo, "mars::stn", "/path/to/stn/src/longlink.cc", "__RunReadWrite", 100),
+		make_info(kLevelError, NULL, "longlink.cc", "LongLink::Send", 0),
+		make_info(kLevelDebug, "", NULL, NULL, -1),
+		make_info(kLevelVerbose, "mars::comm", "C:\\windows\\path\\file.cpp", func_tmp, 2147483647),
+	};
+	infos[1].tid = infos[1].maintid;
+	infos[2].timeval.tv_sec = 0;
+	infos[3].timeval.tv_usec = 7000;
+
+	for (size_t round = 0; round < 3; ++round)
+	{
+		for (size_t i = 0; i < sizeof(infos) / sizeof(infos[0]); ++i)
+		{
+			char expect[16 * 1024] = {0};
+			PtrBuffer expect_buff(expect, 0, sizeof(expect));
+			snprintf_formater(&infos[i], "hello world", expect_buff);
+
+			char result[16 * 1024] = {0};
+			PtrBuffer result_buff(result, 0, sizeof(result));
+			log_formater(&infos[i], "hello world", result_buff);
+
+			EXPECT_STREQ(expect, result);
+		}
+
+		// jni passes temporary strings, the same address may hold another function name.
+		strncpy(func_tmp, "void LongLink::Send(int)", sizeof(func_tmp) - 1);
+	}
+}
+
+TEST(LogFormater_test, benchmark)
+{
+	static const int kCount = 200000;
+	XLoggerInfo info = make_info(kLevelInfo, "mars::stn", "/path/to/stn/src/longlink.cc", "__RunReadWrite", 100);
+	const char* body = "task:1234, cmdid:10, seq:4567, send len:1024, cost:35ms";
+
+	uint64_t begin = gettickcount();
+	for (int i = 0; i < kCount; ++i)
+	{
+		char temp[16 * 1024];
+		PtrBuffer log(temp, 0, sizeof(temp));
+		snprintf_formater(&info, body, log);
+	}
+	uint64_t snprintf_cost = gettickcount() - begin;
+
+	begin = gettickcount();
+	for (int i = 0; i < kCount; ++i)
+	{
+		char temp[16 * 1024];
+		PtrBuffer log(temp, 0, sizeof(temp));
+		log_formater(&info, body, log);
+	}
+	uint64_t cached_cost = gettickcount() - begin;
+
+	printf("log_formater %d records, snprintf:%" PRIu64 "ms, cached:%" PRIu64 "ms\n", kCount, snprintf_cost, cached_cost);
+}
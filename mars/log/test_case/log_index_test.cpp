@@ -0,0 +1,207 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * log_index_test.cpp
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "boost/filesystem.hpp"
+
+#include "mars/comm/time_utils.h"
+#include "mars/log/crypt/log_crypt.h"
+#include "mars/log/src/log_index.h"
+
+namespace
+{
+
+static std::string make_block(int _begin_hour, int _end_hour, size_t _len)
+{
+	LogCrypt crypt;
+	std::string block(crypt.GetHeaderLen() + _len + crypt.GetTailerLen(), 'x');
+	crypt.SetHeaderInfo(&block[0], true);
+	// |magic start(char)|seq(uint16_t)|begin hour(char)|end hour(char)|
+	block[3] = (char)_begin_hour;
+	block[4] = (char)_end_hour;
+	crypt.UpdateLogLen(&block[0], (uint32_t)_len);
+	crypt.SetTailerInfo(&block[crypt.GetHeaderLen() + _len]);
+	return block;
+}
+
+// writes the blocks to the log file and the index, a few blocks at a time like the appender does.
+static void write_log(const std::string& _path, const std::vector<std::string>& _blocks, bool _with_index)
+{
+	FILE* file = fopen(_path.c_str(), "ab");
+	ASSERT_TRUE(NULL != file);
+	fseek(file, 0, SEEK_END);
+	long offset = ftell(file);
+
+	LogIndex index;
+	if (_with_index) ASSERT_TRUE(index.Open(_path, offset));
+
+	for (size_t i = 0; i < _blocks.size(); i += 3)
+	{
+		struct iovec iov[3];
+		int iovcnt = 0;
+		for (size_t j = i; j < _blocks.size() && j < i + 3; ++j, ++iovcnt)
+		{
+			iov[iovcnt].iov_base = (void*)_blocks[j].data();
+			iov[iovcnt].iov_len = _blocks[j].size();
+			fwrite(_blocks[j].data(), 1, _blocks[j].size(), file);
+		}
+
+		index.Append(offset, iov, iovcnt);
+		offset = ftell(file);
+	}
+
+	fclose(file);
+}
+
+static std::vector<std::string> make_day(size_t _len)
+{
+	std::vector<std::string> blocks;
+	blocks.push_back(make_block(23, 0, _len));          // crossed midnight
+	for (int hour = 0; hour < 24; ++hour)
+	{
+		if (3 <= hour && hour < 6) continue;            // no logs in these hours
+		for (int i = 0; i < 5; ++i) blocks.push_back(make_block(hour, hour, _len));
+		if (hour % 4 == 1) blocks.push_back(make_block(hour, hour + 2, _len));
+	}
+	return blocks;
+}
+
+static std::string test_file(const char* _name)
+{
+	static std::string s_root = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+	boost::filesystem::create_directories(s_root);
+	return s_root + "/" + _name;
+}
+
+static void expect_same_as_scan(const std::string& _path)
+{
+	LogCrypt crypt;
+	for (int begin_hour = 0; begin_hour < 24; ++begin_hour)
+	{
+		for (int end_hour = begin_hour + 1; end_hour <= 24; ++end_hour)
+		{
+			unsigned long scan_begin = 0, scan_end = 0;
+			std::string err_msg;
+			bool scan_ret = crypt.GetPeriodLogs(_path.c_str(), begin_hour, end_hour, scan_begin, scan_end, err_msg);
+
+			unsigned long index_begin = 0, index_end = 0;
+			ASSERT_TRUE(LogIndex::GetPeriodLogs(_path.c_str(), begin_hour, end_hour, index_begin, index_end));
+
+			EXPECT_EQ(scan_ret, index_end > index_begin) << begin_hour << "-" << end_hour;
+			if (scan_ret)
+			{
+				EXPECT_EQ(scan_begin, index_begin) << begin_hour << "-" << end_hour;
+				EXPECT_EQ(scan_end, index_end) << begin_hour << "-" << end_hour;
+			}
+		}
+	}
+}
+
+}
+
+TEST(LogIndex_test, same_as_scan)
+{
+	std::string path = test_file("same_as_scan.xlog");
+	write_log(path, make_day(100), true);
+
+	std::vector<LogIndex::Entry> entries;
+	ASSERT_TRUE(LogIndex::Load(path, boost::filesystem::file_size(path), entries));
+	EXPECT_GT(make_day(100).size(), entries.size() * 2);    // blocks within one hour are merged
+
+	expect_same_as_scan(path);
+}
+
+TEST(LogIndex_test, untrusted_index)
+{
+	std::string path = test_file("untrusted.xlog");
+	unsigned long begin_pos = 0, end_pos = 0;
+
+	// written by an old version, no index at all
+	write_log(path, make_day(100), false);
+	EXPECT_FALSE(LogIndex::GetPeriodLogs(path.c_str(), 0, 24, begin_pos, end_pos));
+
+	// indexed from now on, the head is still unknown
+	write_log(path, make_day(100), true);
+	EXPECT_FALSE(LogIndex::GetPeriodLogs(path.c_str(), 0, 24, begin_pos, end_pos));
+
+	// the log file is removed, the index left behind must not be used for the new one
+	boost::filesystem::remove(path);
+	write_log(path, make_day(100), true);
+	expect_same_as_scan(path);
+
+	// appended by someone else
+	FILE* file = fopen(path.c_str(), "ab");
+	fwrite("garbage", 1, 7, file);
+	fclose(file);
+	EXPECT_FALSE(LogIndex::GetPeriodLogs(path.c_str(), 0, 24, begin_pos, end_pos));
+}
+
+TEST(LogIndex_test, append_file)
+{
+	std::string src = test_file("append_src.xlog");
+	std::string dst = test_file("append_dst.xlog");
+	write_log(src, make_day(100), true);
+	write_log(dst, make_day(50), true);
+
+	uint64_t dst_size = boost::filesystem::file_size(dst);
+	uint64_t src_size = boost::filesystem::file_size(src);
+	boost::filesystem::resize_file(dst, dst_size + src_size);
+	FILE* src_file = fopen(src.c_str(), "rb");
+	FILE* dst_file = fopen(dst.c_str(), "rb+");
+	fseek(dst_file, dst_size, SEEK_SET);
+	char buffer[4096];
+	size_t len = 0;
+	while (0 < (len = fread(buffer, 1, sizeof(buffer), src_file))) fwrite(buffer, 1, len, dst_file);
+	fclose(src_file);
+	fclose(dst_file);
+
+	LogIndex::AppendFile(src, dst, dst_size, src_size);
+	EXPECT_FALSE(boost::filesystem::exists(LogIndex::IndexPath(src)));
+	expect_same_as_scan(dst);
+}
+
+TEST(LogIndex_test, benchmark)
+{
+	std::string path = test_file("benchmark.xlog");
+	for (int i = 0; i < 8; ++i) write_log(path, make_day(64 * 1024), true);
+
+	LogCrypt crypt;
+	unsigned long begin_pos = 0, end_pos = 0;
+	std::string err_msg;
+
+	uint64_t begin = gettickcount();
+	for (int hour = 0; hour < 24; ++hour) crypt.GetPeriodLogs(path.c_str(), hour, hour + 1, begin_pos, end_pos, err_msg);
+	uint64_t scan_cost = gettickcount() - begin;
+
+	begin = gettickcount();
+	for (int hour = 0; hour < 24; ++hour) LogIndex::GetPeriodLogs(path.c_str(), hour, hour + 1, begin_pos, end_pos);
+	uint64_t index_cost = gettickcount() - begin;
+
+	printf("24 period queries on %" PRIu64 " bytes, scan:%" PRIu64 "ms, index:%" PRIu64 "ms\n",
+		   (uint64_t)boost::filesystem::file_size(path), scan_cost, index_cost);
+
+	boost::filesystem::remove(path);
+	boost::filesystem::remove(LogIndex::IndexPath(path));
+}
@@ -115,4 +115,12 @@ const static unsigned int kLonglinkConnMax = 3;
 const static unsigned int kShortlinkConnTimeout = 10 * 1000;
 const static unsigned int kShortlinkConnInterval = 4 * 1000;
 
+//shortlink read-write params of the event loop, a send or a recv making no progress that long ends the link
+const static unsigned int kShortlinkSendTimeout = 30 * 1000;
+const static unsigned int kShortlinkRecvTimeout = 60 * 1000;
+
+//shortlink keep-alive params
+const static unsigned int kShortlinkKeepAliveTimeout = 20 * 1000;
+const static unsigned int kShortlinkKeepAliveMax = 4;    // idle connections for each host:port
+
 #endif /* stn_config_h */
@@ -22,10 +22,12 @@
 #define STN_SRC_LONGLINK_PACKER_H_
 
 #include <stdlib.h>
+#include <vector>
 
 #define LONGLINK_UNPACK_CONTINUE (-2)
 #define LONGLINK_UNPACK_FALSE (-1)
 #define LONGLINK_UNPACK_OK (0)
+#define LONGLINK_UNPACK_NO_BATCH (-3)
 
 #ifndef __cplusplus
 #error "support cpp only"
@@ -33,8 +35,25 @@
 
 class AutoBuffer;
 
+struct LongLinkPackInfo {
+    uint32_t cmdid;
+    uint32_t seq;
+    size_t offset;          // of the pack in the buffer unpacked
+    size_t package_len;     // 0 if the header of a pending pack isn't complete yet
+    size_t body_offset;
+    size_t body_len;
+};
+
 void longlink_pack(uint32_t _cmdid, uint32_t _seq, const void* _raw, size_t _raw_len, AutoBuffer& _packed);
+// the header of a pack whose body is sent as is right after it, so the body needn't be copied into the pack.
+// false if the body has to go through the packer, longlink_pack is used then. optional, false if the packer doesn't have it.
+bool longlink_pack_header(uint32_t _cmdid, uint32_t _seq, size_t _raw_len, AutoBuffer& _header);
 int  longlink_unpack(const AutoBuffer& _packed, uint32_t& _cmdid, uint32_t& _seq, size_t& _package_len, AutoBuffer& _body);
+// all the complete packs in _packed at once, in order, the bodies are left where they are.
+// returns what follows them as longlink_unpack does: LONGLINK_UNPACK_OK if nothing,
+// LONGLINK_UNPACK_CONTINUE with _pending the incomplete pack, LONGLINK_UNPACK_FALSE with _pending the broken one.
+// optional, LONGLINK_UNPACK_NO_BATCH if the packer doesn't have it, longlink_unpack is used then.
+int  longlink_unpack_batch(const void* _packed, size_t _packed_len, std::vector<LongLinkPackInfo>& _packs, LongLinkPackInfo& _pending);
 
 //heartbeat signal to keep longlink network alive
 uint32_t longlink_noop_cmdid();
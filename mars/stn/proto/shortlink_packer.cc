@@ -28,6 +28,11 @@ void shortlink_pack(const std::string& _url, const std::map<std::string, std::st
 	req_builder.Request().Method(RequestLine::kPost);
 	req_builder.Request().Version(kVersion_1_1);
 
+	// the ones of the caller first, a field set already is kept, e.g. Connection.
+	for (std::map<std::string, std::string>::const_iterator iter = _headers.begin(); iter != _headers.end(); ++iter) {
+		req_builder.Fields().HeaderFiled(iter->first.c_str(), iter->second.c_str());
+	}
+
 	req_builder.Fields().HeaderFiled(HeaderFields::MakeAcceptAll());
 	req_builder.Fields().HeaderFiled(HeaderFields::KStringUserAgent, HeaderFields::KStringMicroMessenger);
 	req_builder.Fields().HeaderFiled(HeaderFields::MakeCacheControlNoCache());
@@ -38,10 +43,6 @@ void shortlink_pack(const std::string& _url, const std::map<std::string, std::st
 	snprintf(len_str, sizeof(len_str), "%u", (unsigned int)_body.Length());
 	req_builder.Fields().HeaderFiled(HeaderFields::KStringContentLength, len_str);
 
-	for (std::map<std::string, std::string>::const_iterator iter = _headers.begin(); iter != _headers.end(); ++iter) {
-		req_builder.Fields().HeaderFiled(iter->first.c_str(), iter->second.c_str());
-	}
-
 	req_builder.Request().Url(_url);
 	req_builder.HeaderToBuffer(_out_buff);
 	_out_buff.Write(_body.Ptr(), _body.Length());
@@ -20,7 +20,13 @@
 
 #include "longlink.h"
 
+#include <limits.h>
 #include <algorithm>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
 
 #include "boost/bind.hpp"
 
@@ -46,6 +52,10 @@
 #include "proto/longlink_packer.h"
 #include "smart_heartbeat.h"
 
+#if !defined(WIN32) && !defined(IOV_MAX)
+#define IOV_MAX (16)
+#endif
+
 #define AYNC_HANDLER  asyncreg_.Get()
 #define STATIC_RETURN_SYNC2ASYNC_FUNC(func) RETURN_SYNC2ASYNC_FUNC(func, )
 
@@ -53,6 +63,27 @@ using namespace mars::stn;
 using namespace mars::app;
 
 namespace {
+#ifndef WIN32
+// the unsent part of _data, one iovec for what's left of the header and one for the body.
+static void __AppendUnsent(LongLinkSendData& _data, std::vector<iovec>& _vec) {
+    size_t pos = _data.pos;
+    AutoBuffer* bufs[] = {&_data.header, &_data.body};
+    
+    for (size_t i = 0; i < sizeof(bufs) / sizeof(bufs[0]); ++i) {
+        if (pos >= bufs[i]->Length()) {
+            pos -= bufs[i]->Length();
+            continue;
+        }
+        
+        iovec vec;
+        vec.iov_base = bufs[i]->Ptr(pos);
+        vec.iov_len = bufs[i]->Length() - pos;
+        _vec.push_back(vec);
+        pos = 0;
+    }
+}
+#endif
+
 class LongLinkConnectObserver : public MComplexConnect {
   public:
     LongLinkConnectObserver(LongLink& _longlink, const std::vector<IPPortItem>& _iplist): longlink_(_longlink), ip_items_(_iplist) {
@@ -147,7 +178,17 @@ bool LongLink::Send(const unsigned char* _pbuf, size_t _len, uint32_t _cmdid, ui
 
     if (kConnected != connectstatus_) return false;
 
-    return __Send(_pbuf, _len, _cmdid, _taskid, _task_info);
+    AutoBuffer body;
+    body.Write(_pbuf, _len);
+    return __Send(body, _cmdid, _taskid, _task_info);
+}
+
+bool LongLink::Send(AutoBuffer& _body, uint32_t _cmdid, uint32_t _taskid, const std::string& _task_info) {
+    ScopedLock lock(mutex_);
+
+    if (kConnected != connectstatus_) return false;
+
+    return __Send(_body, _cmdid, _taskid, _task_info);
 }
 
 bool LongLink::SendWhenNoData(const unsigned char* _pbuf, size_t _len, uint32_t _cmdid, uint32_t _taskid) {
@@ -156,14 +197,16 @@ bool LongLink::SendWhenNoData(const unsigned char* _pbuf, size_t _len, uint32_t
     if (kConnected != connectstatus_) return false;
     if (!lstsenddata_.empty()) return false;
 
-    return __Send(_pbuf, _len, _cmdid, _taskid, "");
+    AutoBuffer body;
+    body.Write(_pbuf, _len);
+    return __Send(body, _cmdid, _taskid, "");
 }
 
 bool LongLink::Stop(uint32_t _taskid) {
     ScopedLock lock(mutex_);
 
     for (std::list<LongLinkSendData>::iterator it = lstsenddata_.begin(); it != lstsenddata_.end(); ++it) {
-        if (_taskid == it->taskid && 0 == it->data.Pos()) {
+        if (_taskid == it->taskid && 0 == it->pos) {
             lstsenddata_.erase(it);
             return true;
         }
@@ -172,14 +215,23 @@ bool LongLink::Stop(uint32_t _taskid) {
     return false;
 }
 
-bool LongLink::__Send(const unsigned char* _pbuf, size_t _len, uint32_t _cmdid, uint32_t _taskid, const std::string& _task_info) {
+bool LongLink::__Send(AutoBuffer& _body, uint32_t _cmdid, uint32_t _taskid, const std::string& _task_info) {
     lstsenddata_.push_back(LongLinkSendData());
 
-    lstsenddata_.back().cmdid = _cmdid;
-    lstsenddata_.back().taskid = _taskid;
-    longlink_pack(_cmdid, _taskid, _pbuf, _len, lstsenddata_.back().data);
-    lstsenddata_.back().data.Seek(0, AutoBuffer::ESeekStart);
-    lstsenddata_.back().task_info = _task_info;
+    LongLinkSendData& senddata = lstsenddata_.back();
+    senddata.cmdid = _cmdid;
+    senddata.taskid = _taskid;
+    
+    if (longlink_pack_header(_cmdid, _taskid, _body.Length(), senddata.header)) {
+        senddata.body.Attach(_body);
+    } else {
+        senddata.header.Reset();
+        longlink_pack(_cmdid, _taskid, _body.Ptr(), _body.Length(), senddata.header);
+        _body.Reset();
+    }
+    
+    senddata.header.Seek(0, AutoBuffer::ESeekStart);
+    senddata.task_info = _task_info;
 
     readwritebreak_.Break();
     return true;
@@ -425,6 +477,7 @@ SOCKET LongLink::__RunConnect(ConnectProfile& _conn_profile) {
     
     LongLinkConnectObserver connect_observer(*this, ip_items);
     ComplexConnect com_connect(kLonglinkConnTimeout, kLonglinkConnInteral, kLonglinkConnInteral, kLonglinkConnMax);
+    com_connect.Racing(true);
     SOCKET sock = com_connect.ConnectImpatient(vecaddr, connectbreak_, &connect_observer);
     
     _conn_profile.conn_time = gettickcount();
@@ -491,6 +544,13 @@ void LongLink::__RunReadWrite(SOCKET _sock, ErrCmdType& _errtype, int& _errcode,
     bool is_noop = false;
     xgroup2_define(close_log);
     
+    // kept across rounds, _sock stays registered.
+    SocketSelect sel(readwritebreak_, true);
+    std::vector<LongLinkPackInfo> packs;
+#ifndef WIN32
+    std::vector<iovec> vecwrite;
+#endif
+    
     while (true) {
         if (!alarmnoopinterval.IsWaiting()) {
             if (first_noop_sent && alarmnoopinterval.Status() != Alarm::kOnAlarm) {
@@ -522,7 +582,6 @@ void LongLink::__RunReadWrite(SOCKET _sock, ErrCmdType& _errtype, int& _errcode,
             goto End;
         }
         
-        SocketSelect sel(readwritebreak_, true);
         sel.PreSelect();
         sel.Read_FD_SET(_sock);
         sel.Exception_FD_SET(_sock);
@@ -579,21 +638,18 @@ void LongLink::__RunReadWrite(SOCKET _sock, ErrCmdType& _errtype, int& _errcode,
             xinfo2(TSF"task socket send sock:%0, ", _sock) >> xlog_group;
             
 #ifndef WIN32
-            iovec* vecwrite = (iovec*)calloc(lstsenddata_.size(), sizeof(iovec));
-            unsigned int offset = 0;
+            vecwrite.clear();
             
-            for (std::list<LongLinkSendData>::iterator it = lstsenddata_.begin(); it != lstsenddata_.end(); ++it) {
-                vecwrite[offset].iov_base = it->data.PosPtr();
-                vecwrite[offset].iov_len = it->data.PosLength();
-                
-                ++offset;
+            for (std::list<LongLinkSendData>::iterator it = lstsenddata_.begin(); it != lstsenddata_.end() && vecwrite.size() + 2 <= IOV_MAX; ++it) {
+                __AppendUnsent(*it, vecwrite);
             }
             
-            ssize_t writelen = writev(_sock, vecwrite, (int)lstsenddata_.size());
-            
-            free(vecwrite);
+            ssize_t writelen = writev(_sock, &vecwrite[0], (int)vecwrite.size());
 #else
-            ssize_t writelen = ::send(_sock, lstsenddata_.begin()->data.PosPtr(), lstsenddata_.begin()->data.PosLength(), 0);
+            const LongLinkSendData& first = lstsenddata_.front();
+            const AutoBuffer& firstbuf = first.pos < first.header.Length() ? first.header : first.body;
+            size_t firstpos = first.pos < first.header.Length() ? first.pos : first.pos - first.header.Length();
+            ssize_t writelen = ::send(_sock, (const char*)firstbuf.Ptr(firstpos), firstbuf.Length() - firstpos, 0);
 #endif
             
             if (0 == writelen || (0 > writelen && !IS_NOBLOCK_SEND_ERRNO(socket_errno))) {
@@ -619,19 +675,19 @@ void LongLink::__RunReadWrite(SOCKET _sock, ErrCmdType& _errtype, int& _errcode,
             std::list<LongLinkSendData>::iterator it = lstsenddata_.begin();
             
             while (it != lstsenddata_.end() && 0 < writelen) {
-                if (0 == it->data.Pos()) OnSend(it->taskid);
+                if (0 == it->pos) OnSend(it->taskid);
                 
-                if ((size_t)writelen >= it->data.PosLength()) {
-                    xinfo2(TSF"sub send taskid:%_, cmdid:%_, %_, len(S:%_, %_/%_), ", it->taskid, it->cmdid, it->task_info, it->data.PosLength(), it->data.PosLength(), it->data.Length()) >> xlog_group;
-                    writelen -= it->data.PosLength();
+                if ((size_t)writelen >= it->PosLength()) {
+                    xinfo2(TSF"sub send taskid:%_, cmdid:%_, %_, len(S:%_, %_/%_), ", it->taskid, it->cmdid, it->task_info, it->PosLength(), it->PosLength(), it->Length()) >> xlog_group;
+                    writelen -= it->PosLength();
                     if (!it->task_info.empty()) sent_taskids[it->taskid] = it->task_info;
-                    LongLinkNWriteData nwrite(it->taskid, it->data.PosLength(), it->cmdid, it->task_info);
+                    LongLinkNWriteData nwrite(it->taskid, it->PosLength(), it->cmdid, it->task_info);
                     nsent_datas.push_back(nwrite);
                     
                     it = lstsenddata_.erase(it);
                 } else {
-                    xinfo2(TSF"sub send taskid:%_, cmdid:%_, %_, len(S:%_, %_/%_), ", it->taskid, it->cmdid, it->task_info, writelen, it->data.PosLength(), it->data.Length()) >> xlog_group;
-                    it->data.Seek(writelen, AutoBuffer::ESeekCur);
+                    xinfo2(TSF"sub send taskid:%_, cmdid:%_, %_, len(S:%_, %_/%_), ", it->taskid, it->cmdid, it->task_info, writelen, it->PosLength(), it->Length()) >> xlog_group;
+                    it->pos += writelen;
                     writelen = 0;
                 }
             }
@@ -664,41 +720,85 @@ void LongLink::__RunReadWrite(SOCKET _sock, ErrCmdType& _errtype, int& _errcode,
             bufrecv.Length(bufrecv.Pos() + recvlen, bufrecv.Length() + recvlen);
             xinfo2(TSF"task socket recv sock:%_, recv len:%_, buff len:%_", _sock, recvlen, bufrecv.Length());
             
-            while (0 < bufrecv.Length()) {
+            // packs are unpacked where they are, what's left is moved to the front once after all of them.
+            LongLinkPackInfo pending;
+            int unpackret = longlink_unpack_batch(bufrecv.Ptr(), bufrecv.Length(), packs, pending);
+            size_t unpacked = 0;
+            
+            // the packer can't unpack in batch, one pack at a time then, its bodies may not be where they were received.
+            while (LONGLINK_UNPACK_NO_BATCH == unpackret && 0 < bufrecv.Length()) {
                 uint32_t cmdid = 0;
                 uint32_t taskid = Task::kInvalidTaskID;
                 size_t packlen = 0;
                 AutoBuffer body;
                 
-                int unpackret = longlink_unpack(bufrecv, cmdid, taskid, packlen, body);
+                int ret = longlink_unpack(bufrecv, cmdid, taskid, packlen, body);
                 
-                if (LONGLINK_UNPACK_FALSE == unpackret) {
+                if (LONGLINK_UNPACK_FALSE == ret) {
                     xerror2(TSF"task socket recv sock:%0, unpack error dump:%1", _sock, xdump(bufrecv.Ptr(), bufrecv.Length()));
                     _errtype = kEctNetMsgXP;
                     _errcode = kEctNetMsgXPHandleBufferErr;
                     goto End;
                 }
                 
-                xinfo2(TSF"task socket recv sock:%_, pack recv %_ taskid:%_, cmdid:%_, %_, packlen:(%_/%_)", _sock, LONGLINK_UNPACK_CONTINUE == unpackret ? "continue" : "finish", taskid, cmdid, sent_taskids[taskid], LONGLINK_UNPACK_CONTINUE == unpackret ? bufrecv.Length() : packlen, packlen);
+                xinfo2(TSF"task socket recv sock:%_, pack recv %_ taskid:%_, cmdid:%_, %_, packlen:(%_/%_)", _sock, LONGLINK_UNPACK_CONTINUE == ret ? "continue" : "finish", taskid, cmdid, sent_taskids[taskid], LONGLINK_UNPACK_CONTINUE == ret ? bufrecv.Length() : packlen, packlen);
                 lastrecvtime_.gettickcount();
                 
-                if (LONGLINK_UNPACK_CONTINUE == unpackret) {
+                if (LONGLINK_UNPACK_CONTINUE == ret) {
                     OnRecv(taskid, bufrecv.Length(), packlen);
                     break;
+                }
+                
+                sent_taskids.erase(taskid);
+                
+                bufrecv.Move(-(off_t)packlen);
+                
+                if (__NoopResp(cmdid, taskid, body, alarmnooptimeout, _profile)) {
+                    xdebug2(TSF"noopresp span:%0", alarmnooptimeout.ElapseTime());
+                    is_noop = false;
                 } else {
-                    
-                    sent_taskids.erase(taskid);
-                    
-                    bufrecv.Move(-(int)(packlen));
-                    
-                    if (__NoopResp(cmdid, taskid, body, alarmnooptimeout, _profile)) {
-                        xdebug2(TSF"noopresp span:%0", alarmnooptimeout.ElapseTime());
-                        is_noop = false;
-                    } else {
-                        OnResponse(kEctOK, 0, cmdid, taskid, body, _profile);
-                    }
+                    OnResponse(kEctOK, 0, cmdid, taskid, body, _profile);
+                }
+            }
+            
+            if (LONGLINK_UNPACK_NO_BATCH == unpackret) continue;
+            
+            for (std::vector<LongLinkPackInfo>::const_iterator pack = packs.begin(); pack != packs.end(); ++pack) {
+                uint32_t cmdid = pack->cmdid;
+                uint32_t taskid = pack->seq;
+                AutoBuffer body;
+                body.Write(bufrecv.Ptr(pack->body_offset), pack->body_len);
+                body.Seek(0, AutoBuffer::ESeekStart);
+                
+                xinfo2(TSF"task socket recv sock:%_, pack recv finish taskid:%_, cmdid:%_, %_, packlen:(%_/%_)", _sock, taskid, cmdid, sent_taskids[taskid], pack->package_len, pack->package_len);
+                lastrecvtime_.gettickcount();
+                
+                sent_taskids.erase(taskid);
+                
+                unpacked = pack->offset + pack->package_len;
+                
+                if (__NoopResp(cmdid, taskid, body, alarmnooptimeout, _profile)) {
+                    xdebug2(TSF"noopresp span:%0", alarmnooptimeout.ElapseTime());
+                    is_noop = false;
+                } else {
+                    OnResponse(kEctOK, 0, cmdid, taskid, body, _profile);
                 }
             }
+            
+            if (LONGLINK_UNPACK_FALSE == unpackret) {
+                xerror2(TSF"task socket recv sock:%0, unpack error dump:%1", _sock, xdump(bufrecv.Ptr(pending.offset), bufrecv.Length() - pending.offset));
+                _errtype = kEctNetMsgXP;
+                _errcode = kEctNetMsgXPHandleBufferErr;
+                goto End;
+            }
+            
+            if (LONGLINK_UNPACK_CONTINUE == unpackret) {
+                xinfo2(TSF"task socket recv sock:%_, pack recv continue taskid:%_, cmdid:%_, %_, packlen:(%_/%_)", _sock, pending.seq, pending.cmdid, sent_taskids[pending.seq], bufrecv.Length() - pending.offset, pending.package_len);
+                lastrecvtime_.gettickcount();
+                OnRecv(pending.seq, bufrecv.Length() - pending.offset, pending.package_len);
+            }
+            
+            if (0 < unpacked) bufrecv.Move(-(off_t)unpacked);
         }
     }
     
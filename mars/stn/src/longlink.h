@@ -55,13 +55,21 @@ namespace mars {
     namespace stn {
 
 struct LongLinkSendData {
-    LongLinkSendData(): cmdid(0), taskid(mars::stn::Task::kInvalidTaskID)  {}
+    LongLinkSendData(): pos(0), cmdid(0), taskid(mars::stn::Task::kInvalidTaskID)  {}
     LongLinkSendData(const LongLinkSendData& _rhs) {
-        data.Reset();
+        header.Reset();
+        body.Reset();
+        pos = 0;
         taskid = mars::stn::Task::kInvalidTaskID;
         cmdid = 0;
     }
-    AutoBuffer data;
+    
+    size_t Length() const { return header.Length() + body.Length(); }
+    size_t PosLength() const { return Length() - pos; }
+    
+    AutoBuffer header;      // the whole pack if the packer has to see the body
+    AutoBuffer body;        // sent right after the header as is
+    size_t pos;             // sent
     uint32_t cmdid;
     uint32_t taskid;
     std::string task_info;
@@ -130,6 +138,8 @@ class LongLink {
     virtual ~LongLink();
 
     bool    Send(const unsigned char* _pbuf, size_t _len, uint32_t _cmdid, uint32_t _taskid, const std::string& _task_info = "");
+    // takes _body over, it's empty after.
+    bool    Send(AutoBuffer& _body, uint32_t _cmdid, uint32_t _taskid, const std::string& _task_info = "");
     bool    SendWhenNoData(const unsigned char* _pbuf, size_t _len, uint32_t _cmdid, uint32_t _taskid);
     bool    Stop(uint32_t _taskid);
 
@@ -145,7 +155,7 @@ class LongLink {
     LongLink& operator=(const LongLink&);
 
   protected:
-    bool    __Send(const unsigned char* _pbuf, size_t _len, uint32_t _cmdid, uint32_t _taskid, const std::string& _task_message);
+    bool    __Send(AutoBuffer& _body, uint32_t _cmdid, uint32_t _taskid, const std::string& _task_message);
     void    __ConnectStatus(TLongLinkStatus _status);
     void    __UpdateProfile(const ConnectProfile& _conn_profile);
     void    __RunResponseError(ErrCmdType _type, int _errcode, ConnectProfile& _profile, bool _networkreport = true);
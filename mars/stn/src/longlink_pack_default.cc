@@ -0,0 +1,28 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * longlink_pack_default.cc
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include "mars/comm/autobuffer.h"
+#include "mars/comm/compiler_util.h"
+
+#include "proto/longlink_packer.h"
+
+// packers written before longlink_pack_header don't have it, longlink_pack packs the whole body then.
+WEAK_FUNC bool longlink_pack_header(uint32_t _cmdid, uint32_t _seq, size_t _raw_len, AutoBuffer& _header) {
+    return false;
+}
@@ -21,6 +21,7 @@
 #include "longlink_task_manager.h"
 
 #include <algorithm>
+#include <set>
 
 #include "boost/bind.hpp"
 
@@ -83,8 +84,18 @@ bool LongLinkTaskManager::StartTask(const Task& _task) {
     TaskProfile task(_task);
     task.link_type = Task::kChannelLong;
 
-    lst_cmd_.push_back(task);
-    lst_cmd_.sort(__CompareTask);
+    // after the ones of the same priority, as a stable sort would put it
+    std::list<TaskProfile>::iterator pos = lst_cmd_.end();
+    while (pos != lst_cmd_.begin()) {
+        std::list<TaskProfile>::iterator prev = pos;
+        --prev;
+        if (!__CompareTask(task, *prev)) break;
+        pos = prev;
+    }
+
+    pos = lst_cmd_.insert(pos, task);
+    taskid_index_.insert(std::make_pair(pos->task.taskid, pos));
+    __ScheduleTimeout(*pos);
 
     __RunLoop();
     return true;
@@ -93,38 +104,20 @@ bool LongLinkTaskManager::StartTask(const Task& _task) {
 bool LongLinkTaskManager::StopTask(uint32_t _taskid) {
     xverbose_function();
 
-    std::list<TaskProfile>::iterator first = lst_cmd_.begin();
-    std::list<TaskProfile>::iterator last = lst_cmd_.end();
-
-    while (first != last) {
-        if (_taskid == first->task.taskid) {
-            xinfo2(TSF"find the task taskid:%0", _taskid);
+    std::list<TaskProfile>::iterator it = __Locate(_taskid);
+    if (lst_cmd_.end() == it) return false;
 
-            longlink_->Stop(first->task.taskid);
-            lst_cmd_.erase(first);
-            return true;
-        }
+    xinfo2(TSF"find the task taskid:%0", _taskid);
 
-        ++first;
-    }
-
-    return false;
+    longlink_->Stop(it->task.taskid);
+    __Erase(it);
+    return true;
 }
 
 bool LongLinkTaskManager::HasTask(uint32_t _taskid) const {
     xverbose_function();
 
-    std::list<TaskProfile>::const_iterator first = lst_cmd_.begin();
-    std::list<TaskProfile>::const_iterator last = lst_cmd_.end();
-
-    while (first != last) {
-    	if (_taskid == first->task.taskid) {
-    		return true;
-    	}
-    	++first;
-    }
-
-    return false;
+    return taskid_index_.end() != taskid_index_.find(_taskid);
 }
 
 void LongLinkTaskManager::ClearTasks() {
@@ -132,6 +125,8 @@ void LongLinkTaskManager::ClearTasks() {
     longlink_->Disconnect(LongLink::kReset);
     MessageQueue::CancelMessage(asyncreg_.Get(), 0);
     lst_cmd_.clear();
+    taskid_index_.clear();
+    timeouts_.clear();
 }
 
 void LongLinkTaskManager::OnSessionTimeout(int _err_code, uint32_t _src_taskid) {
@@ -182,15 +177,20 @@ void LongLinkTaskManager::__RunLoop() {
     }
 
     __RunOnTimeout();
-    __RunOnStartTask();
+    bool waiting = __RunOnStartTask();
 
     if (!lst_cmd_.empty()) {
 #ifdef ANDROID
         wakeup_lock_->Lock(30 * 1000);
 #endif
+        // the next deadline, or a second later for the tasks waiting to be sent
+        int64_t after = waiting ? 1000 : 60 * 1000;
+        uint64_t cur_time = ::gettickcount();
+        if (!timeouts_.empty()) after = std::min(after, timeouts_.begin()->first > cur_time ? (int64_t)(timeouts_.begin()->first - cur_time) : 0);
+
       MessageQueue::FasterMessage(asyncreg_.Get(),
                                   MessageQueue::Message((MessageQueue::MessageTitle_t)this, boost::bind(&LongLinkTaskManager::__RunLoop, this)),
-                                  MessageQueue::MessageTiming(1000));
+                                  MessageQueue::MessageTiming(after));
     } else {
 #ifdef ANDROID
         /*cancel the last wakeuplock*/
@@ -200,16 +200,20 @@ void LongLinkTaskManager::__RunLoop() {
 }
 
 void LongLinkTaskManager::__RunOnTimeout() {
-    std::list<TaskProfile>::iterator first = lst_cmd_.begin();
-    std::list<TaskProfile>::iterator last = lst_cmd_.end();
-
     uint64_t cur_time = ::gettickcount();
     int socket_timeout_code = 0;
     bool istasktimeout = false;
 
-    while (first != last) {
-        std::list<TaskProfile>::iterator next = first;
-        ++next;
+    // only the tasks with a deadline passed, the others are rescheduled to the actual one.
+    std::set<uint32_t> due_taskids;
+    while (!timeouts_.empty() && timeouts_.begin()->first <= cur_time) {
+        due_taskids.insert(timeouts_.begin()->second);
+        timeouts_.erase(timeouts_.begin());
+    }
+
+    for (std::set<uint32_t>::iterator taskid = due_taskids.begin(); taskid != due_taskids.end(); ++taskid) {
+        std::list<TaskProfile>::iterator first = __Locate(*taskid);
+        if (lst_cmd_.end() == first) continue;
 
         if (first->running_id && 0 < first->transfer_profile.start_send_time) {
             if (0 == first->transfer_profile.last_receive_pkg_time && cur_time - first->transfer_profile.start_send_time >= first->transfer_profile.first_pkg_timeout) {
@@ -236,9 +240,10 @@ void LongLinkTaskManager::__RunOnTimeout() {
         if (cur_time - first->start_task_time >= first->task_timeout) {
             __SingleRespHandle(first, kEctLocal, kEctLocalTaskTimeout, kTaskFailHandleTaskTimeout, longlink_->Profile());
             istasktimeout = true;
+            continue;
         }
 
-        first = next;
+        __ScheduleTimeout(*first);
     }
 
     if (0 != socket_timeout_code) {
@@ -253,7 +258,30 @@ void LongLinkTaskManager::__RunOnTimeout() {
     }
 }
 
-void LongLinkTaskManager::__RunOnStartTask() {
+void LongLinkTaskManager::__ScheduleTimeout(const TaskProfile& _task) {
+    uint64_t deadline = _task.start_task_time + _task.task_timeout;
+
+    if (_task.running_id && 0 < _task.transfer_profile.start_send_time) {
+        const TransferProfile& profile = _task.transfer_profile;
+        deadline = std::min(deadline, profile.start_send_time + profile.read_write_timeout);
+
+        if (0 == profile.last_receive_pkg_time)
+            deadline = std::min(deadline, profile.start_send_time + profile.first_pkg_timeout);
+        else  // the shorter one, the net may change before then
+            deadline = std::min(deadline, profile.last_receive_pkg_time + std::min(kWifiPackageInterval, kGPRSPackageInterval));
+    }
+
+    bool earliest = timeouts_.empty() || deadline < timeouts_.begin()->first;
+    timeouts_.insert(std::make_pair(deadline, _task.task.taskid));
+    if (!earliest) return;
+
+    uint64_t cur_time = ::gettickcount();
+    MessageQueue::FasterMessage(asyncreg_.Get(),
+                                MessageQueue::Message((MessageQueue::MessageTitle_t)this, boost::bind(&LongLinkTaskManager::__RunLoop, this)),
+                                MessageQueue::MessageTiming(deadline > cur_time ? deadline - cur_time : 0));
+}
+
+bool LongLinkTaskManager::__RunOnStartTask() {
     std::list<TaskProfile>::iterator first = lst_cmd_.begin();
     std::list<TaskProfile>::iterator last = lst_cmd_.end();
 
@@ -263,6 +291,7 @@ void LongLinkTaskManager::__RunOnStartTask() {
 
     bool canretry = curtime - lastbatcherrortime_ >= retry_interval_;
     bool canprint = true;
+    bool waiting = false;
     int sent_count = 0;
 
     while (first != last) {
@@ -281,6 +310,7 @@ void LongLinkTaskManager::__RunOnStartTask() {
                        retry_interval_, curtime, lastbatcherrortime_, curtime - lastbatcherrortime_);
             
             canprint = false;
+            waiting = true;
             first = next;
             continue;
         }
@@ -294,6 +324,7 @@ void LongLinkTaskManager::__RunOnStartTask() {
 
             if (!ismakesureauthsuccess) {
                 xinfo2_if(curtime % 3 == 0, TSF"makeSureAuth retsult=%0", ismakesureauthsuccess);
+                waiting = true;
                 first = next;
                 continue;
             }
@@ -320,6 +351,7 @@ void LongLinkTaskManager::__RunOnStartTask() {
         }
 
 		if (!longlinkconnectmon_->MakeSureConnected()) {
+            waiting = true;
             break;
 		}
 
@@ -343,11 +375,12 @@ void LongLinkTaskManager::__RunOnStartTask() {
         first->current_dyntime_status = (first->task.server_process_cost <= 0) ? dynamic_timeout_.GetStatus() : kEValuating;
         first->transfer_profile.read_write_timeout = __ReadWriteTimeout(first->transfer_profile.first_pkg_timeout);
         first->transfer_profile.send_data_size = bufreq.Length();
-        first->running_id = longlink_->Send((const unsigned char*) bufreq.Ptr(), (unsigned int)bufreq.Length(), first->task.cmdid, first->task.taskid,
+        first->running_id = longlink_->Send(bufreq, first->task.cmdid, first->task.taskid,
                                       first->task.send_only ? "":first->task.cgi);
 
         if (!first->running_id) {
             xwarn2(TSF"task add into longlink readwrite fail cgi:%_, cmdid:%_, taskid:%_", first->task.cgi, first->task.cmdid, first->task.taskid);
+            waiting = true;
             first = next;
             continue;
         }
@@ -364,6 +397,8 @@ void LongLinkTaskManager::__RunOnStartTask() {
         ++sent_count;
         first = next;
     }
+
+    return waiting;
 }
 
 void LongLinkTaskManager::__Reset() {
@@ -413,7 +448,7 @@ bool LongLinkTaskManager::__SingleRespHandle(std::list<TaskProfile>::iterator _i
         _it->PushHistory();
         ReportTaskProfile(*_it);
 
-        lst_cmd_.erase(_it);
+        __Erase(_it);
         return true;
     }
 
@@ -474,22 +509,24 @@ void LongLinkTaskManager::__BatchErrorRespHandle(ErrCmdType _err_type, int _err_
     }
 }
 
-struct find_task {
-  public:
-    bool operator()(const TaskProfile& value) {return taskid == value.task.taskid;}
-
-  public:
-    uint32_t taskid;
-};
-
 std::list<TaskProfile>::iterator LongLinkTaskManager::__Locate(uint32_t _taskid) {
     if (Task::kInvalidTaskID == _taskid) return lst_cmd_.end();
 
-    find_task find_functor;
-    find_functor.taskid = _taskid;
-    std::list<TaskProfile>::iterator it = std::find_if(lst_cmd_.begin(), lst_cmd_.end(), find_functor);
+    // the first started of the same taskid
+    std::multimap<uint32_t, std::list<TaskProfile>::iterator>::iterator it = taskid_index_.lower_bound(_taskid);
+    return taskid_index_.end() == it || _taskid != it->first ? lst_cmd_.end() : it->second;
+}
+
+void LongLinkTaskManager::__Erase(std::list<TaskProfile>::iterator _it) {
+    // tasks of the same taskid are all indexed, only this one goes
+    std::pair<std::multimap<uint32_t, std::list<TaskProfile>::iterator>::iterator, std::multimap<uint32_t, std::list<TaskProfile>::iterator>::iterator> range = taskid_index_.equal_range(_it->task.taskid);
+    for (std::multimap<uint32_t, std::list<TaskProfile>::iterator>::iterator index = range.first; index != range.second; ++index) {
+        if (index->second != _it) continue;
+        taskid_index_.erase(index);
+        break;
+    }
 
-    return it;
+    lst_cmd_.erase(_it);
 }
 
 void LongLinkTaskManager::__OnResponse(ErrCmdType _error_type, int _error_code, uint32_t _cmdid, uint32_t _taskid, AutoBuffer& _body, const ConnectProfile& _connect_profile) {
@@ -514,9 +551,11 @@ void LongLinkTaskManager::__OnResponse(ErrCmdType _error_type, int _error_code,
         return;
     }
     
+    bool first_pkg = 0 == it->transfer_profile.last_receive_pkg_time;
     it->transfer_profile.received_size = body->Length();
     it->transfer_profile.receive_data_size = body->Length();
     it->transfer_profile.last_receive_pkg_time = ::gettickcount();
+    if (first_pkg) __ScheduleTimeout(*it);
     
     int err_code = 0;
     int handle_type = Buf2Resp(it->task.taskid, it->task.user_context, body, err_code, Task::kChannelLong);
@@ -573,6 +612,7 @@ void LongLinkTaskManager::__OnSend(uint32_t _taskid) {
     		it->transfer_profile.first_start_send_time = ::gettickcount();
         it->transfer_profile.start_send_time = ::gettickcount();
         xdebug2(TSF"taskid:%_, starttime:%_", it->task.taskid, it->transfer_profile.start_send_time / 1000);
+        __ScheduleTimeout(*it);
     }
 }
 
@@ -582,9 +622,12 @@ void LongLinkTaskManager::__OnRecv(uint32_t _taskid, size_t _cachedsize, size_t
     std::list<TaskProfile>::iterator it = __Locate(_taskid);
 
     if (lst_cmd_.end() != it) {
+        bool first_pkg = 0 == it->transfer_profile.last_receive_pkg_time;
         it->transfer_profile.received_size = _cachedsize;
         it->transfer_profile.receive_data_size = _totalsize;
         it->transfer_profile.last_receive_pkg_time = ::gettickcount();
+        // the later packages only put the pkg-pkg deadline off
+        if (first_pkg) __ScheduleTimeout(*it);
         xdebug2(TSF"taskid:%_, cachedsize:%_, _totalsize:%_", it->task.taskid, _cachedsize, _totalsize);
     } else {
         xwarn2(TSF"not found taskid:%_ cachedsize:%_, _totalsize:%_", _taskid, _cachedsize, _totalsize);
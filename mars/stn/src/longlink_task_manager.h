@@ -22,6 +22,7 @@
 #define STN_SRC_LONGLINK_TASK_MANAGER_H_
 
 #include <list>
+#include <map>
 #include <stdint.h>
 
 #include "boost/function.hpp"
@@ -86,17 +87,21 @@ class LongLinkTaskManager {
 
     void __RunLoop();
     void __RunOnTimeout();
-    void __RunOnStartTask();
+    bool __RunOnStartTask();
+    void __ScheduleTimeout(const TaskProfile& _task);
 
     void __Reset();
     void __BatchErrorRespHandle(ErrCmdType _err_type, int _err_code, int _fail_handle, uint32_t _src_taskid, const ConnectProfile& _connect_profile, bool _callback_runing_task_only = true);
     bool __SingleRespHandle(std::list<TaskProfile>::iterator _it, ErrCmdType _err_type, int _err_code, int _fail_handle, const ConnectProfile& _connect_profile);
 
     std::list<TaskProfile>::iterator __Locate(uint32_t  _taskid);
+    void __Erase(std::list<TaskProfile>::iterator _it);
 
   private:
     MessageQueue::ScopeRegister     asyncreg_;
     std::list<TaskProfile>          lst_cmd_;
+    std::multimap<uint32_t, std::list<TaskProfile>::iterator>  taskid_index_;     // taskid -> the tasks in lst_cmd_, in the order started
+    std::multimap<uint64_t, uint32_t>   timeouts_;  // the next deadline of a task -> taskid, may be earlier than the actual one
     uint64_t                        lastbatcherrortime_;   // ms
     unsigned long                   retry_interval_;	//ms
     unsigned int                    tasks_continuous_fail_count_;
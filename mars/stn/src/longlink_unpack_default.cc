@@ -0,0 +1,31 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * longlink_unpack_default.cc
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <string.h>
+
+#include "mars/comm/compiler_util.h"
+
+#include "proto/longlink_packer.h"
+
+// packers written before longlink_unpack_batch don't have it, longlink_unpack takes the packs one by one then.
+WEAK_FUNC int longlink_unpack_batch(const void* _packed, size_t _packed_len, std::vector<LongLinkPackInfo>& _packs, LongLinkPackInfo& _pending) {
+    _packs.clear();
+    memset(&_pending, 0, sizeof(_pending));
+    return LONGLINK_UNPACK_NO_BATCH;
+}
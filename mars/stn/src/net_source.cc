@@ -524,6 +524,7 @@ void NetSource::__ClearShortLinkProxyInfo() {
 void NetSource::ClearCache() {
     xverbose_function();
     __ClearShortLinkProxyInfo();
+    DNS::ClearCache();
     ipportstrategy_.InitHistory2BannedList(true);
 }
 
@@ -45,7 +45,6 @@ static const unsigned long kIntervalTime = 1 * 60 * 60 * 1000;    // ms
 
 NetSourceTimerCheck::NetSourceTimerCheck(NetSource* _net_source, ActiveLogic& _active_logic, LongLink& _longlink, MessageQueue::MessageQueue_t  _messagequeue_id)
     : net_source_(_net_source)
-    , seletor_(breaker_)
     , longlink_(_longlink)
 	, asyncreg_(MessageQueue::InstallAsyncHandler(_messagequeue_id)){
     xassert2(breaker_.IsCreateSuc(), "create breaker fail");
@@ -195,12 +194,14 @@ bool NetSourceTimerCheck::__TryConnnect(const std::string& _host) {
     size_t port_index = rand() % port_vec.size();
 
     LongLinkSpeedTestItem speed_item(ip_vec[ip_index], port_vec[port_index]);
+    // one per check, a member would keep the last check's fd registered.
+    SocketSelect seletor(breaker_);
 
     while (true) {
-        seletor_.PreSelect();
-        speed_item.HandleSetFD(seletor_);
+        seletor.PreSelect();
+        speed_item.HandleSetFD(seletor);
 
-        int select_ret = seletor_.Select(kTimeout);
+        int select_ret = seletor.Select(kTimeout);
 
         if (select_ret == 0) {
             xerror2(TSF"time out");
@@ -211,17 +212,17 @@ bool NetSourceTimerCheck::__TryConnnect(const std::string& _host) {
             xerror2(TSF"select errror, ret:%0, strerror(errno):%1", select_ret, strerror(errno));
         }
 
-        if (seletor_.IsException()) {
+        if (seletor.IsException()) {
             xerror2(TSF"pipe exception");
             break;
         }
 
-        if (seletor_.IsBreak()) {
+        if (seletor.IsBreak()) {
             xwarn2(TSF"FD_ISSET(pipe_[0], &readfd)");
             break;
         }
 
-        speed_item.HandleFDISSet(seletor_);
+        speed_item.HandleFDISSet(seletor);
 
         if (kLongLinkSpeedTestSuc == speed_item.GetState() || kLongLinkSpeedTestFail == speed_item.GetState()) {
             break;
@@ -60,7 +60,6 @@ class NetSourceTimerCheck {
     boost::signals2::scoped_connection active_connection_;
     NetSource* net_source_;
     SocketSelectBreaker breaker_;
-    SocketSelect seletor_;
     CommFrequencyLimit* frequency_limit_;
     LongLink& longlink_;
 
@@ -41,6 +41,8 @@
 #endif
 #include "mars/stn/proto/shortlink_packer.h"
 
+#include "shortlink_connection_pool.h"
+
 
 
 #define AYNC_HANDLER asyncreg_.Get()
@@ -110,6 +112,7 @@ ShortLink::ShortLink(MessageQueue::MessageQueue_t _messagequeueid, NetSource& _n
 	, taskid_(_taskid)
     , url_(_url), use_proxy_(_use_proxy)
     , status_code_(-1)
+    , keep_alive_(false)
     {
     xdebug2(XTHIS);
     xassert2(breaker_.IsCreateSuc(), "Create Breaker Fail!!!");
@@ -142,7 +145,8 @@ void ShortLink::__Run() {
 	conn_profile.tid = xlogger_tid();
 	__UpdateProfile(conn_profile);
 
-    SOCKET fd_socket = __RunConnect(conn_profile);
+    SOCKET fd_socket = __RunReuse(conn_profile);
+    if (INVALID_SOCKET == fd_socket) fd_socket = __RunConnect(conn_profile);
 
     if (INVALID_SOCKET == fd_socket) return;
     OnSend(this);
@@ -151,17 +155,72 @@ void ShortLink::__Run() {
     int errcode = 0;
     __RunReadWrite(fd_socket, errtype, errcode, conn_profile);
 
+    if (kEctSocket == errtype && conn_profile.conn_reused) {
+        __RunReuseFail(fd_socket, conn_profile);
+
+        fd_socket = __RunConnect(conn_profile);
+        if (INVALID_SOCKET == fd_socket) return;
+
+        errtype = 0;
+        errcode = 0;
+        __RunReadWrite(fd_socket, errtype, errcode, conn_profile);
+    }
+
     conn_profile.disconn_signal = ::getSignal(::getNetInfo() == kWifi);
     __UpdateProfile(conn_profile);
 
-    socket_close(fd_socket);
+    __RunClose(fd_socket, conn_profile);
 }
 
+SOCKET ShortLink::__RunReuse(ConnectProfile& _conn_profile) {
+    if (NULL == connection_pool) return INVALID_SOCKET;
 
-SOCKET ShortLink::__RunConnect(ConnectProfile& _conn_profile) {
-    xmessage2_define(message)(TSF"taskid:%_, cgi:%_, @%_", taskid_, url_, this);
+    // a task through the proxy never takes a direct connection.
+    uint16_t proxy_port = 0;
+    std::string proxy_ip;
+    if (use_proxy_ && net_source_.GetShortLinkProxyInfo(proxy_port, proxy_ip, shortlink_hosts_)) return INVALID_SOCKET;
 
-    std::vector<socket_address> vecaddr;
+    SOCKET sock = connection_pool->Get(shortlink_hosts_.front(), net_source_.GetShortLinkPort(), _conn_profile);
+    if (INVALID_SOCKET == sock) return INVALID_SOCKET;
+
+    IPPortItem item = {_conn_profile.ip, _conn_profile.port, _conn_profile.ip_type, _conn_profile.host};
+    _conn_profile.ip_items.clear();
+    _conn_profile.ip_items.push_back(item);
+    _conn_profile.ip_index = 0;
+    getCurrNetLabel(_conn_profile.net_type);
+    __UpdateProfile(_conn_profile);
+
+    xinfo2(TSF"task socket reuse sock:%_, taskid:%_, cgi:%_, @%_ host:%_, ip:%_, port:%_, net:%_", sock, taskid_, url_, this, _conn_profile.host, _conn_profile.ip, _conn_profile.port, _conn_profile.net_type);
+    return sock;
+}
+
+// the server may close an idle connection any time, a reused one failing at the send or the first recv
+// is connected again once instead of failing the task.
+void ShortLink::__RunReuseFail(SOCKET _sock, ConnectProfile& _conn_profile) {
+    xwarn2(TSF"task socket reuse sock:%_ failed, taskid:%_, cgi:%_, @%_, connect again", _sock, taskid_, url_, this);
+    socket_close(_sock);
+
+    _conn_profile.conn_reused = false;
+    _conn_profile.ip_items.clear();
+    _conn_profile.ip_index = -1;
+    __UpdateProfile(_conn_profile);
+}
+
+void ShortLink::__RunClose(SOCKET _sock, const ConnectProfile& _conn_profile) {
+    // a proxy one is never given back, it's not the host's. the pool is looked up by the port of the settings,
+    // one connected to another port, e.g. of a debug ip, isn't found there.
+    if (keep_alive_ && NULL != connection_pool && kIPSourceProxy != _conn_profile.ip_type
+            && net_source_.GetShortLinkPort() == _conn_profile.port) {
+        connection_pool->Put(_sock, _conn_profile);
+        return;
+    }
+
+    socket_close(_sock);
+}
+
+
+bool ShortLink::__RunResolve(ConnectProfile& _conn_profile, std::vector<socket_address>& _vecaddr) {
+    xmessage2_define(message)(TSF"taskid:%_, cgi:%_, @%_", taskid_, url_, this);
 
     _conn_profile.dns_time = ::gettickcount();
     __UpdateProfile(_conn_profile);
@@ -187,13 +246,13 @@ SOCKET ShortLink::__RunConnect(ConnectProfile& _conn_profile) {
 
     bool isnat64 = ELocalIPStack_IPv6 == local_ipstack_detect();
     for (unsigned int i = 0; i < _conn_profile.ip_items.size(); ++i) {
-        vecaddr.push_back(socket_address(_conn_profile.ip_items[i].str_ip.c_str(), _conn_profile.port).v4tov6_address(isnat64));
+        _vecaddr.push_back(socket_address(_conn_profile.ip_items[i].str_ip.c_str(), _conn_profile.port).v4tov6_address(isnat64));
     }
 
-    if (vecaddr.empty()) {
+    if (_vecaddr.empty()) {
         xerror2(TSF"task socket connect fail %_ vecaddr empty", message.String());
         __RunResponseError(kEctDns, kEctDnsMakeSocketPrepared, _conn_profile);
-        return INVALID_SOCKET;
+        return false;
     }
 
     _conn_profile.host = _conn_profile.ip_items[0].str_host;
@@ -204,6 +263,14 @@ SOCKET ShortLink::__RunConnect(ConnectProfile& _conn_profile) {
     _conn_profile.dns_endtime = ::gettickcount();
     getCurrNetLabel(_conn_profile.net_type);
     __UpdateProfile(_conn_profile);
+    return true;
+}
+
+SOCKET ShortLink::__RunConnect(ConnectProfile& _conn_profile) {
+    xmessage2_define(message)(TSF"taskid:%_, cgi:%_, @%_", taskid_, url_, this);
+
+    std::vector<socket_address> vecaddr;
+    if (!__RunResolve(_conn_profile, vecaddr)) return INVALID_SOCKET;
 
     // set the first ip info to the profiler, after connect, the ip info will be overwrriten by the real one
 
@@ -259,9 +326,7 @@ SOCKET ShortLink::__RunConnect(ConnectProfile& _conn_profile) {
     return sock;
 }
 
-void ShortLink::__RunReadWrite(SOCKET _socket, int& _err_type, int& _err_code, ConnectProfile& _conn_profile) {
-	xmessage2_define(message)(TSF"taskid:%_, cgi:%_, @%_", taskid_, url_, this);
-
+void ShortLink::__PackRequest(const ConnectProfile& _conn_profile, AutoBuffer& _out_buff) {
     std::string url;
     if (kIPSourceProxy==_conn_profile.ip_type) {
         url +="http://";
@@ -272,9 +337,16 @@ void ShortLink::__RunReadWrite(SOCKET _socket, int& _err_type, int& _err_code, C
 
 	std::map<std::string, std::string> headers;
 	headers[http::HeaderFields::KStringHost] = _conn_profile.host;
-	AutoBuffer out_buff;
+	if (NULL != connection_pool && kIPSourceProxy != _conn_profile.ip_type) headers.insert(http::HeaderFields::MakeConnectionKeepalive());
+
+	shortlink_pack(url, headers, send_body_,  _out_buff);
+}
 
-	shortlink_pack(url, headers, send_body_,  out_buff);
+void ShortLink::__RunReadWrite(SOCKET _socket, int& _err_type, int& _err_code, ConnectProfile& _conn_profile) {
+	xmessage2_define(message)(TSF"taskid:%_, cgi:%_, @%_", taskid_, url_, this);
+
+	AutoBuffer out_buff;
+	__PackRequest(_conn_profile, out_buff);
 
 	// send request
 	xgroup2_define(group_send);
@@ -284,6 +356,11 @@ void ShortLink::__RunReadWrite(SOCKET _socket, int& _err_type, int& _err_code, C
 
 	if (send_ret < 0) {
 		xerror2(TSF"Send Request Error, ret:%0, errno:%1, nread:%_, nwrite:%_", send_ret, strerror(_err_code), socket_nread(_socket), socket_nwrite(_socket)) >> group_send;
+		// a reused one is connected again, see __RunReuseFail
+		if (_conn_profile.conn_reused && !breaker_.IsBreak()) {
+			_err_type = kEctSocket;
+			return;
+		}
 		__OnResponse(kEctSocket, (_err_code == 0) ? kEctSocketWritenWithNonBlock : _err_code, buf_body_, _conn_profile, false);
 		return;
 	}
@@ -314,6 +391,10 @@ void ShortLink::__RunReadWrite(SOCKET _socket, int& _err_type, int& _err_code, C
 
 		if (recv_ret < 0) {
 			xerror2(TSF"read block socket return false, error:%0, nread:%_, nwrite:%_", strerror(_err_code), socket_nread(_socket), socket_nwrite(_socket)) >> group_close;
+			if (_conn_profile.conn_reused && 0 == recv_buf.Length() && !breaker_.IsBreak()) {
+				_err_type = kEctSocket;
+				break;
+			}
 			__OnResponse(kEctSocket, (_err_code == 0) ? kEctSocketReadOnce : _err_code, buf_body_, _conn_profile, socket_nwrite(_socket) == 0);
 			break;
 		}
@@ -332,6 +413,10 @@ void ShortLink::__RunReadWrite(SOCKET _socket, int& _err_type, int& _err_code, C
 		}
 		if (recv_ret == 0) {
 			xerror2(TSF"remote disconnect, nread:%_, nwrite:%_", _err_code, strerror(_err_code), socket_nread(_socket), socket_nwrite(_socket)) >> group_close;
+			if (_conn_profile.conn_reused && 0 == recv_buf.Length()) {
+				_err_type = kEctSocket;
+				break;
+			}
 			__OnResponse(kEctSocket,  kEctSocketShutdown, buf_body_, _conn_profile, socket_nwrite(_socket) == 0);
 			break;
 		}
@@ -360,17 +445,18 @@ void ShortLink::__RunReadWrite(SOCKET _socket, int& _err_type, int& _err_code, C
 			break;
 		}
 		else if (parse_status == http::Parser::kBodyError) {
-			xerror2(TSF"content_length_ != buf_body_.Lenght(), Head:%0, http dump:%1 \n headers size:%2" , parser.Fields().ContentLength(), xdump(recv_buf.Ptr(), recv_buf.Length()), parser.Fields().GetHeaders().size()) >> group_close;
+			xerror2(TSF"content_length_ != buf_body_.Lenght(), Head:%0, http dump:%1 \n headers size:%2" , parser.Fields().ContentLength(), xdump(recv_buf.Ptr(), recv_buf.Length()), parser.Fields().Size()) >> group_close;
 			__OnResponse(kEctHttp, kEctHttpSplitHttpHeadAndBody, buf_body_, _conn_profile);
 			break;
 		}
 		else if (parse_status == http::Parser::kEnd) {
 			if (status_code_ != 200) {
-				xerror2(TSF"@%0, status_code_ != 200, code:%1, http dump:%2 \n headers size:%3", this, status_code_, xdump(recv_buf.Ptr(), recv_buf.Length()), parser.Fields().GetHeaders().size()) >> group_close;
+				xerror2(TSF"@%0, status_code_ != 200, code:%1, http dump:%2 \n headers size:%3", this, status_code_, xdump(recv_buf.Ptr(), recv_buf.Length()), parser.Fields().Size()) >> group_close;
 				__OnResponse(kEctHttp, status_code_, buf_body_, _conn_profile);
 			}
 			else {
-				xinfo2(TSF"@%0, headers size:%_, ", this, parser.Fields().GetHeaders().size()) >> group_recv;
+				xinfo2(TSF"@%0, headers size:%_, ", this, parser.Fields().Size()) >> group_recv;
+				keep_alive_ = ShortLinkConnectionPool::IsKeepAlive(parser);
 				__OnResponse(kEctOK, status_code_, buf_body_, _conn_profile);
 			}
 			break;
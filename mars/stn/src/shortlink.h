@@ -32,6 +32,7 @@
 #include "mars/comm/autobuffer.h"
 #include "mars/comm/http.h"
 #include "mars/comm/socket/socketselect.h"
+#include "mars/comm/socket/socket_address.h"
 #include "mars/comm/messagequeue/message_queue.h"
 #include "mars/comm/messagequeue/message_queue_utils.h"
 #include "mars/stn/stn.h"
@@ -54,7 +55,12 @@ class ShortLink : public ShortLinkInterface {
     virtual void 	 SendRequest(AutoBuffer& _buf_req);
 
     virtual void     __Run();
+    SOCKET           __RunReuse(ConnectProfile& _conn_profile);
+    void             __RunReuseFail(SOCKET _sock, ConnectProfile& _conn_profile);
+    void             __RunClose(SOCKET _sock, const ConnectProfile& _conn_profile);
+    bool             __RunResolve(ConnectProfile& _conn_profile, std::vector<socket_address>& _vecaddr);
     virtual SOCKET   __RunConnect(ConnectProfile& _conn_profile);
+    void             __PackRequest(const ConnectProfile& _conn_profile, AutoBuffer& _out_buff);
     virtual void     __RunReadWrite(SOCKET _sock, int& _errtype, int& _errcode, ConnectProfile& _conn_profile);
     void             __CancelAndWaitWorkerThread();
 
@@ -80,6 +86,7 @@ class ShortLink : public ShortLinkInterface {
 
     AutoBuffer                      buf_body_;
     int                             status_code_;
+    bool                            keep_alive_;
 
 };
         
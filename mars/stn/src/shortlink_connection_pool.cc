@@ -0,0 +1,173 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * shortlink_connection_pool.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include "shortlink_connection_pool.h"
+
+#include <stdio.h>
+
+#include "mars/comm/http.h"
+#include "mars/comm/strutil.h"
+#include "mars/comm/thread/lock.h"
+#include "mars/comm/time_utils.h"
+#include "mars/comm/xlogger/xlogger.h"
+#include "mars/stn/config.h"
+
+using namespace mars::stn;
+
+static std::string __Key(const std::string& _host, uint16_t _port) {
+    char port[16] = {0};
+    snprintf(port, sizeof(port), ":%u", (unsigned int)_port);
+    return _host + port;
+}
+
+ShortLinkConnectionPool::ShortLinkConnectionPool() {
+    xassert2(breaker_.IsCreateSuc(), "Create Breaker Fail!!!");
+}
+
+ShortLinkConnectionPool::~ShortLinkConnectionPool() {
+    Clear();
+}
+
+SOCKET ShortLinkConnectionPool::Get(const std::string& _host, uint16_t _port, ConnectProfile& _conn_profile) {
+    ScopedLock lock(mutex_);
+
+    std::map<std::string, std::list<Connection> >::iterator it = idle_.find(__Key(_host, _port));
+    if (idle_.end() == it) return INVALID_SOCKET;
+
+    uint64_t now = ::gettickcount();
+    std::list<Connection>& connections = it->second;
+
+    while (!connections.empty()) {
+        Connection connection = connections.front();
+        connections.pop_front();
+
+        if (now - connection.idle_time >= kShortlinkKeepAliveTimeout || !__IsAlive(connection.sock)) {
+            xinfo2(TSF"keep-alive sock:%_, %_:%_ expired or closed, idle:%_", connection.sock, _host, _port, now - connection.idle_time);
+            socket_close(connection.sock);
+            continue;
+        }
+
+        if (connections.empty()) idle_.erase(it);
+
+        _conn_profile.conn_reused = true;
+        _conn_profile.host = _host;
+        _conn_profile.port = _port;
+        _conn_profile.ip = connection.ip;
+        _conn_profile.ip_type = connection.ip_type;
+        _conn_profile.local_ip = connection.local_ip;
+        _conn_profile.nat64 = connection.nat64;
+        _conn_profile.dns_time = now;
+        _conn_profile.dns_endtime = now;
+        _conn_profile.conn_time = now;
+        _conn_profile.conn_cost = 0;
+        _conn_profile.conn_rtt = 0;
+        _conn_profile.conn_errcode = 0;
+
+        xinfo2(TSF"keep-alive sock:%_ reused for %_:%_, ip:%_, idle:%_", connection.sock, _host, _port, connection.ip, now - connection.idle_time);
+        return connection.sock;
+    }
+
+    idle_.erase(it);
+    return INVALID_SOCKET;
+}
+
+void ShortLinkConnectionPool::Put(SOCKET _sock, const ConnectProfile& _conn_profile) {
+    ScopedLock lock(mutex_);
+
+    uint64_t now = ::gettickcount();
+    std::list<Connection>& connections = idle_[__Key(_conn_profile.host, _conn_profile.port)];
+
+    Connection connection;
+    connection.sock = _sock;
+    connection.ip = _conn_profile.ip;
+    connection.ip_type = _conn_profile.ip_type;
+    connection.local_ip = _conn_profile.local_ip;
+    connection.nat64 = _conn_profile.nat64;
+    connection.idle_time = now;
+    connections.push_front(connection);
+
+    // the least recently used ones go first
+    while (connections.size() > kShortlinkKeepAliveMax) {
+        xinfo2(TSF"keep-alive sock:%_ closed, %_:%_ full", connections.back().sock, _conn_profile.host, _conn_profile.port);
+        socket_close(connections.back().sock);
+        connections.pop_back();
+    }
+
+    // the expired ones of every host, one not asked for anymore would keep them open till Clear.
+    for (std::map<std::string, std::list<Connection> >::iterator it = idle_.begin(); it != idle_.end();) {
+        std::list<Connection>& idle = it->second;
+
+        while (!idle.empty() && now - idle.back().idle_time >= kShortlinkKeepAliveTimeout) {
+            xinfo2(TSF"keep-alive sock:%_ of %_ expired, idle:%_", idle.back().sock, it->first, now - idle.back().idle_time);
+            socket_close(idle.back().sock);
+            idle.pop_back();
+        }
+
+        if (idle.empty())
+            idle_.erase(it++);
+        else
+            ++it;
+    }
+}
+
+void ShortLinkConnectionPool::Clear() {
+    ScopedLock lock(mutex_);
+
+    for (std::map<std::string, std::list<Connection> >::iterator it = idle_.begin(); it != idle_.end(); ++it) {
+        for (std::list<Connection>::iterator conn = it->second.begin(); conn != it->second.end(); ++conn) {
+            socket_close(conn->sock);
+        }
+    }
+
+    xinfo2_if(!idle_.empty(), TSF"keep-alive hosts cleared:%_", idle_.size());
+    idle_.clear();
+}
+
+bool ShortLinkConnectionPool::IsKeepAlive(const http::Parser& _parser) {
+    if (http::Parser::kEnd != _parser.RecvStatus()) return false;
+
+    const http::HeaderFields& fields = _parser.Fields();
+
+    // a body without a length ends with the connection.
+    if (NULL == fields.HeaderField(http::HeaderFields::KStringContentLength)
+            && NULL == fields.HeaderField(http::HeaderFields::KStringTransferEncoding)) {
+        return false;
+    }
+
+    std::string connection;
+    const char* value = fields.HeaderField(http::HeaderFields::KStringConnection);
+    if (NULL != value) connection = value;
+    strutil::ToLower(connection);
+
+    if (std::string::npos != connection.find("close")) return false;
+    if (http::kVersion_1_1 == _parser.Status().Version()) return true;
+
+    return std::string::npos != connection.find("keep-alive");
+}
+
+// an idle connection with something to read has been closed by the server, or has some bytes left by the last response.
+bool ShortLinkConnectionPool::__IsAlive(SOCKET _sock) {
+    SocketSelect sel(breaker_);
+    sel.PreSelect();
+    sel.Read_FD_SET(_sock);
+    sel.Exception_FD_SET(_sock);
+
+    int ret = sel.Select(0);
+    return 0 == ret;
+}
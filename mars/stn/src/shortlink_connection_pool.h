@@ -0,0 +1,82 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * shortlink_connection_pool.h
+ *
+ *  Created on: 2026-10-17
+ */
+
+#ifndef STN_SRC_SHORTLINK_CONNECTION_POOL_H_
+#define STN_SRC_SHORTLINK_CONNECTION_POOL_H_
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "mars/comm/thread/mutex.h"
+#include "mars/comm/socket/unix_socket.h"
+#include "mars/comm/socket/socketselect.h"
+#include "mars/stn/task_profile.h"
+
+namespace http {
+class Parser;
+}
+
+namespace mars {
+namespace stn {
+
+/*
+ * idle http/1.1 keep-alive connections of the shortlinks, by host:port.
+ * a shortlink takes one before its dns and connect, and gives it back once the response ended if the server keeps it alive.
+ * the ones idle for kShortlinkKeepAliveTimeout, or found readable(closed by the server) are closed instead of reused.
+ */
+class ShortLinkConnectionPool {
+  public:
+    ShortLinkConnectionPool();
+    ~ShortLinkConnectionPool();
+
+    // INVALID_SOCKET if none, else the connection is the caller's and _conn_profile is filled like it's just connected.
+    SOCKET Get(const std::string& _host, uint16_t _port, ConnectProfile& _conn_profile);
+    // _sock is closed if the pool is full for _conn_profile.host:port. the expired ones of any host are closed.
+    void Put(SOCKET _sock, const ConnectProfile& _conn_profile);
+    // on network change, all of them are closed.
+    void Clear();
+
+    // the response of _parser ended and the connection it came from can take another request.
+    static bool IsKeepAlive(const http::Parser& _parser);
+
+  private:
+    ShortLinkConnectionPool(const ShortLinkConnectionPool&);
+    ShortLinkConnectionPool& operator=(const ShortLinkConnectionPool&);
+
+    struct Connection {
+        SOCKET          sock;
+        std::string     ip;
+        IPSourceType    ip_type;
+        std::string     local_ip;
+        bool            nat64;
+        uint64_t        idle_time;
+    };
+
+    bool __IsAlive(SOCKET _sock);
+
+  private:
+    Mutex                                           mutex_;
+    SocketSelectBreaker                             breaker_;
+    std::map<std::string, std::list<Connection> >   idle_;      // host:port -> the idle ones, the last put at the front
+};
+
+}}
+
+#endif // STN_SRC_SHORTLINK_CONNECTION_POOL_H_
@@ -0,0 +1,571 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * shortlink_engine.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include "shortlink_engine.h"
+
+#include <algorithm>
+
+#include "boost/bind.hpp"
+
+#include "mars/app/app.h"
+#include "mars/comm/socket/unix_socket.h"
+#include "mars/comm/socket/socket_address.h"
+#include "mars/comm/thread/lock.h"
+#include "mars/comm/xlogger/xlogger.h"
+#include "mars/comm/time_utils.h"
+#include "mars/comm/platform_comm.h"
+#include "mars/baseevent/baseprjevent.h"
+#include "mars/stn/config.h"
+
+#include "shortlink_connection_pool.h"
+
+using namespace mars::stn;
+using namespace mars::app;
+
+static const unsigned int kBufferSize = 8 * 1024;
+static const size_t kResolveThreadMax = 4;
+
+AsyncShortLink::AsyncShortLink(ShortLinkEngine& _engine, MessageQueue::MessageQueue_t _messagequeueid, NetSource& _netsource, const std::vector<std::string>& _host_list, const std::string& _url, const int _taskid, bool _use_proxy)
+    : ShortLink(_messagequeueid, _netsource, _host_list, _url, _taskid, _use_proxy)
+    , engine_(_engine)
+    , status_(kResolving)
+    , next_index_(0)
+    , next_connect_time_(0)
+    , last_err_(-1)
+    , rtt_(0)
+    , io_time_(0)
+    , reuse_failed_(false)
+    , sock_(INVALID_SOCKET)
+    , parser_(new http::MemoryBodyReceiver(buf_body_), true)
+    {
+    xdebug2(XTHIS);
+}
+
+AsyncShortLink::~AsyncShortLink() {
+    xinfo_function(TSF"taskid:%_, cgi:%_, @%_", taskid_, url_, this);
+    engine_.Detach(this);
+}
+
+void AsyncShortLink::SendRequest(AutoBuffer& _buf_req) {
+    xverbose_function();
+    xdebug2(XTHIS)(TSF"bufReq.size:%_", _buf_req.Length());
+    send_body_.Attach(_buf_req);
+
+    getCurrNetLabel(run_profile_.net_type);
+    run_profile_.start_time = ::gettickcount();
+    __UpdateProfile(run_profile_);
+
+    engine_.Attach(this);
+}
+
+bool AsyncShortLink::__Resolve() {
+    xinfo_function(TSF"taskid:%_, cgi:%_, @%_, net:%_", taskid_, url_, this, getNetInfo());
+
+    run_profile_.tid = xlogger_tid();
+
+    if (!reuse_failed_) sock_ = __RunReuse(run_profile_);
+    if (INVALID_SOCKET != sock_) {
+        __PackRequest(run_profile_, out_buff_);
+        out_buff_.Seek(0, AutoBuffer::ESeekStart);
+        status_ = kSending;
+        io_time_ = ::gettickcount();
+        OnSend(this);
+        return true;
+    }
+
+    if (!__RunResolve(run_profile_, vecaddr_)) {
+        status_ = kEnd;
+        return false;
+    }
+
+    connecting_.assign(vecaddr_.size(), INVALID_SOCKET);
+    connect_start_.assign(vecaddr_.size(), 0);
+    status_ = kConnecting;
+    return true;
+}
+
+int64_t AsyncShortLink::__PreSelect(SocketSelect& _sel, uint64_t _now) {
+    switch (status_) {
+    case kConnecting: {
+        for (size_t i = 0; i < next_index_; ++i) {
+            if (INVALID_SOCKET != connecting_[i] && connect_start_[i] + kShortlinkConnTimeout <= _now)
+                __OnConnectFail(i, SOCKET_ERRNO(ETIMEDOUT), _now);
+        }
+
+        __StartConnect(_now);
+        if (kConnecting != status_) return -1;
+
+        uint64_t deadline = next_index_ < vecaddr_.size() ? next_connect_time_ : UINT64_MAX;
+        for (size_t i = 0; i < next_index_; ++i) {
+            if (INVALID_SOCKET == connecting_[i]) continue;
+
+            _sel.Write_FD_SET(connecting_[i]);
+            _sel.Exception_FD_SET(connecting_[i]);
+            deadline = std::min(deadline, connect_start_[i] + kShortlinkConnTimeout);
+        }
+
+        return deadline <= _now ? 0 : (int64_t)(deadline - _now);
+    }
+    case kSending:
+        if (io_time_ + kShortlinkSendTimeout <= _now) {
+            xerror2(TSF"send timeout sock:%_, taskid:%_, sent:%_/%_, nread:%_, nwrite:%_", sock_, taskid_, out_buff_.Pos(), out_buff_.Length(), socket_nread(sock_), socket_nwrite(sock_));
+            __OnEnd(kEctSocket, SOCKET_ERRNO(ETIMEDOUT), false);
+            return -1;
+        }
+
+        _sel.Write_FD_SET(sock_);
+        _sel.Exception_FD_SET(sock_);
+        return (int64_t)(io_time_ + kShortlinkSendTimeout - _now);
+    case kRecving:
+        if (io_time_ + kShortlinkRecvTimeout <= _now) {
+            xerror2(TSF"read timeout sock:%_, taskid:%_, length:%_, nread:%_, nwrite:%_", sock_, taskid_, recv_buf_.Length(), socket_nread(sock_), socket_nwrite(sock_));
+            __OnEnd(kEctSocket, kEctSocketRecvErr, socket_nwrite(sock_) == 0);
+            return -1;
+        }
+
+        _sel.Read_FD_SET(sock_);
+        _sel.Exception_FD_SET(sock_);
+        return (int64_t)(io_time_ + kShortlinkRecvTimeout - _now);
+    default:
+        return -1;
+    }
+}
+
+void AsyncShortLink::__AfterSelect(SocketSelect& _sel, uint64_t _now) {
+    if (kConnecting == status_) {
+        for (size_t i = 0; i < next_index_ && kConnecting == status_; ++i) {
+            SOCKET sock = connecting_[i];
+            if (INVALID_SOCKET == sock) continue;
+            if (!_sel.Write_FD_ISSET(sock) && !_sel.Exception_FD_ISSET(sock)) continue;
+
+            int error = socket_error(sock);
+            if (0 != error)
+                __OnConnectFail(i, error, _now);
+            else
+                __OnConnected(i, _now);
+        }
+        return;
+    }
+
+    if (kSending == status_ && (_sel.Write_FD_ISSET(sock_) || _sel.Exception_FD_ISSET(sock_))) {
+        __OnSend();
+        return;
+    }
+
+    if (kRecving == status_ && (_sel.Read_FD_ISSET(sock_) || _sel.Exception_FD_ISSET(sock_))) {
+        __OnRecv();
+    }
+}
+
+// like ComplexConnect::ConnectImpatient, the next address is tried once the interval passed or the ones before failed.
+void AsyncShortLink::__StartConnect(uint64_t _now) {
+    while (next_index_ < vecaddr_.size() && next_connect_time_ <= _now) {
+        size_t index = next_index_++;
+        const socket_address& addr = vecaddr_[index];
+        next_connect_time_ = _now + kShortlinkConnInterval;
+        connect_start_[index] = _now;
+
+        SOCKET sock = socket(addr.address().sa_family, SOCK_STREAM, IPPROTO_TCP);
+        if (INVALID_SOCKET == sock) {
+            __OnConnectFail(index, socket_errno, _now);
+            continue;
+        }
+
+        connecting_[index] = sock;
+
+        if (::getNetInfo() == kWifi && socket_fix_tcp_mss(sock) < 0) {
+            xinfo2(TSF"wifi set tcp mss error:%_", socket_strerror(socket_errno));
+        }
+
+        if (0 != socket_ipv6only(sock, 0)) {
+            xwarn2(TSF"set ipv6only failed. error %_", socket_strerror(socket_errno));
+        }
+
+        if (0 != socket_set_nobio(sock)) {
+            __OnConnectFail(index, socket_errno, _now);
+            continue;
+        }
+
+        int ret = connect(sock, &(addr.address()), addr.address_length());
+        if (0 != ret && !IS_NOBLOCK_CONNECT_ERRNO(socket_errno)) {
+            __OnConnectFail(index, socket_errno, _now);
+            continue;
+        }
+
+        xinfo2(TSF"task socket connect sock:%_, taskid:%_, addr:%_, index:%_", sock, taskid_, addr.url(), index);
+    }
+
+    if (next_index_ < vecaddr_.size()) return;
+
+    for (size_t i = 0; i < connecting_.size(); ++i) {
+        if (INVALID_SOCKET != connecting_[i]) return;
+    }
+
+    xwarn2(TSF"task socket connect fail taskid:%_, cgi:%_, @%_, net:%_", taskid_, url_, this, getNetInfo());
+    run_profile_.conn_errcode = last_err_;
+    run_profile_.conn_rtt = rtt_;
+    __OnEnd(kEctSocket, kEctSocketMakeSocketPrepared, false, false);
+}
+
+void AsyncShortLink::__OnConnectFail(size_t _index, int _error, uint64_t _now) {
+    xwarn2(TSF"task socket connect fail sock:%_, addr:%_, error:(%_, %_)", connecting_[_index], vecaddr_[_index].url(), _error, socket_strerror(_error));
+
+    if (INVALID_SOCKET != connecting_[_index]) __CloseSocket(connecting_[_index]);
+
+    xassert2(func_network_report);
+    if (_index < run_profile_.ip_items.size())
+        func_network_report(__LINE__, kEctSocket, _error, vecaddr_[_index].ip(), run_profile_.ip_items[_index].str_host, vecaddr_[_index].port());
+
+    last_err_ = _error;
+    rtt_ = (int)(_now - connect_start_[_index]);
+    next_connect_time_ = _now;
+}
+
+void AsyncShortLink::__OnConnected(size_t _index, uint64_t _now) {
+    sock_ = connecting_[_index];
+    connecting_[_index] = INVALID_SOCKET;
+    last_err_ = 0;
+    rtt_ = (int)(_now - connect_start_[_index]);
+
+    for (size_t i = 0; i < next_index_; ++i) {
+        if (INVALID_SOCKET == connecting_[i]) continue;
+
+        if (i < _index)
+            func_network_report(__LINE__, kEctSocket, SOCKET_ERRNO(ETIMEDOUT), run_profile_.ip_items[i].str_ip, run_profile_.ip_items[i].str_host, run_profile_.ip_items[i].port);
+
+        __CloseSocket(connecting_[i]);
+    }
+
+    run_profile_.conn_errcode = last_err_;
+    run_profile_.conn_rtt = rtt_;
+    run_profile_.ip_index = (int)_index;
+    run_profile_.host = run_profile_.ip_items[_index].str_host;
+    run_profile_.ip_type = run_profile_.ip_items[_index].source_type;
+    run_profile_.ip = run_profile_.ip_items[_index].str_ip;
+    run_profile_.conn_cost = _now - connect_start_[0];
+    run_profile_.conn_time = _now;
+    run_profile_.local_ip = socket_address::getsockname(sock_).ip();
+    __UpdateProfile(run_profile_);
+
+    xinfo2(TSF"task socket connect success sock:%_, taskid:%_, cgi:%_, @%_ host:%_, ip:%_, port:%_, iptype:%_, net:%_", sock_, taskid_, url_, this,
+           run_profile_.host, run_profile_.ip, run_profile_.port, IPSourceTypeString[run_profile_.ip_type], run_profile_.net_type);
+
+    __PackRequest(run_profile_, out_buff_);
+    out_buff_.Seek(0, AutoBuffer::ESeekStart);
+    status_ = kSending;
+    io_time_ = _now;
+    OnSend(this);
+    __OnSend();
+}
+
+void AsyncShortLink::__OnSend() {
+    ssize_t nwrite = ::send(sock_, (const char*)out_buff_.PosPtr(), out_buff_.PosLength(), 0);
+
+    if (0 > nwrite && IS_NOBLOCK_SEND_ERRNO(socket_errno)) return;
+
+    if (0 > nwrite) {
+        int error = socket_errno;
+        xerror2(TSF"Send Request Error, sock:%_, errno:(%_, %_), nread:%_, nwrite:%_", sock_, error, socket_strerror(error), socket_nread(sock_), socket_nwrite(sock_));
+        if (run_profile_.conn_reused) {
+            __OnReuseFail();
+            return;
+        }
+        __OnEnd(kEctSocket, (error == 0) ? kEctSocketWritenWithNonBlock : error, false);
+        return;
+    }
+
+    out_buff_.Seek(nwrite, AutoBuffer::ESeekCur);
+    io_time_ = ::gettickcount();
+    if (0 < out_buff_.PosLength()) return;
+
+    xinfo2(TSF"task socket send sock:%_, taskid:%_, cgi:%_, @%_ http len:%_", sock_, taskid_, url_, this, out_buff_.Length());
+    GetSignalOnNetworkDataChange()(XLOGGER_TAG, out_buff_.Length(), 0);
+    status_ = kRecving;
+}
+
+void AsyncShortLink::__OnRecv() {
+    recv_buf_.AddCapacity(kBufferSize);
+    ssize_t nrecv = ::recv(sock_, (char*)recv_buf_.Ptr(recv_buf_.Length()), kBufferSize, 0);
+
+    if (0 > nrecv && IS_NOBLOCK_RECV_ERRNO(socket_errno)) return;
+
+    if (0 > nrecv) {
+        int error = socket_errno;
+        xerror2(TSF"read nonblock socket return false, sock:%_, error:(%_, %_), nread:%_, nwrite:%_", sock_, error, socket_strerror(error), socket_nread(sock_), socket_nwrite(sock_));
+        if (run_profile_.conn_reused && 0 == recv_buf_.Length()) {
+            __OnReuseFail();
+            return;
+        }
+        __OnEnd(kEctSocket, (error == 0) ? kEctSocketReadOnce : error, socket_nwrite(sock_) == 0);
+        return;
+    }
+
+    if (0 == nrecv) {
+        xerror2(TSF"remote disconnect, sock:%_, nread:%_, nwrite:%_", sock_, socket_nread(sock_), socket_nwrite(sock_));
+        if (run_profile_.conn_reused && 0 == recv_buf_.Length()) {
+            __OnReuseFail();
+            return;
+        }
+        __OnEnd(kEctSocket, kEctSocketShutdown, socket_nwrite(sock_) == 0);
+        return;
+    }
+
+    recv_buf_.Length(recv_buf_.Pos(), recv_buf_.Length() + nrecv);
+    io_time_ = ::gettickcount();
+    GetSignalOnNetworkDataChange()(XLOGGER_TAG, 0, nrecv);
+    OnRecv(this, (unsigned int)(recv_buf_.Length() - recv_buf_.Pos()), (unsigned int)recv_buf_.Length());
+
+    http::Parser::TRecvStatus parse_status = parser_.Recv(recv_buf_.Ptr(recv_buf_.Length() - nrecv), nrecv);
+    if (parser_.FirstLineReady()) {
+        status_code_ = parser_.Status().StatusCode();
+    }
+
+    switch (parse_status) {
+    case http::Parser::kFirstLineError:
+        xerror2(TSF"http head not receive yet,but socket closed, length:%_, nread:%_, nwrite:%_ ", recv_buf_.Length(), socket_nread(sock_), socket_nwrite(sock_));
+        __OnEnd(kEctHttp, kEctHttpParseStatusLine, socket_nwrite(sock_) == 0);
+        break;
+    case http::Parser::kHeaderFieldsError:
+        xerror2(TSF"parse http head failed, but socket closed, length:%_, nread:%_, nwrite:%_ ", recv_buf_.Length(), socket_nread(sock_), socket_nwrite(sock_));
+        __OnEnd(kEctHttp, kEctHttpSplitHttpHeadAndBody);
+        break;
+    case http::Parser::kBodyError:
+        xerror2(TSF"content_length_ != buf_body_.Lenght(), Head:%_, http dump:%_ \n headers size:%_", parser_.Fields().ContentLength(), xdump(recv_buf_.Ptr(), recv_buf_.Length()), parser_.Fields().Size());
+        __OnEnd(kEctHttp, kEctHttpSplitHttpHeadAndBody);
+        break;
+    case http::Parser::kEnd:
+        if (status_code_ != 200) {
+            xerror2(TSF"@%_, status_code_ != 200, code:%_, http dump:%_ \n headers size:%_", this, status_code_, xdump(recv_buf_.Ptr(), recv_buf_.Length()), parser_.Fields().Size());
+            __OnEnd(kEctHttp, status_code_);
+        } else {
+            xinfo2(TSF"task socket recv sock:%_, taskid:%_, cgi:%_, @%_, length:%_, headers size:%_", sock_, taskid_, url_, this, recv_buf_.Length(), parser_.Fields().Size());
+            keep_alive_ = ShortLinkConnectionPool::IsKeepAlive(parser_);
+            __OnEnd(kEctOK, status_code_);
+        }
+        break;
+    default:
+        xdebug2(TSF"http parser status:%_ ", parse_status);
+        break;
+    }
+}
+
+// back to the resolve thread for a new connection, once, like ShortLink does.
+void AsyncShortLink::__OnReuseFail() {
+    engine_.__Forget(sock_);
+    __RunReuseFail(sock_, run_profile_);
+    sock_ = INVALID_SOCKET;
+    out_buff_.Reset();
+    reuse_failed_ = true;
+    status_ = kResolving;
+}
+
+void AsyncShortLink::__OnEnd(ErrCmdType _err_type, int _status, bool _cancel_retry, bool _report) {
+    status_ = kEnd;
+    __OnResponse(_err_type, _status, buf_body_, run_profile_, _cancel_retry, _report);
+
+    run_profile_.disconn_signal = ::getSignal(::getNetInfo() == kWifi);
+    __UpdateProfile(run_profile_);
+
+    if (INVALID_SOCKET != sock_) {
+        engine_.__Forget(sock_);
+        __RunClose(sock_, run_profile_);
+        sock_ = INVALID_SOCKET;
+    }
+
+    __Close();
+}
+
+// with the mutex of the engine locked.
+void AsyncShortLink::__Close() {
+    for (size_t i = 0; i < connecting_.size(); ++i) {
+        if (INVALID_SOCKET != connecting_[i]) __CloseSocket(connecting_[i]);
+    }
+
+    if (INVALID_SOCKET != sock_) {
+        xinfo2(TSF"task socket close sock:%_, taskid:%_, cgi:%_, @%_", sock_, taskid_, url_, this);
+        __CloseSocket(sock_);
+    }
+}
+
+void AsyncShortLink::__CloseSocket(SOCKET& _sock) {
+    engine_.__Forget(_sock);
+    socket_close(_sock);
+    _sock = INVALID_SOCKET;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+ShortLinkEngine::ShortLinkEngine()
+    : sel_(breaker_, true)
+    , loop_thread_(boost::bind(&ShortLinkEngine::__RunLoop, this), XLOGGER_TAG "::shortlink_loop")
+    , stop_(false)
+    , idle_resolvers_(0)
+    {
+    xassert2(breaker_.IsCreateSuc(), "Create Breaker Fail!!!");
+
+    for (size_t i = 0; i < kResolveThreadMax; ++i) {
+        resolve_threads_.push_back(new Thread(boost::bind(&ShortLinkEngine::__RunResolve, this), XLOGGER_TAG "::shortlink_resolve"));
+    }
+}
+
+ShortLinkEngine::~ShortLinkEngine() {
+    xinfo_function();
+
+    ScopedLock lock(mutex_);
+    xassert2(resolve_queue_.empty() && resolving_.empty() && links_.empty(), TSF"queue:%_, resolving:%_, links:%_", resolve_queue_.size(), resolving_.size(), links_.size());
+    stop_ = true;
+    resolve_cond_.notifyAll(lock);
+    lock.unlock();
+
+    breaker_.Break();
+
+    for (std::vector<Thread*>::iterator it = resolve_threads_.begin(); it != resolve_threads_.end(); ++it) {
+        if ((*it)->isruning()) (*it)->join();
+        delete (*it);
+    }
+
+    if (loop_thread_.isruning()) loop_thread_.join();
+}
+
+void ShortLinkEngine::Attach(AsyncShortLink* _link) {
+    ScopedLock lock(mutex_);
+    xassert2(!stop_);
+
+    resolve_queue_.push_back(_link);
+    resolve_cond_.notifyAll(lock);
+
+    if (resolve_queue_.size() > idle_resolvers_) {
+        for (std::vector<Thread*>::iterator it = resolve_threads_.begin(); it != resolve_threads_.end(); ++it) {
+            if ((*it)->isruning()) continue;
+            (*it)->start();
+            break;
+        }
+    }
+
+    loop_thread_.start();
+}
+
+void ShortLinkEngine::Detach(AsyncShortLink* _link) {
+    ScopedLock lock(mutex_);
+    resolve_queue_.remove(_link);
+
+    if (resolving_.end() != std::find(resolving_.begin(), resolving_.end(), _link)) {
+        _link->dns_util_.Cancel();
+        while (resolving_.end() != std::find(resolving_.begin(), resolving_.end(), _link)) resolve_cond_.wait(lock);
+    }
+
+    links_.erase(std::remove(links_.begin(), links_.end(), _link), links_.end());
+    std::replace(round_links_.begin(), round_links_.end(), _link, (AsyncShortLink*)NULL);
+
+    // closed with the lock held, the loop thread forgets the fds before a new socket may get one of them.
+    _link->__Close();
+}
+
+void ShortLinkEngine::__RunResolve() {
+    ScopedLock lock(mutex_);
+
+    while (!stop_) {
+        if (resolve_queue_.empty()) {
+            ++idle_resolvers_;
+            resolve_cond_.wait(lock);
+            --idle_resolvers_;
+            continue;
+        }
+
+        AsyncShortLink* link = resolve_queue_.front();
+        resolve_queue_.pop_front();
+        resolving_.push_back(link);
+
+        // Detach waits till it's done, the link can't go away meanwhile.
+        lock.unlock();
+        bool resolved = link->__Resolve();
+        lock.lock();
+
+        if (resolved) {
+            links_.push_back(link);
+            breaker_.Break();
+        }
+
+        resolving_.erase(std::find(resolving_.begin(), resolving_.end(), link));
+        resolve_cond_.notifyAll(lock);
+    }
+}
+
+void ShortLinkEngine::__RunLoop() {
+    xinfo_function();
+
+    while (true) {
+        sel_.PreSelect();
+        int64_t timeout = -1;
+
+        {
+            ScopedLock lock(mutex_);
+            if (stop_) return;
+
+            uint64_t now = ::gettickcount();
+            round_links_ = links_;
+
+            for (size_t i = 0; i < round_links_.size(); ++i) {
+                int64_t next = round_links_[i]->__PreSelect(sel_, now);
+                if (0 <= next && (0 > timeout || next < timeout)) timeout = next;
+            }
+
+            // the fds of the sockets closed may be set again by new ones, in this round already.
+            for (size_t i = 0; i < forgotten_.size(); ++i) sel_.Forget(forgotten_[i]);
+            forgotten_.clear();
+        }
+
+        int ret = sel_.Select((int)timeout);
+
+        ScopedLock lock(mutex_);
+        if (stop_) return;
+
+        if (0 > ret) {
+            xerror2(TSF"select errno:(%_, %_)", sel_.Errno(), strerror(sel_.Errno()));
+        } else {
+            uint64_t now = ::gettickcount();
+
+            for (size_t i = 0; i < round_links_.size(); ++i) {
+                if (NULL != round_links_[i]) round_links_[i]->__AfterSelect(sel_, now);
+            }
+        }
+
+        round_links_.clear();
+
+        for (size_t i = 0; i < links_.size();) {
+            if (AsyncShortLink::kEnd != links_[i]->status_ && AsyncShortLink::kResolving != links_[i]->status_) {
+                ++i;
+                continue;
+            }
+
+            // a reused connection failed, to be connected again
+            if (AsyncShortLink::kResolving == links_[i]->status_) {
+                resolve_queue_.push_back(links_[i]);
+                resolve_cond_.notifyAll(lock);
+            }
+
+            links_[i] = links_.back();
+            links_.pop_back();
+        }
+    }
+}
+
+void ShortLinkEngine::__Forget(SOCKET _sock) {
+    forgotten_.push_back(_sock);
+}
@@ -0,0 +1,141 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+/*
+ * shortlink_engine.h
+ *
+ *  Created on: 2026-10-17
+ */
+
+#ifndef STN_SRC_SHORTLINK_ENGINE_H_
+#define STN_SRC_SHORTLINK_ENGINE_H_
+
+#include <list>
+#include <vector>
+
+#include "mars/comm/thread/thread.h"
+#include "mars/comm/thread/mutex.h"
+#include "mars/comm/thread/condition.h"
+#include "mars/comm/socket/socketselect.h"
+
+#include "shortlink.h"
+
+namespace mars {
+namespace stn {
+
+class ShortLinkEngine;
+
+/*
+ * a shortlink run by a ShortLinkEngine instead of a thread of its own.
+ * the dns is done by a resolve thread of the engine, the connect, send and recv with nonblock sockets by its loop thread.
+ * callbacks come from those threads, like the ones of ShortLink come from its worker thread.
+ */
+class AsyncShortLink : public ShortLink {
+  public:
+    AsyncShortLink(ShortLinkEngine& _engine, MessageQueue::MessageQueue_t _messagequeueid, NetSource& _netsource, const std::vector<std::string>& _host_list, const std::string& _url, const int _taskid, bool _use_proxy);
+    virtual ~AsyncShortLink();
+
+  protected:
+    virtual void     SendRequest(AutoBuffer& _buf_req);
+
+  private:
+    friend class ShortLinkEngine;
+
+    enum TStatus {
+        kResolving,
+        kConnecting,
+        kSending,
+        kRecving,
+        kEnd,
+    };
+
+    bool             __Resolve();
+    int64_t          __PreSelect(SocketSelect& _sel, uint64_t _now);
+    void             __AfterSelect(SocketSelect& _sel, uint64_t _now);
+
+    void             __StartConnect(uint64_t _now);
+    void             __OnConnectFail(size_t _index, int _error, uint64_t _now);
+    void             __OnConnected(size_t _index, uint64_t _now);
+    void             __OnSend();
+    void             __OnRecv();
+    void             __OnReuseFail();
+    void             __OnEnd(ErrCmdType _err_type, int _status, bool _cancel_retry = true, bool _report = true);
+    void             __Close();
+    void             __CloseSocket(SOCKET& _sock);
+
+  private:
+    ShortLinkEngine&                engine_;
+    TStatus                         status_;
+    ConnectProfile                  run_profile_;     // conn_profile_ is the copy on the queue of the task manager
+
+    std::vector<socket_address>     vecaddr_;
+    std::vector<SOCKET>             connecting_;      // by the index of vecaddr_, INVALID_SOCKET if not connecting
+    std::vector<uint64_t>           connect_start_;
+    size_t                          next_index_;
+    uint64_t                        next_connect_time_;
+    int                             last_err_;
+    int                             rtt_;
+    uint64_t                        io_time_;         // of the last progress of the send or the recv
+    bool                            reuse_failed_;    // a pooled connection failed, a new one is connected then
+
+    SOCKET                          sock_;
+    AutoBuffer                      out_buff_;
+    AutoBuffer                      recv_buf_;
+    http::Parser                    parser_;
+};
+
+/*
+ * a few resolve threads and one loop thread for all the AsyncShortLinks attached,
+ * instead of a thread, a stack and a blocking connect for each of them.
+ * the dns of a link blocks one resolve thread, the others go on with the next links meanwhile.
+ */
+class ShortLinkEngine {
+  public:
+    ShortLinkEngine();
+    ~ShortLinkEngine();
+
+    void Attach(AsyncShortLink* _link);
+    // once it returns the engine doesn't touch _link anymore.
+    void Detach(AsyncShortLink* _link);
+
+  private:
+    friend class AsyncShortLink;
+
+    ShortLinkEngine(const ShortLinkEngine&);
+    ShortLinkEngine& operator=(const ShortLinkEngine&);
+
+    void __RunResolve();
+    void __RunLoop();
+    // with mutex_ locked, _sock is closed or handed over, the selector forgets its fd before the next select.
+    void __Forget(SOCKET _sock);
+
+  private:
+    Mutex                           mutex_;
+    Condition                       resolve_cond_;
+    SocketSelectBreaker             breaker_;
+    SocketSelect                    sel_;             // kept across the rounds of the loop thread
+    std::vector<Thread*>            resolve_threads_; // started when the running ones are all busy
+    Thread                          loop_thread_;
+    bool                            stop_;
+    size_t                          idle_resolvers_;
+
+    std::list<AsyncShortLink*>      resolve_queue_;
+    std::vector<AsyncShortLink*>    resolving_;
+    std::vector<AsyncShortLink*>    links_;           // resolved, run by the loop thread
+    std::vector<AsyncShortLink*>    round_links_;     // the ones set to the selector of this round, NULL once detached
+    std::vector<SOCKET>             forgotten_;       // closed or handed over since the last select
+};
+
+}}
+
+#endif // STN_SRC_SHORTLINK_ENGINE_H_
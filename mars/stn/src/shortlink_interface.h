@@ -27,8 +27,11 @@
 namespace mars {
 namespace stn {
 
+class ShortLinkConnectionPool;
+
 class ShortLinkInterface {
   public:
+	ShortLinkInterface(): connection_pool(NULL) {}
 	virtual ~ShortLinkInterface(){};
 
 	virtual void            SendRequest(AutoBuffer& _buf_req) = 0;
@@ -38,6 +41,8 @@ class ShortLinkInterface {
     boost::function<void (ShortLinkInterface* _worker, ErrCmdType _err_type, int _status, AutoBuffer& _body, bool _cancel_retry, ConnectProfile& _conn_profile)> OnResponse;
     boost::function<void (ShortLinkInterface* _worker)> OnSend;
 	boost::function<void (ShortLinkInterface* _worker, unsigned int _cached_size, unsigned int _total_size)> OnRecv;
+
+    ShortLinkConnectionPool* connection_pool;    // idle keep-alive connections to take and give back, NULL for none
 };
     
 }
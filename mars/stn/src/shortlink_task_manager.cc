@@ -25,6 +25,7 @@
 #include "boost/bind.hpp"
 
 #include "mars/app/app.h"
+#include "mars/comm/thread/atomic_oper.h"
 #include "mars/comm/thread/lock.h"
 #include "mars/comm/xlogger/xlogger.h"
 #include "mars/comm/time_utils.h"
@@ -37,6 +38,7 @@
 
 #include "dynamic_timeout.h"
 #include "net_channel_factory.h"
+#include "shortlink_engine.h"
 
 using namespace mars::stn;
 using namespace mars::app;
@@ -44,12 +46,20 @@ using namespace mars::app;
 #define AYNC_HANDLER asyncreg_.Get()
 #define RETURN_SHORTLINK_SYNC2ASYNC_FUNC_TITLE(func, title) RETURN_SYNC2ASYNC_FUNC_TITLE(func, title, )
 
+static uint32_t sg_use_event_loop = 0;   // set by the api thread, read on the queue of the task manager
+
+void ShortLinkTaskManager::UseEventLoop(bool _use) {
+    xinfo2(TSF"shortlink use event loop:%_", _use);
+    atomic_write32(&sg_use_event_loop, _use ? 1 : 0);
+}
+
 ShortLinkTaskManager::ShortLinkTaskManager(NetSource& _netsource, DynamicTimeout& _dynamictimeout, MessageQueue::MessageQueue_t _messagequeueid)
     : asyncreg_(MessageQueue::InstallAsyncHandler(_messagequeueid))
     , net_source_(_netsource)
     , default_use_proxy_(true)
     , tasks_continuous_fail_count_(0)
     , dynamic_timeout_(_dynamictimeout)
+    , engine_(NULL)
 #ifdef ANDROID
     , wakeup_lock_(new WakeUpLock())
 #endif
@@ -63,6 +73,7 @@ ShortLinkTaskManager::~ShortLinkTaskManager() {
     asyncreg_.CancelAndWait();
     xinfo2(TSF"lst_cmd_ count=%0", lst_cmd_.size());
     __Reset();
+    delete engine_;
 #ifdef ANDROID
     delete wakeup_lock_;
 #endif
@@ -82,8 +93,17 @@ bool ShortLinkTaskManager::StartTask(const Task& _task) {
     TaskProfile task(_task);
     task.link_type = Task::kChannelShort;
 
-    lst_cmd_.push_back(task);
-    lst_cmd_.sort(__CompareTask);
+    // after the ones of the same priority, as a stable sort would put it
+    std::list<TaskProfile>::iterator pos = lst_cmd_.end();
+    while (pos != lst_cmd_.begin()) {
+        std::list<TaskProfile>::iterator prev = pos;
+        --prev;
+        if (!__CompareTask(task, *prev)) break;
+        pos = prev;
+    }
+
+    pos = lst_cmd_.insert(pos, task);
+    taskid_index_.insert(std::make_pair(pos->task.taskid, pos));
 
     __RunLoop();
     return true;
@@ -92,38 +112,20 @@ bool ShortLinkTaskManager::StartTask(const Task& _task) {
 bool ShortLinkTaskManager::StopTask(uint32_t _taskid) {
     xverbose_function();
 
-    std::list<TaskProfile>::iterator first = lst_cmd_.begin();
-    std::list<TaskProfile>::iterator last = lst_cmd_.end();
+    std::list<TaskProfile>::iterator it = __Locate(_taskid);
+    if (lst_cmd_.end() == it) return false;
 
-    while (first != last) {
-        if (_taskid == first->task.taskid) {
-            xinfo2(TSF"find the task, taskid:%0", _taskid);
+    xinfo2(TSF"find the task, taskid:%0", _taskid);
 
-            __DeleteShortLink(first->running_id);
-            lst_cmd_.erase(first);
-            return true;
-        }
-
-        ++first;
-    }
-
-    return false;
+    __DeleteShortLink(it->running_id);
+    __Erase(it);
+    return true;
 }
 
 bool ShortLinkTaskManager::HasTask(uint32_t _taskid) const {
     xverbose_function();
 
-    std::list<TaskProfile>::const_iterator first = lst_cmd_.begin();
-    std::list<TaskProfile>::const_iterator last = lst_cmd_.end();
-
-    while (first != last) {
-    	if (_taskid == first->task.taskid) {
-    		return true;
-    	}
-    	++first;
-    }
-
-    return false;
+    return taskid_index_.end() != taskid_index_.find(_taskid);
 }
 
 void ShortLinkTaskManager::ClearTasks() {
@@ -136,6 +138,8 @@ void ShortLinkTaskManager::ClearTasks() {
     }
 
     lst_cmd_.clear();
+    taskid_index_.clear();
+    running_index_.clear();
 }
 
 unsigned int ShortLinkTaskManager::GetTasksContinuousFailCount() {
@@ -291,11 +295,18 @@ void ShortLinkTaskManager::__RunOnStartTask() {
 		first->transfer_profile.send_data_size = bufreq.Length();
 
         first->use_proxy =  (first->remain_retry_count == 0 && first->task.retry_count > 0) ? !default_use_proxy_ : default_use_proxy_;
-        ShortLinkInterface* worker = ShortLinkChannelFactory::Create(MessageQueue::Handler2Queue(asyncreg_.Get()), net_source_, first->task.shortlink_host_list, first->task.cgi, first->task.taskid, first->use_proxy);
+        ShortLinkInterface* worker = NULL;
+        if (0 != atomic_read32(&sg_use_event_loop)) {
+            if (NULL == engine_) engine_ = new ShortLinkEngine();
+            worker = new AsyncShortLink(*engine_, MessageQueue::Handler2Queue(asyncreg_.Get()), net_source_, first->task.shortlink_host_list, first->task.cgi, first->task.taskid, first->use_proxy);
+        } else {
+            worker = ShortLinkChannelFactory::Create(MessageQueue::Handler2Queue(asyncreg_.Get()), net_source_, first->task.shortlink_host_list, first->task.cgi, first->task.taskid, first->use_proxy);
+        }
         worker->OnSend = boost::bind(&ShortLinkTaskManager::__OnSend, this, _1);
         worker->OnRecv = boost::bind(&ShortLinkTaskManager::__OnRecv, this, _1, _2, _3);
         worker->OnResponse = boost::bind(&ShortLinkTaskManager::__OnResponse, this, _1, _2, _3, _4, _5, _6);
         first->running_id = (intptr_t)worker;
+        running_index_[first->running_id] = first;
 
         xassert2(worker && first->running_id);
         if (!first->running_id) {
@@ -305,6 +316,7 @@ void ShortLinkTaskManager::__RunOnStartTask() {
 		}
 
         worker->func_network_report = fun_notify_network_err_;
+        worker->connection_pool = &connection_pool_;
         worker->SendRequest(bufreq);
 
         xinfo2(TSF"task add into shortlink readwrite cgi:%_, cmdid:%_, taskid:%_, work:%_, size:%_, timeout(firstpkg:%_, rw:%_, task:%_), retry:%_, useProxy:%_",
@@ -315,13 +327,6 @@ void ShortLinkTaskManager::__RunOnStartTask() {
     }
 }
 
-struct find_seq {
-  public:
-    bool operator()(const TaskProfile& _value) {return p_worker == (ShortLinkInterface*)_value.running_id;}
-
-  public:
-    ShortLinkInterface* p_worker;
-};
 
 void ShortLinkTaskManager::__OnResponse(ShortLinkInterface* _worker, ErrCmdType _err_type, int _status, AutoBuffer& _body, bool _cancel_retry, ConnectProfile& _conn_profile) {
     copy_wrapper<AutoBuffer> body(_body);
@@ -444,7 +449,9 @@ void ShortLinkTaskManager::RedoTasks() {
 
         first = next;
     }
-    
+
+    // the idle ones may be of the last network or the last servers.
+    connection_pool_.Clear();
     __RunLoop();
 }
 
@@ -516,7 +523,7 @@ bool ShortLinkTaskManager::__SingleRespHandle(std::list<TaskProfile>::iterator _
 
         __DeleteShortLink(_it->running_id);
 
-        lst_cmd_.erase(_it);
+        __Erase(_it);
 
         return true;
     }
@@ -550,15 +557,31 @@ bool ShortLinkTaskManager::__SingleRespHandle(std::list<TaskProfile>::iterator _
 std::list<TaskProfile>::iterator ShortLinkTaskManager::__LocateBySeq(intptr_t _running_id) {
     if (!_running_id) return lst_cmd_.end();
 
-    find_seq find_functor;
-    find_functor.p_worker = (ShortLinkInterface*)_running_id;
-    std::list<TaskProfile>::iterator it = std::find_if(lst_cmd_.begin(), lst_cmd_.end(), find_functor);
+    std::map<intptr_t, std::list<TaskProfile>::iterator>::iterator it = running_index_.find(_running_id);
+    return running_index_.end() == it ? lst_cmd_.end() : it->second;
+}
+
+std::list<TaskProfile>::iterator ShortLinkTaskManager::__Locate(uint32_t _taskid) {
+    // the first started of the same taskid
+    std::multimap<uint32_t, std::list<TaskProfile>::iterator>::iterator it = taskid_index_.lower_bound(_taskid);
+    return taskid_index_.end() == it || _taskid != it->first ? lst_cmd_.end() : it->second;
+}
+
+void ShortLinkTaskManager::__Erase(std::list<TaskProfile>::iterator _it) {
+    // tasks of the same taskid are all indexed, only this one goes
+    std::pair<std::multimap<uint32_t, std::list<TaskProfile>::iterator>::iterator, std::multimap<uint32_t, std::list<TaskProfile>::iterator>::iterator> range = taskid_index_.equal_range(_it->task.taskid);
+    for (std::multimap<uint32_t, std::list<TaskProfile>::iterator>::iterator index = range.first; index != range.second; ++index) {
+        if (index->second != _it) continue;
+        taskid_index_.erase(index);
+        break;
+    }
 
-    return it;
+    lst_cmd_.erase(_it);
 }
 
 void ShortLinkTaskManager::__DeleteShortLink(intptr_t& _running_id) {
     if (!_running_id) return;
+    running_index_.erase(_running_id);
     ShortLinkInterface* p_shortlink = (ShortLinkInterface*)_running_id;
     ShortLinkChannelFactory::Destory(p_shortlink);
     MessageQueue::CancelMessage(asyncreg_.Get(), p_shortlink);
@@ -22,6 +22,7 @@
 #define STN_SRC_SHORTLINK_TASK_MANAGER_H_
 
 #include <list>
+#include <map>
 #include <stdint.h>
 
 #include "boost/function.hpp"
@@ -33,6 +34,7 @@
 #include "mars/stn/task_profile.h"
 
 #include "shortlink.h"
+#include "shortlink_connection_pool.h"
 
 class AutoBuffer;
 
@@ -44,6 +46,7 @@ namespace mars {
     namespace stn {
 
 class DynamicTimeout;
+class ShortLinkEngine;
 
 class ShortLinkTaskManager {
   public:
@@ -53,6 +56,10 @@ class ShortLinkTaskManager {
     boost::function<void (int _status_code)> fun_shortlink_response_;
     boost::function<void (int _err_code, uint32_t _src_taskid)> fun_notify_session_timeout_;
 
+  public:
+    // false by default, a thread for each shortlink. if true, the shortlinks started from now on share one ShortLinkEngine.
+    static void UseEventLoop(bool _use);
+
   public:
     ShortLinkTaskManager(mars::stn::NetSource& _netsource, DynamicTimeout& _dynamictimeout, MessageQueue::MessageQueue_t _messagequeueid);
     virtual ~ShortLinkTaskManager();
@@ -80,6 +87,8 @@ class ShortLinkTaskManager {
     bool __SingleRespHandle(std::list<TaskProfile>::iterator _it, ErrCmdType _err_type, int _err_code, int _fail_handle, size_t _resp_length, const ConnectProfile& _connect_profile);
 
     std::list<TaskProfile>::iterator __LocateBySeq(intptr_t _running_id);
+    std::list<TaskProfile>::iterator __Locate(uint32_t _taskid);
+    void __Erase(std::list<TaskProfile>::iterator _it);
 
     void __DeleteShortLink(intptr_t& _running_id);
 
@@ -88,10 +97,14 @@ class ShortLinkTaskManager {
     NetSource&                      net_source_;
     
     std::list<TaskProfile>          lst_cmd_;
+    std::multimap<uint32_t, std::list<TaskProfile>::iterator>  taskid_index_;     // taskid -> the tasks in lst_cmd_, in the order started
+    std::map<intptr_t, std::list<TaskProfile>::iterator>  running_index_;    // running_id -> the task in lst_cmd_
     
     bool                            default_use_proxy_;
     unsigned int                    tasks_continuous_fail_count_;
     DynamicTimeout&                 dynamic_timeout_;
+    ShortLinkEngine*                engine_;
+    ShortLinkConnectionPool         connection_pool_;
 #ifdef ANDROID
     WakeUpLock*                     wakeup_lock_;
 #endif
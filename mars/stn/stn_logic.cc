@@ -29,6 +29,7 @@
 #include "mars/baseevent/baseprjevent.h"
 #include "mars/baseevent/active_logic.h"
 #include "mars/baseevent/baseevent.h"
+#include "mars/comm/autobuffer_pool.h"
 #include "mars/comm/xlogger/xlogger.h"
 #include "mars/comm/messagequeue/message_queue.h"
 #include "mars/comm/singleton.h"
@@ -39,6 +40,7 @@
 #include "net_core.h"//一定要放这里，Mac os 编译
 #include "net_source.h"
 #include "signalling_keeper.h"
+#include "shortlink_task_manager.h"
 
 namespace mars {
 namespace stn {
@@ -240,6 +242,14 @@ void StopSignalling() {
 #endif
 }
 
+void SetShortLinkEventLoop(bool _use_event_loop) {
+    ShortLinkTaskManager::UseEventLoop(_use_event_loop);
+}
+
+void SetBufferPool(bool _enable) {
+    AutoBufferPool::Enable(_enable);
+}
+
 uint32_t getNoopTaskID() {
 	return Task::kNoopTaskID;
 }
@@ -119,6 +119,14 @@ namespace stn{
     
 
     void StopSignalling();
+
+    // run the shortlinks started from now on by one shared event loop instead of a thread each.
+    // if you did not call this function, stn will start a thread for each shortlink.
+    void SetShortLinkEventLoop(bool use_event_loop);
+
+    // keep the buffers of the network(and all the other AutoBuffers) in size-classed freelists of each thread instead of malloc and free them each time.
+    // if you did not call this function, the buffers are not pooled.
+    void SetBufferPool(bool enable);
     
     // connect quickly if longlink is not connected.
     void MakesureLonglinkConnected();
@@ -89,6 +89,7 @@ struct ConnectProfile {
         conn_rtt = 0;
         conn_cost = 0;
         tryip_count = 0;
+        conn_reused = false;
 
         local_ip.clear();
         ip_index = -1;
@@ -119,6 +120,7 @@ struct ConnectProfile {
     unsigned int conn_rtt;
     unsigned long conn_cost;
     int tryip_count;
+    bool conn_reused;   // an idle keep-alive connection is taken instead of connect
 
     std::string ip;
     uint16_t port;
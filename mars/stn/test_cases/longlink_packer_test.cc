@@ -0,0 +1,175 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * longlink_packer_test.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "mars/comm/autobuffer.h"
+#include "mars/comm/time_utils.h"
+#include "mars/stn/proto/longlink_packer.h"
+
+namespace
+{
+
+static const size_t kReadLen = 64 * 1024;
+
+// a read full of small pushes like the ones of a sync storm, the last one cut by the read.
+static void fill_read(AutoBuffer& _read, size_t _body_len)
+{
+	std::vector<char> raw(_body_len, 'x');
+	uint32_t seq = 1;
+
+	while (_read.Length() < kReadLen)
+	{
+		AutoBuffer pack;
+		longlink_pack(10 + seq % 3, seq, &raw[0], raw.size(), pack);
+		_read.Write(pack.Ptr(), std::min(pack.Length(), kReadLen - _read.Length()));
+		++seq;
+	}
+}
+
+}
+
+TEST(LongLinkPacker_test, batch_same_as_single)
+{
+	AutoBuffer read;
+	fill_read(read, 41);    // the last header is complete, its body isn't
+
+	std::vector<LongLinkPackInfo> packs;
+	LongLinkPackInfo pending;
+	ASSERT_EQ(LONGLINK_UNPACK_CONTINUE, longlink_unpack_batch(read.Ptr(), read.Length(), packs, pending));
+	ASSERT_LT(1000u, packs.size());
+
+	size_t offset = 0;
+	for (size_t i = 0; i < packs.size(); ++i)
+	{
+		AutoBuffer view;
+		view.Attach(read.Ptr(offset), read.Length() - offset);
+
+		uint32_t cmdid = 0;
+		uint32_t seq = 0;
+		size_t package_len = 0;
+		AutoBuffer body;
+		int ret = longlink_unpack(view, cmdid, seq, package_len, body);
+		view.Detach();
+
+		ASSERT_EQ(LONGLINK_UNPACK_OK, ret);
+		EXPECT_EQ(offset, packs[i].offset);
+		EXPECT_EQ(cmdid, packs[i].cmdid);
+		EXPECT_EQ(seq, packs[i].seq);
+		EXPECT_EQ(package_len, packs[i].package_len);
+		ASSERT_EQ(body.Length(), packs[i].body_len);
+		EXPECT_EQ(0, memcmp(body.Ptr(), read.Ptr(packs[i].body_offset), body.Length()));
+		offset += package_len;
+	}
+
+	EXPECT_EQ(offset, pending.offset);
+	EXPECT_EQ(packs.back().seq + 1, pending.seq);
+	EXPECT_LT(read.Length() - offset, pending.package_len);
+
+	// nothing left
+	ASSERT_EQ(LONGLINK_UNPACK_OK, longlink_unpack_batch(read.Ptr(), offset, packs, pending));
+	EXPECT_EQ(0u, pending.package_len);
+
+	// the header itself cut
+	ASSERT_EQ(LONGLINK_UNPACK_CONTINUE, longlink_unpack_batch(read.Ptr(), offset + 3, packs, pending));
+	EXPECT_EQ(0u, pending.package_len);
+}
+
+TEST(LongLinkPacker_test, broken_pack)
+{
+	AutoBuffer read;
+	fill_read(read, 40);
+
+	std::vector<LongLinkPackInfo> packs;
+	LongLinkPackInfo pending;
+	ASSERT_EQ(LONGLINK_UNPACK_CONTINUE, longlink_unpack_batch(read.Ptr(), read.Length(), packs, pending));
+	size_t broken = packs[3].offset;
+
+	// a header length of 0 can't be a pack
+	memset(read.Ptr(broken), 0, sizeof(uint32_t));
+	ASSERT_EQ(LONGLINK_UNPACK_FALSE, longlink_unpack_batch(read.Ptr(), read.Length(), packs, pending));
+	EXPECT_EQ(3u, packs.size());
+	EXPECT_EQ(broken, pending.offset);
+
+	// neither can another client version
+	memset(read.Ptr(broken), 0xff, sizeof(uint32_t) * 2);
+	ASSERT_EQ(LONGLINK_UNPACK_FALSE, longlink_unpack_batch(read.Ptr(), read.Length(), packs, pending));
+	EXPECT_EQ(3u, packs.size());
+}
+
+TEST(LongLinkPacker_test, benchmark)
+{
+	static const int kReads = 200;
+
+	AutoBuffer read;
+	fill_read(read, 12);
+	size_t count[2] = {0};
+
+	// a pack at a time, each moving what's left to the front
+	uint64_t begin = gettickcount();
+	for (int i = 0; i < kReads; ++i)
+	{
+		AutoBuffer recv;
+		recv.Write(read.Ptr(), read.Length());
+
+		while (0 < recv.Length())
+		{
+			uint32_t cmdid = 0;
+			uint32_t seq = 0;
+			size_t package_len = 0;
+			AutoBuffer body;
+			if (LONGLINK_UNPACK_OK != longlink_unpack(recv, cmdid, seq, package_len, body)) break;
+
+			recv.Move(-(off_t)package_len);
+			++count[0];
+		}
+	}
+	uint64_t single_cost = gettickcount() - begin;
+
+	std::vector<LongLinkPackInfo> packs;
+	begin = gettickcount();
+	for (int i = 0; i < kReads; ++i)
+	{
+		AutoBuffer recv;
+		recv.Write(read.Ptr(), read.Length());
+
+		LongLinkPackInfo pending;
+		longlink_unpack_batch(recv.Ptr(), recv.Length(), packs, pending);
+
+		for (size_t j = 0; j < packs.size(); ++j)
+		{
+			AutoBuffer body;
+			body.Write(recv.Ptr(packs[j].body_offset), packs[j].body_len);
+			++count[1];
+		}
+
+		recv.Move(-(off_t)pending.offset);
+	}
+	uint64_t batch_cost = gettickcount() - begin;
+
+	EXPECT_EQ(count[0], count[1]);
+	printf("%d reads of %" PRIu64 " bytes, %" PRIu64 " packs each, one at a time:%" PRIu64 "ms, batch:%" PRIu64 "ms\n",
+		   kReads, (uint64_t)read.Length(), (uint64_t)count[1] / kReads, single_cost, batch_cost);
+}
@@ -0,0 +1,128 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * shortlink_connection_pool_test.cc
+ *
+ *  Created on: 2026-10-17
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "mars/comm/http.h"
+#include "mars/stn/config.h"
+#include "mars/stn/src/shortlink_connection_pool.h"
+
+using namespace mars::stn;
+
+namespace
+{
+
+static bool keep_alive(const char* _response)
+{
+	http::Parser parser;
+	parser.Recv(_response, strlen(_response));
+	return ShortLinkConnectionPool::IsKeepAlive(parser);
+}
+
+static ConnectProfile profile(const char* _host, uint16_t _port)
+{
+	ConnectProfile conn_profile;
+	conn_profile.host = _host;
+	conn_profile.port = _port;
+	conn_profile.ip = "10.0.0.1";
+	conn_profile.ip_type = kIPSourceDNS;
+	return conn_profile;
+}
+
+}
+
+TEST(ShortLinkConnectionPool_test, keep_alive)
+{
+	EXPECT_TRUE(keep_alive("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok"));
+	EXPECT_TRUE(keep_alive("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nok\r\n0\r\n\r\n"));
+	EXPECT_TRUE(keep_alive("HTTP/1.0 200 OK\r\nConnection: Keep-Alive\r\nContent-Length: 2\r\n\r\nok"));
+
+	EXPECT_FALSE(keep_alive("HTTP/1.1 200 OK\r\nConnection: Close\r\nContent-Length: 2\r\n\r\nok"));
+	EXPECT_FALSE(keep_alive("HTTP/1.0 200 OK\r\nContent-Length: 2\r\n\r\nok"));
+	// the body ends with the connection
+	EXPECT_FALSE(keep_alive("HTTP/1.1 200 OK\r\n\r\n"));
+	// not ended yet
+	EXPECT_FALSE(keep_alive("HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nok"));
+}
+
+TEST(ShortLinkConnectionPool_test, get_and_put)
+{
+	ShortLinkConnectionPool pool;
+	ConnectProfile conn_profile;
+	EXPECT_EQ(INVALID_SOCKET, pool.Get("a.qq.com", 80, conn_profile));
+
+	int alive[2] = {-1, -1};
+	int closed[2] = {-1, -1};
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, alive));
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, closed));
+
+	pool.Put(alive[0], profile("a.qq.com", 80));
+	pool.Put(closed[0], profile("a.qq.com", 80));
+	close(closed[1]);
+
+	// another port, another host
+	EXPECT_EQ(INVALID_SOCKET, pool.Get("a.qq.com", 8080, conn_profile));
+	EXPECT_EQ(INVALID_SOCKET, pool.Get("b.qq.com", 80, conn_profile));
+	EXPECT_FALSE(conn_profile.conn_reused);
+
+	// the last put is closed by the peer, skipped
+	EXPECT_EQ(alive[0], pool.Get("a.qq.com", 80, conn_profile));
+	EXPECT_TRUE(conn_profile.conn_reused);
+	EXPECT_EQ("10.0.0.1", conn_profile.ip);
+	EXPECT_EQ(80, conn_profile.port);
+	EXPECT_EQ(INVALID_SOCKET, pool.Get("a.qq.com", 80, conn_profile));
+
+	// some bytes left unread, can't be reused either
+	pool.Put(alive[0], profile("a.qq.com", 80));
+	ASSERT_EQ(1, write(alive[1], "x", 1));
+	EXPECT_EQ(INVALID_SOCKET, pool.Get("a.qq.com", 80, conn_profile));
+	close(alive[1]);
+}
+
+TEST(ShortLinkConnectionPool_test, full_and_clear)
+{
+	ShortLinkConnectionPool pool;
+	int peers[kShortlinkKeepAliveMax + 1];
+
+	for (unsigned int i = 0; i < kShortlinkKeepAliveMax + 1; ++i)
+	{
+		int fds[2] = {-1, -1};
+		ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+		pool.Put(fds[0], profile("a.qq.com", 80));
+		peers[i] = fds[1];
+	}
+
+	// the first put is closed
+	char c = 0;
+	EXPECT_EQ(0, read(peers[0], &c, 1));
+
+	pool.Clear();
+	ConnectProfile conn_profile;
+	EXPECT_EQ(INVALID_SOCKET, pool.Get("a.qq.com", 80, conn_profile));
+
+	for (unsigned int i = 0; i < kShortlinkKeepAliveMax + 1; ++i)
+	{
+		EXPECT_EQ(0, read(peers[i], &c, 1));
+		close(peers[i]);
+	}
+}
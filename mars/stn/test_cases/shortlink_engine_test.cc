@@ -0,0 +1,311 @@
+// Tencent is pleased to support the open source community by making GAutomator available.
+// Copyright (C) 2016 THL A29 Limited, a Tencent company. All rights reserved.
+
+// Licensed under the MIT License (the "License"); you may not use this file except in
+// compliance with the License. You may obtain a copy of the License at
+// http://opensource.org/licenses/MIT
+
+// Unless required by applicable law or agreed to in writing, software distributed under the License is
+// distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+// either express or implied. See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * shortlink_engine_test.cc
+ *
+ *  Created on: 2026-10-18
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <string>
+#include <vector>
+
+#include "boost/bind.hpp"
+#include "gtest/gtest.h"
+
+#include "mars/baseevent/active_logic.h"
+#include "mars/comm/messagequeue/message_queue.h"
+#include "mars/comm/thread/condition.h"
+#include "mars/comm/thread/lock.h"
+#include "mars/stn/src/net_source.h"
+#include "mars/stn/src/shortlink.h"
+#include "mars/stn/src/shortlink_connection_pool.h"
+#include "mars/stn/src/shortlink_engine.h"
+
+using namespace mars::stn;
+
+namespace
+{
+
+static const char* const kHost = "a.qq.com";
+
+struct Response
+{
+	Response(): done(false), err_type(kEctOK), status(0) {}
+
+	Mutex mutex;
+	Condition cond;
+	bool done;
+	ErrCmdType err_type;
+	int status;
+	std::string body;
+	ConnectProfile profile;
+};
+
+static void on_response(Response* _response, ShortLinkInterface* _worker, ErrCmdType _err_type, int _status, AutoBuffer& _body, bool _cancel_retry, ConnectProfile& _conn_profile)
+{
+	ScopedLock lock(_response->mutex);
+	_response->done = true;
+	_response->err_type = _err_type;
+	_response->status = _status;
+	_response->body.assign((const char*)_body.Ptr(), _body.Length());
+	_response->profile = _conn_profile;
+	_response->cond.notifyAll(lock);
+}
+
+static void on_report(int _line, ErrCmdType _errtype, int _errcode, const std::string& _ip, const std::string& _host, uint16_t _port) {}
+static void on_send(ShortLinkInterface* _worker) {}
+static void on_recv(ShortLinkInterface* _worker, unsigned int _cached_size, unsigned int _total_size) {}
+
+static bool wait_response(Response& _response)
+{
+	ScopedLock lock(_response.mutex);
+	while (!_response.done)
+	{
+		if (ETIMEDOUT == _response.cond.wait(lock, 5000)) return false;
+	}
+	return true;
+}
+
+// the request sent through the pooled socket, up to the end of its body
+static std::string read_request(int _fd)
+{
+	std::string request;
+	char buf[1024];
+	while (std::string::npos == request.find("\r\n\r\n") || request.size() < request.find("\r\n\r\n") + 4 + 4)
+	{
+		ssize_t len = read(_fd, buf, sizeof(buf));
+		if (0 >= len) break;
+		request.append(buf, len);
+	}
+	return request;
+}
+
+// the port of a listening socket on 127.0.0.1
+static int listen_local(uint16_t& _port)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+	socklen_t len = sizeof(addr);
+	if (0 != bind(fd, (struct sockaddr*)&addr, len) || 0 != listen(fd, 4) || 0 != getsockname(fd, (struct sockaddr*)&addr, &len))
+	{
+		close(fd);
+		return -1;
+	}
+	_port = ntohs(addr.sin_port);
+	return fd;
+}
+
+static int accept_within(int _listen_fd, int _timeout)
+{
+	struct pollfd pfd = {_listen_fd, POLLIN, 0};
+	if (0 >= poll(&pfd, 1, _timeout)) return -1;
+	return accept(_listen_fd, NULL, NULL);
+}
+
+class ShortLinkEngine_test : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		netsource_ = new NetSource(active_logic_);
+
+		// a new connection goes to the listening socket, the pooled one is a socketpair
+		uint16_t port = 0;
+		listen_fd_ = listen_local(port);
+		ASSERT_LE(0, listen_fd_);
+		NetSource::SetShortlink(port, "127.0.0.1");
+
+		ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds_));
+
+		ConnectProfile conn_profile;
+		conn_profile.host = kHost;
+		conn_profile.port = NetSource::GetShortLinkPort();
+		conn_profile.ip = "10.0.0.1";
+		conn_profile.ip_type = kIPSourceDNS;
+		pool_.Put(fds_[0], conn_profile);
+	}
+
+	virtual void TearDown()
+	{
+		if (0 <= fds_[1]) close(fds_[1]);
+		close(listen_fd_);
+		NetSource::SetShortlink(0, "");
+		delete netsource_;
+	}
+
+	// run by the engine, or by a thread of its own
+	ShortLinkInterface* Create(Response& _response, bool _engine = true)
+	{
+		std::vector<std::string> hosts(1, kHost);
+		ShortLinkInterface* link = _engine ? new AsyncShortLink(engine_, MessageQueue::GetDefMessageQueue(), *netsource_, hosts, "/cgi", 1, false)
+										   : new ShortLink(MessageQueue::GetDefMessageQueue(), *netsource_, hosts, "/cgi", 1, false);
+		link->OnResponse = boost::bind(&on_response, &_response, _1, _2, _3, _4, _5, _6);
+		link->func_network_report = &on_report;
+		link->OnSend = &on_send;
+		link->OnRecv = &on_recv;
+		link->connection_pool = &pool_;
+		return link;
+	}
+
+	// the server closes the pooled connection without a response, the request goes through a new one
+	void StaleReuseConnectsAgain(bool _engine)
+	{
+		Response response;
+		ShortLinkInterface* link = Create(response, _engine);
+
+		AutoBuffer req;
+		req.Write("ping", 4);
+		link->SendRequest(req);
+
+		read_request(fds_[1]);
+		close(fds_[1]);
+		fds_[1] = -1;
+
+		int conn = accept_within(listen_fd_, 5000);
+		ASSERT_LE(0, conn);
+		std::string request = read_request(conn);
+		EXPECT_NE(std::string::npos, request.find("ping"));
+
+		const char* resp = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\npong";
+		EXPECT_EQ((ssize_t)strlen(resp), write(conn, resp, strlen(resp)));
+
+		EXPECT_TRUE(wait_response(response));
+		EXPECT_EQ(kEctOK, response.err_type);
+		EXPECT_EQ("pong", response.body);
+		EXPECT_FALSE(response.profile.conn_reused);
+
+		delete link;
+		close(conn);
+	}
+
+	ActiveLogic active_logic_;
+	NetSource* netsource_;
+	ShortLinkConnectionPool pool_;
+	ShortLinkEngine engine_;
+	int listen_fd_;
+	int fds_[2];
+};
+
+}
+
+TEST_F(ShortLinkEngine_test, reuse_send_recv)
+{
+	Response response;
+	ShortLinkInterface* link = Create(response);
+
+	AutoBuffer req;
+	req.Write("ping", 4);
+	link->SendRequest(req);
+
+	std::string request = read_request(fds_[1]);
+	EXPECT_EQ(0u, request.find("POST /cgi HTTP/1.1\r\n"));
+	EXPECT_NE(std::string::npos, request.find("ping"));
+
+	const char* resp = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\npong";
+	ASSERT_EQ((ssize_t)strlen(resp), write(fds_[1], resp, strlen(resp)));
+
+	ASSERT_TRUE(wait_response(response));
+	EXPECT_EQ(kEctOK, response.err_type);
+	EXPECT_EQ(200, response.status);
+	EXPECT_EQ("pong", response.body);
+
+	delete link;
+	// kept alive, back to the pool
+	ConnectProfile conn_profile;
+	EXPECT_EQ(fds_[0], pool_.Get(kHost, NetSource::GetShortLinkPort(), conn_profile));
+	close(fds_[0]);
+}
+
+TEST_F(ShortLinkEngine_test, remote_disconnect)
+{
+	Response response;
+	ShortLinkInterface* link = Create(response);
+
+	AutoBuffer req;
+	req.Write("ping", 4);
+	link->SendRequest(req);
+
+	read_request(fds_[1]);
+	const char* resp = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\npo";
+	ASSERT_EQ((ssize_t)strlen(resp), write(fds_[1], resp, strlen(resp)));
+	shutdown(fds_[1], SHUT_WR);
+
+	ASSERT_TRUE(wait_response(response));
+	EXPECT_EQ(kEctSocket, response.err_type);
+	EXPECT_EQ(kEctSocketShutdown, response.status);
+
+	delete link;
+	// not kept alive, closed
+	ConnectProfile conn_profile;
+	EXPECT_EQ(INVALID_SOCKET, pool_.Get(kHost, NetSource::GetShortLinkPort(), conn_profile));
+}
+
+TEST_F(ShortLinkEngine_test, detach_before_response)
+{
+	Response response;
+	ShortLinkInterface* link = Create(response);
+
+	AutoBuffer req;
+	req.Write("ping", 4);
+	link->SendRequest(req);
+	read_request(fds_[1]);
+
+	// the engine doesn't touch the link once it's gone, no response comes
+	delete link;
+	usleep(100 * 1000);
+
+	ScopedLock lock(response.mutex);
+	EXPECT_FALSE(response.done);
+}
+
+TEST_F(ShortLinkEngine_test, stale_reuse_connects_again)
+{
+	StaleReuseConnectsAgain(true);
+}
+
+TEST_F(ShortLinkEngine_test, stale_reuse_connects_again_thread)
+{
+	StaleReuseConnectsAgain(false);
+}
+
+TEST_F(ShortLinkEngine_test, reuse_fills_ip_items)
+{
+	Response response;
+	ShortLinkInterface* link = Create(response);
+
+	AutoBuffer req;
+	req.Write("ping", 4);
+	link->SendRequest(req);
+	read_request(fds_[1]);
+
+	const char* resp = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\npong";
+	ASSERT_EQ((ssize_t)strlen(resp), write(fds_[1], resp, strlen(resp)));
+	ASSERT_TRUE(wait_response(response));
+
+	EXPECT_TRUE(response.profile.conn_reused);
+	ASSERT_EQ(1u, response.profile.ip_items.size());
+	EXPECT_EQ(0, response.profile.ip_index);
+	EXPECT_EQ("10.0.0.1", response.profile.ip_items[0].str_ip);
+	EXPECT_EQ(kHost, response.profile.ip_items[0].str_host);
+
+	delete link;
+}